@@ -35,8 +35,10 @@ TableCatalogEntry::TableCatalogEntry(Catalog *catalog, SchemaCatalogEntry *schem
 	}
 	if (!storage) {
 		// create the physical storage
-		storage = make_shared<DataTable>(catalog->storage, schema->name, name, GetTypes(), move(info->data));
+		storage = make_shared<DataTable>(catalog->storage, schema->name, name, GetTypes(), move(info->data),
+		                                 move(info->persistent_data));
 		// create the unique indexes for the UNIQUE and PRIMARY KEY constraints
+		index_t unique_index_nr = 0;
 		for (index_t i = 0; i < bound_constraints.size(); i++) {
 			auto &constraint = bound_constraints[i];
 			if (constraint->type == ConstraintType::UNIQUE) {
@@ -47,7 +49,11 @@ TableCatalogEntry::TableCatalogEntry(Catalog *catalog, SchemaCatalogEntry *schem
 				vector<unique_ptr<Expression>> unbound_expressions;
 				vector<unique_ptr<Expression>> bound_expressions;
 				index_t key_nr = 0;
-				for (auto &key : unique.keys) {
+				// the columns of the key are ordered by their position in the table, so the order does not depend on
+				// the set of keys and a stored index is read back with the same key layout
+				vector<index_t> keys(unique.keys.begin(), unique.keys.end());
+				sort(keys.begin(), keys.end());
+				for (auto &key : keys) {
 					TypeId column_type = GetInternalType(columns[key].type);
 					assert(key < columns.size());
 
@@ -65,7 +71,14 @@ TableCatalogEntry::TableCatalogEntry(Catalog *catalog, SchemaCatalogEntry *schem
 						bound_constraints.push_back(make_unique<BoundNotNullConstraint>(column_index));
 					}
 				}
-				storage->AddIndex(move(art), bound_expressions);
+				if (unique_index_nr < info->indexes.size()) {
+					// the index was written to storage: load it instead of building it from the table data
+					art->LoadFromStorage(move(info->indexes[unique_index_nr]));
+					storage->indexes.push_back(move(art));
+				} else {
+					storage->AddIndex(move(art), bound_expressions);
+				}
+				unique_index_nr++;
 			}
 		}
 	}
@@ -161,7 +161,7 @@ void CatalogSet::DropEntryInternal(Transaction &transaction, CatalogEntry &curre
 
 bool CatalogSet::HasConflict(Transaction &transaction, CatalogEntry &current) {
 	return (current.timestamp >= TRANSACTION_ID_START && current.timestamp != transaction.transaction_id) ||
-	       (current.timestamp < TRANSACTION_ID_START && current.timestamp > transaction.start_time);
+	       (current.timestamp < TRANSACTION_ID_START && current.timestamp >= transaction.start_time);
 }
 
 CatalogEntry *CatalogSet::GetEntryForTransaction(Transaction &transaction, CatalogEntry *current) {
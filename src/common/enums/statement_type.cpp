@@ -46,6 +46,8 @@ string StatementTypeToString(StatementType type) {
 		return "CREATE_SEQUENCE";
 	case StatementType::DROP:
 		return "DROP";
+	case StatementType::CHECKPOINT:
+		return "CHECKPOINT";
 	default:
 		return "INVALID";
 	}
@@ -84,6 +84,8 @@ string Exception::ExceptionTypeToString(ExceptionType type) {
 		return "IO";
 	case ExceptionType::INTERRUPT:
 		return "INTERRUPT";
+	case ExceptionType::OUT_OF_MEMORY:
+		return "Out of Memory";
 	default:
 		return "Unknown";
 	}
@@ -172,3 +174,7 @@ SequenceException::SequenceException(string msg, ...) : Exception(ExceptionType:
 
 InterruptException::InterruptException() : Exception(ExceptionType::INTERRUPT, "Interrupted!") {
 }
+
+OutOfMemoryException::OutOfMemoryException(string msg, ...) : Exception(ExceptionType::OUT_OF_MEMORY, msg) {
+	FORMAT_CONSTRUCTOR(msg);
+}
@@ -31,6 +31,15 @@ FileBuffer::FileBuffer(uint64_t bufsiz) {
 	size = internal_size - FILE_BUFFER_HEADER_SIZE;
 }
 
+FileBuffer::FileBuffer(data_ptr_t data, uint64_t bufsiz) {
+	assert(bufsiz >= FILE_BUFFER_HEADER_SIZE);
+	malloced_buffer = nullptr;
+	internal_buffer = data;
+	internal_size = bufsiz;
+	buffer = internal_buffer + FILE_BUFFER_HEADER_SIZE;
+	size = internal_size - FILE_BUFFER_HEADER_SIZE;
+}
+
 FileBuffer::~FileBuffer() {
 	free(malloced_buffer);
 }
@@ -38,6 +47,10 @@ FileBuffer::~FileBuffer() {
 void FileBuffer::Read(FileHandle &handle, uint64_t location) {
 	// read the buffer from disk
 	handle.Read(internal_buffer, internal_size, location);
+	VerifyChecksum();
+}
+
+void FileBuffer::VerifyChecksum() {
 	// compute the checksum
 	uint64_t stored_checksum = *((uint64_t *)internal_buffer);
 	uint64_t computed_checksum = Checksum(buffer, size);
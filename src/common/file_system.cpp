@@ -23,6 +23,7 @@ static void AssertValidFileFlags(uint8_t flags) {
 #include <dirent.h>
 #include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -115,6 +116,39 @@ void FileSystem::SetFilePointer(FileHandle &handle, index_t location) {
 	}
 }
 
+void FileSystem::Read(FileHandle &handle, void *buffer, int64_t nr_bytes, index_t location) {
+	// pread does not use the file pointer, so multiple threads can read from the same handle at the same time
+	int fd = ((UnixFileHandle &)handle).fd;
+	auto data = (char *)buffer;
+	while (nr_bytes > 0) {
+		int64_t bytes_read = pread(fd, data, nr_bytes, location);
+		if (bytes_read == -1) {
+			throw IOException("Could not read from file \"%s\": %s", handle.path.c_str(), strerror(errno));
+		}
+		if (bytes_read == 0) {
+			throw IOException("Could not read sufficient bytes from file \"%s\"", handle.path.c_str());
+		}
+		data += bytes_read;
+		nr_bytes -= bytes_read;
+		location += bytes_read;
+	}
+}
+
+void FileSystem::Write(FileHandle &handle, void *buffer, int64_t nr_bytes, index_t location) {
+	// pwrite does not use the file pointer, so multiple threads can write to the same handle at the same time
+	int fd = ((UnixFileHandle &)handle).fd;
+	auto data = (char *)buffer;
+	while (nr_bytes > 0) {
+		int64_t bytes_written = pwrite(fd, data, nr_bytes, location);
+		if (bytes_written == -1) {
+			throw IOException("Could not write file \"%s\": %s", handle.path.c_str(), strerror(errno));
+		}
+		data += bytes_written;
+		nr_bytes -= bytes_written;
+		location += bytes_written;
+	}
+}
+
 int64_t FileSystem::Read(FileHandle &handle, void *buffer, int64_t nr_bytes) {
 	int fd = ((UnixFileHandle &)handle).fd;
 	int64_t bytes_read = read(fd, buffer, nr_bytes);
@@ -142,6 +176,19 @@ int64_t FileSystem::GetFileSize(FileHandle &handle) {
 	return s.st_size;
 }
 
+data_ptr_t FileSystem::MapFile(FileHandle &handle, index_t size) {
+	int fd = ((UnixFileHandle &)handle).fd;
+	void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		throw IOException("Could not map file \"%s\": %s", handle.path.c_str(), strerror(errno));
+	}
+	return (data_ptr_t)data;
+}
+
+void FileSystem::UnmapFile(data_ptr_t data, index_t size) {
+	munmap(data, size);
+}
+
 bool FileSystem::DirectoryExists(const string &directory) {
 	if (!directory.empty()) {
 		if (access(directory.c_str(), 0) == 0) {
@@ -367,6 +414,40 @@ void FileSystem::SetFilePointer(FileHandle &handle, index_t location) {
 	}
 }
 
+void FileSystem::Read(FileHandle &handle, void *buffer, int64_t nr_bytes, index_t location) {
+	// reading at an explicit offset is atomic, so multiple threads can read from the same handle at the same time
+	HANDLE hFile = ((WindowsFileHandle &)handle).fd;
+	OVERLAPPED overlapped = {};
+	overlapped.Offset = (DWORD)(location & 0xFFFFFFFF);
+	overlapped.OffsetHigh = (DWORD)(location >> 32);
+	DWORD bytes_read;
+	auto rc = ReadFile(hFile, buffer, (DWORD)nr_bytes, &bytes_read, &overlapped);
+	if (rc == 0) {
+		auto error = GetLastErrorAsString();
+		throw IOException("Could not read file \"%s\": %s", handle.path.c_str(), error.c_str());
+	}
+	if (bytes_read != nr_bytes) {
+		throw IOException("Could not read sufficient bytes from file \"%s\"", handle.path.c_str());
+	}
+}
+
+void FileSystem::Write(FileHandle &handle, void *buffer, int64_t nr_bytes, index_t location) {
+	// writing at an explicit offset is atomic, so multiple threads can write to the same handle at the same time
+	HANDLE hFile = ((WindowsFileHandle &)handle).fd;
+	OVERLAPPED overlapped = {};
+	overlapped.Offset = (DWORD)(location & 0xFFFFFFFF);
+	overlapped.OffsetHigh = (DWORD)(location >> 32);
+	DWORD bytes_written;
+	auto rc = WriteFile(hFile, buffer, (DWORD)nr_bytes, &bytes_written, &overlapped);
+	if (rc == 0) {
+		auto error = GetLastErrorAsString();
+		throw IOException("Could not write file \"%s\": %s", handle.path.c_str(), error.c_str());
+	}
+	if (bytes_written != nr_bytes) {
+		throw IOException("Could not write sufficient bytes from file \"%s\"", handle.path.c_str());
+	}
+}
+
 int64_t FileSystem::Read(FileHandle &handle, void *buffer, int64_t nr_bytes) {
 	HANDLE hFile = ((WindowsFileHandle &)handle).fd;
 	DWORD bytes_read;
@@ -398,6 +479,25 @@ int64_t FileSystem::GetFileSize(FileHandle &handle) {
 	return result.QuadPart;
 }
 
+data_ptr_t FileSystem::MapFile(FileHandle &handle, index_t size) {
+	HANDLE hFile = ((WindowsFileHandle &)handle).fd;
+	HANDLE mapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		throw IOException("Could not map file \"%s\": %s", handle.path.c_str(), GetLastErrorAsString().c_str());
+	}
+	// the view keeps the mapping alive, so we can close the mapping handle right away
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+	CloseHandle(mapping);
+	if (data == NULL) {
+		throw IOException("Could not map file \"%s\": %s", handle.path.c_str(), GetLastErrorAsString().c_str());
+	}
+	return (data_ptr_t)data;
+}
+
+void FileSystem::UnmapFile(data_ptr_t data, index_t size) {
+	UnmapViewOfFile(data);
+}
+
 bool FileSystem::DirectoryExists(const string &directory) {
 	DWORD attrs = GetFileAttributesA(directory.c_str());
 	return (attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY));
@@ -515,26 +615,6 @@ void FileSystem::MoveFile(const string &source, const string &target) {
 }
 #endif
 
-void FileSystem::Read(FileHandle &handle, void *buffer, int64_t nr_bytes, index_t location) {
-	// seek to the location
-	SetFilePointer(handle, location);
-	// now read from the location
-	int64_t bytes_read = Read(handle, buffer, nr_bytes);
-	if (bytes_read != nr_bytes) {
-		throw IOException("Could not read sufficient bytes from file \"%s\"", handle.path.c_str());
-	}
-}
-
-void FileSystem::Write(FileHandle &handle, void *buffer, int64_t nr_bytes, index_t location) {
-	// seek to the location
-	SetFilePointer(handle, location);
-	// now write to the location
-	int64_t bytes_written = Write(handle, buffer, nr_bytes);
-	if (bytes_written != nr_bytes) {
-		throw IOException("Could not write sufficient bytes from file \"%s\"", handle.path.c_str());
-	}
-}
-
 string FileSystem::JoinPath(const string &a, const string &b) {
 	// FIXME: sanitize paths
 	return a + PathSeparator() + b;
@@ -42,3 +42,7 @@ void BufferedFileWriter::Sync() {
 	Flush();
 	handle->Sync();
 }
+
+int64_t BufferedFileWriter::GetFileSize() {
+	return fs.GetFileSize(*handle) + offset;
+}
@@ -116,28 +116,19 @@ static int8_t compare_value(Vector &left_vec, Vector &right_vec, index_t vector_
 	return false;
 }
 
-static int compare_tuple(ChunkCollection *sort_by, vector<OrderType> &desc, index_t left, index_t right) {
-	assert(sort_by);
-
-	index_t chunk_idx_left = left / STANDARD_VECTOR_SIZE;
-	index_t chunk_idx_right = right / STANDARD_VECTOR_SIZE;
-	index_t vector_idx_left = left % STANDARD_VECTOR_SIZE;
-	index_t vector_idx_right = right % STANDARD_VECTOR_SIZE;
-
-	auto &left_chunk = sort_by->chunks[chunk_idx_left];
-	auto &right_chunk = sort_by->chunks[chunk_idx_right];
-
+int ChunkCollection::CompareRows(DataChunk &left, index_t left_idx, DataChunk &right, index_t right_idx,
+                                 vector<OrderType> &desc) {
 	for (index_t col_idx = 0; col_idx < desc.size(); col_idx++) {
 		auto order_type = desc[col_idx];
 
-		Vector &left_vec = left_chunk->data[col_idx];
-		Vector &right_vec = right_chunk->data[col_idx];
+		Vector &left_vec = left.data[col_idx];
+		Vector &right_vec = right.data[col_idx];
 
 		assert(!left_vec.sel_vector);
 		assert(!right_vec.sel_vector);
 		assert(left_vec.type == right_vec.type);
 
-		auto comp_res = compare_value(left_vec, right_vec, vector_idx_left, vector_idx_right);
+		auto comp_res = compare_value(left_vec, right_vec, left_idx, right_idx);
 
 		if (comp_res == 0) {
 			continue;
@@ -148,6 +139,20 @@ static int compare_tuple(ChunkCollection *sort_by, vector<OrderType> &desc, inde
 	return 0;
 }
 
+static int compare_tuple(ChunkCollection *sort_by, vector<OrderType> &desc, index_t left, index_t right) {
+	assert(sort_by);
+
+	index_t chunk_idx_left = left / STANDARD_VECTOR_SIZE;
+	index_t chunk_idx_right = right / STANDARD_VECTOR_SIZE;
+	index_t vector_idx_left = left % STANDARD_VECTOR_SIZE;
+	index_t vector_idx_right = right % STANDARD_VECTOR_SIZE;
+
+	auto &left_chunk = sort_by->chunks[chunk_idx_left];
+	auto &right_chunk = sort_by->chunks[chunk_idx_right];
+
+	return ChunkCollection::CompareRows(*left_chunk, vector_idx_left, *right_chunk, vector_idx_right, desc);
+}
+
 static int64_t _quicksort_initial(ChunkCollection *sort_by, vector<OrderType> &desc, index_t *result) {
 	// select pivot
 	int64_t pivot = 0;
@@ -244,13 +249,13 @@ void ChunkCollection::Reorder(index_t order_org[]) {
 }
 
 template <class TYPE>
-static void templated_set_values(ChunkCollection *src_coll, Vector &tgt_vec, index_t order[], index_t col_idx,
-                                 index_t start_offset, index_t remaining_data) {
+static void templated_set_values(ChunkCollection *src_coll, Vector &tgt_vec, index_t rows[], index_t col_idx,
+                                 index_t remaining_data) {
 	assert(src_coll);
 
 	for (index_t row_idx = 0; row_idx < remaining_data; row_idx++) {
-		index_t chunk_idx_src = order[start_offset + row_idx] / STANDARD_VECTOR_SIZE;
-		index_t vector_idx_src = order[start_offset + row_idx] % STANDARD_VECTOR_SIZE;
+		index_t chunk_idx_src = rows[row_idx] / STANDARD_VECTOR_SIZE;
+		index_t vector_idx_src = rows[row_idx] % STANDARD_VECTOR_SIZE;
 
 		auto &src_chunk = src_coll->chunks[chunk_idx_src];
 		Vector &src_vec = src_chunk->data[col_idx];
@@ -266,6 +271,11 @@ static void templated_set_values(ChunkCollection *src_coll, Vector &tgt_vec, ind
 // TODO: reorder functionality is similar, perhaps merge
 void ChunkCollection::MaterializeSortedChunk(DataChunk &target, index_t order[], index_t start_offset) {
 	index_t remaining_data = min((index_t)STANDARD_VECTOR_SIZE, count - start_offset);
+	MaterializeRows(target, order + start_offset, remaining_data);
+}
+
+void ChunkCollection::MaterializeRows(DataChunk &target, index_t rows[], index_t remaining_data) {
+	assert(remaining_data <= STANDARD_VECTOR_SIZE);
 	assert(target.GetTypes() == types);
 
 	for (index_t col_idx = 0; col_idx < column_count(); col_idx++) {
@@ -274,25 +284,25 @@ void ChunkCollection::MaterializeSortedChunk(DataChunk &target, index_t order[],
 		switch (types[col_idx]) {
 		case TypeId::BOOLEAN:
 		case TypeId::TINYINT:
-			templated_set_values<int8_t>(this, target.data[col_idx], order, col_idx, start_offset, remaining_data);
+			templated_set_values<int8_t>(this, target.data[col_idx], rows, col_idx, remaining_data);
 			break;
 		case TypeId::SMALLINT:
-			templated_set_values<int16_t>(this, target.data[col_idx], order, col_idx, start_offset, remaining_data);
+			templated_set_values<int16_t>(this, target.data[col_idx], rows, col_idx, remaining_data);
 			break;
 		case TypeId::INTEGER:
-			templated_set_values<int32_t>(this, target.data[col_idx], order, col_idx, start_offset, remaining_data);
+			templated_set_values<int32_t>(this, target.data[col_idx], rows, col_idx, remaining_data);
 			break;
 		case TypeId::BIGINT:
-			templated_set_values<int64_t>(this, target.data[col_idx], order, col_idx, start_offset, remaining_data);
+			templated_set_values<int64_t>(this, target.data[col_idx], rows, col_idx, remaining_data);
 			break;
 		case TypeId::FLOAT:
-			templated_set_values<float>(this, target.data[col_idx], order, col_idx, start_offset, remaining_data);
+			templated_set_values<float>(this, target.data[col_idx], rows, col_idx, remaining_data);
 			break;
 		case TypeId::DOUBLE:
-			templated_set_values<double>(this, target.data[col_idx], order, col_idx, start_offset, remaining_data);
+			templated_set_values<double>(this, target.data[col_idx], rows, col_idx, remaining_data);
 			break;
 		case TypeId::VARCHAR:
-			templated_set_values<char *>(this, target.data[col_idx], order, col_idx, start_offset, remaining_data);
+			templated_set_values<char *>(this, target.data[col_idx], rows, col_idx, remaining_data);
 			break;
 		default:
 			throw NotImplementedException("Type for setting");
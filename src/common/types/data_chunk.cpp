@@ -7,6 +7,8 @@
 #include "common/types/null_value.hpp"
 #include "common/vector_operations/vector_operations.hpp"
 
+#include <cstring>
+
 using namespace duckdb;
 using namespace std;
 
@@ -189,10 +191,10 @@ void DataChunk::Serialize(Serializer &serializer) {
 			// strings are inlined into the blob
 			// we use null-padding to store them
 			auto strings = (const char **)data[i].data;
-			for (index_t j = 0; j < size(); j++) {
-				auto source = strings[j] ? strings[j] : NullValue<const char *>();
+			VectorOperations::Exec(data[i], [&](index_t j, index_t k) {
+				auto source = !data[i].nullmask[j] && strings[j] ? strings[j] : NullValue<const char *>();
 				serializer.WriteString(source);
-			}
+			});
 		}
 	}
 }
@@ -264,6 +266,23 @@ void DataChunk::Hash(Vector &result) {
 	}
 }
 
+index_t DataChunk::MemoryUsage() {
+	index_t memory = 0;
+	for (index_t col_idx = 0; col_idx < column_count; col_idx++) {
+		auto &vector = data[col_idx];
+		memory += GetTypeIdSize(vector.type) * vector.count;
+		if (vector.type == TypeId::VARCHAR) {
+			auto strings = (const char **)vector.data;
+			VectorOperations::Exec(vector, [&](index_t i, index_t k) {
+				if (!vector.nullmask[i]) {
+					memory += strlen(strings[i]) + 1;
+				}
+			});
+		}
+	}
+	return memory;
+}
+
 void DataChunk::Verify() {
 #ifdef DEBUG
 	// verify that all vectors in this chunk have the chunk selection vector
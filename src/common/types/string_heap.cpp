@@ -8,7 +8,7 @@ using namespace std;
 
 #define MINIMUM_HEAP_SIZE 4096
 
-StringHeap::StringHeap() : tail(nullptr) {
+StringHeap::StringHeap() : tail(nullptr), allocated_size(0) {
 }
 
 const char *StringHeap::AddString(const char *data, index_t len) {
@@ -20,6 +20,7 @@ const char *StringHeap::AddString(const char *data, index_t len) {
 	if (!chunk || chunk->current_position + len >= chunk->maximum_size) {
 		// have to make a new entry
 		auto new_chunk = make_unique<StringChunk>(std::max(len + 1, (index_t)MINIMUM_HEAP_SIZE));
+		allocated_size += new_chunk->maximum_size;
 		new_chunk->prev = move(chunk);
 		chunk = move(new_chunk);
 		if (!tail) {
@@ -50,4 +51,6 @@ void StringHeap::MergeHeap(StringHeap &other) {
 		tail = this->chunk.get();
 	}
 	other.tail = nullptr;
+	allocated_size += other.allocated_size;
+	other.allocated_size = 0;
 }
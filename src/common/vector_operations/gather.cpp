@@ -13,23 +13,24 @@ using namespace std;
 
 struct GatherLoopSetNull {
 	template <class T, class OP> static void Operation(Vector &src, Vector &result, index_t offset) {
-		(void)offset;
-		auto source = (T **)src.data;
+		auto source = (data_ptr_t *)src.data;
 		auto ldata = (T *)result.data;
 		if (result.sel_vector) {
 			VectorOperations::Exec(src, [&](index_t i, index_t k) {
-				if (IsNullValue<T>(source[i][0])) {
+				auto value = *((T *)(source[i] + offset));
+				if (IsNullValue<T>(value)) {
 					result.nullmask.set(result.sel_vector[k]);
 				} else {
-					ldata[result.sel_vector[k]] = OP::Operation(source[i][0], ldata[i]);
+					ldata[result.sel_vector[k]] = OP::Operation(value, ldata[i]);
 				}
 			});
 		} else {
 			VectorOperations::Exec(src, [&](index_t i, index_t k) {
-				if (IsNullValue<T>(source[i][0])) {
+				auto value = *((T *)(source[i] + offset));
+				if (IsNullValue<T>(value)) {
 					result.nullmask.set(k);
 				} else {
-					ldata[k] = OP::Operation(source[i][0], ldata[i]);
+					ldata[k] = OP::Operation(value, ldata[i]);
 				}
 			});
 		}
@@ -38,16 +39,16 @@ struct GatherLoopSetNull {
 
 struct GatherLoopIgnoreNull {
 	template <class T, class OP> static void Operation(Vector &src, Vector &result, index_t offset) {
-		(void)offset;
-		auto source = (T **)src.data;
+		auto source = (data_ptr_t *)src.data;
 		auto ldata = (T *)result.data;
 		if (result.sel_vector) {
 			VectorOperations::Exec(src, [&](index_t i, index_t k) {
-				ldata[result.sel_vector[k]] = OP::Operation(source[i][0], ldata[i]);
+				ldata[result.sel_vector[k]] = OP::Operation(*((T *)(source[i] + offset)), ldata[i]);
 			});
 		} else {
-			VectorOperations::Exec(src,
-			                       [&](index_t i, index_t k) { ldata[k] = OP::Operation(source[i][0], ldata[i]); });
+			VectorOperations::Exec(src, [&](index_t i, index_t k) {
+				ldata[k] = OP::Operation(*((T *)(source[i] + offset)), ldata[i]);
+			});
 		}
 	}
 };
@@ -6,6 +6,7 @@
 #include "common/vector_operations/vector_operations.hpp"
 #include "planner/expression/bound_aggregate_expression.hpp"
 #include "catalog/catalog_entry/aggregate_function_catalog_entry.hpp"
+#include "storage/temporary_file.hpp"
 
 #include <cmath>
 #include <map>
@@ -258,6 +259,314 @@ void SuperLargeHashTable::FetchAggregates(DataChunk &groups, DataChunk &result)
 	}
 }
 
+bool SuperLargeHashTable::CanCombine(vector<BoundAggregateExpression *> &aggregates) {
+	for (auto &aggr : aggregates) {
+		if (aggr->distinct || !aggr->function.combine) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void SuperLargeHashTable::Combine(SuperLargeHashTable &other) {
+	assert(other.tuple_size == tuple_size);
+	assert(CanCombine(aggregates));
+	if (other.entries == 0) {
+		return;
+	}
+
+	DataChunk groups;
+	groups.Initialize(group_types, false);
+
+	Vector addresses(TypeId::POINTER, true, false);
+	auto data_pointers = (data_ptr_t *)addresses.data;
+
+	data_ptr_t ptr = other.data;
+	data_ptr_t end = other.data + other.capacity * tuple_size;
+	while (true) {
+		groups.Reset();
+
+		// scan the other table for full cells
+		index_t entry = 0;
+		for (; ptr < end && entry < STANDARD_VECTOR_SIZE; ptr += tuple_size) {
+			if (*ptr == FULL_CELL) {
+				data_pointers[entry++] = ptr + FLAG_SIZE;
+			}
+		}
+		if (entry == 0) {
+			break;
+		}
+		addresses.count = entry;
+		// fetch the group columns
+		for (index_t i = 0; i < groups.column_count; i++) {
+			auto &column = groups.data[i];
+			column.count = entry;
+			VectorOperations::Gather::Set(addresses, column);
+			VectorOperations::AddInPlace(addresses, GetTypeIdSize(column.type));
+		}
+		groups.Verify();
+
+		// find or create the groups in this table
+		StaticPointerVector new_addresses;
+		StaticVector<bool> new_group_dummy;
+		FindOrCreateGroups(groups, new_addresses, new_group_dummy);
+
+		// NB: both address vectors now point to the payload start, combine the aggregate states one by one
+		assert(addresses.count == new_addresses.count && addresses.sel_vector == new_addresses.sel_vector);
+		for (index_t aggr_idx = 0; aggr_idx < aggregates.size(); aggr_idx++) {
+			auto aggr = aggregates[aggr_idx];
+			aggr->function.combine(addresses, new_addresses, aggr->return_type);
+
+			auto state_size = aggr->function.state_size(aggr->return_type);
+			VectorOperations::AddInPlace(addresses, state_size);
+			VectorOperations::AddInPlace(new_addresses, state_size);
+		}
+	}
+	// the groups (and possibly aggregate states) can point into the string heap of the other table
+	string_heap.MergeHeap(other.string_heap);
+}
+
+//! Computes for every partition the selection vector of the groups that belong to it. The selection vector of partition
+//! i is stored at partition_sel + i * STANDARD_VECTOR_SIZE.
+static void RadixPartition(DataChunk &groups, index_t partition_count, sel_t partition_sel[],
+                           index_t partition_entries[]) {
+	// the hash is computed the same way as in FindOrCreateGroups
+	for (index_t group_idx = 0; group_idx < groups.column_count; group_idx++) {
+		VectorOperations::FillNullMask(groups.data[group_idx]);
+	}
+	StaticVector<uint64_t> hashes;
+	groups.Hash(hashes);
+
+	// the HTs use the lower bits of the hash to find a slot, use the upper bits for the partitioning
+	index_t radix_bits = 0;
+	while (((index_t)1 << radix_bits) < partition_count) {
+		radix_bits++;
+	}
+	auto shift = 64 - radix_bits;
+
+	memset(partition_entries, 0, sizeof(index_t) * partition_count);
+	VectorOperations::ExecType<uint64_t>(hashes, [&](uint64_t element, index_t i, index_t k) {
+		auto partition = element >> shift;
+		partition_sel[partition * STANDARD_VECTOR_SIZE + partition_entries[partition]++] = i;
+	});
+}
+
+void SuperLargeHashTable::AddChunkPartitioned(vector<unique_ptr<SuperLargeHashTable>> &partitions, DataChunk &groups,
+                                              DataChunk &payload) {
+	index_t partition_count = partitions.size();
+	assert(partition_count > 0 && (partition_count & (partition_count - 1)) == 0);
+	if (groups.size() == 0) {
+		return;
+	}
+	if (partition_count == 1) {
+		partitions[0]->AddChunk(groups, payload);
+		return;
+	}
+	auto partition_sel = unique_ptr<sel_t[]>(new sel_t[partition_count * STANDARD_VECTOR_SIZE]);
+	auto partition_entries = unique_ptr<index_t[]>(new index_t[partition_count]);
+	RadixPartition(groups, partition_count, partition_sel.get(), partition_entries.get());
+
+	// add each of the partitions to its HT by setting the selection vector of the chunks
+	auto old_sel_vector = groups.sel_vector;
+	index_t old_count = groups.size();
+	for (index_t partition = 0; partition < partition_count; partition++) {
+		auto count = partition_entries[partition];
+		if (count == 0) {
+			continue;
+		}
+		auto sel_vector = partition_sel.get() + partition * STANDARD_VECTOR_SIZE;
+		groups.sel_vector = payload.sel_vector = sel_vector;
+		for (index_t i = 0; i < groups.column_count; i++) {
+			groups.data[i].sel_vector = sel_vector;
+			groups.data[i].count = count;
+		}
+		for (index_t i = 0; i < payload.column_count; i++) {
+			payload.data[i].sel_vector = sel_vector;
+			payload.data[i].count = count;
+		}
+		partitions[partition]->AddChunk(groups, payload);
+	}
+	groups.sel_vector = payload.sel_vector = old_sel_vector;
+	for (index_t i = 0; i < groups.column_count; i++) {
+		groups.data[i].sel_vector = old_sel_vector;
+		groups.data[i].count = old_count;
+	}
+	for (index_t i = 0; i < payload.column_count; i++) {
+		payload.data[i].sel_vector = old_sel_vector;
+		payload.data[i].count = old_count;
+	}
+}
+
+index_t SuperLargeHashTable::MemoryUsage() {
+	return capacity * tuple_size + string_heap.MemoryUsage();
+}
+
+vector<TypeId> SuperLargeHashTable::GetSpillTypes() {
+	vector<TypeId> types = group_types;
+	for (auto &aggr : aggregates) {
+		if (aggr->return_type == TypeId::VARCHAR) {
+			// the state is a pointer into the string heap: the string itself is stored
+			types.push_back(TypeId::VARCHAR);
+			continue;
+		}
+		// other states are stored byte-for-byte in as many BIGINT columns as are required
+		auto state_size = aggr->function.state_size(aggr->return_type);
+		for (index_t state_offset = 0; state_offset < state_size; state_offset += sizeof(int64_t)) {
+			types.push_back(TypeId::BIGINT);
+		}
+	}
+	return types;
+}
+
+void SuperLargeHashTable::Spill(TemporaryDirectory &directory, vector<unique_ptr<TemporaryFile>> &partitions) {
+	assert(CanCombine(aggregates));
+	index_t partition_count = partitions.size();
+	assert(partition_count > 0 && (partition_count & (partition_count - 1)) == 0);
+	if (entries == 0) {
+		return;
+	}
+	auto spill_types = GetSpillTypes();
+	DataChunk spill_chunk, groups;
+	spill_chunk.Initialize(spill_types);
+	groups.InitializeEmpty(group_types);
+
+	Vector addresses(TypeId::POINTER, true, false);
+	auto data_pointers = (data_ptr_t *)addresses.data;
+
+	auto partition_sel = unique_ptr<sel_t[]>(new sel_t[partition_count * STANDARD_VECTOR_SIZE]);
+	auto partition_entries = unique_ptr<index_t[]>(new index_t[partition_count]);
+
+	data_ptr_t ptr = data;
+	data_ptr_t end = data + capacity * tuple_size;
+	while (true) {
+		spill_chunk.Reset();
+
+		// scan the table for full cells
+		index_t entry = 0;
+		for (; ptr < end && entry < STANDARD_VECTOR_SIZE; ptr += tuple_size) {
+			if (*ptr == FULL_CELL) {
+				data_pointers[entry++] = ptr + FLAG_SIZE;
+			}
+		}
+		if (entry == 0) {
+			break;
+		}
+		addresses.count = entry;
+		// fetch the group columns
+		index_t column = 0, offset = 0;
+		for (; column < group_types.size(); column++) {
+			auto &vector = spill_chunk.data[column];
+			vector.count = entry;
+			VectorOperations::Gather::Set(addresses, vector, true, offset);
+			offset += GetTypeIdSize(vector.type);
+		}
+		// fetch the aggregate states
+		for (auto &aggr : aggregates) {
+			auto state_size = aggr->function.state_size(aggr->return_type);
+			if (aggr->return_type == TypeId::VARCHAR) {
+				auto &vector = spill_chunk.data[column++];
+				vector.count = entry;
+				VectorOperations::Gather::Set(addresses, vector, true, offset);
+			} else {
+				for (index_t state_offset = 0; state_offset < state_size; state_offset += sizeof(int64_t)) {
+					auto &vector = spill_chunk.data[column++];
+					auto vector_data = (int64_t *)vector.data;
+					auto copy_size = std::min((index_t)sizeof(int64_t), state_size - state_offset);
+					for (index_t i = 0; i < entry; i++) {
+						vector_data[i] = 0;
+						memcpy(&vector_data[i], data_pointers[i] + offset + state_offset, copy_size);
+					}
+					vector.count = entry;
+				}
+			}
+			offset += state_size;
+		}
+
+		// write the entries to their partitions
+		for (index_t i = 0; i < groups.column_count; i++) {
+			groups.data[i].Reference(spill_chunk.data[i]);
+		}
+		RadixPartition(groups, partition_count, partition_sel.get(), partition_entries.get());
+		for (index_t partition = 0; partition < partition_count; partition++) {
+			auto count = partition_entries[partition];
+			if (count == 0) {
+				continue;
+			}
+			auto sel_vector = partition_sel.get() + partition * STANDARD_VECTOR_SIZE;
+			spill_chunk.sel_vector = sel_vector;
+			for (index_t i = 0; i < spill_chunk.column_count; i++) {
+				spill_chunk.data[i].sel_vector = sel_vector;
+				spill_chunk.data[i].count = count;
+			}
+			if (!partitions[partition]) {
+				partitions[partition] = make_unique<TemporaryFile>(directory);
+			}
+			partitions[partition]->Append(spill_chunk);
+		}
+	}
+}
+
+void SuperLargeHashTable::CombineSpilledChunk(DataChunk &chunk) {
+	assert(CanCombine(aggregates));
+	auto count = chunk.size();
+	if (count == 0) {
+		return;
+	}
+	assert(!chunk.sel_vector);
+	// the strings of the groups and states have to stay alive as long as this HT
+	chunk.MoveStringsToHeap(string_heap);
+
+	// find or create the groups in this table
+	DataChunk groups;
+	groups.InitializeEmpty(group_types);
+	for (index_t i = 0; i < groups.column_count; i++) {
+		groups.data[i].Reference(chunk.data[i]);
+	}
+	StaticPointerVector new_addresses;
+	StaticVector<bool> new_group_dummy;
+	FindOrCreateGroups(groups, new_addresses, new_group_dummy);
+
+	// reconstruct the aggregate states in the layout they have in the HT
+	auto states = unique_ptr<data_t[]>(new data_t[count * payload_width]);
+	Vector addresses(TypeId::POINTER, true, false);
+	auto data_pointers = (data_ptr_t *)addresses.data;
+	for (index_t i = 0; i < count; i++) {
+		data_pointers[i] = states.get() + i * payload_width;
+	}
+	addresses.count = count;
+	index_t column = group_types.size(), offset = 0;
+	for (auto &aggr : aggregates) {
+		auto state_size = aggr->function.state_size(aggr->return_type);
+		if (aggr->return_type == TypeId::VARCHAR) {
+			auto &vector = chunk.data[column++];
+			auto strings = (const char **)vector.data;
+			for (index_t i = 0; i < count; i++) {
+				*((const char **)(data_pointers[i] + offset)) =
+				    vector.nullmask[i] ? NullValue<const char *>() : strings[i];
+			}
+		} else {
+			for (index_t state_offset = 0; state_offset < state_size; state_offset += sizeof(int64_t)) {
+				auto vector_data = (int64_t *)chunk.data[column++].data;
+				auto copy_size = std::min((index_t)sizeof(int64_t), state_size - state_offset);
+				for (index_t i = 0; i < count; i++) {
+					memcpy(data_pointers[i] + offset + state_offset, &vector_data[i], copy_size);
+				}
+			}
+		}
+		offset += state_size;
+	}
+
+	// NB: both address vectors now point to the payload start, combine the aggregate states one by one
+	assert(addresses.count == new_addresses.count && addresses.sel_vector == new_addresses.sel_vector);
+	for (auto &aggr : aggregates) {
+		aggr->function.combine(addresses, new_addresses, aggr->return_type);
+
+		auto state_size = aggr->function.state_size(aggr->return_type);
+		VectorOperations::AddInPlace(addresses, state_size);
+		VectorOperations::AddInPlace(new_addresses, state_size);
+	}
+}
+
 template <class T>
 void templated_compare_group_vector(data_ptr_t group_pointers[], Vector &groups, sel_t sel_vector[], index_t &sel_count,
                                     sel_t no_match_vector[], index_t &no_match_count) {
@@ -2,6 +2,9 @@
 #include "execution/expression_executor.hpp"
 #include "common/vector_operations/vector_operations.hpp"
 #include "main/client_context.hpp"
+#include "main/database.hpp"
+#include "parallel/task_scheduler.hpp"
+#include "storage/meta_block_writer.hpp"
 #include <algorithm>
 
 using namespace duckdb;
@@ -10,11 +13,7 @@ using namespace std;
 ART::ART(DataTable &table, vector<column_t> column_ids, vector<unique_ptr<Expression>> unbound_expressions,
          bool is_unique)
     : Index(IndexType::ART, table, column_ids, move(unbound_expressions)), is_unique(is_unique) {
-	if (this->unbound_expressions.size() > 1) {
-		throw NotImplementedException("Multiple columns in ART index not supported");
-	}
 	tree = nullptr;
-	expression_result.Initialize(types);
 	int n = 1;
 	// little endian if true
 	if (*(char *)&n == 1) {
@@ -22,21 +21,19 @@ ART::ART(DataTable &table, vector<column_t> column_ids, vector<unique_ptr<Expres
 	} else {
 		is_little_endian = false;
 	}
-	switch (types[0]) {
-	case TypeId::TINYINT:
-		maxPrefix = sizeof(int8_t);
-		break;
-	case TypeId::SMALLINT:
-		maxPrefix = sizeof(int16_t);
-		break;
-	case TypeId::INTEGER:
-		maxPrefix = sizeof(int32_t);
-		break;
-	case TypeId::BIGINT:
-		maxPrefix = sizeof(int64_t);
-		break;
-	default:
-		throw InvalidTypeException(types[0], "Invalid type for index");
+	for (auto &type : types) {
+		switch (type) {
+		case TypeId::TINYINT:
+		case TypeId::SMALLINT:
+		case TypeId::INTEGER:
+		case TypeId::BIGINT:
+		case TypeId::FLOAT:
+		case TypeId::DOUBLE:
+		case TypeId::VARCHAR:
+			break;
+		default:
+			throw InvalidTypeException(type, "Invalid type for index");
+		}
 	}
 }
 
@@ -44,13 +41,14 @@ ART::~ART() {
 }
 
 bool ART::LeafMatches(Node *node, Key &key, unsigned depth) {
-	if (depth != maxPrefix) {
-		auto leaf = static_cast<Leaf *>(node);
-		Key &leaf_key = *leaf->value;
-		for (index_t i = depth; i < maxPrefix; i++) {
-			if (leaf_key[i] != key[i]) {
-				return false;
-			}
+	auto leaf = static_cast<Leaf *>(node);
+	Key &leaf_key = *leaf->value;
+	if (leaf_key.len != key.len) {
+		return false;
+	}
+	for (index_t i = depth; i < key.len; i++) {
+		if (leaf_key[i] != key[i]) {
+			return false;
 		}
 	}
 	return true;
@@ -59,8 +57,9 @@ bool ART::LeafMatches(Node *node, Key &key, unsigned depth) {
 unique_ptr<IndexScanState> ART::InitializeScanSinglePredicate(Transaction &transaction, vector<column_t> column_ids,
                                                               Value value, ExpressionType expression_type) {
 	auto result = make_unique<ARTIndexScanState>(column_ids);
-	result->values[0] = value;
+	result->values[0].push_back(value);
 	result->expressions[0] = expression_type;
+	result->row_count = table.AppendedRowCount();
 	return move(result);
 }
 
@@ -68,58 +67,142 @@ unique_ptr<IndexScanState> ART::InitializeScanTwoPredicates(Transaction &transac
                                                             Value low_value, ExpressionType low_expression_type,
                                                             Value high_value, ExpressionType high_expression_type) {
 	auto result = make_unique<ARTIndexScanState>(column_ids);
-	result->values[0] = low_value;
+	result->values[0].push_back(low_value);
 	result->expressions[0] = low_expression_type;
-	result->values[1] = high_value;
+	result->values[1].push_back(high_value);
 	result->expressions[1] = high_expression_type;
+	result->row_count = table.AppendedRowCount();
+	return move(result);
+}
+
+unique_ptr<IndexScanState> ART::InitializeScanEqual(Transaction &transaction, vector<column_t> column_ids,
+                                                    vector<Value> values) {
+	assert(values.size() == types.size());
+	auto result = make_unique<ARTIndexScanState>(column_ids);
+	result->values[0] = move(values);
+	result->expressions[0] = ExpressionType::COMPARE_EQUAL;
+	result->row_count = table.AppendedRowCount();
 	return move(result);
 }
 
 //===--------------------------------------------------------------------===//
 // Insert
 //===--------------------------------------------------------------------===//
-template <class T> static void generate_keys(DataChunk &input, vector<unique_ptr<Key>> &keys, bool is_little_endian) {
-	auto input_data = (T *)input.data[0].data;
-	VectorOperations::Exec(input.data[0], [&](index_t i, index_t k) {
-		if (input.data[0].nullmask[i]) {
-			keys.push_back(nullptr);
-		} else {
-			keys.push_back(Key::CreateKey<T>(input_data[i], is_little_endian));
+//! Add the size of the encoded values of the column to the sizes of the keys. The size of the key of a row with a NULL
+//! value is set to INVALID_INDEX, these rows are not stored in the index.
+static void compute_key_sizes(Vector &input, index_t key_sizes[]) {
+	if (input.type == TypeId::VARCHAR) {
+		auto input_data = (const char **)input.data;
+		VectorOperations::Exec(input, [&](index_t i, index_t k) {
+			if (input.nullmask[i]) {
+				key_sizes[k] = INVALID_INDEX;
+			} else if (key_sizes[k] != INVALID_INDEX) {
+				// strings are encoded with their terminating zero byte, so no key is a prefix of another key
+				key_sizes[k] += strlen(input_data[i]) + 1;
+			}
+		});
+	} else {
+		auto type_size = GetTypeIdSize(input.type);
+		VectorOperations::Exec(input, [&](index_t i, index_t k) {
+			if (input.nullmask[i]) {
+				key_sizes[k] = INVALID_INDEX;
+			} else if (key_sizes[k] != INVALID_INDEX) {
+				key_sizes[k] += type_size;
+			}
+		});
+	}
+}
+
+template <class T> static void encode_keys(Vector &input, data_ptr_t key_data[], bool is_little_endian) {
+	auto input_data = (T *)input.data;
+	VectorOperations::Exec(input, [&](index_t i, index_t k) {
+		if (key_data[k]) {
+			Key::EncodeData<T>(input_data[i], is_little_endian, key_data[k]);
+			key_data[k] += sizeof(T);
 		}
 	});
 }
 
-void ART::GenerateKeys(DataChunk &input, vector<unique_ptr<Key>> &keys) {
-	keys.reserve(STANDARD_VECTOR_SIZE);
+static void encode_string_keys(Vector &input, data_ptr_t key_data[]) {
+	auto input_data = (const char **)input.data;
+	VectorOperations::Exec(input, [&](index_t i, index_t k) {
+		if (key_data[k]) {
+			auto length = strlen(input_data[i]) + 1;
+			memcpy(key_data[k], input_data[i], length);
+			key_data[k] += length;
+		}
+	});
+}
 
-	switch (input.data[0].type) {
+//! Write the encoded values of the column to the keys and move the key pointers past them. The keys of rows with a
+//! NULL value are nullptr.
+static void encode_column(Vector &input, data_ptr_t key_data[], bool is_little_endian) {
+	switch (input.type) {
 	case TypeId::TINYINT:
-		generate_keys<int8_t>(input, keys, is_little_endian);
+		encode_keys<int8_t>(input, key_data, is_little_endian);
 		break;
 	case TypeId::SMALLINT:
-		generate_keys<int16_t>(input, keys, is_little_endian);
+		encode_keys<int16_t>(input, key_data, is_little_endian);
 		break;
 	case TypeId::INTEGER:
-		generate_keys<int32_t>(input, keys, is_little_endian);
+		encode_keys<int32_t>(input, key_data, is_little_endian);
 		break;
 	case TypeId::BIGINT:
-		generate_keys<int64_t>(input, keys, is_little_endian);
+		encode_keys<int64_t>(input, key_data, is_little_endian);
+		break;
+	case TypeId::FLOAT:
+		encode_keys<float>(input, key_data, is_little_endian);
+		break;
+	case TypeId::DOUBLE:
+		encode_keys<double>(input, key_data, is_little_endian);
+		break;
+	case TypeId::VARCHAR:
+		encode_string_keys(input, key_data);
 		break;
 	default:
-		throw InvalidTypeException(input.data[0].type, "Invalid type for index");
+		throw InvalidTypeException(input.type, "Invalid type for index");
+	}
+}
+
+void ART::GenerateKeys(DataChunk &input, vector<unique_ptr<Key>> &keys) {
+	index_t count = input.size();
+	// the key of a row is the concatenation of the encoded values of all its columns
+	index_t key_sizes[STANDARD_VECTOR_SIZE];
+	data_ptr_t key_data[STANDARD_VECTOR_SIZE];
+	memset(key_sizes, 0, count * sizeof(index_t));
+	for (index_t i = 0; i < input.column_count; i++) {
+		compute_key_sizes(input.data[i], key_sizes);
+	}
+	keys.reserve(count);
+	for (index_t k = 0; k < count; k++) {
+		if (key_sizes[k] == INVALID_INDEX) {
+			key_data[k] = nullptr;
+			keys.push_back(nullptr);
+			continue;
+		}
+		auto data = unique_ptr<data_t[]>(new data_t[key_sizes[k]]);
+		key_data[k] = data.get();
+		keys.push_back(make_unique<Key>(move(data), key_sizes[k]));
+	}
+	for (index_t i = 0; i < input.column_count; i++) {
+		encode_column(input.data[i], key_data, is_little_endian);
 	}
 }
 
 bool ART::Insert(DataChunk &input, Vector &row_ids) {
+	return InsertKeys(input, row_ids, is_unique);
+}
+
+bool ART::InsertKeys(DataChunk &input, Vector &row_ids, bool verify_unique) {
 	assert(row_ids.type == TypeId::BIGINT);
 	assert(input.size() == row_ids.count);
-	assert(types[0] == input.data[0].type);
 
 	// generate the keys for the given input
 	vector<unique_ptr<Key>> keys;
 	GenerateKeys(input, keys);
 
 	// now insert the elements into the index
+	EpochGuard guard(epochs);
 	auto row_identifiers = (row_t *)row_ids.data;
 	index_t failed_index = INVALID_INDEX;
 	for (index_t i = 0; i < row_ids.count; i++) {
@@ -127,7 +210,12 @@ bool ART::Insert(DataChunk &input, Vector &row_ids) {
 			continue;
 		}
 		row_t row_id = row_identifiers[row_ids.sel_vector ? row_ids.sel_vector[i] : i];
-		if (!Insert(tree, move(keys[i]), 0, row_id)) {
+		bool inserted, restart;
+		do {
+			restart = false;
+			inserted = Insert(keys[i], row_id, verify_unique, restart);
+		} while (restart);
+		if (!inserted) {
 			// failed to insert because of constraint violation
 			failed_index = i;
 			break;
@@ -145,7 +233,11 @@ bool ART::Insert(DataChunk &input, Vector &row_ids) {
 			}
 			index_t k = row_ids.sel_vector ? row_ids.sel_vector[i] : i;
 			row_t row_id = row_identifiers[k];
-			Erase(tree, *keys[i], 0, row_id);
+			bool restart;
+			do {
+				restart = false;
+				Erase(*keys[i], row_id, restart);
+			} while (restart);
 		}
 		return false;
 	}
@@ -153,104 +245,433 @@ bool ART::Insert(DataChunk &input, Vector &row_ids) {
 }
 
 bool ART::Append(DataChunk &appended_data, Vector &row_identifiers) {
-	lock_guard<mutex> l(lock);
-
 	// first resolve the expressions for the index
+	DataChunk expression_result;
+	expression_result.Initialize(types);
 	ExecuteExpressions(appended_data, expression_result);
 
 	// now insert into the index
 	return Insert(expression_result, row_identifiers);
 }
 
-bool ART::InsertToLeaf(Leaf &leaf, row_t row_id) {
-	if (is_unique && leaf.num_elements != 0) {
+void ART::AppendVerified(DataChunk &appended_data, Vector &row_identifiers) {
+	DataChunk expression_result;
+	expression_result.Initialize(types);
+	ExecuteExpressions(appended_data, expression_result);
+
+	// the keys were verified when the rows were appended originally
+	bool inserted = InsertKeys(expression_result, row_identifiers, false);
+	assert(inserted);
+}
+
+bool ART::InsertToLeaf(Leaf &leaf, row_t row_id, bool verify_unique) {
+	if (verify_unique && leaf.num_elements != 0) {
 		return false;
 	}
-	leaf.Insert(row_id);
+	leaf.Insert(*this, row_id);
 	return true;
 }
 
-bool ART::Insert(unique_ptr<Node> &node, unique_ptr<Key> value, unsigned depth, row_t row_id) {
+void ART::ReplaceNode(unique_ptr<Node> &node, unique_ptr<Node> new_node) {
+	auto old_node = move(node);
+	node = move(new_node);
+	old_node->lock.WriteUnlockObsolete();
+	epochs.Retire(move(old_node));
+}
+
+Node *ART::GetChildOrRestart(Node *node, index_t pos, uint64_t version, bool &restart) {
+	// the reference is only valid if the node did not change while it was read
+	auto child_ref = node->ReadChild(pos);
+	Node *child = child_ref ? child_ref->get() : nullptr;
+	node->lock.CheckOrRestart(version, restart);
+	if (restart) {
+		return nullptr;
+	}
+	assert(child);
+	if (child->type == NodeType::NPersistent) {
+		// the child has not been loaded yet: loading it replaces the reference to it, which requires the lock of the
+		// node
+		node->lock.UpgradeToWriteLockOrRestart(version, restart);
+		if (restart) {
+			return nullptr;
+		}
+		PersistentNode::Swizzle(*child_ref);
+		node->lock.WriteUnlock();
+		// the node changed: the operation restarts, and finds the loaded child
+		restart = true;
+		return nullptr;
+	}
+	return child;
+}
+
+bool ART::Insert(unique_ptr<Key> &value, row_t row_id, bool verify_unique, bool &restart) {
 	Key &key = *value;
+	// the reference to the node is stored in its parent, which is locked to replace the node. The lock of the tree
+	// takes the place of the lock of the parent of the root.
+	Node *parent = nullptr;
+	index_t parent_pos = INVALID_INDEX;
+	OptimisticLock *parent_lock = &tree_lock;
+	uint64_t parent_version = tree_lock.ReadLockOrRestart(restart);
+	Node *node = tree.get();
 	if (!node) {
-		// node is currently empty, create a leaf here with the key
-		node = make_unique<Leaf>(*this, move(value), row_id);
+		// the tree is currently empty, create a leaf here with the key
+		tree_lock.UpgradeToWriteLockOrRestart(parent_version, restart);
+		if (restart) {
+			return false;
+		}
+		tree = make_unique<Leaf>(*this, move(value), row_id);
+		tree_lock.WriteUnlock();
 		return true;
 	}
 
-	if (node->type == NodeType::NLeaf) {
-		// Replace leaf with Node4 and store both leaves in it
-		auto leaf = static_cast<Leaf *>(node.get());
-
-		Key &existingKey = *leaf->value;
-		uint32_t newPrefixLength = 0;
-		// Leaf node is already there, update row_id vector
-		if (depth + newPrefixLength == maxPrefix) {
-			return InsertToLeaf(*leaf, row_id);
-		}
-		while (existingKey[depth + newPrefixLength] == key[depth + newPrefixLength]) {
-			newPrefixLength++;
-			// Leaf node is already there, update row_id vector
-			if (depth + newPrefixLength == maxPrefix) {
-				return InsertToLeaf(*leaf, row_id);
-			}
-		}
-		unique_ptr<Node> newNode = make_unique<Node4>(*this);
-		newNode->prefix_length = newPrefixLength;
-		memcpy(newNode->prefix.get(), &key[depth], std::min(newPrefixLength, maxPrefix));
-		Node4::insert(*this, newNode, existingKey[depth + newPrefixLength], node);
-		unique_ptr<Node> leaf_node = make_unique<Leaf>(*this, move(value), row_id);
-		Node4::insert(*this, newNode, key[depth + newPrefixLength], leaf_node);
-		node = move(newNode);
-		return true;
-	}
+	index_t depth = 0;
+	while (true) {
+		uint64_t version = node->lock.ReadLockOrRestart(restart);
+		parent_lock->CheckOrRestart(parent_version, restart);
+		if (restart) {
+			return false;
+		}
 
-	// Handle prefix of inner node
-	if (node->prefix_length) {
-		uint32_t mismatchPos = Node::PrefixMismatch(*this, node.get(), key, depth);
-		if (mismatchPos != node->prefix_length) {
-			// Prefix differs, create new node
-			unique_ptr<Node> newNode = make_unique<Node4>(*this);
-			newNode->prefix_length = mismatchPos;
-			memcpy(newNode->prefix.get(), node->prefix.get(), std::min(mismatchPos, maxPrefix));
-			// Break up prefix
-			if (node->prefix_length < maxPrefix) {
-				auto node_ptr = node.get();
-				Node4::insert(*this, newNode, node->prefix[mismatchPos], node);
-				node_ptr->prefix_length -= (mismatchPos + 1);
-				memmove(node_ptr->prefix.get(), node_ptr->prefix.get() + mismatchPos + 1,
-				        std::min(node_ptr->prefix_length, maxPrefix));
-			} else {
-				throw NotImplementedException("PrefixLength > MaxPrefixLength");
+		if (node->type == NodeType::NLeaf) {
+			auto leaf = static_cast<Leaf *>(node);
+			Key &existingKey = *leaf->value;
+			uint32_t newPrefixLength = 0;
+			// the keys are prefix-free: if the key matches the existing key up to its end the keys are equal
+			while (depth + newPrefixLength < key.len &&
+			       existingKey[depth + newPrefixLength] == key[depth + newPrefixLength]) {
+				newPrefixLength++;
 			}
+			if (depth + newPrefixLength == key.len) {
+				// Leaf node is already there, update row_id vector
+				leaf->lock.UpgradeToWriteLockOrRestart(version, restart);
+				if (restart) {
+					return false;
+				}
+				bool inserted = InsertToLeaf(*leaf, row_id, verify_unique);
+				leaf->lock.WriteUnlock();
+				return inserted;
+			}
+			// Replace leaf with Node4 and store both leaves in it, the leaf itself is not modified
+			parent_lock->UpgradeToWriteLockOrRestart(parent_version, restart);
+			if (restart) {
+				return false;
+			}
+			auto &node_ref = parent ? *parent->ReadChild(parent_pos) : tree;
+			unique_ptr<Node> newNode = make_unique<Node4>(*this);
+			newNode->SetPrefix(*this, key.data.get() + depth, newPrefixLength);
+			Node4::insert(*this, newNode, existingKey[depth + newPrefixLength], node_ref);
 			unique_ptr<Node> leaf_node = make_unique<Leaf>(*this, move(value), row_id);
+			Node4::insert(*this, newNode, key[depth + newPrefixLength], leaf_node);
+			node_ref = move(newNode);
+			parent_lock->WriteUnlock();
+			return true;
+		}
 
+		// Handle prefix of inner node
+		auto prefix = node->ReadPrefix(version, restart);
+		if (restart) {
+			return false;
+		}
+		uint32_t mismatchPos = Node::PrefixMismatch(prefix, key, depth);
+		if (mismatchPos != prefix.length) {
+			// Prefix differs, create new node that replaces the node in its parent
+			parent_lock->UpgradeToWriteLockOrRestart(parent_version, restart);
+			if (restart) {
+				return false;
+			}
+			node->lock.UpgradeToWriteLockOrRestart(version, restart);
+			if (restart) {
+				parent_lock->WriteUnlock();
+				return false;
+			}
+			auto &node_ref = parent ? *parent->ReadChild(parent_pos) : tree;
+			unique_ptr<Node> newNode = make_unique<Node4>(*this);
+			newNode->SetPrefix(*this, prefix.data, mismatchPos);
+			// Break up prefix
+			Node4::insert(*this, newNode, prefix.data[mismatchPos], node_ref);
+			node->SetPrefix(*this, prefix.data + mismatchPos + 1, prefix.length - (mismatchPos + 1));
+			unique_ptr<Node> leaf_node = make_unique<Leaf>(*this, move(value), row_id);
 			Node4::insert(*this, newNode, key[depth + mismatchPos], leaf_node);
-			node = move(newNode);
+			node_ref = move(newNode);
+			node->lock.WriteUnlock();
+			parent_lock->WriteUnlock();
+			return true;
+		}
+		depth += prefix.length;
+
+		index_t pos = node->GetChildPos(key[depth]);
+		if (pos == INVALID_INDEX) {
+			// add the leaf to the node: the node is replaced in its parent if it has to grow, so both are locked
+			parent_lock->UpgradeToWriteLockOrRestart(parent_version, restart);
+			if (restart) {
+				return false;
+			}
+			node->lock.UpgradeToWriteLockOrRestart(version, restart);
+			if (restart) {
+				parent_lock->WriteUnlock();
+				return false;
+			}
+			auto &node_ref = parent ? *parent->ReadChild(parent_pos) : tree;
+			unique_ptr<Node> newNode = make_unique<Leaf>(*this, move(value), row_id);
+			Node::InsertLeaf(*this, node_ref, key[depth], newNode);
+			if (node_ref.get() == node) {
+				// a node that grew was replaced, which already marked it as obsolete
+				node->lock.WriteUnlock();
+			}
+			parent_lock->WriteUnlock();
 			return true;
 		}
-		depth += node->prefix_length;
+		// Recurse
+		auto child = GetChildOrRestart(node, pos, version, restart);
+		if (restart) {
+			return false;
+		}
+		parent = node;
+		parent_pos = pos;
+		parent_lock = &node->lock;
+		parent_version = version;
+		node = child;
+		depth++;
 	}
+}
 
-	// Recurse
-	index_t pos = node->GetChildPos(key[depth]);
-	if (pos != INVALID_INDEX) {
-		auto child = node->GetChild(pos);
-		return Insert(*child, move(value), depth + 1, row_id);
+//===--------------------------------------------------------------------===//
+// Bulk Load
+//===--------------------------------------------------------------------===//
+//! Orders build entries by their key, and entries with the same key by their row id
+struct ARTBuildEntryCompare {
+	ARTBuildEntryCompare(data_ptr_t key_data) : key_data(key_data) {
 	}
 
-	unique_ptr<Node> newNode = make_unique<Leaf>(*this, move(value), row_id);
-	Node::InsertLeaf(*this, node, key[depth], newNode);
-	return true;
+	//! The data of the keys that are longer than the prefix of the entries
+	data_ptr_t key_data;
+
+	bool operator()(const ARTBuildEntry &a, const ARTBuildEntry &b) const {
+		if (a.prefix != b.prefix) {
+			return a.prefix < b.prefix;
+		}
+		// the keys are prefix-free, so keys with the same prefix are either equal or both longer than the prefix
+		if (a.length > sizeof(a.prefix)) {
+			assert(b.length > sizeof(b.prefix));
+			auto cmp = memcmp(key_data + a.offset + sizeof(a.prefix), key_data + b.offset + sizeof(b.prefix),
+			                  std::min(a.length, b.length) - sizeof(a.prefix));
+			if (cmp != 0) {
+				return cmp < 0;
+			}
+			if (a.length != b.length) {
+				return a.length < b.length;
+			}
+		}
+		return a.row_id < b.row_id;
+	}
+};
+
+static bool build_keys_equal(ARTBuildEntry &a, ARTBuildEntry &b, data_ptr_t key_data) {
+	if (a.prefix != b.prefix || a.length != b.length) {
+		return false;
+	}
+	return a.length <= sizeof(a.prefix) || memcmp(key_data + a.offset + sizeof(a.prefix),
+	                                              key_data + b.offset + sizeof(b.prefix),
+	                                              a.length - sizeof(a.prefix)) == 0;
+}
+
+void ART::BuildAppend(DataChunk &input, Vector &row_ids) {
+	assert(row_ids.type == TypeId::BIGINT);
+	assert(input.size() == row_ids.count);
+
+	index_t count = input.size();
+	index_t key_sizes[STANDARD_VECTOR_SIZE];
+	index_t key_offsets[STANDARD_VECTOR_SIZE];
+	data_ptr_t key_data[STANDARD_VECTOR_SIZE];
+	memset(key_sizes, 0, count * sizeof(index_t));
+	for (index_t i = 0; i < input.column_count; i++) {
+		compute_key_sizes(input.data[i], key_sizes);
+	}
+	// encode the keys of the chunk into the key data of the bulk load
+	index_t data_start = build_key_data.size();
+	index_t data_end = data_start;
+	bool has_long_keys = false;
+	for (index_t k = 0; k < count; k++) {
+		if (key_sizes[k] != INVALID_INDEX) {
+			key_offsets[k] = data_end;
+			data_end += key_sizes[k];
+			has_long_keys = has_long_keys || key_sizes[k] > sizeof(ARTBuildEntry::prefix);
+		}
+	}
+	build_key_data.resize(data_end);
+	for (index_t k = 0; k < count; k++) {
+		key_data[k] = key_sizes[k] == INVALID_INDEX ? nullptr : build_key_data.data() + key_offsets[k];
+	}
+	for (index_t i = 0; i < input.column_count; i++) {
+		encode_column(input.data[i], key_data, is_little_endian);
+	}
+
+	auto row_identifiers = (row_t *)row_ids.data;
+	for (index_t k = 0; k < count; k++) {
+		if (key_sizes[k] == INVALID_INDEX) {
+			continue;
+		}
+		ARTBuildEntry entry;
+		auto data = build_key_data.data() + key_offsets[k];
+		entry.prefix = 0;
+		for (index_t byte = 0; byte < sizeof(entry.prefix); byte++) {
+			entry.prefix = (entry.prefix << 8) | (byte < key_sizes[k] ? data[byte] : 0);
+		}
+		entry.offset = key_offsets[k];
+		entry.length = key_sizes[k];
+		entry.row_id = row_identifiers[row_ids.sel_vector ? row_ids.sel_vector[k] : k];
+		build_entries.push_back(entry);
+	}
+	if (!has_long_keys) {
+		// all keys of the chunk are held completely by the prefix of their entry
+		build_key_data.resize(data_start);
+	}
+}
+
+void ART::FinalizeBuild() {
+	assert(!tree);
+	if (build_entries.size() > 0) {
+		SortBuildEntries();
+		tree = Construct(0, build_entries.size(), 0);
+	}
+	// free the memory of the collected entries
+	vector<ARTBuildEntry>().swap(build_entries);
+	vector<data_t>().swap(build_key_data);
+}
+
+void ART::SortBuildEntries() {
+	auto &scheduler = *table.storage.database.scheduler;
+	index_t count = build_entries.size();
+	index_t threads = scheduler.NumberOfThreads();
+	ARTBuildEntryCompare compare(build_key_data.data());
+	if (threads == 1 || count < PARALLEL_SORT_THRESHOLD) {
+		sort(build_entries.begin(), build_entries.end(), compare);
+		return;
+	}
+	auto entries = build_entries.data();
+	// first sort a run of the entries per thread
+	vector<index_t> run_bounds;
+	vector<task_function_t> tasks;
+	for (index_t i = 0; i < threads; i++) {
+		run_bounds.push_back(count * i / threads);
+	}
+	run_bounds.push_back(count);
+	for (index_t i = 0; i < threads; i++) {
+		auto begin = entries + run_bounds[i], end = entries + run_bounds[i + 1];
+		tasks.push_back([begin, end, compare]() { sort(begin, end, compare); });
+	}
+	scheduler.ExecuteTasks(move(tasks));
+	// then merge pairs of adjacent runs until a single run is left
+	while (run_bounds.size() > 2) {
+		index_t run_count = run_bounds.size() - 1;
+		vector<index_t> merged_bounds;
+		tasks.clear();
+		for (index_t i = 0; i + 1 < run_count; i += 2) {
+			auto begin = entries + run_bounds[i], middle = entries + run_bounds[i + 1],
+			     end = entries + run_bounds[i + 2];
+			tasks.push_back([begin, middle, end, compare]() { inplace_merge(begin, middle, end, compare); });
+			merged_bounds.push_back(run_bounds[i]);
+		}
+		if (run_count % 2 == 1) {
+			// the last run has no partner to be merged with in this round
+			merged_bounds.push_back(run_bounds[run_count - 1]);
+		}
+		merged_bounds.push_back(count);
+		scheduler.ExecuteTasks(move(tasks));
+		run_bounds = move(merged_bounds);
+	}
+}
+
+unique_ptr<Node> ART::Construct(index_t start, index_t end, index_t depth) {
+	auto &first = build_entries[start];
+	auto &last = build_entries[end - 1];
+	if (build_keys_equal(first, last, build_key_data.data())) {
+		// all entries have the same key: they are stored in a single leaf
+		if (is_unique && end - start > 1) {
+			throw ConstraintException("duplicate key value violates primary key or unique constraint");
+		}
+		auto key_data = unique_ptr<data_t[]>(new data_t[first.length]);
+		for (index_t i = 0; i < first.length; i++) {
+			key_data[i] = GetKeyByte(first, i);
+		}
+		auto leaf = make_unique<Leaf>(*this, make_unique<Key>(move(key_data), first.length), first.row_id);
+		for (index_t i = start + 1; i < end; i++) {
+			leaf->Insert(*this, build_entries[i].row_id);
+		}
+		return move(leaf);
+	}
+	// the entries are sorted, so they share all bytes up to the first byte in which the first and the last entry differ
+	index_t mismatch = depth;
+	while (GetKeyByte(first, mismatch) == GetKeyByte(last, mismatch)) {
+		mismatch++;
+	}
+	// count the children first, so a node of the right size is created up front
+	index_t child_count = 1;
+	for (index_t i = start + 1; i < end; i++) {
+		if (GetKeyByte(build_entries[i], mismatch) != GetKeyByte(build_entries[i - 1], mismatch)) {
+			child_count++;
+		}
+	}
+	unique_ptr<Node> node;
+	if (child_count <= 4) {
+		node = make_unique<Node4>(*this);
+	} else if (child_count <= 16) {
+		node = make_unique<Node16>(*this);
+	} else if (child_count <= 48) {
+		node = make_unique<Node48>(*this);
+	} else {
+		node = make_unique<Node256>(*this);
+	}
+	if (mismatch > depth) {
+		node->prefix_length = mismatch - depth;
+		node->prefix = unique_ptr<uint8_t[]>(new uint8_t[node->prefix_length]);
+		for (index_t i = 0; i < node->prefix_length; i++) {
+			node->prefix[i] = GetKeyByte(first, depth + i);
+		}
+	}
+	// every group of entries with the same byte at the mismatch position forms a child of the node
+	index_t group_start = start;
+	for (index_t i = start + 1; i <= end; i++) {
+		uint8_t group_byte = GetKeyByte(build_entries[group_start], mismatch);
+		if (i == end || GetKeyByte(build_entries[i], mismatch) != group_byte) {
+			auto child = Construct(group_start, i, mismatch + 1);
+			Node::InsertLeaf(*this, node, group_byte, child);
+			group_start = i;
+		}
+	}
+	return node;
+}
+
+//===--------------------------------------------------------------------===//
+// Storage
+//===--------------------------------------------------------------------===//
+void ART::LoadFromStorage(IndexPointer pointer) {
+	assert(!tree);
+	if (pointer.block_id != INVALID_BLOCK) {
+		tree = PersistentNode(*this, pointer.block_id, pointer.offset).Load();
+	}
+	persistent_pointer = move(pointer);
+}
+
+IndexPointer ART::WriteToStorage(BlockManager &manager) {
+	IndexPointer result;
+	if (!tree) {
+		return result;
+	}
+	MetaBlockWriter writer(manager);
+	PersistentNode::Write(*this, *tree, writer, result.block_id, result.offset);
+	writer.Flush();
+	result.blocks = writer.written_blocks;
+	return result;
 }
 
 //===--------------------------------------------------------------------===//
 // Delete
 //===--------------------------------------------------------------------===//
 void ART::Delete(DataChunk &input, Vector &row_ids) {
-	lock_guard<mutex> l(lock);
-
 	// first resolve the expressions
+	DataChunk expression_result;
+	expression_result.Initialize(types);
 	ExecuteExpressions(input, expression_result);
 
 	// then generate the keys for the given input
@@ -258,166 +679,274 @@ void ART::Delete(DataChunk &input, Vector &row_ids) {
 	GenerateKeys(expression_result, keys);
 
 	// now erase the elements from the database
+	EpochGuard guard(epochs);
 	auto row_identifiers = (int64_t *)row_ids.data;
 	VectorOperations::Exec(row_ids, [&](index_t i, index_t k) {
 		if (!keys[k]) {
 			return;
 		}
-		Erase(tree, *keys[k], 0, row_identifiers[i]);
+		bool restart;
+		do {
+			restart = false;
+			Erase(*keys[k], row_identifiers[i], restart);
+		} while (restart);
 	});
 }
 
-void ART::Erase(unique_ptr<Node> &node, Key &key, unsigned depth, row_t row_id) {
+void ART::Erase(Key &key, row_t row_id, bool &restart) {
+	uint64_t tree_version = tree_lock.ReadLockOrRestart(restart);
+	Node *node = tree.get();
 	if (!node) {
+		tree_lock.CheckOrRestart(tree_version, restart);
+		return;
+	}
+	uint64_t version = node->lock.ReadLockOrRestart(restart);
+	tree_lock.CheckOrRestart(tree_version, restart);
+	if (restart) {
 		return;
 	}
 	// Delete a leaf from a tree
 	if (node->type == NodeType::NLeaf) {
 		// Make sure we have the right leaf
-		if (ART::LeafMatches(node.get(), key, depth)) {
-			node.reset();
+		if (!LeafMatches(node, key, 0)) {
+			node->lock.CheckOrRestart(version, restart);
+			return;
+		}
+		auto leaf = static_cast<Leaf *>(node);
+		if (leaf->num_elements > 1) {
+			// leaf has multiple rows: remove the row from the leaf
+			leaf->lock.UpgradeToWriteLockOrRestart(version, restart);
+			if (restart) {
+				return;
+			}
+			leaf->Remove(row_id);
+			leaf->lock.WriteUnlock();
+			return;
 		}
+		tree_lock.UpgradeToWriteLockOrRestart(tree_version, restart);
+		if (restart) {
+			return;
+		}
+		leaf->lock.UpgradeToWriteLockOrRestart(version, restart);
+		if (restart) {
+			tree_lock.WriteUnlock();
+			return;
+		}
+		ReplaceNode(tree, nullptr);
+		tree_lock.WriteUnlock();
 		return;
 	}
 
-	// Handle prefix
-	if (node->prefix_length) {
-		if (Node::PrefixMismatch(*this, node.get(), key, depth) != node->prefix_length) {
+	// the node is erased from through its reference in the parent, which is locked when the node is modified. The lock
+	// of the tree takes the place of the lock of the parent of the root.
+	Node *parent = nullptr;
+	index_t parent_pos = INVALID_INDEX;
+	OptimisticLock *parent_lock = &tree_lock;
+	uint64_t parent_version = tree_version;
+	index_t depth = 0;
+	while (true) {
+		// Handle prefix
+		auto prefix = node->ReadPrefix(version, restart);
+		if (restart) {
 			return;
 		}
-		depth += node->prefix_length;
-	}
-	index_t pos = node->GetChildPos(key[depth]);
-	if (pos != INVALID_INDEX) {
-		auto child = node->GetChild(pos);
-		assert(child);
-
-		unique_ptr<Node> &child_ref = *child;
-		if (child_ref->type == NodeType::NLeaf && LeafMatches(child_ref.get(), key, depth)) {
-			// Leaf found, remove entry
-			auto leaf = static_cast<Leaf *>(child_ref.get());
-			if (leaf->num_elements > 1) {
-				// leaf has multiple rows: remove the row from the leaf
-				leaf->Remove(row_id);
-			} else {
-				// Leaf only has one element, delete leaf, decrement node counter and maybe shrink node
-				Node::Erase(*this, node, pos);
-			}
-		} else {
+		if (Node::PrefixMismatch(prefix, key, depth) != prefix.length) {
+			return;
+		}
+		depth += prefix.length;
+		index_t pos = node->GetChildPos(key[depth]);
+		if (pos == INVALID_INDEX) {
+			node->lock.CheckOrRestart(version, restart);
+			return;
+		}
+		auto child = GetChildOrRestart(node, pos, version, restart);
+		if (restart) {
+			return;
+		}
+		uint64_t child_version = child->lock.ReadLockOrRestart(restart);
+		node->lock.CheckOrRestart(version, restart);
+		if (restart) {
+			return;
+		}
+		if (child->type != NodeType::NLeaf) {
 			// Recurse
-			Erase(*child, key, depth + 1, row_id);
+			parent = node;
+			parent_pos = pos;
+			parent_lock = &node->lock;
+			parent_version = version;
+			node = child;
+			version = child_version;
+			depth++;
+			continue;
+		}
+		// Make sure we have the right leaf
+		auto leaf = static_cast<Leaf *>(child);
+		if (!LeafMatches(leaf, key, depth)) {
+			leaf->lock.CheckOrRestart(child_version, restart);
+			return;
+		}
+		if (leaf->num_elements > 1) {
+			// leaf has multiple rows: remove the row from the leaf
+			leaf->lock.UpgradeToWriteLockOrRestart(child_version, restart);
+			if (restart) {
+				return;
+			}
+			leaf->Remove(row_id);
+			leaf->lock.WriteUnlock();
+			return;
+		}
+		// Leaf only has one element, delete leaf, decrement node counter and maybe shrink node. A Node4 with two
+		// children is replaced by its other child, whose prefix is extended if it is an inner node.
+		Node *other = nullptr;
+		uint64_t other_version = 0;
+		if (node->type == NodeType::N4 && node->count == 2) {
+			other = GetChildOrRestart(node, pos == 0 ? 1 : 0, version, restart);
+			if (restart) {
+				return;
+			}
+			other_version = other->lock.ReadLockOrRestart(restart);
+			node->lock.CheckOrRestart(version, restart);
+			if (restart) {
+				return;
+			}
+			if (other->type == NodeType::NLeaf) {
+				// leaves store their complete key, the prefix of a leaf is not used
+				other = nullptr;
+			}
+		}
+		parent_lock->UpgradeToWriteLockOrRestart(parent_version, restart);
+		if (restart) {
+			return;
+		}
+		node->lock.UpgradeToWriteLockOrRestart(version, restart);
+		if (restart) {
+			parent_lock->WriteUnlock();
+			return;
+		}
+		leaf->lock.UpgradeToWriteLockOrRestart(child_version, restart);
+		if (restart) {
+			node->lock.WriteUnlock();
+			parent_lock->WriteUnlock();
+			return;
+		}
+		if (other) {
+			other->lock.UpgradeToWriteLockOrRestart(other_version, restart);
+			if (restart) {
+				leaf->lock.WriteUnlock();
+				node->lock.WriteUnlock();
+				parent_lock->WriteUnlock();
+				return;
+			}
 		}
+		// concurrent operations on the leaf restart once it is marked as obsolete
+		leaf->lock.WriteUnlockObsolete();
+		auto &node_ref = parent ? *parent->ReadChild(parent_pos) : tree;
+		Node::Erase(*this, node_ref, pos);
+		if (other) {
+			other->lock.WriteUnlock();
+		}
+		if (node_ref.get() == node) {
+			// a node that shrunk was replaced, which already marked it as obsolete
+			node->lock.WriteUnlock();
+		}
+		parent_lock->WriteUnlock();
+		return;
 	}
 }
 
 //===--------------------------------------------------------------------===//
 // Point Query
 //===--------------------------------------------------------------------===//
-static unique_ptr<Key> CreateKey(ART &art, TypeId type, Value &value) {
-	assert(type == value.type);
-	switch (type) {
-	case TypeId::TINYINT:
-		return Key::CreateKey<int8_t>(value.value_.tinyint, art.is_little_endian);
-	case TypeId::SMALLINT:
-		return Key::CreateKey<int16_t>(value.value_.smallint, art.is_little_endian);
-	case TypeId::INTEGER:
-		return Key::CreateKey<int32_t>(value.value_.integer, art.is_little_endian);
-	case TypeId::BIGINT:
-		return Key::CreateKey<int64_t>(value.value_.bigint, art.is_little_endian);
-	default:
-		throw InvalidTypeException(type, "Invalid type for index");
+unique_ptr<Key> ART::CreateKey(vector<Value> &values) {
+	assert(values.size() == types.size());
+	// the key is generated from a chunk with a single row, so it is encoded exactly like the keys stored in the index
+	DataChunk input;
+	input.Initialize(types);
+	for (index_t i = 0; i < types.size(); i++) {
+		input.data[i].count = 1;
+		input.data[i].SetValue(0, values[i].type == types[i] ? values[i] : values[i].CastAs(types[i]));
 	}
+	vector<unique_ptr<Key>> keys;
+	GenerateKeys(input, keys);
+	return move(keys[0]);
 }
 
-void ART::SearchEqual(vector<row_t> &result_ids, ARTIndexScanState *state) {
-	unique_ptr<Key> key = CreateKey(*this, types[0], state->values[0]);
-	auto leaf = static_cast<Leaf *>(Lookup(tree, *key, 0));
-	if (!leaf) {
+void ART::Lookup(Key &key, vector<row_t> &result_ids, bool &restart) {
+	uint64_t tree_version = tree_lock.ReadLockOrRestart(restart);
+	Node *node = tree.get();
+	if (!node) {
+		tree_lock.CheckOrRestart(tree_version, restart);
 		return;
 	}
-	for (index_t i = 0; i < leaf->num_elements; i++) {
-		row_t row_id = leaf->GetRowId(i);
-		result_ids.push_back(row_id);
+	uint64_t version = node->lock.ReadLockOrRestart(restart);
+	tree_lock.CheckOrRestart(tree_version, restart);
+	if (restart) {
+		return;
 	}
-}
-
-Node *ART::Lookup(unique_ptr<Node> &node, Key &key, unsigned depth) {
-	bool skippedPrefix = false; // Did we optimistically skip some prefix without checking it?
-	auto node_val = node.get();
 
-	while (node_val) {
-		if (node_val->type == NodeType::NLeaf) {
-			if (!skippedPrefix && depth == maxPrefix) {
-				// No check required
-				return node_val;
-			}
-
-			if (depth != maxPrefix) {
-				// Check leaf
-				auto leaf = static_cast<Leaf *>(node_val);
-				Key &leafKey = *leaf->value;
-				for (index_t i = (skippedPrefix ? 0 : depth); i < maxPrefix; i++) {
-					if (leafKey[i] != key[i]) {
-						return nullptr;
-					}
-				}
+	index_t depth = 0;
+	while (true) {
+		if (node->type == NodeType::NLeaf) {
+			// the leaf stores the complete key: check the part of the key below the current depth
+			if (LeafMatches(node, key, depth)) {
+				static_cast<Leaf *>(node)->ReadRowIds(version, result_ids, restart);
 			}
-			return node_val;
+			return;
 		}
-
-		if (node_val->prefix_length) {
-			if (node_val->prefix_length < maxPrefix) {
-				for (index_t pos = 0; pos < node_val->prefix_length; pos++) {
-					if (key[depth + pos] != node_val->prefix[pos]) {
-						return nullptr;
-					}
-				}
-			} else {
-				skippedPrefix = true;
-			}
-			depth += node_val->prefix_length;
+		auto prefix = node->ReadPrefix(version, restart);
+		if (restart) {
+			return;
+		}
+		if (Node::PrefixMismatch(prefix, key, depth) != prefix.length) {
+			return;
 		}
-		index_t pos = node_val->GetChildPos(key[depth]);
+		depth += prefix.length;
+		index_t pos = node->GetChildPos(key[depth]);
 		if (pos == INVALID_INDEX) {
-			return nullptr;
+			node->lock.CheckOrRestart(version, restart);
+			return;
 		}
-		node_val = node_val->GetChild(pos)->get();
-		assert(node_val);
-
+		auto child = GetChildOrRestart(node, pos, version, restart);
+		if (restart) {
+			return;
+		}
+		uint64_t child_version = child->lock.ReadLockOrRestart(restart);
+		node->lock.CheckOrRestart(version, restart);
+		if (restart) {
+			return;
+		}
+		node = child;
+		version = child_version;
 		depth++;
 	}
-
-	return nullptr;
 }
 
 //===--------------------------------------------------------------------===//
 // Iterator scans
 //===--------------------------------------------------------------------===//
-template <bool HAS_BOUND, bool INCLUSIVE>
-void ART::IteratorScan(ARTIndexScanState *state, Iterator *it, vector<row_t> &result_ids, Key *bound) {
-	bool has_next;
-	do {
-		if (HAS_BOUND) {
-			assert(bound);
-			if (INCLUSIVE) {
-				if (*it->node->value > *bound) {
-					break;
-				}
-			} else {
-				if (*it->node->value >= *bound) {
-					break;
-				}
-			}
+bool ART::FindMinimum(Iterator &it, Node *node, uint64_t version, bool &restart) {
+	while (node->type != NodeType::NLeaf) {
+		// the first child of an inner node holds the smallest keys
+		index_t pos = node->GetNextPos(INVALID_INDEX);
+		auto child = GetChildOrRestart(node, pos, version, restart);
+		if (restart) {
+			return false;
 		}
-		for (index_t i = 0; i < it->node->num_elements; i++) {
-			row_t row_id = it->node->GetRowId(i);
-			result_ids.push_back(row_id);
+		uint64_t child_version = child->lock.ReadLockOrRestart(restart);
+		node->lock.CheckOrRestart(version, restart);
+		if (restart) {
+			return false;
 		}
-		has_next = ART::IteratorNext(*it);
-	} while (has_next);
+		it.Push(node, pos, version);
+		node = child;
+		version = child_version;
+	}
+	it.node = (Leaf *)node;
+	it.version = version;
+	return true;
 }
 
-bool ART::IteratorNext(Iterator &it) {
+bool ART::IteratorNext(Iterator &it, bool &restart) {
 	// Skip leaf
 	if ((it.depth) && ((it.stack[it.depth - 1].node)->type == NodeType::NLeaf)) {
 		it.depth--;
@@ -431,261 +960,254 @@ bool ART::IteratorNext(Iterator &it) {
 		if (node->type == NodeType::NLeaf) {
 			// found a leaf: move to next node
 			it.node = (Leaf *)node;
+			it.version = top.version;
 			return true;
 		}
 
-		// Find next node
+		// Find next node, the positions of the node are only valid as long as its version is unchanged
 		top.pos = node->GetNextPos(top.pos);
 		if (top.pos != INVALID_INDEX) {
 			// next node found: go there
-			it.stack[it.depth].node = node->GetChild(top.pos)->get();
-			it.stack[it.depth].pos = INVALID_INDEX;
-			it.depth++;
+			auto child = GetChildOrRestart(node, top.pos, top.version, restart);
+			if (restart) {
+				return false;
+			}
+			uint64_t child_version = child->lock.ReadLockOrRestart(restart);
+			node->lock.CheckOrRestart(top.version, restart);
+			if (restart) {
+				return false;
+			}
+			it.Push(child, INVALID_INDEX, child_version);
 		} else {
 			// no node found: move up the tree
+			node->lock.CheckOrRestart(top.version, restart);
+			if (restart) {
+				return false;
+			}
 			it.depth--;
 		}
 	}
 	return false;
 }
 
-//===--------------------------------------------------------------------===//
-// Greater Than
-//===--------------------------------------------------------------------===//
-bool ART::Bound(unique_ptr<Node> &n, Key &key, Iterator &it, bool inclusive) {
+bool ART::Bound(Key *key, Iterator &it, bool inclusive, bool &restart) {
 	it.depth = 0;
-	if (!n) {
+	uint64_t tree_version = tree_lock.ReadLockOrRestart(restart);
+	Node *node = tree.get();
+	if (!node) {
+		tree_lock.CheckOrRestart(tree_version, restart);
+		return false;
+	}
+	uint64_t version = node->lock.ReadLockOrRestart(restart);
+	tree_lock.CheckOrRestart(tree_version, restart);
+	if (restart) {
 		return false;
 	}
-	Node *node = n.get();
+	if (!key) {
+		return FindMinimum(it, node, version, restart);
+	}
 
 	index_t depth = 0;
 	while (true) {
-		auto &top = it.stack[it.depth];
-		top.node = node;
-		it.depth++;
+		it.Push(node, INVALID_INDEX, version);
+		auto &top = it.stack[it.depth - 1];
 
 		if (node->type == NodeType::NLeaf) {
-			// found a leaf node: check if it is bigger than the current key
+			// found a leaf node: check if it satisfies the bound
 			auto leaf = static_cast<Leaf *>(node);
 			it.node = leaf;
-			if (key > *leaf->value) {
-				// the key is bigger than the min_key
-				// in this case there are no keys in the set that are bigger than key
-				// thus we terminate
-				return false;
-			}
-			// if the search is not inclusive the leaf node could still be equal to the current value
-			// check if leaf is equal to the current key
-			if (!inclusive && *leaf->value == key) {
-				// leaf is equal: move to next node
-				if (!IteratorNext(it)) {
-					return false;
-				}
+			it.version = version;
+			if (*key > *leaf->value || (!inclusive && *key == *leaf->value)) {
+				// the leaf is smaller than the bound: the first leaf that satisfies it is the next leaf
+				return IteratorNext(it, restart);
 			}
 			return true;
 		}
-		uint32_t mismatchPos = Node::PrefixMismatch(*this, node, key, depth);
-		if (mismatchPos != node->prefix_length) {
-			if (node->prefix[mismatchPos] < key[depth + mismatchPos]) {
+		auto prefix = node->ReadPrefix(version, restart);
+		if (restart) {
+			return false;
+		}
+		uint32_t mismatchPos = Node::PrefixMismatch(prefix, *key, depth);
+		if (mismatchPos != prefix.length) {
+			if (prefix.data[mismatchPos] < (*key)[depth + mismatchPos]) {
 				// Less
 				it.depth--;
-				return IteratorNext(it);
+				return IteratorNext(it, restart);
 			} else {
 				// Greater
 				top.pos = INVALID_INDEX;
-				return IteratorNext(it);
+				return IteratorNext(it, restart);
 			}
 		}
 		// prefix matches, search inside the child for the key
-		depth += node->prefix_length;
+		depth += prefix.length;
 
-		top.pos = node->GetChildGreaterEqual(key[depth]);
+		top.pos = node->GetChildGreaterEqual((*key)[depth]);
 		if (top.pos == INVALID_INDEX) {
-			// no node that is >= to the current node: abort
+			// all children are smaller than the key: the first leaf that satisfies the bound follows this node
+			node->lock.CheckOrRestart(version, restart);
+			if (restart) {
+				return false;
+			}
+			it.depth--;
+			return IteratorNext(it, restart);
+		}
+		bool exact_match = node->GetChildPos((*key)[depth]) == top.pos;
+		auto child = GetChildOrRestart(node, top.pos, version, restart);
+		if (restart) {
+			return false;
+		}
+		uint64_t child_version = child->lock.ReadLockOrRestart(restart);
+		node->lock.CheckOrRestart(version, restart);
+		if (restart) {
 			return false;
 		}
-		node = node->GetChild(top.pos)->get();
+		if (!exact_match) {
+			// the child is bigger than the key: all of its leaves satisfy the bound
+			return FindMinimum(it, child, child_version, restart);
+		}
+		node = child;
+		version = child_version;
 		depth++;
 	}
 }
 
-void ART::SearchGreater(vector<row_t> &result_ids, ARTIndexScanState *state, bool inclusive) {
-	Iterator *it = &state->iterator;
-	auto key = CreateKey(*this, types[0], state->values[0]);
-
-	// greater than scan: first set the iterator to the node at which we will start our scan by finding the lowest node
-	// that satisfies our requirement
-	if (!it->start) {
-		bool found = ART::Bound(tree, *key, *it, inclusive);
-		if (!found) {
-			return;
-		}
-		it->start = true;
+void ART::InitializeBounds(ARTIndexScanState &state) {
+	state.checked = true;
+	if (state.expressions[0] == ExpressionType::COMPARE_EQUAL) {
+		state.lower_bound = CreateKey(state.values[0]);
+		// comparisons with NULL never match
+		state.exhausted = !state.lower_bound;
+		return;
 	}
-	// after that we continue the scan; we don't need to check the bounds as any value following this value is
-	// automatically bigger and hence satisfies our predicate
-	IteratorScan<false, false>(state, it, result_ids, nullptr);
-}
-
-//===--------------------------------------------------------------------===//
-// Less Than
-//===--------------------------------------------------------------------===//
-static Leaf &FindMinimum(Iterator &it, Node &node) {
-	Node *next = nullptr;
-	index_t pos = 0;
-	switch (node.type) {
-	case NodeType::NLeaf:
-		it.node = (Leaf *)&node;
-		return (Leaf &)node;
-	case NodeType::N4:
-		next = ((Node4 &)node).child[0].get();
-		break;
-	case NodeType::N16:
-		next = ((Node16 &)node).child[0].get();
-		break;
-	case NodeType::N48: {
-		auto &n48 = (Node48 &)node;
-		while (n48.childIndex[pos] == Node::EMPTY_MARKER) {
-			pos++;
+	for (index_t i = 0; i < 2; i++) {
+		if (state.values[i].empty()) {
+			continue;
 		}
-		next = n48.child[n48.childIndex[pos]].get();
-		break;
-	}
-	case NodeType::N256: {
-		auto &n256 = (Node256 &)node;
-		while (!n256.child[pos]) {
-			pos++;
+		auto key = CreateKey(state.values[i]);
+		if (!key) {
+			state.exhausted = true;
+			return;
+		}
+		switch (state.expressions[i]) {
+		case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+		case ExpressionType::COMPARE_GREATERTHAN:
+			state.lower_bound = move(key);
+			state.lower_inclusive = state.expressions[i] == ExpressionType::COMPARE_GREATERTHANOREQUALTO;
+			break;
+		case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		case ExpressionType::COMPARE_LESSTHAN:
+			state.upper_bound = move(key);
+			state.upper_inclusive = state.expressions[i] == ExpressionType::COMPARE_LESSTHANOREQUALTO;
+			break;
+		default:
+			throw NotImplementedException("Operation not implemented");
 		}
-		next = n256.child[pos].get();
-		break;
-	}
 	}
-	it.stack[it.depth].node = &node;
-	it.stack[it.depth].pos = pos;
-	it.depth++;
-	return FindMinimum(it, *next);
 }
 
-void ART::SearchLess(vector<row_t> &result_ids, ARTIndexScanState *state, bool inclusive) {
-	if (!tree) {
+void ART::ScanNextBatch(ARTIndexScanState &state) {
+	// the nodes that the scan reads are not freed until the batch is collected
+	EpochGuard guard(epochs);
+	auto &it = state.iterator;
+	state.result_ids.clear();
+	state.result_index = 0;
+
+	bool restart;
+	if (state.expressions[0] == ExpressionType::COMPARE_EQUAL) {
+		// an equality scan returns the row ids of a single leaf
+		state.exhausted = true;
+		do {
+			restart = false;
+			state.result_ids.clear();
+			Lookup(*state.lower_bound, state.result_ids, restart);
+		} while (restart);
+		state.result_ids.erase(remove_if(state.result_ids.begin(), state.result_ids.end(),
+		                                 [&](row_t row_id) { return (index_t)row_id >= state.row_count; }),
+		                       state.result_ids.end());
+		// a row id is stored twice in a leaf if the row is updated to the key it already has
+		sort(state.result_ids.begin(), state.result_ids.end());
+		state.result_ids.erase(unique(state.result_ids.begin(), state.result_ids.end()), state.result_ids.end());
 		return;
 	}
 
-	Iterator *it = &state->iterator;
-	auto upper_bound = CreateKey(*this, types[0], state->values[0]);
-
-	if (!it->start) {
-		// first find the minimum value in the ART: we start scanning from this value
-		auto &minimum = FindMinimum(state->iterator, *tree);
-		// early out min value higher than upper bound query
-		if (*minimum.value > *upper_bound) {
-			return;
-		}
-		it->start = true;
-	}
-	// now continue the scan until we reach the upper bound
-	if (inclusive) {
-		IteratorScan<true, true>(state, it, result_ids, upper_bound.get());
-	} else {
-		IteratorScan<true, false>(state, it, result_ids, upper_bound.get());
-	}
-}
-
-//===--------------------------------------------------------------------===//
-// Closed Range Query
-//===--------------------------------------------------------------------===//
-void ART::SearchCloseRange(vector<row_t> &result_ids, ARTIndexScanState *state, bool left_inclusive,
-                           bool right_inclusive) {
-	auto lower_bound = CreateKey(*this, types[0], state->values[0]);
-	auto upper_bound = CreateKey(*this, types[0], state->values[1]);
-	Iterator *it = &state->iterator;
-	// first find the first node that satisfies the left predicate
-	if (!it->start) {
-		bool found = ART::Bound(tree, *lower_bound, *it, left_inclusive);
-		if (!found) {
-			return;
+	// the key of the last leaf whose row ids were collected; the leaf cannot be freed before the batch is collected
+	Key *last_key = state.last_key.get();
+	vector<row_t> row_ids;
+	do {
+		restart = false;
+		// position the iterator at the leaf that follows the last collected leaf; it is positioned again for every
+		// batch and after every restart, because concurrent writers can replace the nodes it points to
+		bool found = last_key ? Bound(last_key, it, false, restart)
+		                      : Bound(state.lower_bound.get(), it, state.lower_inclusive, restart);
+		while (found && !restart) {
+			auto leaf = it.node;
+			if (state.upper_bound) {
+				if (state.upper_inclusive ? *leaf->value > *state.upper_bound : *leaf->value >= *state.upper_bound) {
+					// the scan is exhausted, unless the leaf was removed in the meantime
+					leaf->lock.CheckOrRestart(it.version, restart);
+					break;
+				}
+			}
+			row_ids.clear();
+			leaf->ReadRowIds(it.version, row_ids, restart);
+			if (restart) {
+				break;
+			}
+			for (auto row_id : row_ids) {
+				if ((index_t)row_id < state.row_count && state.collected_ids.Insert(row_id)) {
+					state.result_ids.push_back(row_id);
+				}
+			}
+			last_key = leaf->value.get();
+			if (state.result_ids.size() >= STANDARD_VECTOR_SIZE) {
+				// the batch is full: remember where to continue, the leaf itself might be removed before the next batch
+				auto key_data = unique_ptr<data_t[]>(new data_t[last_key->len]);
+				memcpy(key_data.get(), last_key->data.get(), last_key->len);
+				state.last_key = make_unique<Key>(move(key_data), last_key->len);
+				return;
+			}
+			found = IteratorNext(it, restart);
 		}
-		it->start = true;
-	}
-	// now continue the scan until we reach the upper bound
-	if (right_inclusive) {
-		IteratorScan<true, true>(state, it, result_ids, upper_bound.get());
-	} else {
-		IteratorScan<true, false>(state, it, result_ids, upper_bound.get());
-	}
+	} while (restart);
+	state.exhausted = true;
 }
 
 void ART::Scan(Transaction &transaction, IndexScanState *ss, DataChunk &result) {
 	auto state = (ARTIndexScanState *)ss;
 
-	// scan the index
-	if (!state->checked) {
-		vector<row_t> result_ids;
-		assert(state->values[0].type == types[0]);
-
-		if (state->values[1].is_null) {
-			lock_guard<mutex> l(lock);
-			// single predicate
-			switch (state->expressions[0]) {
-			case ExpressionType::COMPARE_EQUAL:
-				SearchEqual(result_ids, state);
-				break;
-			case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
-				SearchGreater(result_ids, state, true);
-				break;
-			case ExpressionType::COMPARE_GREATERTHAN:
-				SearchGreater(result_ids, state, false);
-				break;
-			case ExpressionType::COMPARE_LESSTHANOREQUALTO:
-				SearchLess(result_ids, state, true);
-				break;
-			case ExpressionType::COMPARE_LESSTHAN:
-				SearchLess(result_ids, state, false);
-				break;
-			default:
-				throw NotImplementedException("Operation not implemented");
+	// an empty result ends the scan: keep fetching until a row is visible to the transaction, none of the rows of a
+	// set of row ids are visible if they were all inserted by transactions that have not committed yet
+	while (result.size() == 0) {
+		while (state->result_index >= state->result_ids.size() && !state->exhausted) {
+			// the previous batch has been fetched: collect the row ids of the next batch from the index
+			if (!state->checked) {
+				InitializeBounds(*state);
+				if (state->exhausted) {
+					return;
+				}
+			}
+			ScanNextBatch(*state);
+			// the rows of a batch are fetched in the order of their row ids, so every storage chunk is only looked up
+			// and locked once; the row ids are usually sorted already if the keys were inserted in order
+			if (!is_sorted(state->result_ids.begin(), state->result_ids.end())) {
+				sort(state->result_ids.begin(), state->result_ids.end());
 			}
-		} else {
-			lock_guard<mutex> l(lock);
-			// two predicates
-			assert(state->values[1].type == types[0]);
-			bool left_inclusive = state->expressions[0] == ExpressionType ::COMPARE_GREATERTHANOREQUALTO;
-			bool right_inclusive = state->expressions[1] == ExpressionType ::COMPARE_LESSTHANOREQUALTO;
-			SearchCloseRange(result_ids, state, left_inclusive, right_inclusive);
 		}
-		state->checked = true;
-
-		if (result_ids.size() == 0) {
+		if (state->result_index >= state->result_ids.size()) {
+			// exhausted all row ids
 			return;
 		}
 
-		// sort the row ids
-		sort(result_ids.begin(), result_ids.end());
-		// duplicate eliminate the row ids and append them to the row ids of the state
-		state->result_ids.reserve(result_ids.size());
+		// create a vector pointing to the current set of row ids
+		Vector row_identifiers(ROW_TYPE, (data_ptr_t)&state->result_ids[state->result_index]);
+		row_identifiers.count =
+		    std::min((index_t)STANDARD_VECTOR_SIZE, (index_t)state->result_ids.size() - state->result_index);
 
-		state->result_ids.push_back(result_ids[0]);
-		for (index_t i = 1; i < result_ids.size(); i++) {
-			if (result_ids[i] != result_ids[i - 1]) {
-				state->result_ids.push_back(result_ids[i]);
-			}
-		}
-	}
+		// fetch the actual values from the base table
+		table.Fetch(transaction, result, state->column_ids, row_identifiers);
 
-	if (state->result_index >= state->result_ids.size()) {
-		// exhausted all row ids
-		return;
+		// move to the next set of row ids
+		state->result_index += row_identifiers.count;
 	}
-
-	// create a vector pointing to the current set of row ids
-	Vector row_identifiers(ROW_TYPE, (data_ptr_t)&state->result_ids[state->result_index]);
-	row_identifiers.count =
-	    std::min((index_t)STANDARD_VECTOR_SIZE, (index_t)state->result_ids.size() - state->result_index);
-
-	// fetch the actual values from the base table
-	table.Fetch(transaction, result, state->column_ids, row_identifiers);
-
-	// move to the next set of row ids
-	state->result_index += row_identifiers.count;
 }
@@ -1,6 +1,8 @@
 #include "execution/index/art/art_key.hpp"
 #include "execution/index/art/art.hpp"
 
+#include <cmath>
+
 using namespace duckdb;
 
 //! these are optimized and assume a particular byte order
@@ -23,32 +25,57 @@ static uint8_t FlipSign(uint8_t key_byte) {
 Key::Key(unique_ptr<data_t[]> data, index_t len) : len(len), data(move(data)) {
 }
 
-template <> unique_ptr<data_t[]> Key::CreateData(int8_t value, bool is_little_endian) {
-	auto data = unique_ptr<data_t[]>(new data_t[sizeof(value)]);
-	reinterpret_cast<uint8_t *>(data.get())[0] = value;
-	data[0] = FlipSign(data[0]);
-	return data;
+template <> void Key::EncodeData(int8_t value, bool is_little_endian, data_ptr_t target) {
+	target[0] = FlipSign((uint8_t)value);
+}
+
+template <> void Key::EncodeData(int16_t value, bool is_little_endian, data_ptr_t target) {
+	uint16_t data = is_little_endian ? BSWAP16(value) : value;
+	memcpy(target, &data, sizeof(data));
+	target[0] = FlipSign(target[0]);
 }
 
-template <> unique_ptr<data_t[]> Key::CreateData(int16_t value, bool is_little_endian) {
-	auto data = unique_ptr<data_t[]>(new data_t[sizeof(value)]);
-	reinterpret_cast<uint16_t *>(data.get())[0] = is_little_endian ? BSWAP16(value) : value;
-	data[0] = FlipSign(data[0]);
-	return data;
+template <> void Key::EncodeData(int32_t value, bool is_little_endian, data_ptr_t target) {
+	uint32_t data = is_little_endian ? BSWAP32(value) : value;
+	memcpy(target, &data, sizeof(data));
+	target[0] = FlipSign(target[0]);
 }
 
-template <> unique_ptr<data_t[]> Key::CreateData(int32_t value, bool is_little_endian) {
-	auto data = unique_ptr<data_t[]>(new data_t[sizeof(value)]);
-	reinterpret_cast<uint32_t *>(data.get())[0] = is_little_endian ? BSWAP32(value) : value;
-	data[0] = FlipSign(data[0]);
-	return data;
+template <> void Key::EncodeData(int64_t value, bool is_little_endian, data_ptr_t target) {
+	uint64_t data = is_little_endian ? BSWAP64(value) : value;
+	memcpy(target, &data, sizeof(data));
+	target[0] = FlipSign(target[0]);
 }
 
-template <> unique_ptr<data_t[]> Key::CreateData(int64_t value, bool is_little_endian) {
-	auto data = unique_ptr<data_t[]>(new data_t[sizeof(value)]);
-	reinterpret_cast<uint64_t *>(data.get())[0] = is_little_endian ? BSWAP64(value) : value;
-	data[0] = FlipSign(data[0]);
-	return data;
+//! Floating point numbers are encoded so their bytes compare like the numbers: the sign bit of positive numbers is
+//! flipped so they sort after the negative numbers, and all bits of negative numbers are flipped so that a larger
+//! magnitude sorts first. Negative zero is encoded as positive zero, and all NaNs are encoded as the same value.
+template <> void Key::EncodeData(float value, bool is_little_endian, data_ptr_t target) {
+	uint32_t bits;
+	if (value == 0) {
+		bits = 0;
+	} else if (std::isnan(value)) {
+		bits = 0x7FC00000u;
+	} else {
+		memcpy(&bits, &value, sizeof(bits));
+	}
+	bits = (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u;
+	uint32_t data = is_little_endian ? BSWAP32(bits) : bits;
+	memcpy(target, &data, sizeof(data));
+}
+
+template <> void Key::EncodeData(double value, bool is_little_endian, data_ptr_t target) {
+	uint64_t bits;
+	if (value == 0) {
+		bits = 0;
+	} else if (std::isnan(value)) {
+		bits = 0x7FF8000000000000ull;
+	} else {
+		memcpy(&bits, &value, sizeof(bits));
+	}
+	bits = (bits & 0x8000000000000000ull) ? ~bits : bits ^ 0x8000000000000000ull;
+	uint64_t data = is_little_endian ? BSWAP64(bits) : bits;
+	memcpy(target, &data, sizeof(data));
 }
 
 template <> unique_ptr<Key> Key::CreateKey(string value, bool is_little_endian) {
@@ -0,0 +1,81 @@
+#include "execution/index/art/epoch_manager.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+EpochManager::EpochManager() : current_epoch(0), retired_count(0) {
+	for (index_t i = 0; i < 3; i++) {
+		active[i] = 0;
+	}
+}
+
+uint64_t EpochManager::Enter() {
+	while (true) {
+		uint64_t epoch = current_epoch.load();
+		active[epoch % 3]++;
+		// the epoch could have advanced before the operation was counted: only enter it if it is still current
+		if (current_epoch.load() == epoch) {
+			return epoch;
+		}
+		active[epoch % 3]--;
+	}
+}
+
+void EpochManager::Leave(uint64_t epoch) {
+	active[epoch % 3]--;
+	if (retired_count.load() > 0) {
+		Reclaim();
+	}
+}
+
+void EpochManager::Retire(unique_ptr<Node> node) {
+	RetiredEntry entry;
+	entry.node = move(node);
+	Retire(move(entry));
+}
+
+void EpochManager::Retire(unique_ptr<uint8_t[]> prefix) {
+	if (!prefix) {
+		return;
+	}
+	RetiredEntry entry;
+	entry.prefix = move(prefix);
+	Retire(move(entry));
+}
+
+void EpochManager::Retire(unique_ptr<row_t[]> row_ids) {
+	RetiredEntry entry;
+	entry.row_ids = move(row_ids);
+	Retire(move(entry));
+}
+
+void EpochManager::Retire(RetiredEntry entry) {
+	lock_guard<mutex> guard(retired_lock);
+	// the memory was removed from the tree before the epoch is read, so only operations that entered this epoch or an
+	// earlier one can still read it
+	entry.epoch = current_epoch.load();
+	retired.push_back(move(entry));
+	retired_count++;
+}
+
+void EpochManager::Reclaim() {
+	unique_lock<mutex> guard(retired_lock, try_to_lock);
+	if (!guard.owns_lock()) {
+		// another operation is reclaiming the memory
+		return;
+	}
+	uint64_t epoch = current_epoch.load();
+	if (active[(epoch + 2) % 3].load() == 0) {
+		// no operation of the previous epoch is active anymore: move to the next epoch
+		current_epoch = ++epoch;
+	}
+	// the operations that were active when the memory was retired have all finished two epochs later
+	index_t reclaim_count = 0;
+	while (reclaim_count < retired.size() && retired[reclaim_count].epoch + 2 <= epoch) {
+		reclaim_count++;
+	}
+	if (reclaim_count > 0) {
+		retired.erase(retired.begin(), retired.begin() + reclaim_count);
+		retired_count -= reclaim_count;
+	}
+}
@@ -1,5 +1,9 @@
 #include "execution/index/art/node.hpp"
 #include "execution/index/art/leaf.hpp"
+#include "execution/index/art/art.hpp"
+
+using namespace duckdb;
+using namespace std;
 
 Leaf::Leaf(ART &art, unique_ptr<Key> value, row_t row_id) : Node(art, NodeType::NLeaf) {
 	this->value = move(value);
@@ -9,13 +13,16 @@ Leaf::Leaf(ART &art, unique_ptr<Key> value, row_t row_id) : Node(art, NodeType::
 	this->num_elements = 1;
 }
 
-void Leaf::Insert(row_t row_id) {
+void Leaf::Insert(ART &art, row_t row_id) {
 	// Grow array
 	if (num_elements == capacity) {
 		auto new_row_id = unique_ptr<row_t[]>(new row_t[capacity * 2]);
 		memcpy(new_row_id.get(), row_ids.get(), capacity * sizeof(row_t));
 		capacity *= 2;
+		// concurrent readers can still read the old array
+		auto old_row_ids = move(row_ids);
 		row_ids = move(new_row_id);
+		art.epochs.Retire(move(old_row_ids));
 	}
 	row_ids[num_elements++] = row_id;
 }
@@ -34,3 +41,20 @@ void Leaf::Remove(row_t row_id) {
 		row_ids[j] = row_ids[j + 1];
 	}
 }
+
+void Leaf::ReadRowIds(uint64_t version, vector<row_t> &result, bool &restart) {
+	index_t count = num_elements;
+	row_t *data = row_ids.get();
+	// the count and the array only belong together if the leaf was not modified in between
+	lock.CheckOrRestart(version, restart);
+	if (restart) {
+		return;
+	}
+	index_t result_count = result.size();
+	result.insert(result.end(), data, data + count);
+	lock.CheckOrRestart(version, restart);
+	if (restart) {
+		// the row ids were modified while they were copied
+		result.resize(result_count);
+	}
+}
@@ -5,12 +5,32 @@
 using namespace duckdb;
 
 Node::Node(ART &art, NodeType type) : prefix_length(0), count(0), type(type) {
-	this->prefix = unique_ptr<uint8_t[]>(new uint8_t[art.maxPrefix]);
+}
+
+void Node::SetPrefix(ART &art, const uint8_t *data, uint32_t length) {
+	unique_ptr<uint8_t[]> new_prefix;
+	if (length > 0) {
+		new_prefix = unique_ptr<uint8_t[]>(new uint8_t[length]);
+		memcpy(new_prefix.get(), data, length);
+	}
+	// concurrent readers can still read the old prefix
+	auto old_prefix = move(prefix);
+	prefix = move(new_prefix);
+	prefix_length = length;
+	art.epochs.Retire(move(old_prefix));
+}
+
+NodePrefix Node::ReadPrefix(uint64_t version, bool &restart) {
+	NodePrefix result;
+	result.length = prefix_length;
+	result.data = prefix.get();
+	// the length and the bytes only belong together if the node was not modified in between
+	lock.CheckOrRestart(version, restart);
+	return result;
 }
 
 void Node::CopyPrefix(ART &art, Node *src, Node *dst) {
-	dst->prefix_length = src->prefix_length;
-	memcpy(dst->prefix.get(), src->prefix.get(), std::min(src->prefix_length, art.maxPrefix));
+	dst->SetPrefix(art, src->prefix.get(), src->prefix_length);
 }
 
 unique_ptr<Node> *Node::GetChild(index_t pos) {
@@ -18,17 +38,14 @@ unique_ptr<Node> *Node::GetChild(index_t pos) {
 	return nullptr;
 }
 
-uint32_t Node::PrefixMismatch(ART &art, Node *node, Key &key, uint64_t depth) {
+uint32_t Node::PrefixMismatch(NodePrefix prefix, Key &key, uint64_t depth) {
+	// the keys of an index are prefix-free, so the key cannot end before it differs from the prefix of a node below
+	// which other keys are stored. A prefix that is read while it is replaced can be longer, the read is restarted.
 	uint64_t pos;
-	// TODO: node->prefix_length > node->max_prefix_length
-	if (node->prefix_length <= art.maxPrefix) {
-		for (pos = 0; pos < node->prefix_length; pos++) {
-			if (key[depth + pos] != node->prefix[pos]) {
-				return pos;
-			}
+	for (pos = 0; pos < prefix.length && depth + pos < key.len; pos++) {
+		if (key[depth + pos] != prefix.data[pos]) {
+			return pos;
 		}
-	} else {
-		throw NotImplementedException("Operation not implemented");
 	}
 	return pos;
 }
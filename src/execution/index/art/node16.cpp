@@ -1,6 +1,8 @@
 #include "execution/index/art/node4.hpp"
 #include "execution/index/art/node16.hpp"
 #include "execution/index/art/node48.hpp"
+#include "execution/index/art/persistent_node.hpp"
+#include "execution/index/art/art.hpp"
 
 using namespace duckdb;
 
@@ -37,9 +39,14 @@ index_t Node16::GetNextPos(index_t pos) {
 
 unique_ptr<Node> *Node16::GetChild(index_t pos) {
 	assert(pos < count);
+	PersistentNode::Swizzle(child[pos]);
 	return &child[pos];
 }
 
+unique_ptr<Node> *Node16::ReadChild(index_t pos) {
+	return pos < 16 ? &child[pos] : nullptr;
+}
+
 void Node16::insert(ART &art, unique_ptr<Node> &node, uint8_t keyByte, unique_ptr<Node> &child) {
 	Node16 *n = static_cast<Node16 *>(node.get());
 
@@ -66,7 +73,7 @@ void Node16::insert(ART &art, unique_ptr<Node> &node, uint8_t keyByte, unique_pt
 		}
 		CopyPrefix(art, n, newNode.get());
 		newNode->count = node->count;
-		node = move(newNode);
+		art.ReplaceNode(node, move(newNode));
 
 		Node48::insert(art, node, keyByte, child);
 	}
@@ -76,7 +83,7 @@ void Node16::erase(ART &art, unique_ptr<Node> &node, int pos) {
 	Node16 *n = static_cast<Node16 *>(node.get());
 	if (node->count > 3) {
 		// erase the child and decrease the count
-		n->child[pos].reset();
+		art.epochs.Retire(move(n->child[pos]));
 		n->count--;
 		// potentially move any children backwards
 		for (; pos < n->count; pos++) {
@@ -84,13 +91,17 @@ void Node16::erase(ART &art, unique_ptr<Node> &node, int pos) {
 			n->child[pos] = move(n->child[pos + 1]);
 		}
 	} else {
-		// Shrink node
+		// Shrink node, without the erased child
 		auto newNode = make_unique<Node4>(art);
+		art.epochs.Retire(move(n->child[pos]));
 		for (unsigned i = 0; i < n->count; i++) {
+			if (i == (unsigned)pos) {
+				continue;
+			}
 			newNode->key[newNode->count] = n->key[i];
 			newNode->child[newNode->count++] = move(n->child[i]);
 		}
 		CopyPrefix(art, n, newNode.get());
-		node = move(newNode);
+		art.ReplaceNode(node, move(newNode));
 	}
 }
@@ -1,5 +1,7 @@
 #include "execution/index/art/node48.hpp"
 #include "execution/index/art/node256.hpp"
+#include "execution/index/art/persistent_node.hpp"
+#include "execution/index/art/art.hpp"
 
 using namespace duckdb;
 
@@ -34,9 +36,14 @@ index_t Node256::GetNextPos(index_t pos) {
 
 unique_ptr<Node> *Node256::GetChild(index_t pos) {
 	assert(child[pos]);
+	PersistentNode::Swizzle(child[pos]);
 	return &child[pos];
 }
 
+unique_ptr<Node> *Node256::ReadChild(index_t pos) {
+	return pos < 256 ? &child[pos] : nullptr;
+}
+
 void Node256::insert(ART &art, unique_ptr<Node> &node, uint8_t keyByte, unique_ptr<Node> &child) {
 	Node256 *n = static_cast<Node256 *>(node.get());
 
@@ -48,11 +55,13 @@ void Node256::erase(ART &art, unique_ptr<Node> &node, int pos) {
 	Node256 *n = static_cast<Node256 *>(node.get());
 
 	if (node->count > 37) {
-		n->child[pos].reset();
+		art.epochs.Retire(move(n->child[pos]));
 		n->count--;
 	} else {
+		// shrink to a Node48, without the erased child
 		auto newNode = make_unique<Node48>(art);
 		CopyPrefix(art, n, newNode.get());
+		art.epochs.Retire(move(n->child[pos]));
 		for (index_t i = 0; i < 256; i++) {
 			if (n->child[i]) {
 				newNode->childIndex[i] = newNode->count;
@@ -60,6 +69,6 @@ void Node256::erase(ART &art, unique_ptr<Node> &node, int pos) {
 				newNode->count++;
 			}
 		}
-		node = move(newNode);
+		art.ReplaceNode(node, move(newNode));
 	}
 }
@@ -1,4 +1,5 @@
 #include "execution/index/art/node4.hpp"
+#include "execution/index/art/persistent_node.hpp"
 #include "execution/index/art/node16.hpp"
 #include "execution/index/art/art.hpp"
 
@@ -36,9 +37,14 @@ index_t Node4::GetNextPos(index_t pos) {
 
 unique_ptr<Node> *Node4::GetChild(index_t pos) {
 	assert(pos < count);
+	PersistentNode::Swizzle(child[pos]);
 	return &child[pos];
 }
 
+unique_ptr<Node> *Node4::ReadChild(index_t pos) {
+	return pos < 4 ? &child[pos] : nullptr;
+}
+
 void Node4::insert(ART &art, unique_ptr<Node> &node, uint8_t keyByte, unique_ptr<Node> &child) {
 	Node4 *n = static_cast<Node4 *>(node.get());
 
@@ -66,7 +72,7 @@ void Node4::insert(ART &art, unique_ptr<Node> &node, uint8_t keyByte, unique_ptr
 			newNode->key[i] = n->key[i];
 			newNode->child[i] = move(n->child[i]);
 		}
-		node = move(newNode);
+		art.ReplaceNode(node, move(newNode));
 		Node16::insert(art, node, keyByte, child);
 	}
 }
@@ -76,7 +82,7 @@ void Node4::erase(ART &art, unique_ptr<Node> &node, int pos) {
 	assert(pos < n->count);
 
 	// erase the child and decrease the count
-	n->child[pos].reset();
+	art.epochs.Retire(move(n->child[pos]));
 	n->count--;
 	// potentially move any children backwards
 	for (; pos < n->count; pos++) {
@@ -86,25 +92,17 @@ void Node4::erase(ART &art, unique_ptr<Node> &node, int pos) {
 
 	// This is a one way node
 	if (n->count == 1) {
-		auto childref = n->child[0].get();
-		if (childref->type == NodeType::NLeaf) {
-			// Concantenate prefixes
-			uint32_t l1 = childref->prefix_length;
-			if (l1 < art.maxPrefix) {
-				n->prefix[l1] = n->key[0];
-				l1++;
-			}
-			if (l1 < art.maxPrefix) {
-				uint32_t l2 = std::min(childref->prefix_length, art.maxPrefix - l1);
-				for (index_t i = 0; i < l2; i++) {
-					n->prefix[l1 + i] = childref->prefix[l2];
-				}
-				l1 += l2;
-			}
-			for (index_t i = 0; i < l1; i++) {
-				childref->prefix[i] = n->prefix[i];
-			}
+		auto childref = n->GetChild(0)->get();
+		if (childref->type != NodeType::NLeaf) {
+			// Concatenate prefixes: the prefix of the node, the key byte of the child and the prefix of the child
+			// (leaves store their complete key, so their prefix is not used)
+			uint32_t new_length = n->prefix_length + 1 + childref->prefix_length;
+			auto new_prefix = unique_ptr<uint8_t[]>(new uint8_t[new_length]);
+			memcpy(new_prefix.get(), n->prefix.get(), n->prefix_length);
+			new_prefix[n->prefix_length] = n->key[0];
+			memcpy(new_prefix.get() + n->prefix_length + 1, childref->prefix.get(), childref->prefix_length);
+			childref->SetPrefix(art, new_prefix.get(), new_length);
 		}
-		node = move(n->child[0]);
+		art.ReplaceNode(node, move(n->child[0]));
 	}
 }
@@ -1,6 +1,8 @@
 #include "execution/index/art/node16.hpp"
 #include "execution/index/art/node48.hpp"
 #include "execution/index/art/node256.hpp"
+#include "execution/index/art/persistent_node.hpp"
+#include "execution/index/art/art.hpp"
 
 using namespace duckdb;
 
@@ -38,9 +40,18 @@ index_t Node48::GetNextPos(index_t pos) {
 
 unique_ptr<Node> *Node48::GetChild(index_t pos) {
 	assert(childIndex[pos] != Node::EMPTY_MARKER);
+	PersistentNode::Swizzle(child[childIndex[pos]]);
 	return &child[childIndex[pos]];
 }
 
+unique_ptr<Node> *Node48::ReadChild(index_t pos) {
+	if (pos >= 256) {
+		return nullptr;
+	}
+	auto index = childIndex[pos];
+	return index < 48 ? &child[index] : nullptr;
+}
+
 void Node48::insert(ART &art, unique_ptr<Node> &node, uint8_t keyByte, unique_ptr<Node> &child) {
 	Node48 *n = static_cast<Node48 *>(node.get());
 
@@ -68,7 +79,7 @@ void Node48::insert(ART &art, unique_ptr<Node> &node, uint8_t keyByte, unique_pt
 		}
 		newNode->count = n->count;
 		CopyPrefix(art, n, newNode.get());
-		node = move(newNode);
+		art.ReplaceNode(node, move(newNode));
 		Node256::insert(art, node, keyByte, child);
 	}
 }
@@ -77,18 +88,20 @@ void Node48::erase(ART &art, unique_ptr<Node> &node, int pos) {
 	Node48 *n = static_cast<Node48 *>(node.get());
 
 	if (node->count > 12) {
-		n->child[n->childIndex[pos]].reset();
+		art.epochs.Retire(move(n->child[n->childIndex[pos]]));
 		n->childIndex[pos] = Node::EMPTY_MARKER;
 		n->count--;
 	} else {
+		// shrink to a Node16, without the erased child
 		auto newNode = make_unique<Node16>(art);
 		CopyPrefix(art, n, newNode.get());
+		art.epochs.Retire(move(n->child[n->childIndex[pos]]));
 		for (index_t i = 0; i < 256; i++) {
-			if (n->childIndex[i] != Node::EMPTY_MARKER) {
+			if (n->childIndex[i] != Node::EMPTY_MARKER && i != (index_t)pos) {
 				newNode->key[newNode->count] = i;
 				newNode->child[newNode->count++] = move(n->child[n->childIndex[i]]);
 			}
 		}
-		node = move(newNode);
+		art.ReplaceNode(node, move(newNode));
 	}
 }
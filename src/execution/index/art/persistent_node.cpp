@@ -0,0 +1,184 @@
+#include "execution/index/art/persistent_node.hpp"
+#include "execution/index/art/art.hpp"
+#include "storage/buffer_manager.hpp"
+#include "storage/meta_block_writer.hpp"
+#include "storage/storage_manager.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+//! Reads a node from the chain of meta blocks it was written to. The blocks are pinned through the buffer manager, so
+//! a block that stores many nodes does not have to be read from disk for every node.
+class PersistentNodeReader : public Deserializer {
+public:
+	PersistentNodeReader(BufferManager &manager, block_id_t block_id, uint32_t offset)
+	    : manager(manager), offset(offset) {
+		handle = manager.Pin(block_id);
+	}
+
+	void ReadData(data_ptr_t buffer, index_t read_size) override {
+		auto block = handle->block;
+		while (offset + read_size > block->size) {
+			// the data continues in the next block: first read what is left in this block
+			index_t to_read = block->size - offset;
+			if (to_read > 0) {
+				memcpy(buffer, block->buffer + offset, to_read);
+				read_size -= to_read;
+				buffer += to_read;
+			}
+			// the id of the next block is stored at the start of the block
+			handle = manager.Pin(*((block_id_t *)block->buffer));
+			block = handle->block;
+			offset = sizeof(block_id_t);
+		}
+		memcpy(buffer, block->buffer + offset, read_size);
+		offset += read_size;
+	}
+
+private:
+	BufferManager &manager;
+	unique_ptr<BufferHandle> handle;
+	index_t offset;
+};
+
+PersistentNode::PersistentNode(ART &art, block_id_t block_id, uint32_t offset)
+    : Node(art, NodeType::NPersistent), art(art), block_id(block_id), offset(offset) {
+}
+
+unique_ptr<Node> PersistentNode::Load() {
+	PersistentNodeReader reader(*art.table.storage.buffer_manager, block_id, offset);
+	auto type = (NodeType)reader.Read<uint8_t>();
+	auto prefix_length = reader.Read<uint32_t>();
+	auto prefix = unique_ptr<uint8_t[]>(new uint8_t[prefix_length]);
+	reader.ReadData(prefix.get(), prefix_length);
+
+	unique_ptr<Node> result;
+	if (type == NodeType::NLeaf) {
+		// read the key and the row ids of the leaf
+		auto key_length = reader.Read<uint32_t>();
+		auto key_data = unique_ptr<data_t[]>(new data_t[key_length]);
+		reader.ReadData(key_data.get(), key_length);
+		auto row_count = reader.Read<uint64_t>();
+		assert(row_count > 0);
+		auto leaf = make_unique<Leaf>(art, make_unique<Key>(move(key_data), key_length), reader.Read<row_t>());
+		for (index_t i = 1; i < row_count; i++) {
+			leaf->Insert(art, reader.Read<row_t>());
+		}
+		result = move(leaf);
+	} else {
+		// read the children of the inner node, they are loaded when they are first accessed
+		auto count = reader.Read<uint16_t>();
+		switch (type) {
+		case NodeType::N4:
+			result = make_unique<Node4>(art);
+			break;
+		case NodeType::N16:
+			result = make_unique<Node16>(art);
+			break;
+		case NodeType::N48:
+			result = make_unique<Node48>(art);
+			break;
+		case NodeType::N256:
+			result = make_unique<Node256>(art);
+			break;
+		default:
+			throw IOException("Corrupt index: invalid node type");
+		}
+		for (index_t i = 0; i < count; i++) {
+			auto key_byte = reader.Read<uint8_t>();
+			auto child_block = reader.Read<block_id_t>();
+			auto child_offset = reader.Read<uint32_t>();
+			auto child = make_unique<PersistentNode>(art, child_block, child_offset);
+			switch (type) {
+			case NodeType::N4: {
+				auto &n4 = (Node4 &)*result;
+				n4.key[i] = key_byte;
+				n4.child[i] = move(child);
+				break;
+			}
+			case NodeType::N16: {
+				auto &n16 = (Node16 &)*result;
+				n16.key[i] = key_byte;
+				n16.child[i] = move(child);
+				break;
+			}
+			case NodeType::N48: {
+				auto &n48 = (Node48 &)*result;
+				n48.childIndex[key_byte] = i;
+				n48.child[i] = move(child);
+				break;
+			}
+			default:
+				assert(type == NodeType::N256);
+				((Node256 &)*result).child[key_byte] = move(child);
+				break;
+			}
+		}
+		result->count = count;
+	}
+	result->prefix_length = prefix_length;
+	result->prefix = move(prefix);
+	return result;
+}
+
+void PersistentNode::Swizzle(unique_ptr<Node> &node) {
+	if (node && node->type == NodeType::NPersistent) {
+		auto &art = ((PersistentNode &)*node).art;
+		auto loaded_node = ((PersistentNode &)*node).Load();
+		// concurrent readers can still read the persistent node
+		auto persistent_node = move(node);
+		node = move(loaded_node);
+		art.epochs.Retire(move(persistent_node));
+	}
+}
+
+void PersistentNode::Write(ART &art, Node &node, MetaBlockWriter &writer, block_id_t &block_id, uint32_t &offset) {
+	assert(node.type != NodeType::NPersistent);
+	// the children are written first, so the node can store their location
+	vector<uint8_t> child_keys;
+	vector<block_id_t> child_blocks;
+	vector<uint32_t> child_offsets;
+	if (node.type != NodeType::NLeaf) {
+		for (index_t pos = node.GetNextPos(INVALID_INDEX); pos != INVALID_INDEX; pos = node.GetNextPos(pos)) {
+			block_id_t child_block;
+			uint32_t child_offset;
+			Write(art, **node.GetChild(pos), writer, child_block, child_offset);
+			switch (node.type) {
+			case NodeType::N4:
+				child_keys.push_back(((Node4 &)node).key[pos]);
+				break;
+			case NodeType::N16:
+				child_keys.push_back(((Node16 &)node).key[pos]);
+				break;
+			default:
+				// the positions of a Node48 and Node256 are the key bytes of the children
+				child_keys.push_back(pos);
+				break;
+			}
+			child_blocks.push_back(child_block);
+			child_offsets.push_back(child_offset);
+		}
+	}
+	block_id = writer.block->id;
+	offset = writer.offset;
+
+	writer.Write<uint8_t>((uint8_t)node.type);
+	writer.Write<uint32_t>(node.prefix_length);
+	writer.WriteData(node.prefix.get(), node.prefix_length);
+	if (node.type == NodeType::NLeaf) {
+		auto &leaf = (Leaf &)node;
+		writer.Write<uint32_t>(leaf.value->len);
+		writer.WriteData(leaf.value->data.get(), leaf.value->len);
+		writer.Write<uint64_t>(leaf.num_elements);
+		for (index_t i = 0; i < leaf.num_elements; i++) {
+			writer.Write<row_t>(leaf.GetRowId(i));
+		}
+	} else {
+		writer.Write<uint16_t>(child_keys.size());
+		for (index_t i = 0; i < child_keys.size(); i++) {
+			writer.Write<uint8_t>(child_keys[i]);
+			writer.Write<block_id_t>(child_blocks[i]);
+			writer.Write<uint32_t>(child_offsets[i]);
+		}
+	}
+}
@@ -4,6 +4,9 @@
 #include "common/types/null_value.hpp"
 #include "common/types/static_vector.hpp"
 #include "common/vector_operations/vector_operations.hpp"
+#include "function/aggregate/distributive_functions.hpp"
+#include "parallel/task_scheduler.hpp"
+#include "planner/expression/bound_aggregate_expression.hpp"
 
 using namespace duckdb;
 using namespace std;
@@ -22,21 +25,21 @@ static void SerializeChunk(DataChunk &source, data_ptr_t targets[]) {
 	}
 }
 
-static void DeserializeChunk(DataChunk &result, data_ptr_t source[], index_t count) {
+static void DeserializeChunk(DataChunk &result, data_ptr_t source[], index_t count, bool set_null = false) {
 	Vector source_vector(TypeId::POINTER, (data_ptr_t)source);
 	source_vector.count = count;
 
 	index_t offset = 0;
 	for (index_t i = 0; i < result.column_count; i++) {
-		VectorOperations::Gather::Set(source_vector, result.data[i], false, offset);
+		VectorOperations::Gather::Set(source_vector, result.data[i], set_null, offset);
 		offset += GetTypeIdSize(result.data[i].type);
 	}
 }
 
 JoinHashTable::JoinHashTable(vector<JoinCondition> &conditions, vector<TypeId> build_types, JoinType type,
-                             index_t initial_capacity, bool parallel)
+                             index_t initial_capacity)
     : build_types(build_types), equality_size(0), condition_size(0), build_size(0), entry_size(0), tuple_size(0),
-      join_type(type), has_null(false), capacity(0), count(0), parallel(parallel) {
+      join_type(type), has_null(false), capacity(0), count(0) {
 	for (auto &condition : conditions) {
 		assert(condition.left->return_type == condition.right->return_type);
 		auto type = condition.left->return_type;
@@ -80,7 +83,7 @@ void JoinHashTable::ApplyBitmask(Vector &hashes) {
 	VectorOperations::Exec(hashes, [&](index_t i, index_t k) { indices[i] = indices[i] & bitmask; });
 }
 
-void JoinHashTable::InsertHashes(Vector &hashes, data_ptr_t key_locations[]) {
+template <bool PARALLEL> void JoinHashTable::InsertHashes(Vector &hashes, data_ptr_t key_locations[]) {
 	assert(hashes.type == TypeId::HASH);
 
 	// use bitmask to get position in array
@@ -94,76 +97,89 @@ void JoinHashTable::InsertHashes(Vector &hashes, data_ptr_t key_locations[]) {
 		// set prev in current key to the value (NOTE: this will be nullptr if
 		// there is none)
 		auto prev_pointer = (data_ptr_t *)(key_locations[i] + tuple_size);
-		*prev_pointer = pointers[index];
-
-		// set pointer to current tuple
-		pointers[index] = key_locations[i];
+		if (PARALLEL) {
+			// other threads can be inserting into the same chain: retry until the head of the chain is swapped
+			auto head = pointers[index].load(memory_order_relaxed);
+			do {
+				*prev_pointer = head;
+			} while (!pointers[index].compare_exchange_weak(head, key_locations[i], memory_order_relaxed));
+		} else {
+			*prev_pointer = pointers[index].load(memory_order_relaxed);
+			// set pointer to current tuple
+			pointers[index].store(key_locations[i], memory_order_relaxed);
+		}
 	});
 }
 
-void JoinHashTable::Resize(index_t size) {
-	if (size <= capacity) {
-		throw Exception("Cannot downsize a hash table!");
+template <bool PARALLEL> void JoinHashTable::InsertNode(Node &node) {
+	DataChunk keys;
+	keys.Initialize(equality_types);
+
+	data_ptr_t key_locations[STANDARD_VECTOR_SIZE];
+	// scan all the entries in this node
+	auto dataptr = node.data.get();
+	for (index_t i = 0; i < node.count; i++) {
+		// key is stored at the start
+		key_locations[i] = dataptr;
+		// move to next entry
+		dataptr += entry_size;
 	}
-	capacity = size;
 
+	// reconstruct the keys chunk from the stored entries
+	// we only reconstruct the keys that are part of the equality
+	// comparison as these are the ones that are used to compute the
+	// hash
+	DeserializeChunk(keys, key_locations, node.count);
+
+	// create the hash
+	StaticVector<uint64_t> hashes;
+	keys.Hash(hashes);
+
+	// insert the entries, this overwrites the old chain pointers
+	InsertHashes<PARALLEL>(hashes, key_locations);
+}
+
+void JoinHashTable::InitializePointerTable(index_t size) {
 	// size needs to be a power of 2
 	assert((size & (size - 1)) == 0);
+	capacity = size;
 	bitmask = size - 1;
 
-	hashed_pointers = unique_ptr<data_ptr_t[]>(new data_ptr_t[capacity]);
-	memset(hashed_pointers.get(), 0, capacity * sizeof(data_ptr_t));
+	// value-initialize the pointers to nullptr
+	hashed_pointers = unique_ptr<atomic<data_ptr_t>[]>(new atomic<data_ptr_t>[capacity]());
+}
+
+void JoinHashTable::InitializeCorrelatedMarkJoin(vector<TypeId> correlated_types) {
+	auto &info = correlated_mark_join_info;
+
+	vector<TypeId> payload_types = {TypeId::BIGINT, TypeId::BIGINT}; // COUNT types
+	vector<AggregateFunction> aggregate_functions = {CountStar::GetFunction(), Count::GetFunction()};
+	vector<BoundAggregateExpression *> correlated_aggregates;
+	for (index_t i = 0; i < aggregate_functions.size(); ++i) {
+		auto aggr = make_unique<BoundAggregateExpression>(payload_types[i], aggregate_functions[i], false);
+		correlated_aggregates.push_back(&*aggr);
+		info.correlated_aggregates.push_back(move(aggr));
+	}
+	info.correlated_counts =
+	    make_unique<SuperLargeHashTable>(1024, correlated_types, payload_types, correlated_aggregates);
+	info.correlated_types = correlated_types;
+	// FIXME: these can be initialized "empty" (without allocating empty vectors)
+	info.group_chunk.Initialize(correlated_types);
+	info.payload_chunk.Initialize(payload_types);
+	info.result_chunk.Initialize(payload_types);
+}
+
+void JoinHashTable::Resize(index_t size) {
+	if (size <= capacity) {
+		throw Exception("Cannot downsize a hash table!");
+	}
+	InitializePointerTable(size);
 
 	if (count > 0) {
 		// we have entries, need to rehash the pointers
-		// first reset all chain pointers to the nullptr
-		// we could do this by actually following the chains in the
-		// hashed_pointers as well might be more or less efficient depending on
-		// length of chains?
 		auto node = head.get();
 		while (node) {
-			// scan all the entries in this node
-			auto entry_pointer = (data_ptr_t)node->data.get() + tuple_size;
-			for (index_t i = 0; i < node->count; i++) {
-				// reset chain pointer
-				auto prev_pointer = (data_ptr_t *)entry_pointer;
-				*prev_pointer = nullptr;
-				// move to next entry
-				entry_pointer += entry_size;
-			}
-			node = node->prev.get();
-		}
-
-		// now rehash the entries
-		DataChunk keys;
-		keys.Initialize(equality_types);
-
-		data_ptr_t key_locations[STANDARD_VECTOR_SIZE];
-
-		node = head.get();
-		while (node) {
-			// scan all the entries in this node
-			auto dataptr = node->data.get();
-			for (index_t i = 0; i < node->count; i++) {
-				// key is stored at the start
-				key_locations[i] = dataptr;
-				// move to next entry
-				dataptr += entry_size;
-			}
-
-			// reconstruct the keys chunk from the stored entries
-			// we only reconstruct the keys that are part of the equality
-			// comparison as these are the ones that are used to compute the
-			// hash
-			DeserializeChunk(keys, key_locations, node->count);
-
-			// create the hash
-			StaticVector<uint64_t> hashes;
-			keys.Hash(hashes);
-
-			// re-insert the entries
-			InsertHashes(hashes, key_locations);
-
+			InsertNode<false>(*node);
 			// move to the next node
 			node = node->prev.get();
 		}
@@ -201,9 +217,6 @@ void JoinHashTable::Build(DataChunk &keys, DataChunk &payload) {
 		return;
 	}
 	// resize at 50% capacity, also need to fit the entire vector
-	if (parallel) {
-		parallel_lock.lock();
-	}
 	if (count + keys.size() > capacity / 2) {
 		Resize(capacity * 2);
 	}
@@ -212,10 +225,36 @@ void JoinHashTable::Build(DataChunk &keys, DataChunk &payload) {
 	keys.MoveStringsToHeap(string_heap);
 	payload.MoveStringsToHeap(string_heap);
 
-	if (parallel) {
-		parallel_lock.unlock();
+	data_ptr_t key_locations[STANDARD_VECTOR_SIZE];
+	if (!AppendNode(keys, payload, key_locations)) {
+		return;
+	}
+
+	// hash the keys and obtain an entry in the list
+	// note that we only hash the keys used in the equality comparison
+	StaticVector<uint64_t> hashes;
+	Hash(keys, hashes);
+
+	InsertHashes<false>(hashes, key_locations);
+}
+
+void JoinHashTable::Append(DataChunk &keys, DataChunk &payload) {
+	assert(keys.size() == payload.size());
+	// the correlated counts are kept in a single aggregate HT, which does not support parallel appends
+	assert(correlated_mark_join_info.correlated_types.size() == 0);
+	if (keys.size() == 0) {
+		return;
 	}
+	count += keys.size();
+	// move strings to the string heap
+	keys.MoveStringsToHeap(string_heap);
+	payload.MoveStringsToHeap(string_heap);
+
+	data_ptr_t key_locations[STANDARD_VECTOR_SIZE];
+	AppendNode(keys, payload, key_locations);
+}
 
+bool JoinHashTable::AppendNode(DataChunk &keys, DataChunk &payload, data_ptr_t key_locations[]) {
 	// for any columns for which null values are equal, fill the NullMask
 	assert(keys.column_count == null_values_are_equal.size());
 	bool null_values_equal_for_all = true;
@@ -263,12 +302,11 @@ void JoinHashTable::Build(DataChunk &keys, DataChunk &payload) {
 			payload.sel_vector = keys.data[0].sel_vector;
 		}
 		if (not_null_count == 0) {
-			return;
+			return false;
 		}
 	}
 
 	// get the locations of where to serialize the keys and payload columns
-	data_ptr_t key_locations[STANDARD_VECTOR_SIZE];
 	data_ptr_t tuple_locations[STANDARD_VECTOR_SIZE];
 	auto node = make_unique<Node>(entry_size, keys.size());
 	auto dataptr = node->data.get();
@@ -288,22 +326,81 @@ void JoinHashTable::Build(DataChunk &keys, DataChunk &payload) {
 		SerializeChunk(payload, tuple_locations);
 	}
 
-	// hash the keys and obtain an entry in the list
-	// note that we only hash the keys used in the equality comparison
-	StaticVector<uint64_t> hashes;
-	Hash(keys, hashes);
-
-	if (parallel) {
-		// obtain lock
-		parallel_lock.lock();
-	}
-	InsertHashes(hashes, key_locations);
 	// store the new node as the head
 	node->prev = move(head);
 	head = move(node);
-	if (parallel) {
-		parallel_lock.unlock();
+	return true;
+}
+
+void JoinHashTable::ScanEntries(std::function<void(DataChunk &keys, DataChunk &payload)> callback) {
+	DataChunk keys, payload;
+	keys.Initialize(condition_types);
+	if (build_size > 0) {
+		payload.Initialize(build_types);
+	}
+	data_ptr_t key_locations[STANDARD_VECTOR_SIZE];
+	data_ptr_t tuple_locations[STANDARD_VECTOR_SIZE];
+	auto node = head.get();
+	while (node) {
+		// nodes never hold more than STANDARD_VECTOR_SIZE entries
+		assert(node->count <= STANDARD_VECTOR_SIZE);
+		auto dataptr = node->data.get();
+		for (index_t i = 0; i < node->count; i++) {
+			key_locations[i] = dataptr;
+			tuple_locations[i] = dataptr + condition_size;
+			dataptr += entry_size;
+		}
+		keys.Reset();
+		DeserializeChunk(keys, key_locations, node->count, true);
+		if (build_size > 0) {
+			payload.Reset();
+			DeserializeChunk(payload, tuple_locations, node->count, true);
+		}
+		callback(keys, payload);
+		node = node->prev.get();
+	}
+}
+
+void JoinHashTable::Merge(JoinHashTable &other) {
+	assert(other.tuple_size == tuple_size && other.entry_size == entry_size);
+	count += other.count;
+	has_null = has_null || other.has_null;
+	string_heap.MergeHeap(other.string_heap);
+	other.count = 0;
+	if (!other.head) {
+		return;
+	}
+	// append the current list of nodes to the tail of the other list, and make the other list the new list
+	auto tail = other.head.get();
+	while (tail->prev) {
+		tail = tail->prev.get();
+	}
+	tail->prev = move(head);
+	head = move(other.head);
+}
+
+void JoinHashTable::Finalize(TaskScheduler &scheduler, index_t task_count) {
+	// size the hash map at 50% capacity up front, so we never need to resize while inserting
+	index_t new_capacity = capacity;
+	while (count > new_capacity / 2) {
+		new_capacity *= 2;
+	}
+	InitializePointerTable(new_capacity);
+
+	vector<Node *> nodes;
+	for (auto node = head.get(); node; node = node->prev.get()) {
+		nodes.push_back(node);
+	}
+	// every task inserts a disjoint set of nodes, the chains are shared between the tasks
+	vector<task_function_t> tasks;
+	for (index_t task_idx = 0; task_idx < task_count && task_idx < nodes.size(); task_idx++) {
+		tasks.push_back([this, &nodes, task_idx, task_count]() {
+			for (index_t node_idx = task_idx; node_idx < nodes.size(); node_idx += task_count) {
+				InsertNode<true>(*nodes[node_idx]);
+			}
+		});
 	}
+	scheduler.ExecuteTasks(move(tasks));
 }
 
 unique_ptr<ScanStructure> JoinHashTable::Probe(DataChunk &keys) {
@@ -329,7 +426,7 @@ unique_ptr<ScanStructure> JoinHashTable::Probe(DataChunk &keys) {
 	auto indices = (uint64_t *)hashes.data;
 	for (index_t i = 0; i < hashes.count; i++) {
 		auto index = indices[i];
-		ptrs[i] = hashed_pointers[index];
+		ptrs[i] = hashed_pointers[index].load(memory_order_relaxed);
 	}
 	ss->pointers.count = hashes.count;
 
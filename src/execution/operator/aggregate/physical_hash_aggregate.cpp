@@ -5,6 +5,10 @@
 #include "planner/expression/bound_aggregate_expression.hpp"
 #include "planner/expression/bound_constant_expression.hpp"
 #include "catalog/catalog_entry/aggregate_function_catalog_entry.hpp"
+#include "main/client_context.hpp"
+#include "main/database.hpp"
+#include "parallel/pipeline_executor.hpp"
+#include "parallel/task_scheduler.hpp"
 
 using namespace duckdb;
 using namespace std;
@@ -33,8 +37,199 @@ PhysicalHashAggregate::PhysicalHashAggregate(vector<TypeId> types, vector<unique
 	}
 }
 
+void PhysicalHashAggregate::ResolveGroupsAndPayload(DataChunk &input, DataChunk &group_chunk,
+                                                    DataChunk &payload_chunk) {
+	// the chunks are reused for every input chunk: a constant result of the previous chunk references the value of its
+	// expression, which cannot hold the rows of the next chunk
+	group_chunk.Reset();
+	payload_chunk.Reset();
+	index_t payload_idx = 0;
+	ExpressionExecutor executor(input);
+	// aggregation with groups
+	executor.Execute(groups, group_chunk);
+	for (index_t i = 0; i < aggregates.size(); i++) {
+		auto &aggr = (BoundAggregateExpression &)*aggregates[i];
+		if (aggr.children.size()) {
+			for (index_t j = 0; j < aggr.children.size(); ++j) {
+				executor.ExecuteExpression(*aggr.children[j], payload_chunk.data[payload_idx]);
+				payload_chunk.heap.MergeHeap(payload_chunk.data[payload_idx].string_heap);
+				++payload_idx;
+			}
+		} else {
+			payload_chunk.data[payload_idx].count = group_chunk.size();
+			payload_chunk.data[payload_idx].sel_vector = group_chunk.sel_vector;
+			++payload_idx;
+		}
+	}
+	payload_chunk.sel_vector = group_chunk.sel_vector;
+
+	group_chunk.Verify();
+	payload_chunk.Verify();
+	assert(payload_chunk.column_count == 0 || group_chunk.size() == payload_chunk.size());
+}
+
+void PhysicalHashAggregate::ParallelBuild(ClientContext &context, PhysicalHashAggregateOperatorState *state,
+                                          index_t thread_count) {
+	// every thread resolves the groups and aggregate inputs of its own chunks
+	auto group_types = state->group_chunk.GetTypes();
+	auto payload_types = state->payload_chunk.GetTypes();
+	vector<unique_ptr<DataChunk>> group_chunks, payload_chunks;
+	for (index_t i = 0; i < thread_count; i++) {
+		auto group_chunk = make_unique<DataChunk>();
+		group_chunk->Initialize(group_types);
+		auto payload_chunk = make_unique<DataChunk>();
+		if (payload_types.size() > 0) {
+			payload_chunk->Initialize(payload_types);
+		}
+		group_chunks.push_back(move(group_chunk));
+		payload_chunks.push_back(move(payload_chunk));
+	}
+	vector<BoundAggregateExpression *> aggregate_kind;
+	for (auto &expr : aggregates) {
+		aggregate_kind.push_back((BoundAggregateExpression *)expr.get());
+	}
+	if (!SuperLargeHashTable::CanCombine(aggregate_kind)) {
+		// the aggregate states cannot be combined: the hash table is shared and additions to it are serialized
+		mutex ht_lock;
+		auto sink = [&](index_t thread_idx, DataChunk &input) {
+			auto &group_chunk = *group_chunks[thread_idx];
+			auto &payload_chunk = *payload_chunks[thread_idx];
+			ResolveGroupsAndPayload(input, group_chunk, payload_chunk);
+
+			lock_guard<mutex> guard(ht_lock);
+			group_chunk.MoveStringsToHeap(state->ht->string_heap);
+			payload_chunk.MoveStringsToHeap(state->ht->string_heap);
+			state->ht->AddChunk(group_chunk, payload_chunk);
+			state->tuples_scanned += input.size();
+		};
+		PipelineExecutor::Execute(context, *children[0], state->child_state.get(), thread_count, sink);
+		return;
+	}
+	// every thread pre-aggregates into its own set of HTs, radix partitioned on the hash of the groups
+	index_t partition_count = 1;
+	while (partition_count < 2 * thread_count) {
+		partition_count *= 2;
+	}
+	bool can_spill = CanSpill(context);
+	index_t thread_limit = context.db.maximum_memory / thread_count;
+	mutex spill_lock;
+	vector<vector<unique_ptr<SuperLargeHashTable>>> thread_partitions(thread_count);
+	vector<unique_ptr<StringHeap>> thread_heaps;
+	vector<index_t> thread_tuples(thread_count, 0);
+	for (index_t i = 0; i < thread_count; i++) {
+		for (index_t partition = 0; partition < partition_count; partition++) {
+			thread_partitions[i].push_back(
+			    make_unique<SuperLargeHashTable>(1024, group_types, payload_types, aggregate_kind));
+		}
+		thread_heaps.push_back(make_unique<StringHeap>());
+	}
+	auto sink = [&](index_t thread_idx, DataChunk &input) {
+		auto &group_chunk = *group_chunks[thread_idx];
+		auto &payload_chunk = *payload_chunks[thread_idx];
+		ResolveGroupsAndPayload(input, group_chunk, payload_chunk);
+
+		group_chunk.MoveStringsToHeap(*thread_heaps[thread_idx]);
+		payload_chunk.MoveStringsToHeap(*thread_heaps[thread_idx]);
+		SuperLargeHashTable::AddChunkPartitioned(thread_partitions[thread_idx], group_chunk, payload_chunk);
+		thread_tuples[thread_idx] += input.size();
+		if (!can_spill) {
+			return;
+		}
+		auto &partitions = thread_partitions[thread_idx];
+		index_t thread_memory = thread_heaps[thread_idx]->MemoryUsage();
+		for (auto &partition : partitions) {
+			thread_memory += partition->MemoryUsage();
+		}
+		if (thread_memory > thread_limit) {
+			// the HTs of this thread exceed its share of the memory limit: write the partial aggregates to disk
+			lock_guard<mutex> guard(spill_lock);
+			for (auto &partition : partitions) {
+				partition->Spill(*context.db.temporary_directory, state->spill_partitions);
+				partition = make_unique<SuperLargeHashTable>(1024, group_types, payload_types, aggregate_kind);
+			}
+			thread_heaps[thread_idx] = make_unique<StringHeap>();
+			state->spilled = true;
+		}
+	};
+	PipelineExecutor::Execute(context, *children[0], state->child_state.get(), thread_count, sink);
+	if (state->spilled) {
+		// write the remaining partial aggregates to disk as well, the partitions are combined one at a time
+		for (index_t i = 0; i < thread_count; i++) {
+			for (auto &partition : thread_partitions[i]) {
+				partition->Spill(*context.db.temporary_directory, state->spill_partitions);
+			}
+			state->tuples_scanned += thread_tuples[i];
+		}
+		state->partitions.resize(HASH_AGGREGATE_PARTITION_COUNT);
+		return;
+	}
+	// now merge the partitions of the different threads in parallel
+	state->partitions.resize(partition_count);
+	vector<task_function_t> merge_tasks;
+	for (index_t partition = 0; partition < partition_count; partition++) {
+		merge_tasks.push_back([&, partition]() {
+			auto merged = move(thread_partitions[0][partition]);
+			for (index_t i = 1; i < thread_count; i++) {
+				merged->Combine(*thread_partitions[i][partition]);
+			}
+			state->partitions[partition] = move(merged);
+		});
+	}
+	context.db.scheduler->ExecuteTasks(move(merge_tasks));
+	// the groups and states point into the thread-local string heaps: keep them alive in the state
+	for (index_t i = 0; i < thread_count; i++) {
+		state->ht->string_heap.MergeHeap(*thread_heaps[i]);
+		state->tuples_scanned += thread_tuples[i];
+	}
+}
+
+bool PhysicalHashAggregate::CanSpill(ClientContext &context) {
+	if (context.db.maximum_memory == (index_t)-1 || is_implicit_aggr) {
+		return false;
+	}
+	// the spilled partial aggregates are merged using the combine functions of the aggregates
+	vector<BoundAggregateExpression *> aggregate_kind;
+	for (auto &expr : aggregates) {
+		aggregate_kind.push_back((BoundAggregateExpression *)expr.get());
+	}
+	return SuperLargeHashTable::CanCombine(aggregate_kind);
+}
+
+unique_ptr<SuperLargeHashTable> PhysicalHashAggregate::CreateHashTable(PhysicalHashAggregateOperatorState &state) {
+	auto group_types = state.group_chunk.GetTypes();
+	auto payload_types = state.payload_chunk.GetTypes();
+	vector<BoundAggregateExpression *> aggregate_kind;
+	for (auto &expr : aggregates) {
+		aggregate_kind.push_back((BoundAggregateExpression *)expr.get());
+	}
+	return make_unique<SuperLargeHashTable>(1024, group_types, payload_types, aggregate_kind);
+}
+
+unique_ptr<SuperLargeHashTable> PhysicalHashAggregate::LoadSpilledPartition(PhysicalHashAggregateOperatorState &state,
+                                                                           index_t partition) {
+	auto ht = CreateHashTable(state);
+	auto &file = state.spill_partitions[partition];
+	if (file) {
+		DataChunk spilled_chunk;
+		while (file->Scan(spilled_chunk)) {
+			ht->CombineSpilledChunk(spilled_chunk);
+		}
+		file.reset();
+	}
+	return ht;
+}
+
 void PhysicalHashAggregate::GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
 	auto state = reinterpret_cast<PhysicalHashAggregateOperatorState *>(state_);
+	bool can_spill = children.size() > 0 && !state->child_state->finished && CanSpill(context);
+	if (children.size() > 0 && !state->child_state->finished) {
+		auto thread_count = PipelineExecutor::ParallelThreadCount(context, *children[0]);
+		if (thread_count > 1) {
+			// the child pipeline can be executed by multiple threads
+			ParallelBuild(context, state, thread_count);
+			state->child_state->finished = true;
+		}
+	}
 	do {
 		if (children.size() > 0) {
 			// resolve the child chunk if there is one
@@ -43,31 +238,9 @@ void PhysicalHashAggregate::GetChunkInternal(ClientContext &context, DataChunk &
 				break;
 			}
 		}
-		index_t payload_idx = 0;
-		ExpressionExecutor executor(state->child_chunk);
-		// aggregation with groups
 		DataChunk &group_chunk = state->group_chunk;
 		DataChunk &payload_chunk = state->payload_chunk;
-		executor.Execute(groups, group_chunk);
-		for (index_t i = 0; i < aggregates.size(); i++) {
-			auto &aggr = (BoundAggregateExpression &)*aggregates[i];
-			if (aggr.children.size()) {
-				for (index_t j = 0; j < aggr.children.size(); ++j) {
-					executor.ExecuteExpression(*aggr.children[j], payload_chunk.data[payload_idx]);
-					payload_chunk.heap.MergeHeap(payload_chunk.data[payload_idx].string_heap);
-					++payload_idx;
-				}
-			} else {
-				payload_chunk.data[payload_idx].count = group_chunk.size();
-				payload_chunk.data[payload_idx].sel_vector = group_chunk.sel_vector;
-				++payload_idx;
-			}
-		}
-		payload_chunk.sel_vector = group_chunk.sel_vector;
-
-		group_chunk.Verify();
-		payload_chunk.Verify();
-		assert(payload_chunk.column_count == 0 || group_chunk.size() == payload_chunk.size());
+		ResolveGroupsAndPayload(state->child_chunk, group_chunk, payload_chunk);
 
 		// move the strings inside the groups to the string heap
 		group_chunk.MoveStringsToHeap(state->ht->string_heap);
@@ -75,11 +248,42 @@ void PhysicalHashAggregate::GetChunkInternal(ClientContext &context, DataChunk &
 
 		state->ht->AddChunk(group_chunk, payload_chunk);
 		state->tuples_scanned += state->child_chunk.size();
+		if (can_spill && state->ht->MemoryUsage() > context.db.maximum_memory) {
+			// the HT exceeds the memory limit: write the partial aggregates to disk and continue with an empty HT
+			state->ht->Spill(*context.db.temporary_directory, state->spill_partitions);
+			state->ht = CreateHashTable(*state);
+			state->spilled = true;
+		}
 	} while (state->child_chunk.size() > 0);
+	if (state->spilled && state->partitions.size() == 0) {
+		// write the remaining partial aggregates to disk as well, the partitions are combined one at a time
+		state->ht->Spill(*context.db.temporary_directory, state->spill_partitions);
+		state->ht = CreateHashTable(*state);
+		state->partitions.resize(HASH_AGGREGATE_PARTITION_COUNT);
+	}
 
 	state->group_chunk.Reset();
 	state->aggregate_chunk.Reset();
-	index_t elements_found = state->ht->Scan(state->ht_scan_position, state->group_chunk, state->aggregate_chunk);
+	index_t elements_found = 0;
+	if (state->partitions.size() == 0) {
+		elements_found = state->ht->Scan(state->ht_scan_position, state->group_chunk, state->aggregate_chunk);
+	} else {
+		// after a partitioned parallel build or a spill, the groups are spread over the partitions: scan them one by one
+		while (elements_found == 0 && state->partition_idx < state->partitions.size()) {
+			auto &partition = state->partitions[state->partition_idx];
+			if (!partition) {
+				// the partition was spilled to disk: combine its partial aggregates first
+				partition = LoadSpilledPartition(*state, state->partition_idx);
+			}
+			elements_found = partition->Scan(state->ht_scan_position, state->group_chunk, state->aggregate_chunk);
+			if (elements_found == 0) {
+				// the partition is exhausted, release its memory
+				partition.reset();
+				state->partition_idx++;
+				state->ht_scan_position = 0;
+			}
+		}
+	}
 
 	// special case hack to sort out aggregating from empty intermediates
 	// for aggregations without groups
@@ -147,7 +351,8 @@ unique_ptr<PhysicalOperatorState> PhysicalHashAggregate::GetOperatorState() {
 
 PhysicalHashAggregateOperatorState::PhysicalHashAggregateOperatorState(PhysicalHashAggregate *parent,
                                                                        PhysicalOperator *child)
-    : PhysicalOperatorState(child), ht_scan_position(0), tuples_scanned(0) {
+    : PhysicalOperatorState(child), ht_scan_position(0), tuples_scanned(0), partition_idx(0), spilled(false) {
+	spill_partitions.resize(HASH_AGGREGATE_PARTITION_COUNT);
 	vector<TypeId> group_types, aggregate_types;
 	for (auto &expr : parent->groups) {
 		group_types.push_back(expr->return_type);
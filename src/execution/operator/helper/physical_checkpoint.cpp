@@ -0,0 +1,17 @@
+#include "execution/operator/helper/physical_checkpoint.hpp"
+
+#include "main/client_context.hpp"
+#include "main/database.hpp"
+#include "storage/storage_manager.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+void PhysicalCheckpoint::GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state) {
+	context.db.storage->CreateCheckpoint(true);
+
+	chunk.data[0].count = 1;
+	chunk.data[0].SetValue(0, Value::BOOLEAN(true));
+
+	state->finished = true;
+}
@@ -9,5 +9,6 @@ void PhysicalExecute::GetChunkInternal(ClientContext &context, DataChunk &chunk,
 }
 
 unique_ptr<PhysicalOperatorState> PhysicalExecute::GetOperatorState() {
-	return make_unique<PhysicalOperatorState>(plan->children.size() > 0 ? plan->children[0].get() : nullptr);
+	// every execution of the prepared plan gets a fresh state of the plan itself
+	return plan->GetOperatorState();
 }
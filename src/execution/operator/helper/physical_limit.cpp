@@ -26,10 +26,15 @@ void PhysicalLimit::GetChunkInternal(ClientContext &context, DataChunk &chunk, P
 			index_t chunk_count = min(limit, state->child_chunk.size() - start_position);
 			for (index_t i = 0; i < chunk.column_count; i++) {
 				chunk.data[i].Reference(state->child_chunk.data[i]);
-				chunk.data[i].data = chunk.data[i].data + GetTypeIdSize(chunk.data[i].type) * start_position;
+				if (chunk.data[i].sel_vector) {
+					chunk.data[i].sel_vector = chunk.data[i].sel_vector + start_position;
+				} else {
+					chunk.data[i].data = chunk.data[i].data + GetTypeIdSize(chunk.data[i].type) * start_position;
+					chunk.data[i].nullmask = chunk.data[i].nullmask >> start_position;
+				}
 				chunk.data[i].count = chunk_count;
 			}
-			chunk.sel_vector = move(state->child_chunk.sel_vector);
+			chunk.sel_vector = chunk.column_count > 0 ? chunk.data[0].sel_vector : nullptr;
 		}
 	} else {
 		// have to copy either the entire chunk or part of it
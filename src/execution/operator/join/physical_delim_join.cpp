@@ -30,7 +30,9 @@ void PhysicalDelimJoin::GetChunkInternal(ClientContext &context, DataChunk &chun
 	auto state = reinterpret_cast<PhysicalDelimJoinState *>(state_);
 	assert(distinct);
 	if (!state->join_state) {
-		// first run: fully materialize the LHS
+		// first run: fully materialize the LHS, discarding the data of a previous execution of a prepared statement
+		lhs_data.Reset();
+		delim_data.Reset();
 		ChunkCollection &big_data = lhs_data;
 		do {
 			children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
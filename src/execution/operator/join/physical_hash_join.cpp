@@ -1,7 +1,13 @@
 #include "execution/operator/join/physical_hash_join.hpp"
 
+#include "common/types/hash.hpp"
+#include "common/types/static_vector.hpp"
 #include "common/vector_operations/vector_operations.hpp"
 #include "execution/expression_executor.hpp"
+#include "main/client_context.hpp"
+#include "main/database.hpp"
+#include "parallel/pipeline_executor.hpp"
+#include "parallel/task_scheduler.hpp"
 
 using namespace duckdb;
 using namespace std;
@@ -15,41 +21,368 @@ PhysicalHashJoin::PhysicalHashJoin(LogicalOperator &op, unique_ptr<PhysicalOpera
 	children.push_back(move(right));
 }
 
-void PhysicalHashJoin::GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
-	auto state = reinterpret_cast<PhysicalHashJoinOperatorState *>(state_);
-	if (!state->initialized) {
-		// build the HT
-		auto right_state = children[1]->GetOperatorState();
+unique_ptr<JoinHashTable> PhysicalHashJoin::CreateHashTable() {
+	auto table = make_unique<JoinHashTable>(conditions, children[1]->GetTypes(), hash_table->join_type);
+	auto &correlated_types = hash_table->correlated_mark_join_info.correlated_types;
+	if (correlated_types.size() > 0) {
+		table->InitializeCorrelatedMarkJoin(correlated_types);
+	}
+	return table;
+}
+
+void PhysicalHashJoin::ResolveBuildKeys(DataChunk &join_keys, DataChunk &right_chunk) {
+	// resolve the join keys for the right chunk
+	join_keys.Reset();
+	ExpressionExecutor executor(right_chunk);
+	for (index_t i = 0; i < conditions.size(); i++) {
+		executor.ExecuteExpression(*conditions[i].right, join_keys.data[i]);
+	}
+}
+
+void PhysicalHashJoin::ParallelBuild(ClientContext &context, HashJoinBuildState &build,
+                                     PhysicalOperatorState *right_state, index_t thread_count) {
+	// every thread materializes its own chunks into a thread-local HT, without touching the hash map
+	auto build_types = children[1]->GetTypes();
+	vector<unique_ptr<DataChunk>> join_keys;
+	vector<unique_ptr<JoinHashTable>> local_tables;
+	for (index_t i = 0; i < thread_count; i++) {
+		auto keys = make_unique<DataChunk>();
+		keys->Initialize(hash_table->condition_types);
+		join_keys.push_back(move(keys));
+		local_tables.push_back(make_unique<JoinHashTable>(conditions, build_types, hash_table->join_type, 1));
+	}
+	bool can_spill = CanSpill(context);
+	atomic<index_t> build_memory(0);
+	auto sink = [&](index_t thread_idx, DataChunk &right_chunk) {
+		auto &keys = *join_keys[thread_idx];
+		ResolveBuildKeys(keys, right_chunk);
+		if (can_spill && !build.spilled) {
+			build_memory += right_chunk.MemoryUsage();
+			if (build_memory > context.db.maximum_memory) {
+				build.spilled = true;
+			}
+		}
+		if (build.spilled) {
+			// the build side exceeds the memory limit: write the remaining chunks to the partitions directly
+			lock_guard<mutex> guard(build.partition_lock);
+			PartitionChunk(*context.db.temporary_directory, *build.hash_table, keys, right_chunk,
+			               build.build_partitions, true);
+			return;
+		}
+		local_tables[thread_idx]->Append(keys, right_chunk);
+	};
+	PipelineExecutor::Execute(context, *children[1], right_state, thread_count, sink);
+	if (build.spilled) {
+		// move the entries that were already materialized to the partitions as well
+		for (auto &local_table : local_tables) {
+			SpillHashTable(context, build, *local_table);
+		}
+		return;
+	}
+	// move the entries of the thread-local HTs into the global HT and insert them into the hash map in parallel
+	for (auto &local_table : local_tables) {
+		build.hash_table->Merge(*local_table);
+	}
+	build.hash_table->Finalize(*context.db.scheduler, thread_count);
+}
+
+bool PhysicalHashJoin::ParallelProbe() {
+	// the correlated MARK join fetches the correlated counts using chunks that are shared by all probes
+	return hash_table->correlated_mark_join_info.correlated_types.size() == 0;
+}
+
+bool PhysicalHashJoin::CanSpill(ClientContext &context) {
+	// the correlated MARK join keeps its counts in a single aggregate HT, which cannot be partitioned
+	return context.db.maximum_memory != (index_t)-1 &&
+	       hash_table->correlated_mark_join_info.correlated_types.size() == 0;
+}
+
+void PhysicalHashJoin::SpillHashTable(ClientContext &context, HashJoinBuildState &build, JoinHashTable &table) {
+	build.hash_table->has_null = build.hash_table->has_null || table.has_null;
+	table.ScanEntries([&](DataChunk &keys, DataChunk &payload) {
+		PartitionChunk(*context.db.temporary_directory, *build.hash_table, keys, payload, build.build_partitions,
+		               true);
+	});
+}
+
+void PhysicalHashJoin::PartitionChunk(TemporaryDirectory &directory, JoinHashTable &table, DataChunk &keys,
+                                      DataChunk &payload, vector<unique_ptr<TemporaryFile>> &partitions,
+                                      bool build_side) {
+	auto count = keys.size();
+	if (count == 0) {
+		return;
+	}
+	// the keys can have selection vectors that are not set on the chunk: flatten every vector
+	for (index_t i = 0; i < keys.column_count; i++) {
+		keys.data[i].Flatten();
+	}
+	keys.sel_vector = nullptr;
+	bool discard[STANDARD_VECTOR_SIZE] = {false};
+	for (index_t i = 0; i < keys.column_count; i++) {
+		if (conditions[i].null_values_are_equal) {
+			VectorOperations::FillNullMask(keys.data[i]);
+		} else if (build_side) {
+			// rows with NULL keys can never find a match, but the MARK join needs to know that they exist
+			for (index_t k = 0; k < count; k++) {
+				if (keys.data[i].nullmask[k]) {
+					table.has_null = true;
+					discard[k] = true;
+				}
+			}
+		}
+	}
+	// the partition of a row is determined by the hash of its equality keys; the hash is mixed again because the low
+	// bits of the hash determine the position of the row in the hash map of the partition
+	StaticVector<uint64_t> hashes;
+	VectorOperations::Hash(keys.data[0], hashes);
+	for (index_t i = 1; i < table.equality_types.size(); i++) {
+		VectorOperations::CombineHash(hashes, keys.data[i]);
+	}
+	auto hash_data = (uint64_t *)hashes.data;
+	sel_t partition_sel[HASH_JOIN_PARTITION_COUNT][STANDARD_VECTOR_SIZE];
+	index_t partition_count[HASH_JOIN_PARTITION_COUNT] = {0};
+	for (index_t i = 0; i < count; i++) {
+		if (discard[i]) {
+			continue;
+		}
+		auto partition = murmurhash64(hash_data[i]) >> (64 - HASH_JOIN_PARTITION_BITS);
+		partition_sel[partition][partition_count[partition]++] = i;
+	}
+
+	// write the rows as [keys..., payload...]; the payload is only stored if the join outputs the build side
+	bool store_payload = !build_side || table.build_size > 0;
+	for (index_t i = 0; store_payload && i < payload.column_count; i++) {
+		payload.data[i].Flatten();
+	}
+	payload.sel_vector = nullptr;
+	auto types = keys.GetTypes();
+	if (store_payload) {
+		auto payload_types = payload.GetTypes();
+		types.insert(types.end(), payload_types.begin(), payload_types.end());
+	}
+	DataChunk partition_chunk;
+	partition_chunk.InitializeEmpty(types);
+	for (index_t partition = 0; partition < HASH_JOIN_PARTITION_COUNT; partition++) {
+		if (partition_count[partition] == 0) {
+			continue;
+		}
+		for (index_t i = 0; i < keys.column_count; i++) {
+			partition_chunk.data[i].Reference(keys.data[i]);
+		}
+		for (index_t i = 0; store_payload && i < payload.column_count; i++) {
+			partition_chunk.data[keys.column_count + i].Reference(payload.data[i]);
+		}
+		partition_chunk.sel_vector = partition_sel[partition];
+		for (index_t i = 0; i < partition_chunk.column_count; i++) {
+			partition_chunk.data[i].sel_vector = partition_chunk.sel_vector;
+			partition_chunk.data[i].count = partition_count[partition];
+		}
+		if (!partitions[partition]) {
+			partitions[partition] = make_unique<TemporaryFile>(directory);
+		}
+		partitions[partition]->Append(partition_chunk);
+	}
+}
+
+void PhysicalHashJoin::BuildHashTable(ClientContext &context, PhysicalOperatorState *state) {
+	auto &build = *((PhysicalHashJoinOperatorState *)state)->build;
+	lock_guard<mutex> guard(build.build_lock);
+	if (build.hash_table_built) {
+		return;
+	}
+	build.hash_table = CreateHashTable();
+	auto right_state = children[1]->GetOperatorState();
+	auto thread_count = PipelineExecutor::ParallelThreadCount(context, *children[1]);
+	if (thread_count > 1 && hash_table->correlated_mark_join_info.correlated_types.size() == 0) {
+		// the build side can be executed by multiple threads
+		ParallelBuild(context, build, right_state.get(), thread_count);
+	} else {
 		auto types = children[1]->GetTypes();
+		bool can_spill = CanSpill(context);
+		index_t build_memory = 0;
 
-		DataChunk right_chunk;
+		DataChunk right_chunk, join_keys;
 		right_chunk.Initialize(types);
-
-		state->join_keys.Initialize(hash_table->condition_types);
+		join_keys.Initialize(hash_table->condition_types);
 		while (true) {
 			// get the child chunk
 			children[1]->GetChunk(context, right_chunk, right_state.get());
 			if (right_chunk.size() == 0) {
 				break;
 			}
-			// resolve the join keys for the right chunk
-			state->join_keys.Reset();
-			ExpressionExecutor executor(right_chunk);
-			for (index_t i = 0; i < conditions.size(); i++) {
-				executor.ExecuteExpression(*conditions[i].right, state->join_keys.data[i]);
+			ResolveBuildKeys(join_keys, right_chunk);
+			if (build.spilled) {
+				// the build side exceeds the memory limit: write the chunk to the partitions
+				PartitionChunk(*context.db.temporary_directory, *build.hash_table, join_keys, right_chunk,
+				               build.build_partitions, true);
+				continue;
 			}
 			// build the HT
-			hash_table->Build(state->join_keys, right_chunk);
+			build_memory += right_chunk.MemoryUsage();
+			build.hash_table->Build(join_keys, right_chunk);
+			if (can_spill && build_memory > context.db.maximum_memory) {
+				// the HT does not fit in memory anymore: move its entries to the partitions
+				build.spilled = true;
+				auto full_table = move(build.hash_table);
+				build.hash_table = CreateHashTable();
+				SpillHashTable(context, build, *full_table);
+			}
 		}
+	}
+	build.hash_table_built = true;
+}
 
-		if (hash_table->size() == 0 &&
-		    (hash_table->join_type == JoinType::INNER || hash_table->join_type == JoinType::SEMI)) {
+void PhysicalHashJoin::ProbeHashTable(JoinHashTable &table, PhysicalHashJoinOperatorState &state, DataChunk &chunk) {
+	if (table.size() == 0) {
+		// empty hash table, special case
+		if (table.join_type == JoinType::INNER || table.join_type == JoinType::SEMI) {
 			// empty hash table with INNER or SEMI join means empty result set
 			return;
+		} else if (table.join_type == JoinType::ANTI) {
+			// anti join with empty hash table, NOP join
+			// return the input
+			assert(chunk.column_count == state.child_chunk.column_count);
+			for (index_t i = 0; i < chunk.column_count; i++) {
+				chunk.data[i].Reference(state.child_chunk.data[i]);
+			}
+			return;
+		} else if (table.join_type == JoinType::MARK) {
+			// MARK join with empty hash table
+			assert(chunk.column_count == state.child_chunk.column_count + 1);
+			auto &result_vector = chunk.data[state.child_chunk.column_count];
+			assert(result_vector.type == TypeId::BOOLEAN);
+			result_vector.count = state.child_chunk.size();
+			// for every data vector, we just reference the child chunk
+			for (index_t i = 0; i < state.child_chunk.column_count; i++) {
+				chunk.data[i].Reference(state.child_chunk.data[i]);
+			}
+			// for the MARK vector:
+			// if the HT has no NULL values (i.e. empty result set), return a vector that has false for every input
+			// entry if the HT has NULL values (i.e. result set had values, but all were NULL), return a vector that
+			// has NULL for every input entry
+			if (!table.has_null) {
+				auto bool_result = (bool *)result_vector.data;
+				for (index_t i = 0; i < result_vector.count; i++) {
+					bool_result[i] = false;
+				}
+			} else {
+				result_vector.nullmask.set();
+			}
+			return;
+		}
+	}
+	// perform the actual probe
+	state.scan_structure = table.Probe(state.join_keys);
+	state.scan_structure->Next(state.join_keys, state.child_chunk, chunk);
+}
+
+void PhysicalHashJoin::ProbePartitions(ClientContext &context, DataChunk &chunk, PhysicalHashJoinOperatorState &state) {
+	if (state.probe_partitions.size() == 0) {
+		// first partition the entire probe side
+		state.probe_partitions.resize(HASH_JOIN_PARTITION_COUNT);
+		while (true) {
+			children[0]->GetChunk(context, state.child_chunk, state.child_state.get());
+			if (state.child_chunk.size() == 0) {
+				break;
+			}
+			state.child_chunk.Flatten();
+			state.join_keys.Reset();
+			ExpressionExecutor executor(state.child_chunk);
+			for (index_t i = 0; i < conditions.size(); i++) {
+				executor.ExecuteExpression(*conditions[i].left, state.join_keys.data[i]);
+			}
+			PartitionChunk(*context.db.temporary_directory, *state.build->hash_table, state.join_keys,
+			               state.child_chunk, state.probe_partitions, false);
+		}
+	}
+	auto key_count = conditions.size();
+	while (true) {
+		if (state.scan_structure) {
+			// still have elements remaining from the previous probe
+			state.scan_structure->Next(state.join_keys, state.child_chunk, chunk);
+			if (chunk.size() > 0) {
+				return;
+			}
+			state.scan_structure = nullptr;
+		}
+		if (state.partition_index >= HASH_JOIN_PARTITION_COUNT) {
+			// joined all partitions
+			return;
+		}
+		auto &probe_partition = state.probe_partitions[state.partition_index];
+		if (!probe_partition) {
+			// no probe rows in this partition
+			state.partition_index++;
+			continue;
+		}
+		if (!state.partition_table) {
+			// build the HT of the partition
+			state.partition_table = CreateHashTable();
+			state.partition_table->has_null = state.build->hash_table->has_null;
+			auto &build_partition = state.build->build_partitions[state.partition_index];
+			if (build_partition) {
+				build_partition->Rewind();
+				DataChunk build_chunk, keys, payload;
+				while (build_partition->Scan(build_chunk)) {
+					auto types = build_chunk.GetTypes();
+					vector<TypeId> key_types(types.begin(), types.begin() + key_count);
+					keys.InitializeEmpty(key_types);
+					for (index_t i = 0; i < key_count; i++) {
+						keys.data[i].Reference(build_chunk.data[i]);
+					}
+					if (build_chunk.column_count == key_count) {
+						// the build-side columns are not stored in the HT for this join type: only pass the keys
+						state.partition_table->Build(keys, keys);
+						continue;
+					}
+					vector<TypeId> payload_types(types.begin() + key_count, types.end());
+					payload.InitializeEmpty(payload_types);
+					for (index_t i = 0; i < payload.column_count; i++) {
+						payload.data[i].Reference(build_chunk.data[key_count + i]);
+					}
+					state.partition_table->Build(keys, payload);
+				}
+			}
+		}
+		// probe the HT with the next chunk of the probe partition
+		if (!probe_partition->Scan(state.partition_chunk)) {
+			// finished this partition
+			probe_partition = nullptr;
+			state.partition_table = nullptr;
+			state.partition_index++;
+			continue;
+		}
+		for (index_t i = 0; i < key_count; i++) {
+			state.join_keys.data[i].Reference(state.partition_chunk.data[i]);
 		}
+		for (index_t i = 0; i < state.child_chunk.column_count; i++) {
+			state.child_chunk.data[i].Reference(state.partition_chunk.data[key_count + i]);
+		}
+		ProbeHashTable(*state.partition_table, state, chunk);
+		if (chunk.size() > 0) {
+			return;
+		}
+	}
+}
 
+void PhysicalHashJoin::GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalHashJoinOperatorState *>(state_);
+	if (!state->initialized) {
+		// build the HT
+		state->join_keys.Initialize(hash_table->condition_types);
+		BuildHashTable(context, state);
 		state->initialized = true;
 	}
+	auto &table = *state->build->hash_table;
+	if (state->build->spilled) {
+		// the build side did not fit in memory: join the partitions one by one
+		ProbePartitions(context, chunk, *state);
+		return;
+	}
+	if (table.size() == 0 && (table.join_type == JoinType::INNER || table.join_type == JoinType::SEMI)) {
+		// empty hash table with INNER or SEMI join means empty result set
+		return;
+	}
 	if (state->child_chunk.size() > 0 && state->scan_structure) {
 		// still have elements remaining from the previous probe (i.e. we got
 		// >1024 elements in the previous probe)
@@ -69,51 +402,13 @@ void PhysicalHashJoin::GetChunkInternal(ClientContext &context, DataChunk &chunk
 		}
 		// remove any selection vectors
 		state->child_chunk.Flatten();
-		if (hash_table->size() == 0) {
-			// empty hash table, special case
-			if (hash_table->join_type == JoinType::ANTI) {
-				// anti join with empty hash table, NOP join
-				// return the input
-				assert(chunk.column_count == state->child_chunk.column_count);
-				for (index_t i = 0; i < chunk.column_count; i++) {
-					chunk.data[i].Reference(state->child_chunk.data[i]);
-				}
-				return;
-			} else if (hash_table->join_type == JoinType::MARK) {
-				// MARK join with empty hash table
-				assert(hash_table->join_type == JoinType::MARK);
-				assert(chunk.column_count == state->child_chunk.column_count + 1);
-				auto &result_vector = chunk.data[state->child_chunk.column_count];
-				assert(result_vector.type == TypeId::BOOLEAN);
-				result_vector.count = state->child_chunk.size();
-				// for every data vector, we just reference the child chunk
-				for (index_t i = 0; i < state->child_chunk.column_count; i++) {
-					chunk.data[i].Reference(state->child_chunk.data[i]);
-				}
-				// for the MARK vector:
-				// if the HT has no NULL values (i.e. empty result set), return a vector that has false for every input
-				// entry if the HT has NULL values (i.e. result set had values, but all were NULL), return a vector that
-				// has NULL for every input entry
-				if (!hash_table->has_null) {
-					auto bool_result = (bool *)result_vector.data;
-					for (index_t i = 0; i < result_vector.count; i++) {
-						bool_result[i] = false;
-					}
-				} else {
-					result_vector.nullmask.set();
-				}
-				return;
-			}
-		}
 		// resolve the join keys for the left chunk
 		state->join_keys.Reset();
 		ExpressionExecutor executor(state->child_chunk);
 		for (index_t i = 0; i < conditions.size(); i++) {
 			executor.ExecuteExpression(*conditions[i].left, state->join_keys.data[i]);
 		}
-		// perform the actual probe
-		state->scan_structure = hash_table->Probe(state->join_keys);
-		state->scan_structure->Next(state->join_keys, state->child_chunk, chunk);
+		ProbeHashTable(table, *state, chunk);
 	} while (chunk.size() == 0);
 }
 
@@ -4,48 +4,89 @@
 #include "common/value_operations/value_operations.hpp"
 #include "common/vector_operations/vector_operations.hpp"
 #include "execution/expression_executor.hpp"
+#include "main/client_context.hpp"
+#include "main/database.hpp"
+#include "parallel/pipeline_executor.hpp"
 #include "storage/data_table.hpp"
 
+#include <algorithm>
+#include <mutex>
+
 using namespace duckdb;
 using namespace std;
 
 void PhysicalOrder::GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
 	auto state = reinterpret_cast<PhysicalOrderOperatorState *>(state_);
 	ChunkCollection &big_data = state->sorted_data;
-	if (state->position == 0) {
+	if (!state->finished_sink) {
 		// first concatenate all the data of the child chunks
-		do {
-			children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
-			big_data.Append(state->child_chunk);
-		} while (state->child_chunk.size() != 0);
-
-		// now perform the actual ordering of the data
-		// compute the sorting columns from the input data
-		vector<TypeId> sort_types;
-		vector<Expression *> order_expressions;
-		vector<OrderType> order_types;
-		for (index_t i = 0; i < orders.size(); i++) {
-			auto &expr = orders[i].expression;
-			sort_types.push_back(expr->return_type);
-			order_expressions.push_back(expr.get());
-			order_types.push_back(orders[i].type);
-		}
+		// every thread collects its own chunks; if a thread exceeds its share of the memory limit, it sorts its
+		// chunks and spills them to disk as a sorted run
+		auto thread_count = PipelineExecutor::ParallelThreadCount(context, *children[0]);
+		index_t memory_limit = context.db.maximum_memory;
+		index_t thread_limit = memory_limit == (index_t)-1 ? memory_limit : memory_limit / max((index_t)1, thread_count);
 
-		ChunkCollection sort_collection;
-		for (index_t i = 0; i < big_data.chunks.size(); i++) {
-			DataChunk sort_chunk;
-			sort_chunk.Initialize(sort_types);
+		vector<unique_ptr<ChunkCollection>> thread_data;
+		vector<index_t> thread_memory;
+		for (index_t i = 0; i < max((index_t)1, thread_count); i++) {
+			thread_data.push_back(make_unique<ChunkCollection>());
+			thread_memory.push_back(0);
+		}
+		mutex run_lock;
+		auto sink = [&](index_t thread_idx, DataChunk &input) {
+			thread_data[thread_idx]->Append(input);
+			thread_memory[thread_idx] += input.MemoryUsage();
+			if (thread_memory[thread_idx] > thread_limit) {
+				auto run = SpillRun(context, *thread_data[thread_idx]);
+				thread_data[thread_idx] = make_unique<ChunkCollection>();
+				thread_memory[thread_idx] = 0;
 
-			ExpressionExecutor executor(*big_data.chunks[i]);
-			executor.Execute(order_expressions, sort_chunk);
-			sort_collection.Append(sort_chunk);
+				lock_guard<mutex> guard(run_lock);
+				state->runs.push_back(SortedRun{move(run), nullptr, 0});
+			}
+		};
+		if (thread_count > 1) {
+			// the child pipeline can be executed by multiple threads
+			PipelineExecutor::Execute(context, *children[0], state->child_state.get(), thread_count, sink);
+		} else {
+			do {
+				children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
+				sink(0, state->child_chunk);
+			} while (state->child_chunk.size() != 0);
 		}
+		state->finished_sink = true;
 
-		assert(sort_collection.count == big_data.count);
+		if (state->runs.size() == 0) {
+			// everything fits in memory: sort the data in-memory
+			for (auto &collection : thread_data) {
+				for (auto &thread_chunk : collection->chunks) {
+					big_data.Append(*thread_chunk);
+				}
+			}
+			ChunkCollection sort_collection;
+			state->sorted_vector = SortCollection(big_data, sort_collection);
+		} else {
+			// we spilled to disk: spill the remaining data as well and merge the sorted runs
+			for (auto &collection : thread_data) {
+				if (collection->count > 0) {
+					state->runs.push_back(SortedRun{SpillRun(context, *collection), nullptr, 0});
+					collection.reset();
+				}
+			}
+			// load the first chunk of every run
+			for (index_t i = 0; i < state->runs.size(); i++) {
+				auto &run = state->runs[i];
+				run.chunk = make_unique<DataChunk>();
+				if (run.file->Scan(*run.chunk)) {
+					state->merge_heap.push_back(i);
+				}
+			}
+		}
+	}
 
-		// now perform the actual sort
-		state->sorted_vector = unique_ptr<index_t[]>(new index_t[sort_collection.count]);
-		sort_collection.Sort(order_types, state->sorted_vector.get());
+	if (state->runs.size() > 0) {
+		MergeRuns(chunk, state);
+		return;
 	}
 
 	if (state->position >= big_data.count) {
@@ -56,6 +97,162 @@ void PhysicalOrder::GetChunkInternal(ClientContext &context, DataChunk &chunk, P
 	state->position += STANDARD_VECTOR_SIZE;
 }
 
+unique_ptr<index_t[]> PhysicalOrder::SortCollection(ChunkCollection &collection, ChunkCollection &sort_collection) {
+	// compute the sorting columns from the input data
+	vector<TypeId> sort_types;
+	vector<Expression *> order_expressions;
+	vector<OrderType> order_types;
+	for (index_t i = 0; i < orders.size(); i++) {
+		auto &expr = orders[i].expression;
+		sort_types.push_back(expr->return_type);
+		order_expressions.push_back(expr.get());
+		order_types.push_back(orders[i].type);
+	}
+
+	for (index_t i = 0; i < collection.chunks.size(); i++) {
+		DataChunk sort_chunk;
+		sort_chunk.Initialize(sort_types);
+
+		ExpressionExecutor executor(*collection.chunks[i]);
+		executor.Execute(order_expressions, sort_chunk);
+		sort_collection.Append(sort_chunk);
+	}
+
+	assert(sort_collection.count == collection.count);
+
+	// now perform the actual sort
+	auto sorted_vector = unique_ptr<index_t[]>(new index_t[sort_collection.count]);
+	sort_collection.Sort(order_types, sorted_vector.get());
+	return sorted_vector;
+}
+
+unique_ptr<TemporaryFile> PhysicalOrder::SpillRun(ClientContext &context, ChunkCollection &collection) {
+	assert(collection.count > 0);
+	ChunkCollection sort_collection;
+	auto sorted_vector = SortCollection(collection, sort_collection);
+
+	// write the sorted data to the run as [sort keys..., payload...]
+	DataChunk keys, payload, run_chunk;
+	keys.Initialize(sort_collection.types);
+	payload.Initialize(collection.types);
+	vector<TypeId> run_types = sort_collection.types;
+	run_types.insert(run_types.end(), collection.types.begin(), collection.types.end());
+	run_chunk.InitializeEmpty(run_types);
+
+	auto run = make_unique<TemporaryFile>(*context.db.temporary_directory);
+	for (index_t offset = 0; offset < collection.count; offset += STANDARD_VECTOR_SIZE) {
+		sort_collection.MaterializeSortedChunk(keys, sorted_vector.get(), offset);
+		collection.MaterializeSortedChunk(payload, sorted_vector.get(), offset);
+		for (index_t i = 0; i < keys.column_count; i++) {
+			run_chunk.data[i].Reference(keys.data[i]);
+		}
+		for (index_t i = 0; i < payload.column_count; i++) {
+			run_chunk.data[keys.column_count + i].Reference(payload.data[i]);
+		}
+		run->Append(run_chunk);
+	}
+	return run;
+}
+
+template <class T>
+static void merge_copy(Vector &target, DataChunk *sources[], index_t positions[], index_t column, index_t count) {
+	auto target_data = (T *)target.data;
+	for (index_t i = 0; i < count; i++) {
+		auto &source = sources[i]->data[column];
+		target.nullmask[i] = source.nullmask[positions[i]];
+		target_data[i] = ((T *)source.data)[positions[i]];
+	}
+	target.count = count;
+}
+
+void PhysicalOrder::MergeRuns(DataChunk &chunk, PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalOrderOperatorState *>(state_);
+	auto &runs = state->runs;
+	auto &heap = state->merge_heap;
+	// the strings of the previous result can now be released
+	state->exhausted_chunks.clear();
+
+	vector<OrderType> order_types;
+	for (index_t i = 0; i < orders.size(); i++) {
+		order_types.push_back(orders[i].type);
+	}
+	// the heap is a max-heap, so the run with the smallest current row should compare as largest; ties are broken
+	// on the run index
+	auto compare = [&](index_t a, index_t b) {
+		auto cmp = ChunkCollection::CompareRows(*runs[a].chunk, runs[a].position, *runs[b].chunk, runs[b].position,
+		                                        order_types);
+		return cmp == 0 ? a > b : cmp > 0;
+	};
+	if (!state->initialized_merge) {
+		make_heap(heap.begin(), heap.end(), compare);
+		state->initialized_merge = true;
+	}
+
+	// select the next STANDARD_VECTOR_SIZE rows from the runs
+	DataChunk *sources[STANDARD_VECTOR_SIZE];
+	index_t positions[STANDARD_VECTOR_SIZE];
+	index_t result_count = 0;
+	while (result_count < STANDARD_VECTOR_SIZE && heap.size() > 0) {
+		pop_heap(heap.begin(), heap.end(), compare);
+		auto run_idx = heap.back();
+		heap.pop_back();
+
+		auto &run = runs[run_idx];
+		sources[result_count] = run.chunk.get();
+		positions[result_count] = run.position;
+		result_count++;
+
+		run.position++;
+		if (run.position >= run.chunk->size()) {
+			// exhausted the current chunk of the run: load the next one
+			state->exhausted_chunks.push_back(move(run.chunk));
+			run.chunk = make_unique<DataChunk>();
+			run.position = 0;
+			if (!run.file->Scan(*run.chunk)) {
+				// exhausted the run
+				run.file.reset();
+				continue;
+			}
+		}
+		heap.push_back(run_idx);
+		push_heap(heap.begin(), heap.end(), compare);
+	}
+
+	// copy the payload of the selected rows into the result
+	auto key_count = orders.size();
+	for (index_t col_idx = 0; col_idx < chunk.column_count; col_idx++) {
+		auto &target = chunk.data[col_idx];
+		auto column = key_count + col_idx;
+		switch (target.type) {
+		case TypeId::BOOLEAN:
+		case TypeId::TINYINT:
+			merge_copy<int8_t>(target, sources, positions, column, result_count);
+			break;
+		case TypeId::SMALLINT:
+			merge_copy<int16_t>(target, sources, positions, column, result_count);
+			break;
+		case TypeId::INTEGER:
+			merge_copy<int32_t>(target, sources, positions, column, result_count);
+			break;
+		case TypeId::BIGINT:
+			merge_copy<int64_t>(target, sources, positions, column, result_count);
+			break;
+		case TypeId::FLOAT:
+			merge_copy<float>(target, sources, positions, column, result_count);
+			break;
+		case TypeId::DOUBLE:
+			merge_copy<double>(target, sources, positions, column, result_count);
+			break;
+		case TypeId::VARCHAR:
+			merge_copy<const char *>(target, sources, positions, column, result_count);
+			break;
+		default:
+			throw NotImplementedException("Unimplemented type for external sort");
+		}
+	}
+	chunk.Verify();
+}
+
 unique_ptr<PhysicalOperatorState> PhysicalOrder::GetOperatorState() {
 	return make_unique<PhysicalOrderOperatorState>(children[0].get());
 }
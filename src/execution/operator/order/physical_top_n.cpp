@@ -0,0 +1,206 @@
+#include "execution/operator/order/physical_top_n.hpp"
+
+#include "execution/expression_executor.hpp"
+#include "parallel/pipeline_executor.hpp"
+
+#include <algorithm>
+
+using namespace duckdb;
+using namespace std;
+
+TopNHeap::TopNHeap(vector<OrderType> order_types, index_t heap_size)
+    : order_types(move(order_types)), heap_size(heap_size) {
+}
+
+int TopNHeap::CompareRows(index_t left, index_t right) {
+	auto cmp = ChunkCollection::CompareRows(*data.chunks[left / STANDARD_VECTOR_SIZE], left % STANDARD_VECTOR_SIZE,
+	                                        *data.chunks[right / STANDARD_VECTOR_SIZE], right % STANDARD_VECTOR_SIZE,
+	                                        order_types);
+	if (cmp != 0) {
+		return cmp;
+	}
+	return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+void TopNHeap::Append(DataChunk &input) {
+	assert(!input.sel_vector);
+	if (heap_size == 0 || input.size() == 0) {
+		return;
+	}
+	auto compare = [&](index_t left, index_t right) { return CompareRows(left, right) < 0; };
+
+	// first figure out which rows of the input can enter the heap: if the heap is full, only rows that come before
+	// the current last row of the heap qualify
+	sel_t sel[STANDARD_VECTOR_SIZE];
+	index_t count = 0;
+	if (heap.size() < heap_size) {
+		for (index_t i = 0; i < input.size(); i++) {
+			sel[count++] = i;
+		}
+	} else {
+		auto last = heap[0];
+		auto &last_chunk = *data.chunks[last / STANDARD_VECTOR_SIZE];
+		for (index_t i = 0; i < input.size(); i++) {
+			if (ChunkCollection::CompareRows(input, i, last_chunk, last % STANDARD_VECTOR_SIZE, order_types) < 0) {
+				sel[count++] = i;
+			}
+		}
+	}
+	if (count == 0) {
+		return;
+	}
+
+	// append the qualifying rows to the data collection
+	auto input_count = input.size();
+	input.sel_vector = count == input_count ? nullptr : sel;
+	for (index_t col_idx = 0; col_idx < input.column_count; col_idx++) {
+		input.data[col_idx].sel_vector = input.sel_vector;
+		input.data[col_idx].count = count;
+	}
+	index_t start = data.count;
+	data.Append(input);
+	input.sel_vector = nullptr;
+	for (index_t col_idx = 0; col_idx < input.column_count; col_idx++) {
+		input.data[col_idx].sel_vector = nullptr;
+		input.data[col_idx].count = input_count;
+	}
+
+	// now add them to the heap, evicting the last row whenever the heap overflows
+	for (index_t row = start; row < data.count; row++) {
+		heap.push_back(row);
+		push_heap(heap.begin(), heap.end(), compare);
+		if (heap.size() > heap_size) {
+			pop_heap(heap.begin(), heap.end(), compare);
+			heap.pop_back();
+		}
+	}
+
+	// evicted rows stay in the data collection, periodically get rid of them
+	// the threshold saturates: heap_size is limit + offset, which can be close to the maximum index
+	index_t compact_threshold = heap_size > (index_t)-1 / 2 ? (index_t)-1 : 2 * heap_size;
+	if (data.count > max(compact_threshold, (index_t)4 * STANDARD_VECTOR_SIZE)) {
+		Compact();
+		make_heap(heap.begin(), heap.end(), compare);
+	}
+}
+
+void TopNHeap::Combine(TopNHeap &other) {
+	for (auto &chunk : other.data.chunks) {
+		Append(*chunk);
+	}
+}
+
+void TopNHeap::Compact() {
+	ChunkCollection new_data;
+	if (heap.size() > 0) {
+		DataChunk rows;
+		rows.Initialize(data.types);
+		for (index_t i = 0; i < heap.size(); i += STANDARD_VECTOR_SIZE) {
+			data.MaterializeRows(rows, &heap[i], min((index_t)STANDARD_VECTOR_SIZE, heap.size() - i));
+			new_data.Append(rows);
+		}
+	}
+	data = move(new_data);
+	for (index_t i = 0; i < heap.size(); i++) {
+		heap[i] = i;
+	}
+}
+
+void TopNHeap::Finalize(index_t offset) {
+	auto compare = [&](index_t left, index_t right) { return CompareRows(left, right) < 0; };
+	sort(heap.begin(), heap.end(), compare);
+	heap.erase(heap.begin(), heap.begin() + min(offset, (index_t)heap.size()));
+	Compact();
+}
+
+void PhysicalTopN::Sink(DataChunk &input, TopNHeap &heap) {
+	if (input.size() == 0) {
+		return;
+	}
+	input.Flatten();
+
+	// compute the sort keys
+	vector<TypeId> sort_types;
+	vector<Expression *> order_expressions;
+	for (index_t i = 0; i < orders.size(); i++) {
+		sort_types.push_back(orders[i].expression->return_type);
+		order_expressions.push_back(orders[i].expression.get());
+	}
+	DataChunk keys;
+	keys.Initialize(sort_types);
+	ExpressionExecutor executor(input);
+	executor.Execute(order_expressions, keys);
+	keys.Flatten();
+
+	// append [sort keys..., payload...] to the heap
+	vector<TypeId> heap_types = sort_types;
+	heap_types.insert(heap_types.end(), types.begin(), types.end());
+	DataChunk heap_chunk;
+	heap_chunk.InitializeEmpty(heap_types);
+	for (index_t i = 0; i < keys.column_count; i++) {
+		heap_chunk.data[i].Reference(keys.data[i]);
+	}
+	for (index_t i = 0; i < input.column_count; i++) {
+		heap_chunk.data[keys.column_count + i].Reference(input.data[i]);
+	}
+	heap.Append(heap_chunk);
+}
+
+void PhysicalTopN::GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalTopNOperatorState *>(state_);
+	if (!state->heap) {
+		vector<OrderType> order_types;
+		for (index_t i = 0; i < orders.size(); i++) {
+			order_types.push_back(orders[i].type);
+		}
+		// limit + offset can overflow if only an OFFSET is given
+		index_t heap_size = limit + offset < limit ? (index_t)-1 : limit + offset;
+
+		auto thread_count = PipelineExecutor::ParallelThreadCount(context, *children[0]);
+		if (thread_count > 1) {
+			// the child pipeline can be executed by multiple threads: every thread fills its own heap
+			vector<unique_ptr<TopNHeap>> heaps;
+			for (index_t i = 0; i < thread_count; i++) {
+				heaps.push_back(make_unique<TopNHeap>(order_types, heap_size));
+			}
+			PipelineExecutor::Execute(context, *children[0], state->child_state.get(), thread_count,
+			                          [&](index_t thread_idx, DataChunk &input) { Sink(input, *heaps[thread_idx]); });
+			// combine the heaps of the threads
+			for (index_t i = 1; i < thread_count; i++) {
+				heaps[0]->Combine(*heaps[i]);
+			}
+			state->heap = move(heaps[0]);
+		} else {
+			state->heap = make_unique<TopNHeap>(order_types, heap_size);
+			do {
+				children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
+				Sink(state->child_chunk, *state->heap);
+			} while (state->child_chunk.size() != 0);
+		}
+		state->heap->Finalize(offset);
+	}
+
+	auto &data = state->heap->data;
+	if (state->position >= data.chunks.size()) {
+		return;
+	}
+	// the heap holds [sort keys..., payload...]: only output the payload
+	auto &result = *data.chunks[state->position];
+	auto key_count = orders.size();
+	for (index_t i = 0; i < chunk.column_count; i++) {
+		chunk.data[i].Reference(result.data[key_count + i]);
+	}
+	state->position++;
+}
+
+string PhysicalTopN::ExtraRenderInformation() const {
+	string extra_info = "Top " + to_string(limit);
+	if (offset > 0) {
+		extra_info += "\nOffset " + to_string(offset);
+	}
+	return extra_info;
+}
+
+unique_ptr<PhysicalOperatorState> PhysicalTopN::GetOperatorState() {
+	return make_unique<PhysicalTopNOperatorState>(children[0].get());
+}
@@ -13,8 +13,12 @@ void PhysicalIndexScan::GetChunkInternal(ClientContext &context, DataChunk &chun
 
 	if (!state->scan_state) {
 		// initialize the scan state of the index
+		// An equality predicate selects the fewest entries, so it is preferred over the range predicates
+		if (equal_index) {
+			state->scan_state = index.InitializeScanEqual(context.ActiveTransaction(), column_ids, equal_values);
+		}
 		// We have a query with two predicates
-		if (low_index && high_index) {
+		else if (low_index && high_index) {
 			state->scan_state =
 			    index.InitializeScanTwoPredicates(context.ActiveTransaction(), column_ids, low_value,
 			                                      low_expression_type, high_value, high_expression_type);
@@ -27,9 +31,6 @@ void PhysicalIndexScan::GetChunkInternal(ClientContext &context, DataChunk &chun
 			else if (high_index)
 				state->scan_state = index.InitializeScanSinglePredicate(context.ActiveTransaction(), column_ids,
 				                                                        high_value, high_expression_type);
-			else if (equal_index)
-				state->scan_state = index.InitializeScanSinglePredicate(context.ActiveTransaction(), column_ids,
-				                                                        equal_value, ExpressionType::COMPARE_EQUAL);
 		}
 	}
 
@@ -11,11 +11,27 @@ void PhysicalTableScan::GetChunkInternal(ClientContext &context, DataChunk &chun
 	if (column_ids.size() == 0)
 		return;
 
-	table.Scan(context.ActiveTransaction(), chunk, column_ids, state->scan_offset);
+	auto &transaction = context.ActiveTransaction();
+	if (!state->parallel_state) {
+		table.Scan(transaction, chunk, column_ids, state->scan_offset, table_filters);
+		return;
+	}
+	// parallel scan: keep on fetching new morsels until we find a non-empty chunk or the table is exhausted
+	do {
+		table.Scan(transaction, chunk, column_ids, state->scan_offset, table_filters);
+		if (chunk.size() > 0) {
+			return;
+		}
+	} while (table.NextParallelScan(*state->parallel_state, state->scan_offset));
 }
 
 string PhysicalTableScan::ExtraRenderInformation() const {
-	return tableref.name;
+	string extra_info = tableref.name;
+	for (auto &filter : table_filters) {
+		extra_info += "\n" + tableref.columns[column_ids[filter.column_index]].name +
+		              ExpressionTypeToOperator(filter.comparison_type) + filter.constant.ToString();
+	}
+	return extra_info;
 }
 
 unique_ptr<PhysicalOperatorState> PhysicalTableScan::GetOperatorState() {
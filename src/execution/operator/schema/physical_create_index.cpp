@@ -26,10 +26,6 @@ void PhysicalCreateIndex::GetChunkInternal(ClientContext &context, DataChunk &ch
 		return;
 	}
 
-	// create the chunk to hold intermediate expression results
-	// "Multidimensional indexes not supported yet"
-	assert(expressions.size() == 1);
-
 	switch (info->index_type) {
 	case IndexType::ART: {
 		CreateARTIndex();
@@ -0,0 +1,10 @@
+#include "execution/operator/helper/physical_checkpoint.hpp"
+#include "execution/physical_plan_generator.hpp"
+#include "planner/operator/logical_checkpoint.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalCheckpoint &op) {
+	return make_unique<PhysicalCheckpoint>(op);
+}
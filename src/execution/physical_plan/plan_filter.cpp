@@ -1,17 +1,62 @@
 #include "execution/operator/filter/physical_filter.hpp"
+#include "execution/operator/scan/physical_table_scan.hpp"
 #include "execution/physical_plan_generator.hpp"
 #include "optimizer/matcher/expression_matcher.hpp"
 #include "planner/expression/bound_comparison_expression.hpp"
 #include "planner/expression/bound_constant_expression.hpp"
+#include "planner/expression/bound_reference_expression.hpp"
 #include "planner/operator/logical_filter.hpp"
 #include "planner/operator/logical_get.hpp"
 
 using namespace duckdb;
 using namespace std;
 
+//! Extract the comparisons between a column and a constant from the filter expressions and push them into the table
+//! scan, which evaluates them while scanning the base table. The pushed expressions are removed from the filter.
+static void ExtractTableFilters(vector<unique_ptr<Expression>> &expressions, PhysicalTableScan &scan) {
+	for (index_t expr_idx = 0; expr_idx < expressions.size(); expr_idx++) {
+		auto &expr = expressions[expr_idx];
+		if (expr->GetExpressionClass() != ExpressionClass::BOUND_COMPARISON) {
+			continue;
+		}
+		auto comparison_type = expr->type;
+		if (comparison_type != ExpressionType::COMPARE_EQUAL &&
+		    comparison_type != ExpressionType::COMPARE_GREATERTHAN &&
+		    comparison_type != ExpressionType::COMPARE_GREATERTHANOREQUALTO &&
+		    comparison_type != ExpressionType::COMPARE_LESSTHAN &&
+		    comparison_type != ExpressionType::COMPARE_LESSTHANOREQUALTO) {
+			continue;
+		}
+		auto &comparison = (BoundComparisonExpression &)*expr;
+		Expression *column = comparison.left.get(), *constant = comparison.right.get();
+		if (column->GetExpressionClass() == ExpressionClass::BOUND_CONSTANT) {
+			// constant on the left side: flip the comparison
+			swap(column, constant);
+			comparison_type = FlipComparisionExpression(comparison_type);
+		}
+		if (column->GetExpressionClass() != ExpressionClass::BOUND_REF ||
+		    constant->GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+			continue;
+		}
+		auto column_index = ((BoundReferenceExpression *)column)->index;
+		auto &value = ((BoundConstantExpression *)constant)->value;
+		if (value.is_null || value.type != column->return_type ||
+		    scan.column_ids[column_index] == COLUMN_IDENTIFIER_ROW_ID) {
+			continue;
+		}
+		scan.table_filters.push_back(TableFilter(value, comparison_type, column_index));
+		expressions.erase(expressions.begin() + expr_idx);
+		expr_idx--;
+	}
+}
+
 unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalFilter &op) {
 	assert(op.children.size() == 1);
 	unique_ptr<PhysicalOperator> plan = CreatePlan(*op.children[0]);
+	if (plan->type == PhysicalOperatorType::SEQ_SCAN) {
+		// filter directly on top of a table scan: push the constant comparisons into the scan
+		ExtractTableFilters(op.expressions, (PhysicalTableScan &)*plan);
+	}
 	if (op.expressions.size() > 0) {
 		// create a filter if there is anything to filter
 		auto filter = make_unique<PhysicalFilter>(op, move(op.expressions));
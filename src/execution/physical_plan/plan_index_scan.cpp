@@ -18,7 +18,7 @@ unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalIndexScan
 	unique_ptr<PhysicalOperator> plan;
 	auto node = make_unique<PhysicalIndexScan>(op, op.tableref, op.table, op.index, op.column_ids);
 	if (op.equal_index) {
-		node->equal_value = op.equal_value;
+		node->equal_values = op.equal_values;
 		node->equal_index = true;
 	}
 	if (op.low_index) {
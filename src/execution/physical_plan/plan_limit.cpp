@@ -1,6 +1,10 @@
 #include "execution/operator/helper/physical_limit.hpp"
+#include "execution/operator/order/physical_top_n.hpp"
 #include "execution/physical_plan_generator.hpp"
 #include "planner/operator/logical_limit.hpp"
+#include "planner/operator/logical_order.hpp"
+
+#include <limits>
 
 using namespace duckdb;
 using namespace std;
@@ -8,6 +12,17 @@ using namespace std;
 unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalLimit &op) {
 	assert(op.children.size() == 1);
 
+	if (op.children[0]->type == LogicalOperatorType::ORDER_BY && op.limit != numeric_limits<int64_t>::max()) {
+		// ORDER BY followed by a LIMIT: only the first limit + offset rows of the order are required, so we can use
+		// a Top-N operator instead of sorting the entire input
+		auto &order = (LogicalOrder &)*op.children[0];
+		auto plan = CreatePlan(*order.children[0]);
+
+		auto top_n = make_unique<PhysicalTopN>(op, move(order.orders), op.limit, op.offset);
+		top_n->children.push_back(move(plan));
+		return move(top_n);
+	}
+
 	auto plan = CreatePlan(*op.children[0]);
 
 	auto limit = make_unique<PhysicalLimit>(op, op.limit, op.offset);
@@ -104,6 +104,8 @@ unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalOperator &
 		return CreatePlan((LogicalCreateTable &)op);
 	case LogicalOperatorType::CREATE_INDEX:
 		return CreatePlan((LogicalCreateIndex &)op);
+	case LogicalOperatorType::CHECKPOINT:
+		return CreatePlan((LogicalCheckpoint &)op);
 	case LogicalOperatorType::EXPLAIN:
 		return CreatePlan((LogicalExplain &)op);
 	case LogicalOperatorType::DISTINCT:
@@ -64,12 +64,18 @@ void WindowSegmentTree::WindowSegmentValue(index_t l_idx, index_t begin, index_t
 		aggregate.update(&inputs[0], input_count, s);
 	} else {
 		assert(end - begin < STANDARD_VECTOR_SIZE);
-		v.data = levels_flat_native.get() + state.size() * (begin + levels_flat_start[l_idx - 1]);
+		// combine the states of the segment tree nodes
+		data_ptr_t state_pointers[STANDARD_VECTOR_SIZE];
+		auto begin_ptr = levels_flat_native.get() + state.size() * (begin + levels_flat_start[l_idx - 1]);
+		for (index_t i = 0; i < end - begin; i++) {
+			state_pointers[i] = begin_ptr + i * state.size();
+		}
+		v.type = TypeId::POINTER;
+		v.data = (data_ptr_t)state_pointers;
 		v.count = end - begin;
-		v.type = result_type;
 		assert(!v.sel_vector);
 		v.Verify();
-		aggregate.combine(v, s);
+		aggregate.combine(v, s, result_type);
 	}
 }
 
@@ -37,14 +37,14 @@ static void avg_update(Vector inputs[], index_t input_count, Vector &state) {
 	});
 }
 
-static void avg_combine(Vector &state, Vector &combined) {
+static void avg_combine(Vector &state, Vector &combined, TypeId return_type) {
 	// combine streaming avg states
 	auto combined_data = (avg_state_t**) combined.data;
-	auto state_data = (avg_state_t*) state.data;
+	auto state_data = (avg_state_t**) state.data;
 
 	VectorOperations::Exec(state, [&](uint64_t i, uint64_t k) {
 		auto combined_ptr = combined_data[i];
-		auto state_ptr = state_data + i;
+		auto state_ptr = state_data[i];
 
 		if (0 == combined_ptr->count) {
 			*combined_ptr = *state_ptr;
@@ -48,14 +48,14 @@ static void stddev_update(Vector inputs[], index_t input_count, Vector &state) {
 }
 
 
-static void stddev_combine(Vector &state, Vector &combined) {
+static void stddev_combine(Vector &state, Vector &combined, TypeId return_type) {
 	// combine streaming stddev states
 	auto combined_data = (stddev_state_t**) combined.data;
-	auto state_data = (stddev_state_t*) state.data;
+	auto state_data = (stddev_state_t**) state.data;
 
 	VectorOperations::Exec(state, [&](uint64_t i, uint64_t k) {
 		auto combined_ptr = combined_data[i];
-		auto state_ptr = state_data + i;
+		auto state_ptr = state_data[i];
 
 		if (0 == combined_ptr->count) {
 			*combined_ptr = *state_ptr;
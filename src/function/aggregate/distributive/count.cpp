@@ -23,8 +23,13 @@ static void count_update(Vector inputs[], index_t input_count, Vector &result) {
 	VectorOperations::Scatter::AddOne(inputs[0], result);
 }
 
-static void count_combine(Vector &state, Vector &combined) {
-	VectorOperations::Scatter::Add(state, combined);
+static void count_combine(Vector &state, Vector &combined, TypeId return_type) {
+	// gather the source states and add them into the combined states
+	Vector source(TypeId::BIGINT, true, false);
+	source.count = state.count;
+	source.sel_vector = state.sel_vector;
+	gather_finalize(state, source);
+	VectorOperations::Scatter::Add(source, combined);
 }
 
 static void count_simple_update(Vector inputs[], index_t input_count, Value &result) {
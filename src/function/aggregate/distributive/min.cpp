@@ -11,8 +11,13 @@ static void min_update(Vector inputs[], index_t input_count, Vector &result) {
 	VectorOperations::Scatter::Min(inputs[0], result);
 }
 
-static void min_combine(Vector &state, Vector &combined) {
-	VectorOperations::Scatter::Min(state, combined);
+static void min_combine(Vector &state, Vector &combined, TypeId return_type) {
+	// gather the source states and merge them into the combined states
+	Vector source(return_type, true, false);
+	source.count = state.count;
+	source.sel_vector = state.sel_vector;
+	gather_finalize(state, source);
+	VectorOperations::Scatter::Min(source, combined);
 }
 
 static void min_simple_update(Vector inputs[], index_t input_count, Value &result) {
@@ -11,8 +11,13 @@ static void sum_update(Vector inputs[], index_t input_count, Vector &result) {
 	VectorOperations::Scatter::Add(inputs[0], result);
 }
 
-static void sum_combine(Vector &state, Vector &combined) {
-	VectorOperations::Scatter::Add(state, combined);
+static void sum_combine(Vector &state, Vector &combined, TypeId return_type) {
+	// gather the source states and add them into the combined states
+	Vector source(return_type, true, false);
+	source.count = state.count;
+	source.sel_vector = state.sel_vector;
+	gather_finalize(state, source);
+	VectorOperations::Scatter::Add(source, combined);
 }
 
 static void sum_simple_update(Vector inputs[], index_t input_count, Value &result) {
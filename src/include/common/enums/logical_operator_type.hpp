@@ -60,6 +60,7 @@ enum class LogicalOperatorType : uint8_t {
 	UPDATE,
 	CREATE_TABLE,
 	CREATE_INDEX,
+	CHECKPOINT,
 
 	// -----------------------------
 	// Explain
@@ -54,7 +54,8 @@ enum class ExceptionType {
 	OPTIMIZER = 26,       // optimizer related
 	NULL_POINTER = 27,    // nullptr exception
 	IO = 28,              // IO exception
-	INTERRUPT = 29        // interrupt
+	INTERRUPT = 29,       // interrupt
+	OUT_OF_MEMORY = 30    // out of memory
 };
 
 class Exception : public std::exception {
@@ -167,4 +168,9 @@ public:
 	InterruptException();
 };
 
+class OutOfMemoryException : public Exception {
+public:
+	OutOfMemoryException(string msg, ...);
+};
+
 } // namespace duckdb
@@ -24,6 +24,9 @@ public:
 	//! DIRECT_IO on all operating systems, however, the entire buffer must be written to the file. Note that the
 	//! returned size is 8 bytes less than the allocation size to account for the checksum.
 	FileBuffer(uint64_t bufsiz);
+	//! Wraps bufsiz bytes of existing (sector-aligned) memory, e.g. a memory-mapped part of a file, including the
+	//! checksum. The memory is not owned by the FileBuffer, and has to outlive it.
+	FileBuffer(data_ptr_t data, uint64_t bufsiz);
 	~FileBuffer();
 
 	//! The buffer that users can write to
@@ -37,6 +40,9 @@ public:
 	//! Write the contents of the FileBuffer to the specified location. Automatically adds a checksum of the contents of
 	//! the filebuffer in front of the written data.
 	void Write(FileHandle &handle, uint64_t location);
+	//! Verify the checksum of the contents of the FileBuffer, throws an exception if it does not match the checksum
+	//! stored in front of the contents
+	void VerifyChecksum();
 
 	void Clear();
 
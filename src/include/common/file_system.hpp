@@ -62,11 +62,11 @@ public:
 	unique_ptr<FileHandle> OpenFile(string &path, uint8_t flags, FileLockType lock = FileLockType::NO_LOCK) {
 		return OpenFile(path.c_str(), flags, lock);
 	}
-	//! Read exactly nr_bytes from the specified location in the file. Fails if nr_bytes could not be read. This is
-	//! equivalent to calling SetFilePointer(location) followed by calling Read().
+	//! Read exactly nr_bytes from the specified location in the file. Fails if nr_bytes could not be read. The file
+	//! pointer is not used, so multiple threads can read from the same handle concurrently.
 	virtual void Read(FileHandle &handle, void *buffer, int64_t nr_bytes, index_t location);
-	//! Write exactly nr_bytes to the specified location in the file. Fails if nr_bytes could not be read. This is
-	//! equivalent to calling SetFilePointer(location) followed by calling Write().
+	//! Write exactly nr_bytes to the specified location in the file. Fails if nr_bytes could not be written. The file
+	//! pointer is not used, so multiple threads can write to the same handle concurrently.
 	virtual void Write(FileHandle &handle, void *buffer, int64_t nr_bytes, index_t location);
 	//! Read nr_bytes from the specified file into the buffer, moving the file pointer forward by nr_bytes. Returns the
 	//! amount of bytes read.
@@ -76,6 +76,11 @@ public:
 
 	//! Returns the file size of a file handle, returns -1 on error
 	virtual int64_t GetFileSize(FileHandle &handle);
+	//! Map the first size bytes of the file into memory for reading. The mapping remains valid after the handle is
+	//! closed, until it is unmapped with UnmapFile.
+	virtual data_ptr_t MapFile(FileHandle &handle, index_t size);
+	//! Unmap a mapping created with MapFile
+	virtual void UnmapFile(data_ptr_t data, index_t size);
 
 	//! Check if a directory exists
 	virtual bool DirectoryExists(const string &directory);
@@ -30,10 +30,10 @@ public:
 	void WriteData(const_data_ptr_t buffer, uint64_t write_size) override;
 	//! Flush the buffer to disk and sync the file to ensure writing is completed
 	void Sync();
-
-private:
-	//! Flush the buffer to the file
+	//! Flush the buffer to the file (without syncing)
 	void Flush();
+	//! Returns the size of the file, including the data in the buffer that has not been flushed yet
+	int64_t GetFileSize();
 };
 
 } // namespace duckdb
@@ -40,6 +40,12 @@ public:
 
 	//! Append a new DataChunk directly to this ChunkCollection
 	void Append(DataChunk &new_chunk);
+	//! Removes all chunks from the ChunkCollection
+	void Reset() {
+		count = 0;
+		chunks.clear();
+		types.clear();
+	}
 
 	//! Gets the value of the column at the specified index
 	Value GetValue(index_t column, index_t index);
@@ -60,10 +66,17 @@ public:
 	}
 
 	void Sort(vector<OrderType> &desc, index_t result[]);
+	//! Compares the rows at the given indices of two chunks on their first desc.size() columns, using the same
+	//! ordering as Sort. Returns a negative value if left sorts before right, zero if they are equal and a positive
+	//! value otherwise.
+	static int CompareRows(DataChunk &left, index_t left_idx, DataChunk &right, index_t right_idx,
+	                       vector<OrderType> &desc);
 	//! Reorders the rows in the collection according to the given indices. NB: order is changed!
 	void Reorder(index_t order[]);
 
 	void MaterializeSortedChunk(DataChunk &target, index_t order[], index_t start_offset);
+	//! Materializes the given rows (at most STANDARD_VECTOR_SIZE) of the collection into the target chunk
+	void MaterializeRows(DataChunk &target, index_t rows[], index_t row_count);
 
 	//! Returns true if the ChunkCollections are equivalent
 	bool Equals(ChunkCollection &other);
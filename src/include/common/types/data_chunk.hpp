@@ -106,6 +106,8 @@ public:
 
 	//! Hashes the DataChunk to the target vector
 	void Hash(Vector &result);
+	//! Returns an estimate of the amount of memory required to materialize the chunk, including its strings
+	index_t MemoryUsage();
 
 	//! Returns a list of types of the vectors of this data chunk
 	vector<TypeId> GetTypes();
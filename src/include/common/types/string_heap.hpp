@@ -22,13 +22,16 @@ public:
 	void Destroy() {
 		tail = nullptr;
 		chunk = nullptr;
+		allocated_size = 0;
 	}
 
 	void Move(StringHeap &other) {
 		assert(!other.chunk);
 		other.tail = tail;
 		other.chunk = move(chunk);
+		other.allocated_size = allocated_size;
 		tail = nullptr;
+		allocated_size = 0;
 	}
 
 	//! Add a string to the string heap, returns a pointer to the string
@@ -39,6 +42,10 @@ public:
 	const char *AddString(const string &data);
 	//! Add all strings from a different string heap to this string heap
 	void MergeHeap(StringHeap &heap);
+	//! Returns the amount of memory allocated by the string heap in bytes
+	index_t MemoryUsage() {
+		return allocated_size;
+	}
 
 private:
 	struct StringChunk {
@@ -61,6 +68,8 @@ private:
 	};
 	StringChunk *tail;
 	unique_ptr<StringChunk> chunk;
+	//! The total size of the allocated string chunks
+	index_t allocated_size;
 };
 
 } // namespace duckdb
@@ -15,6 +15,8 @@
 
 namespace duckdb {
 class BoundAggregateExpression;
+class TemporaryDirectory;
+class TemporaryFile;
 
 //! SuperLargeHashTable is a linear probing HT that is used for computing
 //! aggregates
@@ -45,6 +47,25 @@ public:
 	//! Fetch the aggregates for specific groups from the HT and place them in the result
 	void FetchAggregates(DataChunk &groups, DataChunk &result);
 
+	//! Merge the groups and aggregate states of another HT with the same layout into this HT. Requires all aggregates
+	//! to have a combine function and not to be DISTINCT aggregates.
+	void Combine(SuperLargeHashTable &other);
+	//! Returns whether or not HTs with the given set of aggregates can be combined
+	static bool CanCombine(vector<BoundAggregateExpression *> &aggregates);
+	//! Radix partition the given data on the hash of the groups, and add every partition to the corresponding HT. The
+	//! amount of partitions must be a power of two.
+	static void AddChunkPartitioned(vector<unique_ptr<SuperLargeHashTable>> &partitions, DataChunk &groups,
+	                                DataChunk &payload);
+
+	//! Returns the amount of memory used by the HT and its string heap in bytes
+	index_t MemoryUsage();
+	//! Write the groups and aggregate states of the HT to the given temporary files, radix partitioned on the hash of
+	//! the groups in the same way as AddChunkPartitioned. Files are created for partitions that do not have one yet.
+	//! Requires the aggregates to be combinable.
+	void Spill(TemporaryDirectory &directory, vector<unique_ptr<TemporaryFile>> &partitions);
+	//! Merge a chunk of groups and aggregate states that was written by Spill into this HT
+	void CombineSpilledChunk(DataChunk &chunk);
+
 	void FindOrCreateGroups(DataChunk &groups, Vector &addresses, Vector &new_group);
 
 	//! The stringheap of the AggregateHashTable
@@ -52,6 +73,9 @@ public:
 
 private:
 	void HashGroups(DataChunk &groups, Vector &addresses);
+	//! Returns the types of the chunks written by Spill: the groups followed by the aggregate states. VARCHAR states
+	//! are stored as strings, all other states are stored byte-for-byte in BIGINT columns.
+	vector<TypeId> GetSpillTypes();
 
 	//! The aggregates to be computed
 	vector<BoundAggregateExpression *> aggregates;
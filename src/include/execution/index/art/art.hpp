@@ -15,60 +15,133 @@
 #include "storage/data_table.hpp"
 #include "storage/index.hpp"
 #include "common/types/static_vector.hpp"
+#include "common/unordered_map.hpp"
 #include "art_key.hpp"
+#include "epoch_manager.hpp"
 #include "leaf.hpp"
 #include "node.hpp"
 #include "node4.hpp"
 #include "node16.hpp"
 #include "node48.hpp"
 #include "node256.hpp"
+#include "persistent_node.hpp"
 
 namespace duckdb {
 struct IteratorEntry {
 	Node *node = nullptr;
 	index_t pos = 0;
+	//! The version of the node when it was read
+	uint64_t version = 0;
 };
 
 struct Iterator {
 	//! The current Leaf Node, valid if depth>0
 	Leaf *node = nullptr;
+	//! The version of the current Leaf Node when it was read
+	uint64_t version = 0;
 	//! The current depth
 	int32_t depth = 0;
-	//! Stack, actually the size is determined at runtime
-	IteratorEntry stack[9];
+	//! Stack of the nodes on the path to the current leaf, it grows with the depth of the tree
+	vector<IteratorEntry> stack;
+
+	//! Push a node on the stack
+	void Push(Node *node, index_t pos, uint64_t version) {
+		if ((index_t)depth == stack.size()) {
+			stack.emplace_back();
+		}
+		stack[depth].node = node;
+		stack[depth].pos = pos;
+		stack[depth].version = version;
+		depth++;
+	}
+};
+
+//! An entry of an ART that is being bulk loaded. The prefix holds the first (up to) eight bytes of the encoded key as a
+//! big-endian number, so most comparisons of keys only have to compare the numbers. Keys that are longer than eight
+//! bytes are stored completely in the key data of the ART, starting at the offset.
+struct ARTBuildEntry {
+	uint64_t prefix;
+	index_t offset;
+	index_t length;
+	row_t row_id;
+};
+
+//! A set of row ids. The row ids are stored in bitmaps of ROWS_PER_BITMAP consecutive row ids, which are only
+//! allocated when a row id in their range is added, so the set stays small if it holds few rows of a big table.
+class RowIdSet {
+public:
+	static constexpr index_t ROWS_PER_BITMAP = 65536;
+
+	//! Add the row id to the set, returns false if it was part of the set already
+	bool Insert(row_t row_id) {
+		auto &bitmap = bitmaps[row_id / ROWS_PER_BITMAP];
+		if (!bitmap) {
+			bitmap = unique_ptr<uint64_t[]>(new uint64_t[ROWS_PER_BITMAP / 64]());
+		}
+		index_t bit = row_id % ROWS_PER_BITMAP;
+		uint64_t mask = (uint64_t)1 << (bit % 64);
+		if (bitmap[bit / 64] & mask) {
+			return false;
+		}
+		bitmap[bit / 64] |= mask;
+		return true;
+	}
 
-	bool start = false;
+private:
+	unordered_map<row_t, unique_ptr<uint64_t[]>> bitmaps;
 };
 
 struct ARTIndexScanState : public IndexScanState {
-	ARTIndexScanState(vector<column_t> column_ids) : IndexScanState(column_ids), checked(false), result_index(0) {
+	ARTIndexScanState(vector<column_t> column_ids) : IndexScanState(column_ids) {
 	}
 
-	Value values[2];
+	//! The values the predicates compare the key with. A range predicate holds a single value, an equality predicate
+	//! holds a value for every column of the key.
+	vector<Value> values[2];
 	ExpressionType expressions[2];
-	bool checked;
-	index_t result_index = 0;
+	//! Whether the bounds of the scan have been created from the predicates
+	bool checked = false;
+	//! The bounds of the scan, a nullptr if the scan is not bounded on that side
+	unique_ptr<Key> lower_bound;
+	unique_ptr<Key> upper_bound;
+	bool lower_inclusive = false;
+	bool upper_inclusive = false;
+	//! The number of rows in the table when the scan started, rows that are appended later are not part of the scan
+	index_t row_count = 0;
+	//! The key of the last leaf whose row ids were collected, the next batch continues after it
+	unique_ptr<Key> last_key;
+	//! Whether all row ids that satisfy the predicates have been collected
+	bool exhausted = false;
+	//! The row ids of the current batch, and the position of the next row id to fetch
 	vector<row_t> result_ids;
+	index_t result_index = 0;
+	//! The row ids that were collected by a range scan. While the old key of an updated row has not been cleaned up,
+	//! the row id is stored under both keys, but it can only be returned once.
+	RowIdSet collected_ids;
 	Iterator iterator;
 };
 
 class ART : public Index {
 public:
+	//! The minimum amount of entries for which the entries of a bulk load are sorted in parallel
+	static constexpr index_t PARALLEL_SORT_THRESHOLD = 100000;
+
 	ART(DataTable &table, vector<column_t> column_ids, vector<unique_ptr<Expression>> unbound_expressions,
 	    bool is_unique = false);
 	~ART();
 
-	//! Lock used for updating the index
-	std::mutex lock;
 	//! Root of the tree
 	unique_ptr<Node> tree;
+	//! The lock of the reference to the root of the tree, it takes the place of the lock of the parent of the root
+	OptimisticLock tree_lock;
+	//! The epoch manager that frees the memory that is removed from the tree
+	EpochManager epochs;
 	//! True if machine is little endian
 	bool is_little_endian;
-	//! The maximum prefix length for compressed paths stored in the
-	//! header, if the path is longer it is loaded from the database on demand
-	uint32_t maxPrefix;
 	//! Whether or not the ART is an index built to enforce a UNIQUE constraint
 	bool is_unique;
+	//! The location of the tree in the last checkpoint that was written or loaded, if it is stored
+	IndexPointer persistent_pointer;
 
 public:
 	//! Initialize a scan on the index with the given expression and column ids
@@ -83,51 +156,99 @@ public:
 	                                                       Value high_value,
 	                                                       ExpressionType high_expression_type) override;
 
+	//! Initialize a scan on the index for the entries with a key that is equal to the given values, one value for
+	//! every column of the key
+	unique_ptr<IndexScanState> InitializeScanEqual(Transaction &transaction, vector<column_t> column_ids,
+	                                               vector<Value> values) override;
+
 	//! Perform a lookup on the index
 	void Scan(Transaction &transaction, IndexScanState *ss, DataChunk &result) override;
 	//! Append entries to the index
 	bool Append(DataChunk &entries, Vector &row_identifiers) override;
+	//! Append entries to the index without verifying the uniqueness of the keys
+	void AppendVerified(DataChunk &entries, Vector &row_identifiers) override;
 	//! Delete entries in the index
 	void Delete(DataChunk &entries, Vector &row_identifiers) override;
 
 	//! Insert data into the index. Does not lock the index.
 	bool Insert(DataChunk &data, Vector &row_ids) override;
 
+	//! Collect entries for the bulk load of the tree, the entries are added to the tree by FinalizeBuild
+	void BuildAppend(DataChunk &data, Vector &row_ids) override;
+	//! Sort the collected entries and construct the tree from them bottom-up. Throws a ConstraintException if a unique
+	//! index contains a key more than once.
+	void FinalizeBuild() override;
+
+	//! Load the tree that was written to storage by a checkpoint. Only the root node is read, the other nodes are read
+	//! when they are first accessed.
+	void LoadFromStorage(IndexPointer pointer);
+	//! Write the tree to storage and return its location
+	IndexPointer WriteToStorage(BlockManager &manager);
+
+	//! Replace a write locked node with a new node. The old node is marked as obsolete and retired, so concurrent
+	//! readers restart when they check its version.
+	void ReplaceNode(unique_ptr<Node> &node, unique_ptr<Node> new_node);
+
 private:
-	DataChunk expression_result;
+	//! The entries collected for the bulk load of the tree
+	vector<ARTBuildEntry> build_entries;
+	//! The encoded keys of the entries collected for the bulk load of the tree that are longer than eight bytes
+	vector<data_t> build_key_data;
 
 private:
+	//! Insert the keys of the input into the tree. If verify_unique is true, no keys are inserted if any of the keys
+	//! is already in the tree.
+	bool InsertKeys(DataChunk &input, Vector &row_ids, bool verify_unique);
 	//! Insert a row id into a leaf node
-	bool InsertToLeaf(Leaf &leaf, row_t row_id);
-	//! Insert the leaf value into the tree
-	bool Insert(unique_ptr<Node> &node, unique_ptr<Key> key, unsigned depth, row_t row_id);
-
-	//! Erase element from leaf (if leaf has more than one value) or eliminate the leaf itself
-	void Erase(unique_ptr<Node> &node, Key &key, unsigned depth, row_t row_id);
+	bool InsertToLeaf(Leaf &leaf, row_t row_id, bool verify_unique);
+	//! Insert the key into the tree, the key is only moved into the tree if it is inserted. Sets restart if a
+	//! concurrent operation modified a node that the insert read.
+	bool Insert(unique_ptr<Key> &key, row_t row_id, bool verify_unique, bool &restart);
+
+	//! Erase element from leaf (if leaf has more than one value) or eliminate the leaf itself. Sets restart if a
+	//! concurrent operation modified a node that the erase read.
+	void Erase(Key &key, row_t row_id, bool &restart);
+
+	//! Sort the collected entries, in parallel if there are many of them
+	void SortBuildEntries();
+	//! Construct the tree for the sorted entries [start, end), which share the first depth bytes of their keys
+	unique_ptr<Node> Construct(index_t start, index_t end, index_t depth);
+	//! Returns the byte of the key of a build entry at the given position
+	uint8_t GetKeyByte(ARTBuildEntry &entry, index_t pos) {
+		return pos < sizeof(entry.prefix) ? (uint8_t)(entry.prefix >> (8 * (sizeof(entry.prefix) - 1 - pos)))
+		                                  : build_key_data[entry.offset + pos];
+	}
 
 	//! Check if the key of the leaf is equal to the searched key
 	bool LeafMatches(Node *node, Key &key, unsigned depth);
 
-	//! Find the node with a matching key, optimistic version
-	Node *Lookup(unique_ptr<Node> &node, Key &key, unsigned depth);
+	//! Get the child of a read locked node at the given position. A child that is stored on disk is loaded first, in
+	//! which case restart is set as the node was modified.
+	Node *GetChildOrRestart(Node *node, index_t pos, uint64_t version, bool &restart);
 
-	//! Find the first node that is bigger (or equal to) a specific key
-	bool Bound(unique_ptr<Node> &node, Key &key, Iterator &iterator, bool inclusive);
+	//! Add the row ids of the leaf with a matching key to the result
+	void Lookup(Key &key, vector<row_t> &result_ids, bool &restart);
+
+	//! Find the first leaf that is bigger (or equal to) a specific key, or the first leaf of the tree if the key is a
+	//! nullptr. Returns false if there is no such leaf.
+	bool Bound(Key *key, Iterator &iterator, bool inclusive, bool &restart);
+	//! Find the first leaf below the read locked node
+	bool FindMinimum(Iterator &iterator, Node *node, uint64_t version, bool &restart);
 
 	//! Gets next node for range queries
-	bool IteratorNext(Iterator &iter);
+	bool IteratorNext(Iterator &iter, bool &restart);
 
-	void SearchEqual(vector<row_t> &result_ids, ARTIndexScanState *state);
-	void SearchGreater(vector<row_t> &result_ids, ARTIndexScanState *state, bool inclusive);
-	void SearchLess(vector<row_t> &result_ids, ARTIndexScanState *state, bool inclusive);
-	void SearchCloseRange(vector<row_t> &result_ids, ARTIndexScanState *state, bool left_inclusive,
-	                      bool right_inclusive);
+	//! Create the bounds of the scan from its predicates
+	void InitializeBounds(ARTIndexScanState &state);
+	//! Collect the row ids of the leaves that follow the leaves of the previous batch and satisfy the predicates of the
+	//! scan, until the batch holds at least STANDARD_VECTOR_SIZE row ids or the scan is exhausted
+	void ScanNextBatch(ARTIndexScanState &state);
 
 private:
-	template <bool HAS_BOUND, bool INCLUSIVE>
-	void IteratorScan(ARTIndexScanState *state, Iterator *it, vector<row_t> &result_ids, Key *upper_bound);
-
+	//! Generate the keys for the rows of the input, the key of a row is a nullptr if any of its columns is NULL
 	void GenerateKeys(DataChunk &input, vector<unique_ptr<Key>> &keys);
+	//! Create the key for the given values, one value for every column of the key
+	unique_ptr<Key> CreateKey(vector<Value> &values);
 };
 
 } // namespace duckdb
@@ -35,16 +35,25 @@ public:
 
 	string ToString(bool is_little_endian, TypeId type);
 
+	//! Write the binary-comparable representation of the value to the target, which has room for sizeof(T) bytes
+	template <class T> static void EncodeData(T value, bool is_little_endian, data_ptr_t target) {
+		throw NotImplementedException("Cannot create data from this type");
+	}
+
 private:
 	template <class T> static unique_ptr<data_t[]> CreateData(T value, bool is_little_endian) {
-		throw NotImplementedException("Cannot create data from this type");
+		auto data = unique_ptr<data_t[]>(new data_t[sizeof(value)]);
+		EncodeData<T>(value, is_little_endian, data.get());
+		return data;
 	}
 };
 
-template <> unique_ptr<data_t[]> Key::CreateData(int8_t value, bool is_little_endian);
-template <> unique_ptr<data_t[]> Key::CreateData(int16_t value, bool is_little_endian);
-template <> unique_ptr<data_t[]> Key::CreateData(int32_t value, bool is_little_endian);
-template <> unique_ptr<data_t[]> Key::CreateData(int64_t value, bool is_little_endian);
+template <> void Key::EncodeData(int8_t value, bool is_little_endian, data_ptr_t target);
+template <> void Key::EncodeData(int16_t value, bool is_little_endian, data_ptr_t target);
+template <> void Key::EncodeData(int32_t value, bool is_little_endian, data_ptr_t target);
+template <> void Key::EncodeData(int64_t value, bool is_little_endian, data_ptr_t target);
+template <> void Key::EncodeData(float value, bool is_little_endian, data_ptr_t target);
+template <> void Key::EncodeData(double value, bool is_little_endian, data_ptr_t target);
 
 template <> unique_ptr<Key> Key::CreateKey(string element, bool is_little_endian);
 
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// execution/index/art/epoch_manager.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+#include "node.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace duckdb {
+
+//! The epoch manager defers freeing the nodes, prefixes and row id arrays that are removed from an ART until no
+//! operation can read them anymore. Readers of the tree do not take locks, so an operation can still read memory that
+//! a concurrent writer just removed from the tree. Every operation on the tree runs in an epoch (see EpochGuard), and
+//! removed memory is retired with the epoch in which it was removed. The epoch advances when no operation of the
+//! previous epoch is active anymore; memory is freed two epochs after it was retired, when all operations that started
+//! before it was removed have finished.
+class EpochManager {
+public:
+	EpochManager();
+
+	//! Enter the current epoch, returns the entered epoch
+	uint64_t Enter();
+	//! Leave the entered epoch, and free the retired memory that can no longer be read
+	void Leave(uint64_t epoch);
+
+	//! Retire memory that was removed from the tree, it is freed when no operation can read it anymore
+	void Retire(unique_ptr<Node> node);
+	void Retire(unique_ptr<uint8_t[]> prefix);
+	void Retire(unique_ptr<row_t[]> row_ids);
+
+private:
+	struct RetiredEntry {
+		uint64_t epoch;
+		unique_ptr<Node> node;
+		unique_ptr<uint8_t[]> prefix;
+		unique_ptr<row_t[]> row_ids;
+	};
+
+	void Retire(RetiredEntry entry);
+	//! Advance the epoch if possible, and free the retired memory that can no longer be read
+	void Reclaim();
+
+	std::atomic<uint64_t> current_epoch;
+	//! The amount of active operations per epoch, at index (epoch % 3). Operations are only active in the current and
+	//! the previous epoch.
+	std::atomic<index_t> active[3];
+	//! The retired memory, in the order in which it was retired
+	vector<RetiredEntry> retired;
+	std::atomic<index_t> retired_count;
+	std::mutex retired_lock;
+};
+
+//! Runs an operation on the tree in the current epoch: nothing that the operation reads is freed until it finishes
+class EpochGuard {
+public:
+	EpochGuard(EpochManager &manager) : manager(manager), epoch(manager.Enter()) {
+	}
+	~EpochGuard() {
+		manager.Leave(epoch);
+	}
+
+private:
+	EpochManager &manager;
+	uint64_t epoch;
+};
+
+} // namespace duckdb
@@ -25,8 +25,13 @@ public:
 	}
 
 public:
-	void Insert(row_t row_id);
+	//! Add a row id to the leaf. A full array of row ids is replaced by a bigger one, the old array is retired in the
+	//! epoch manager of the ART.
+	void Insert(ART &art, row_t row_id);
 	void Remove(row_t row_id);
+	//! Append the row ids of the leaf, which was read locked with the given version, to the result. Sets restart if
+	//! the leaf changed while the row ids were read.
+	void ReadRowIds(uint64_t version, vector<row_t> &result, bool &restart);
 
 private:
 	unique_ptr<row_t[]> row_ids;
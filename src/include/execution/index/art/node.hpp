@@ -10,12 +10,21 @@
 
 #include "art_key.hpp"
 #include "common/common.hpp"
+#include "optimistic_lock.hpp"
 
 namespace duckdb {
-enum class NodeType : uint8_t { N4 = 0, N16 = 1, N48 = 2, N256 = 3, NLeaf = 4 };
+enum class NodeType : uint8_t { N4 = 0, N16 = 1, N48 = 2, N256 = 3, NLeaf = 4, NPersistent = 5 };
 
 class ART;
 
+//! The prefix of a node as read by an operation that does not hold the lock of the node. The bytes of a prefix are
+//! never modified in place (a new prefix is allocated instead), so they can be read until the operation leaves its
+//! epoch.
+struct NodePrefix {
+	const uint8_t *data;
+	uint32_t length;
+};
+
 class Node {
 public:
 	static const uint8_t EMPTY_MARKER = 48;
@@ -31,10 +40,18 @@ public:
 	uint16_t count;
 	//! node type
 	NodeType type;
-	//! compressed path (prefix)
+	//! compressed path (prefix), holds prefix_length bytes
 	unique_ptr<uint8_t[]> prefix;
+	//! The lock that synchronizes concurrent operations on the node
+	OptimisticLock lock;
 
 public:
+	//! Replace the prefix of the node with the given bytes. The bytes may point into the current prefix, which is
+	//! retired in the epoch manager of the ART.
+	void SetPrefix(ART &art, const uint8_t *data, uint32_t length);
+	//! Read the prefix of the node, which was read locked with the given version. Sets restart if the node changed.
+	NodePrefix ReadPrefix(uint64_t version, bool &restart);
+
 	//! Get the position of a child corresponding exactly to the specific byte, returns INVALID_INDEX if not exists
 	virtual index_t GetChildPos(uint8_t k) {
 		return INVALID_INDEX;
@@ -52,9 +69,15 @@ public:
 	//! Get the child at the specified position in the node. pos should be between [0, count). Throws an assertion if
 	//! the element is not found.
 	virtual unique_ptr<Node> *GetChild(index_t pos);
+	//! Get the reference to the child at the specified position without loading it from storage. The node can be
+	//! modified concurrently, so the position is not asserted: a nullptr is returned for invalid positions, and the
+	//! result is only valid if the version of the node is unchanged afterwards.
+	virtual unique_ptr<Node> *ReadChild(index_t pos) {
+		return nullptr;
+	}
 
-	//! Compare the key with the prefix of the node, return the number matching bytes
-	static uint32_t PrefixMismatch(ART &art, Node *node, Key &key, uint64_t depth);
+	//! Compare the key from the depth with the prefix, return the number matching bytes
+	static uint32_t PrefixMismatch(NodePrefix prefix, Key &key, uint64_t depth);
 	//! Insert leaf into inner node
 	static void InsertLeaf(ART &art, unique_ptr<Node> &node, uint8_t key, unique_ptr<Node> &newNode);
 	//! Erase entry from node
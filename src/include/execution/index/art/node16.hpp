@@ -28,6 +28,8 @@ public:
 	index_t GetNextPos(index_t pos) override;
 	//! Get Node16 Child
 	unique_ptr<Node> *GetChild(index_t pos) override;
+	//! Get the reference to a child without loading it, for optimistic reads
+	unique_ptr<Node> *ReadChild(index_t pos) override;
 
 	//! Insert node into Node16
 	static void insert(ART &art, unique_ptr<Node> &node, uint8_t keyByte, unique_ptr<Node> &child);
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// execution/index/art/optimistic_lock.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace duckdb {
+
+//! The lock of a node of the ART, used for optimistic lock coupling. Readers do not acquire the lock: they remember its
+//! version before they read the node, and check that the version is unchanged after they read it. If it changed, a
+//! writer modified the node in the meantime and the reader restarts its operation. Writers upgrade a version they
+//! read to the exclusive lock, which fails if the node was modified since. Unlocking increments the version.
+//! The lowest bit of the version marks a node that was removed from the tree, the second bit is set while the lock is
+//! held by a writer.
+class OptimisticLock {
+public:
+	OptimisticLock() : version(0) {
+	}
+
+	//! Wait until no writer holds the lock and return its version. Sets restart if the node is obsolete.
+	uint64_t ReadLockOrRestart(bool &restart) const {
+		uint64_t current = version.load();
+		while (IsLocked(current)) {
+			std::this_thread::yield();
+			current = version.load();
+		}
+		if (IsObsolete(current)) {
+			restart = true;
+		}
+		return current;
+	}
+	//! Check that the version is unchanged after the node was read, sets restart if it changed
+	void CheckOrRestart(uint64_t read_version, bool &restart) const {
+		// the reads of the node must not be moved after the version is read again
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (version.load(std::memory_order_relaxed) != read_version) {
+			restart = true;
+		}
+	}
+	//! Acquire the lock exclusively if the version is unchanged, sets restart otherwise
+	void UpgradeToWriteLockOrRestart(uint64_t &read_version, bool &restart) {
+		if (version.compare_exchange_strong(read_version, read_version + 2)) {
+			read_version += 2;
+		} else {
+			restart = true;
+		}
+	}
+	//! Release the exclusive lock
+	void WriteUnlock() {
+		version.fetch_add(2);
+	}
+	//! Release the exclusive lock and mark the node as obsolete
+	void WriteUnlockObsolete() {
+		version.fetch_add(3);
+	}
+
+private:
+	static bool IsLocked(uint64_t version) {
+		return (version & 2) == 2;
+	}
+	static bool IsObsolete(uint64_t version) {
+		return (version & 1) == 1;
+	}
+
+	std::atomic<uint64_t> version;
+};
+
+} // namespace duckdb
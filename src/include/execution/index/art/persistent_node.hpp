@@ -0,0 +1,41 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// execution/index/art/persistent_node.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "node.hpp"
+#include "storage/block.hpp"
+
+namespace duckdb {
+class MetaBlockWriter;
+
+//! A persistent node is a placeholder for a node of the ART that was written to storage and has not been loaded yet.
+//! The children of a node that is loaded from storage are persistent nodes, the first access to a child replaces the
+//! persistent node with the node read from storage. This way only the parts of the tree that are used are loaded.
+class PersistentNode : public Node {
+public:
+	PersistentNode(ART &art, block_id_t block_id, uint32_t offset);
+
+	//! The ART the node belongs to
+	ART &art;
+	//! The block and offset the node is stored at
+	block_id_t block_id;
+	uint32_t offset;
+
+public:
+	//! Read the node from storage, its children are returned as persistent nodes
+	unique_ptr<Node> Load();
+
+	//! Replace the node with the node read from storage if it is a persistent node. The node that holds the reference
+	//! has to be write locked if it can be accessed concurrently.
+	static void Swizzle(unique_ptr<Node> &node);
+	//! Write the node and all of its children to the writer, and return the block and offset the node is stored at
+	static void Write(ART &art, Node &node, MetaBlockWriter &writer, block_id_t &block_id, uint32_t &offset);
+};
+
+} // namespace duckdb
@@ -14,9 +14,11 @@
 #include "execution/aggregate_hashtable.hpp"
 #include "planner/operator/logical_comparison_join.hpp"
 
-#include <mutex>
+#include <atomic>
+#include <functional>
 
 namespace duckdb {
+class TaskScheduler;
 
 //! JoinHashTable is a linear probing HT that is used for computing joins
 /*!
@@ -30,6 +32,10 @@ namespace duckdb {
    [POINTER]
    [POINTER]
    The pointers are either NULL
+   The HT can be built in parallel: every thread materializes its data into a thread-local HT using Append, after which
+   the thread-local HTs are merged into the global HT and all entries are inserted into the hash map by multiple threads
+   using atomic compare-and-swap chaining (Finalize). After building, the HT is read-only and can be probed by multiple
+   threads concurrently.
 */
 class JoinHashTable {
 public:
@@ -100,14 +106,27 @@ private:
 
 public:
 	JoinHashTable(vector<JoinCondition> &conditions, vector<TypeId> build_types, JoinType type,
-	              index_t initial_capacity = 32768, bool parallel = false);
+	              index_t initial_capacity = 32768);
 	//! Resize the HT to the specified size. Must be larger than the current
 	//! size.
 	void Resize(index_t size);
+	//! Set up the group counts of a correlated MARK join on the given duplicate eliminated columns
+	void InitializeCorrelatedMarkJoin(vector<TypeId> correlated_types);
 	//! Add the given data to the HT
 	void Build(DataChunk &keys, DataChunk &input);
+	//! Materialize the given data in the HT without inserting it into the hash map. The entries only become visible
+	//! to probes after the HT is merged into another HT and/or finalized.
+	void Append(DataChunk &keys, DataChunk &input);
+	//! Move all the materialized entries of another HT (filled with Append) into this HT
+	void Merge(JoinHashTable &other);
+	//! Size the hash map for all entries in the HT and insert all entries using the given amount of parallel tasks
+	void Finalize(TaskScheduler &scheduler, index_t task_count);
 	//! Probe the HT with the given input chunk, resulting in the given result
 	unique_ptr<ScanStructure> Probe(DataChunk &keys);
+	//! Scans all the entries stored in the HT, calling the callback for every batch of at most STANDARD_VECTOR_SIZE
+	//! entries with their keys and build-side columns. The build-side columns are only available if they are stored
+	//! in the HT (i.e. build_size > 0), otherwise the payload chunk is empty.
+	void ScanEntries(std::function<void(DataChunk &keys, DataChunk &payload)> callback);
 
 	//! The stringheap of the JoinHashTable
 	StringHeap string_heap;
@@ -161,8 +180,16 @@ private:
 	//! Apply a bitmask to the hashes
 	void ApplyBitmask(Vector &hashes);
 	//! Insert the given set of locations into the HT with the given set of
-	//! hashes. Caller should hold lock in parallel HT.
-	void InsertHashes(Vector &hashes, data_ptr_t key_locations[]);
+	//! hashes. If PARALLEL is set, the chains are updated using atomic compare-and-swap, so multiple threads can
+	//! insert into the HT concurrently.
+	template <bool PARALLEL> void InsertHashes(Vector &hashes, data_ptr_t key_locations[]);
+	//! (Re-)insert all the entries of the given node into the hash map
+	template <bool PARALLEL> void InsertNode(Node &node);
+	//! Serialize the keys and payload into a new node. Returns false if all keys were filtered out because of NULL
+	//! values.
+	bool AppendNode(DataChunk &keys, DataChunk &payload, data_ptr_t key_locations[]);
+	//! Allocate an empty hash map of the specified size
+	void InitializePointerTable(index_t size);
 	//! The capacity of the HT. This can be increased using
 	//! JoinHashTable::Resize
 	index_t capacity;
@@ -171,11 +198,7 @@ private:
 	//! The data of the HT
 	unique_ptr<Node> head;
 	//! The hash map of the HT
-	unique_ptr<data_ptr_t[]> hashed_pointers;
-	//! Whether or not the HT has to support parallel build
-	bool parallel = false;
-	//! Mutex used for parallelism
-	std::mutex parallel_lock;
+	unique_ptr<std::atomic<data_ptr_t>[]> hashed_pointers;
 	//! Whether or not NULL values are considered equal in each of the comparisons
 	vector<bool> null_values_are_equal;
 
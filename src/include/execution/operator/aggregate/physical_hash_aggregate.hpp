@@ -11,11 +11,18 @@
 #include "execution/aggregate_hashtable.hpp"
 #include "execution/physical_operator.hpp"
 #include "storage/data_table.hpp"
+#include "storage/temporary_file.hpp"
+
+#define HASH_AGGREGATE_PARTITION_BITS 4
+#define HASH_AGGREGATE_PARTITION_COUNT (1 << HASH_AGGREGATE_PARTITION_BITS)
 
 namespace duckdb {
+class PhysicalHashAggregateOperatorState;
 
 //! PhysicalHashAggregate is an group-by and aggregate implementation that uses
-//! a hash table to perform the grouping
+//! a hash table to perform the grouping. If the HT grows larger than the memory limit, its groups and partial
+//! aggregates are written to disk in HASH_AGGREGATE_PARTITION_COUNT radix partitions, and the partitions are combined
+//! and finalized one at a time.
 class PhysicalHashAggregate : public PhysicalOperator {
 public:
 	PhysicalHashAggregate(vector<TypeId> types, vector<unique_ptr<Expression>> expressions,
@@ -34,6 +41,18 @@ public:
 	void GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
 
 	unique_ptr<PhysicalOperatorState> GetOperatorState() override;
+
+private:
+	//! Resolves the groups and the inputs of the aggregates for the given input chunk
+	void ResolveGroupsAndPayload(DataChunk &input, DataChunk &group_chunk, DataChunk &payload_chunk);
+	//! Fills the hash table by executing the child pipeline with multiple threads
+	void ParallelBuild(ClientContext &context, PhysicalHashAggregateOperatorState *state, index_t thread_count);
+	//! Returns whether or not the HT can be spilled to disk when it exceeds the memory limit
+	bool CanSpill(ClientContext &context);
+	//! Creates a new, empty HT for the groups and aggregates of this operator
+	unique_ptr<SuperLargeHashTable> CreateHashTable(PhysicalHashAggregateOperatorState &state);
+	//! Combines the partial aggregates of a spilled partition into a new HT
+	unique_ptr<SuperLargeHashTable> LoadSpilledPartition(PhysicalHashAggregateOperatorState &state, index_t partition);
 };
 
 class PhysicalHashAggregateOperatorState : public PhysicalOperatorState {
@@ -51,5 +70,13 @@ public:
 	unique_ptr<SuperLargeHashTable> ht;
 	//! The payload chunk, only used while filling the HT
 	DataChunk payload_chunk;
+	//! The radix partitioned HTs produced by a parallel build (if any)
+	vector<unique_ptr<SuperLargeHashTable>> partitions;
+	//! The partition that is currently being scanned
+	index_t partition_idx;
+	//! Whether or not partial aggregates were spilled to disk
+	bool spilled;
+	//! The radix partitions of the spilled groups and partial aggregates
+	vector<unique_ptr<TemporaryFile>> spill_partitions;
 };
 } // namespace duckdb
@@ -0,0 +1,24 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// execution/operator/helper/physical_checkpoint.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "execution/physical_operator.hpp"
+
+namespace duckdb {
+
+//! PhysicalCheckpoint writes the changes in the WAL to the database file when it is executed
+class PhysicalCheckpoint : public PhysicalOperator {
+public:
+	PhysicalCheckpoint(LogicalOperator &op) : PhysicalOperator(PhysicalOperatorType::CHECKPOINT, op.types) {
+	}
+
+public:
+	void GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
+};
+} // namespace duckdb
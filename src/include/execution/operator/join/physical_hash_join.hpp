@@ -13,31 +13,110 @@
 #include "execution/operator/join/physical_comparison_join.hpp"
 #include "execution/physical_operator.hpp"
 #include "planner/operator/logical_join.hpp"
+#include "storage/temporary_file.hpp"
+
+#include <atomic>
+#include <mutex>
 
 namespace duckdb {
 
-//! PhysicalHashJoin represents a hash loop join between two tables
+//! The amount of bits of the hash used to partition the input of a hash join that exceeds the memory limit
+#define HASH_JOIN_PARTITION_BITS 4
+#define HASH_JOIN_PARTITION_COUNT (1 << HASH_JOIN_PARTITION_BITS)
+
+class PhysicalHashJoinOperatorState;
+
+//! The build side of a hash join. It is built once for every execution of the join, and shared by the operator
+//! states of all threads that probe it.
+class HashJoinBuildState {
+public:
+	HashJoinBuildState() : hash_table_built(false), spilled(false) {
+		build_partitions.resize(HASH_JOIN_PARTITION_COUNT);
+	}
+
+	//! Lock held while building the hash table
+	std::mutex build_lock;
+	//! Whether or not the hash table has been built
+	bool hash_table_built;
+	//! The hash table of the build side
+	unique_ptr<JoinHashTable> hash_table;
+	//! Whether or not the build side was spilled to the build partitions. Set by any of the threads that build the
+	//! hash table in parallel, once the build side exceeds the memory limit.
+	std::atomic<bool> spilled;
+	//! Lock held while writing to the build partitions
+	std::mutex partition_lock;
+	//! The partitions of the build side, only used if the build side was spilled
+	vector<unique_ptr<TemporaryFile>> build_partitions;
+};
+
+//! PhysicalHashJoin represents a hash loop join between two tables. If the build side exceeds the memory limit of the
+//! database, both sides are partitioned on the hash of the join keys into temporary files, after which the partitions
+//! are joined one at a time (grace hash join).
 class PhysicalHashJoin : public PhysicalComparisonJoin {
 public:
 	PhysicalHashJoin(LogicalOperator &op, unique_ptr<PhysicalOperator> left, unique_ptr<PhysicalOperator> right,
 	                 vector<JoinCondition> cond, JoinType join_type);
 
+	//! The (empty) hash table as it is set up by the planner, every execution of the join builds a hash table like it
 	unique_ptr<JoinHashTable> hash_table;
 
 public:
 	void GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
 	unique_ptr<PhysicalOperatorState> GetOperatorState() override;
+
+	//! Builds the hash table of the given operator state from the right side if it has not been built yet. After the
+	//! hash table is built it is read-only, so the left side can be probed by multiple threads that each have their
+	//! own operator state sharing the build side.
+	void BuildHashTable(ClientContext &context, PhysicalOperatorState *state);
+	//! Whether or not the left side of the join can be probed by multiple threads concurrently, unless the build side
+	//! is spilled to disk
+	bool ParallelProbe();
+
+private:
+	//! Creates an empty hash table that is set up like the hash table of the planner
+	unique_ptr<JoinHashTable> CreateHashTable();
+	//! Resolves the join keys of a chunk of the build side
+	void ResolveBuildKeys(DataChunk &join_keys, DataChunk &right_chunk);
+	//! Builds the hash table by executing the build side with multiple threads
+	void ParallelBuild(ClientContext &context, HashJoinBuildState &build, PhysicalOperatorState *right_state,
+	                   index_t thread_count);
+	//! Whether or not the build side can be spilled to disk when it exceeds the memory limit
+	bool CanSpill(ClientContext &context);
+	//! Moves the entries of the given hash table to the build partitions
+	void SpillHashTable(ClientContext &context, HashJoinBuildState &build, JoinHashTable &table);
+	//! Writes the rows of the keys and payload to the partitions of the hashes of their equality keys as
+	//! [keys..., payload...]. If build_side is true, rows that can never find a match because of NULL keys are
+	//! discarded (which is recorded in the given hash table) and the payload is only written if the hash table stores
+	//! it.
+	void PartitionChunk(TemporaryDirectory &directory, JoinHashTable &table, DataChunk &keys, DataChunk &payload,
+	                    vector<unique_ptr<TemporaryFile>> &partitions, bool build_side);
+	//! Probes the hash table with the join keys and the left chunk of the state
+	void ProbeHashTable(JoinHashTable &table, PhysicalHashJoinOperatorState &state, DataChunk &chunk);
+	//! Joins the partitions of the build side with the partitions of the probe side
+	void ProbePartitions(ClientContext &context, DataChunk &chunk, PhysicalHashJoinOperatorState &state);
 };
 
 class PhysicalHashJoinOperatorState : public PhysicalOperatorState {
 public:
 	PhysicalHashJoinOperatorState(PhysicalOperator *left, PhysicalOperator *right)
-	    : PhysicalOperatorState(left), initialized(false) {
+	    : PhysicalOperatorState(left), initialized(false), build(std::make_shared<HashJoinBuildState>()),
+	      partition_index(0) {
 		assert(left && right);
 	}
 
 	bool initialized;
 	DataChunk join_keys;
 	unique_ptr<JoinHashTable::ScanStructure> scan_structure;
+
+	//! The build side of the join, shared with the states of the other threads that probe the join in parallel
+	std::shared_ptr<HashJoinBuildState> build;
+	//! The partitions of the probe side, only used if the build side was spilled
+	vector<unique_ptr<TemporaryFile>> probe_partitions;
+	//! The partition that is currently being joined
+	index_t partition_index;
+	//! The hash table of the build partition that is currently being joined
+	unique_ptr<JoinHashTable> partition_table;
+	//! The chunk read from the current probe partition
+	DataChunk partition_chunk;
 };
 } // namespace duckdb
@@ -11,11 +11,14 @@
 #include "common/types/chunk_collection.hpp"
 #include "execution/physical_operator.hpp"
 #include "planner/bound_query_node.hpp"
+#include "storage/temporary_file.hpp"
 
 namespace duckdb {
 
 //! Represents a physical ordering of the data. Note that this will not change
-//! the data but only add a selection vector.
+//! the data but only add a selection vector. If the input does not fit in the
+//! memory limit of the database, sorted runs are spilled to temporary files and
+//! merged afterwards (external merge sort).
 class PhysicalOrder : public PhysicalOperator {
 public:
 	PhysicalOrder(LogicalOperator &op, vector<BoundOrderByNode> orders)
@@ -27,15 +30,47 @@ public:
 public:
 	void GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
 	unique_ptr<PhysicalOperatorState> GetOperatorState() override;
+
+private:
+	//! Computes the sort keys of the collection and sorts them, the sorted keys are stored in sort_collection and the
+	//! sorted order in the returned array
+	unique_ptr<index_t[]> SortCollection(ChunkCollection &collection, ChunkCollection &sort_collection);
+	//! Sorts the collection and writes it to a new sorted run on disk
+	unique_ptr<TemporaryFile> SpillRun(ClientContext &context, ChunkCollection &collection);
+	//! Merges the sorted runs into the result chunk
+	void MergeRuns(DataChunk &chunk, PhysicalOperatorState *state);
+};
+
+//! A position in one of the sorted runs of an external sort
+struct SortedRun {
+	//! The file holding the run
+	unique_ptr<TemporaryFile> file;
+	//! The current chunk of the run, which holds [sort keys..., payload...]
+	unique_ptr<DataChunk> chunk;
+	//! The position within the current chunk
+	index_t position;
 };
 
 class PhysicalOrderOperatorState : public PhysicalOperatorState {
 public:
-	PhysicalOrderOperatorState(PhysicalOperator *child) : PhysicalOperatorState(child), position(0) {
+	PhysicalOrderOperatorState(PhysicalOperator *child)
+	    : PhysicalOperatorState(child), finished_sink(false), initialized_merge(false), position(0) {
 	}
 
+	//! Whether or not the input has been consumed
+	bool finished_sink;
+	//! Whether or not the merge heap has been built
+	bool initialized_merge;
 	index_t position;
 	ChunkCollection sorted_data;
 	unique_ptr<index_t[]> sorted_vector;
+
+	//! The sorted runs that were spilled to disk, empty if the input fit in memory
+	vector<SortedRun> runs;
+	//! A heap of run indices, ordered on the current row of each run
+	vector<index_t> merge_heap;
+	//! Run chunks that were exhausted while producing the previous result chunk. They are kept around until the next
+	//! call, because the strings of the result chunk point into them.
+	vector<unique_ptr<DataChunk>> exhausted_chunks;
 };
 } // namespace duckdb
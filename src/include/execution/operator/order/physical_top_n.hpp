@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// execution/operator/order/physical_top_n.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/types/chunk_collection.hpp"
+#include "execution/physical_operator.hpp"
+#include "planner/bound_query_node.hpp"
+
+namespace duckdb {
+
+//! The TopNHeap keeps the first heap_size rows (according to the order types) of the rows that are appended to it.
+//! The appended chunks hold the sort keys followed by the payload: [sort keys..., payload...].
+class TopNHeap {
+public:
+	TopNHeap(vector<OrderType> order_types, index_t heap_size);
+
+	//! The rows of the heap. Rows that are evicted from the heap remain in the collection until the next compaction.
+	ChunkCollection data;
+
+public:
+	//! Append the rows of the chunk to the heap, keeping only the rows that belong to the top heap_size rows
+	void Append(DataChunk &input);
+	//! Append the rows of another heap to this heap
+	void Combine(TopNHeap &other);
+	//! Sorts the rows of the heap and removes the first offset rows; afterwards the data collection holds the result
+	void Finalize(index_t offset);
+
+private:
+	vector<OrderType> order_types;
+	index_t heap_size;
+	//! Max-heap of row indices into the data collection, the top of the heap is the last row in the order
+	vector<index_t> heap;
+
+	//! Compares two rows of the data collection, ties are broken on the row index
+	int CompareRows(index_t left, index_t right);
+	//! Rewrites the data collection to only hold the rows that are in the heap, in the order of the heap
+	void Compact();
+};
+
+//! Represents an ORDER BY followed by a LIMIT. Instead of sorting the entire
+//! input, only the first limit + offset rows are kept in a bounded heap.
+class PhysicalTopN : public PhysicalOperator {
+public:
+	PhysicalTopN(LogicalOperator &op, vector<BoundOrderByNode> orders, index_t limit, index_t offset)
+	    : PhysicalOperator(PhysicalOperatorType::TOP_N, op.types), orders(move(orders)), limit(limit),
+	      offset(offset) {
+	}
+
+	vector<BoundOrderByNode> orders;
+	index_t limit;
+	index_t offset;
+
+public:
+	void GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
+	unique_ptr<PhysicalOperatorState> GetOperatorState() override;
+
+	string ExtraRenderInformation() const override;
+
+private:
+	//! Computes the sort keys of the input and appends the rows to the heap
+	void Sink(DataChunk &input, TopNHeap &heap);
+};
+
+class PhysicalTopNOperatorState : public PhysicalOperatorState {
+public:
+	PhysicalTopNOperatorState(PhysicalOperator *child) : PhysicalOperatorState(child), position(0) {
+	}
+
+	//! The heap holding the result, nullptr if the input has not been consumed yet
+	unique_ptr<TopNHeap> heap;
+	//! The index of the next chunk of the heap to return
+	index_t position;
+};
+} // namespace duckdb
@@ -35,7 +35,8 @@ public:
 	//! The value for the query predicate
 	Value low_value;
 	Value high_value;
-	Value equal_value;
+	//! The values for an equality predicate, one for every expression of the index
+	vector<Value> equal_values;
 
 	//! If the predicate is low, high or equal
 	bool low_index = false;
@@ -27,6 +27,8 @@ public:
 	DataTable &table;
 	//! The column ids to project
 	vector<column_t> column_ids;
+	//! The comparisons with constants that are evaluated during the scan, only tuples that satisfy them are returned
+	vector<TableFilter> table_filters;
 
 public:
 	void GetChunkInternal(ClientContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
@@ -42,5 +44,7 @@ public:
 
 	//! The current position in the scan
 	TableScanState scan_offset;
+	//! The shared state of a parallel scan, if the scan is driven by multiple threads
+	ParallelTableScanState *parallel_state = nullptr;
 };
 } // namespace duckdb
@@ -18,8 +18,9 @@ typedef index_t (*aggregate_size_t)(TypeId return_type);
 typedef void (*aggregate_initialize_t)(data_ptr_t state, TypeId return_type);
 //! The type used for updating hashed aggregate functions
 typedef void (*aggregate_update_t)(Vector inputs[], index_t input_count, Vector &state);
-//! The type used for combining hashed aggregate states (optional)
-typedef void (*aggregate_combine_t)(Vector &state, Vector &combined);
+//! The type used for combining hashed aggregate states (optional). Both vectors hold pointers to aggregate states: the
+//! source states are merged into the combined (target) states.
+typedef void (*aggregate_combine_t)(Vector &state, Vector &combined, TypeId return_type);
 //! The type used for finalizing hashed aggregate function payloads
 typedef void (*aggregate_finalize_t)(Vector &state, Vector &result);
 
@@ -11,36 +11,55 @@
 #include "common/common.hpp"
 #include "common/file_system.hpp"
 
+#include <atomic>
+
 namespace duckdb {
 class StorageManager;
 class Catalog;
 class TransactionManager;
 class ConnectionManager;
 class FileSystem;
+class TaskScheduler;
+class TemporaryDirectory;
 
 enum AccessMode { UNDEFINED, READ_ONLY, READ_WRITE }; // TODO AUTOMATIC
 
 // this is optional and only used in tests at the moment
 struct DBConfig {
 	friend class DuckDB;
-	friend class StorageManager;
 
 public:
 	~DBConfig();
 
 	//! Access mode of the database (READ_ONLY or READ_WRITE)
 	AccessMode access_mode = AccessMode::UNDEFINED;
-	// Checkpoint when WAL reaches this size
+	//! Checkpoint the database when the WAL grows beyond this size, either at startup or when a transaction commits
 	index_t checkpoint_wal_size = 1 << 20;
+	//! The time (in microseconds) a committing transaction waits before syncing the WAL, so the WAL records of
+	//! concurrently committing transactions can be synced together (group commit)
+	index_t commit_delay = 0;
+	//! A committing transaction stops waiting for the commit delay once this many transactions are waiting for the WAL
+	//! to be synced
+	index_t commit_batch_size = 16;
 	//! Whether or not to use Direct IO, bypassing operating system buffers
 	bool use_direct_io = false;
+	//! Whether or not a database opened in read-only mode is memory-mapped, instead of reading its blocks into memory
+	bool use_mmap = true;
+	//! The amount of threads used for query execution, including the thread that issues the query
+	index_t maximum_threads = 1;
+	//! The maximum amount of memory (in bytes) used for keeping blocks of the database file in memory. It is also the
+	//! budget of every operator that can spill its intermediate results to the temporary directory (hash aggregate,
+	//! hash join and order), each of which spills once its own intermediates exceed it.
+	index_t maximum_memory = (index_t)-1;
+	//! The amount of persistent segments (per scanned column) that a table scan reads ahead in the background, 0
+	//! disables read-ahead
+	index_t prefetch_depth = 4;
+	//! The directory in which operators can spill intermediate results when the memory limit is exceeded. If empty,
+	//! defaults to "[database_path].tmp" (or ".tmp" for in-memory databases).
+	string temporary_directory;
 	//! The FileSystem to use, can be overwritten to allow for injecting custom file systems for testing purposes (e.g.
 	//! RamFS or something similar)
 	unique_ptr<FileSystem> file_system;
-
-private:
-	// FIXME: don't set this as a user: used internally (only for now)
-	bool checkpoint_only = false;
 };
 
 //! The database object. This object holds the catalog and all the
@@ -58,14 +77,22 @@ public:
 	unique_ptr<Catalog> catalog;
 	unique_ptr<TransactionManager> transaction_manager;
 	unique_ptr<ConnectionManager> connection_manager;
+	unique_ptr<TaskScheduler> scheduler;
+	unique_ptr<TemporaryDirectory> temporary_directory;
 
 	AccessMode access_mode;
 	bool use_direct_io;
-	bool checkpoint_only;
+	bool use_mmap;
 	index_t checkpoint_wal_size;
+	index_t commit_delay;
+	index_t commit_batch_size;
+	index_t maximum_threads;
+	//! The memory limit, which can be changed by PRAGMA memory_limit while other connections are running queries
+	std::atomic<index_t> maximum_memory;
+	index_t prefetch_depth;
 
 private:
-	void Configure(DBConfig &config);
+	void Configure(DBConfig &config, const string &path);
 };
 
 } // namespace duckdb
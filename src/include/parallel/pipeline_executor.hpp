@@ -0,0 +1,41 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// parallel/pipeline_executor.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+#include "common/types/data_chunk.hpp"
+
+#include <functional>
+
+namespace duckdb {
+class ClientContext;
+class PhysicalOperator;
+class PhysicalOperatorState;
+
+//! The sink of a parallel pipeline, called for every chunk with the index of the thread that produced it
+typedef std::function<void(index_t thread_idx, DataChunk &chunk)> pipeline_sink_t;
+
+//! The PipelineExecutor drives a pipeline of streaming operators (filters, projections and hash join probes on top of
+//! a base table scan) with multiple threads. Every thread owns its own operator states and pulls morsels of the base
+//! table from a shared parallel scan, so the threads work on disjoint parts of the table. Pipeline breakers (e.g.
+//! aggregates, hash join builds and orders) use this to consume their child pipeline in parallel.
+class PipelineExecutor {
+public:
+	//! Returns the amount of threads that the pipeline rooted at the given operator can be executed with, or 1 if the
+	//! pipeline can only be executed by a single thread. This does not execute any part of the pipeline.
+	static index_t ParallelThreadCount(ClientContext &context, PhysicalOperator &op);
+	//! Executes the pipeline rooted at the given operator to completion with the given amount of threads, calling the
+	//! sink for every produced chunk. The sink is called concurrently from different threads. The hash tables of the
+	//! joins in the pipeline are built into the given operator state first and shared by the threads. If a join spilled
+	//! its build side, the pipeline is executed by the calling thread only, with thread index 0.
+	static void Execute(ClientContext &context, PhysicalOperator &op, PhysicalOperatorState *state,
+	                    index_t thread_count, pipeline_sink_t sink);
+};
+
+} // namespace duckdb
@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// parallel/task_scheduler.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace duckdb {
+
+typedef std::function<void()> task_function_t;
+
+//! A TaskGroup is a set of tasks that are executed together, the issuing thread waits for all of them to finish
+struct TaskGroup {
+	TaskGroup(vector<task_function_t> tasks);
+
+	//! The tasks of the group
+	vector<task_function_t> tasks;
+	//! The index of the next task that has to be picked up
+	std::atomic<index_t> next_task;
+	//! The amount of tasks that have finished executing
+	index_t finished_tasks;
+	//! The first error that was thrown by any of the tasks (if any)
+	std::exception_ptr error;
+	//! Lock and condition variable used to signal that all tasks have finished
+	std::mutex lock;
+	std::condition_variable finished;
+
+	//! Executes tasks of this group until there are none left to pick up
+	void Work();
+};
+
+//! The TaskScheduler is responsible for managing the worker threads of a database. Task groups are pushed into a
+//! queue from which the worker threads pick them up. The thread that issues a group of tasks always participates in
+//! executing them, so a group finishes even if all worker threads are busy.
+class TaskScheduler {
+public:
+	TaskScheduler();
+	~TaskScheduler();
+
+	//! Sets the total amount of threads used for query execution, including the thread that issues the query
+	void SetThreads(index_t threads);
+	//! Returns the total amount of threads used for query execution
+	index_t NumberOfThreads();
+	//! Executes the given set of tasks using the worker threads and the calling thread, and waits for all of them to
+	//! finish. If any of the tasks throws an exception, the first exception is rethrown after all tasks finished.
+	void ExecuteTasks(vector<task_function_t> tasks);
+
+private:
+	//! The main loop of a worker thread
+	void WorkerThread();
+	//! Stops and joins all worker threads
+	void StopWorkers();
+
+	//! Lock protecting the queue and the shutdown flag
+	std::mutex queue_lock;
+	//! Signaled when a new entry is pushed into the queue or the workers have to shut down
+	std::condition_variable queue_signal;
+	//! The queue of task groups that worker threads can help with
+	std::queue<std::shared_ptr<TaskGroup>> queue;
+	//! Whether or not the worker threads should shut down
+	bool shutdown;
+	//! Lock held while changing the amount of worker threads
+	std::mutex thread_lock;
+	//! The worker threads
+	vector<std::thread> workers;
+};
+
+} // namespace duckdb
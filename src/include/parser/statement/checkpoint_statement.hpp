@@ -0,0 +1,20 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// parser/statement/checkpoint_statement.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "parser/sql_statement.hpp"
+
+namespace duckdb {
+
+//! The CHECKPOINT statement writes the changes in the WAL to the database file and truncates the WAL
+class CheckpointStatement : public SQLStatement {
+public:
+	CheckpointStatement() : SQLStatement(StatementType::CHECKPOINT){};
+};
+} // namespace duckdb
@@ -1,4 +1,5 @@
 #include "parser/statement/alter_table_statement.hpp"
+#include "parser/statement/checkpoint_statement.hpp"
 #include "parser/statement/copy_statement.hpp"
 #include "parser/statement/create_index_statement.hpp"
 #include "parser/statement/create_schema_statement.hpp"
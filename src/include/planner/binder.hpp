@@ -107,6 +107,7 @@ private:
 	unique_ptr<BoundSQLStatement> Bind(CreateTableStatement &stmt);
 	unique_ptr<BoundSQLStatement> Bind(CreateIndexStatement &stmt);
 	unique_ptr<BoundSQLStatement> Bind(ExecuteStatement &stmt);
+	unique_ptr<BoundSQLStatement> Bind(CheckpointStatement &stmt);
 
 	unique_ptr<BoundQueryNode> Bind(SelectNode &node);
 	unique_ptr<BoundQueryNode> Bind(SetOperationNode &node);
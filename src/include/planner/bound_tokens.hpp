@@ -15,6 +15,7 @@ namespace duckdb {
 //===--------------------------------------------------------------------===//
 class BoundSQLStatement;
 
+class BoundCheckpointStatement;
 class BoundCopyStatement;
 class BoundCreateIndexStatement;
 class BoundCreateTableStatement;
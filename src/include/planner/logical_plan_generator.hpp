@@ -37,6 +37,7 @@ private:
 	unique_ptr<LogicalOperator> CreatePlan(BoundCreateTableStatement &statement);
 	unique_ptr<LogicalOperator> CreatePlan(BoundCreateIndexStatement &statement);
 	unique_ptr<LogicalOperator> CreatePlan(BoundExecuteStatement &statement);
+	unique_ptr<LogicalOperator> CreatePlan(BoundCheckpointStatement &statement);
 
 	unique_ptr<LogicalOperator> CreatePlan(BoundSelectNode &node);
 	unique_ptr<LogicalOperator> CreatePlan(BoundSetOperationNode &node);
@@ -44,5 +44,6 @@ class LogicalPrepare;
 class LogicalPruneColumns;
 class LogicalWindow;
 class LogicalExecute;
+class LogicalCheckpoint;
 
 } // namespace duckdb
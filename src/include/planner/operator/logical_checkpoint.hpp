@@ -0,0 +1,26 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// planner/operator/logical_checkpoint.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "planner/logical_operator.hpp"
+
+namespace duckdb {
+
+//! LogicalCheckpoint represents a CHECKPOINT statement
+class LogicalCheckpoint : public LogicalOperator {
+public:
+	LogicalCheckpoint() : LogicalOperator(LogicalOperatorType::CHECKPOINT) {
+	}
+
+protected:
+	void ResolveTypes() override {
+		types.push_back(TypeId::BOOLEAN);
+	}
+};
+} // namespace duckdb
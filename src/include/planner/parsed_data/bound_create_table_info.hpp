@@ -11,6 +11,8 @@
 #include "parser/parsed_data/create_table_info.hpp"
 #include "planner/bound_constraint.hpp"
 #include "planner/expression.hpp"
+#include "storage/data_pointer.hpp"
+#include "storage/index.hpp"
 #include "storage/table/persistent_segment.hpp"
 
 namespace duckdb {
@@ -31,6 +33,10 @@ struct BoundCreateTableInfo {
 	unordered_set<CatalogEntry *> dependencies;
 	//! The existing table data on disk (if any)
 	unique_ptr<vector<unique_ptr<PersistentSegment>>[]> data;
+	//! The location of the existing table data on disk
+	PersistentTableData persistent_data;
+	//! The existing indexes of the UNIQUE and PRIMARY KEY constraints on disk (if any)
+	vector<IndexPointer> indexes;
 	//! The base create table info
 	unique_ptr<CreateTableInfo> base;
 };
@@ -0,0 +1,28 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// planner/statement/bound_checkpoint_statement.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "planner/bound_sql_statement.hpp"
+
+namespace duckdb {
+//! Bound equivalent to CheckpointStatement
+class BoundCheckpointStatement : public BoundSQLStatement {
+public:
+	BoundCheckpointStatement() : BoundSQLStatement(StatementType::CHECKPOINT) {
+	}
+
+public:
+	vector<string> GetNames() override {
+		return {"Success"};
+	}
+	vector<SQLType> GetTypes() override {
+		return {SQLType(SQLTypeId::BOOLEAN)};
+	}
+};
+} // namespace duckdb
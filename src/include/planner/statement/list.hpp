@@ -1,3 +1,4 @@
+#include "planner/statement/bound_checkpoint_statement.hpp"
 #include "planner/statement/bound_copy_statement.hpp"
 #include "planner/statement/bound_create_index_statement.hpp"
 #include "planner/statement/bound_create_table_statement.hpp"
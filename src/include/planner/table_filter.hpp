@@ -0,0 +1,31 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// planner/table_filter.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+#include "common/enums/expression_type.hpp"
+#include "common/types/value.hpp"
+
+namespace duckdb {
+
+//! A TableFilter represents a comparison of the form [column] [comparison] [constant] that is pushed into a table scan
+struct TableFilter {
+	TableFilter(Value constant, ExpressionType comparison_type, index_t column_index)
+	    : constant(constant), comparison_type(comparison_type), column_index(column_index) {
+	}
+
+	//! The constant to compare against
+	Value constant;
+	//! The comparison type (one of =, <, <=, >, >=)
+	ExpressionType comparison_type;
+	//! The index of the filtered column in the column_ids of the scan
+	index_t column_index;
+};
+
+} // namespace duckdb
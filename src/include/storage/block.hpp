@@ -17,6 +17,8 @@ namespace duckdb {
 class Block : public FileBuffer {
 public:
 	Block(block_id_t id);
+	//! Create a block that refers to the (BLOCK_SIZE bytes of) data of the block in existing memory
+	Block(block_id_t id, data_ptr_t data);
 
 	block_id_t id;
 };
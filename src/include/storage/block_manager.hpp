@@ -14,7 +14,8 @@
 
 namespace duckdb {
 //! BlockManager is an abstract representation to manage blocks on DuckDB. When writing or reading blocks, the
-//! BlockManager creates and accesses blocks. The concrete types implements how blocks are stored.
+//! BlockManager creates and accesses blocks. The concrete types implements how blocks are stored. Blocks can be
+//! created, read and written by multiple threads at the same time.
 class BlockManager {
 public:
 	virtual ~BlockManager() = default;
@@ -23,10 +24,19 @@ public:
 	virtual unique_ptr<Block> CreateBlock() = 0;
 	//! Return the next free block id
 	virtual block_id_t GetFreeBlockId() = 0;
+	//! Mark a block of the current checkpoint as being used by the next checkpoint as well, so it is not added to the
+	//! free list when the next checkpoint is written
+	virtual void MarkBlockAsUsed(block_id_t block_id) = 0;
 	//! Get the first meta block id
 	virtual block_id_t GetMetaBlock() = 0;
 	//! Read the content of the block from disk
 	virtual void Read(Block &block) = 0;
+	//! Load the block with the given id from disk
+	virtual unique_ptr<Block> LoadBlock(block_id_t block_id) {
+		auto block = make_unique<Block>(block_id);
+		Read(*block);
+		return block;
+	}
 	//! Writes the block to disk
 	virtual void Write(Block &block) = 0;
 	//! Write the header; should be the final step of a checkpoint
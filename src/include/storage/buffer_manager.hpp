@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// storage/buffer_manager.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+#include "common/unordered_map.hpp"
+#include "storage/block.hpp"
+#include "storage/block_manager.hpp"
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace duckdb {
+class BufferManager;
+struct BufferEntry;
+
+//! A BufferHandle pins a block in memory, the block is unpinned when the handle is destroyed
+class BufferHandle {
+public:
+	BufferHandle(BufferManager &manager, BufferEntry *entry, Block *block);
+	~BufferHandle();
+
+	//! The buffer manager that pinned the block
+	BufferManager &manager;
+	//! The pinned block
+	Block *block;
+
+private:
+	BufferEntry *entry;
+};
+
+//! The BufferManager is responsible for keeping the persistent blocks of the database in memory. Blocks are loaded
+//! from the BlockManager when they are pinned, and unpinned blocks are evicted in least-recently-used order when
+//! loading a new block would exceed the memory limit.
+class BufferManager {
+	friend class BufferHandle;
+
+public:
+	BufferManager(BlockManager &manager, index_t maximum_memory);
+	~BufferManager();
+
+	//! Pin a block in memory, loading it from disk if it is not loaded yet. The block cannot be evicted until the
+	//! returned handle is destroyed. Throws an OutOfMemoryException if the block cannot be loaded within the memory
+	//! limit.
+	unique_ptr<BufferHandle> Pin(block_id_t block_id);
+	//! Schedule a block to be loaded in the background, so a subsequent Pin of the block does not have to wait for
+	//! the disk. Does nothing if the block is already loaded (or being loaded), or if there is no room for it within
+	//! the memory limit.
+	void Prefetch(block_id_t block_id);
+	//! Set a new memory limit, evicting unpinned blocks if the currently used memory exceeds the limit
+	void SetLimit(index_t limit);
+
+	//! Returns the amount of memory used by the loaded blocks
+	index_t GetUsedMemory() {
+		return current_memory;
+	}
+	//! Returns the memory limit
+	index_t GetMaxMemory() {
+		return maximum_memory;
+	}
+	//! Returns the block manager that is used to read the blocks
+	BlockManager &GetBlockManager() {
+		return manager;
+	}
+
+private:
+	//! Unpin a block, adding it to the set of blocks that can be evicted when it is no longer pinned by anyone
+	void Unpin(BufferEntry *entry);
+	//! Release a pin of an entry, requires the lock to be held
+	void ReleaseEntry(BufferEntry *entry);
+	//! Evict unpinned blocks until extra_memory more memory fits within the memory limit. Returns false if not enough
+	//! blocks could be evicted. Requires the lock to be held.
+	bool EvictBlocks(index_t extra_memory, index_t memory_limit);
+	//! Load a block into an entry that was reserved for it, if it has not been loaded yet
+	void LoadBlock(BufferEntry *entry);
+	//! The main loop of the prefetch thread: loads the scheduled blocks until the buffer manager is destroyed
+	void PrefetchBlocks();
+
+	//! The block manager used to read the blocks
+	BlockManager &manager;
+	//! The amount of memory currently reserved for loaded blocks
+	index_t current_memory;
+	//! The memory limit
+	index_t maximum_memory;
+	//! Lock protecting the set of blocks and the LRU list
+	std::mutex lock;
+	//! The blocks that are currently loaded (or being loaded)
+	unordered_map<block_id_t, unique_ptr<BufferEntry>> blocks;
+	//! The unpinned blocks, ordered from least to most recently used
+	std::list<BufferEntry *> lru;
+
+	//! The thread that loads prefetched blocks, started by the first call to Prefetch
+	std::thread prefetch_thread;
+	//! The entries (pinned by the prefetcher) that still have to be loaded by the prefetch thread
+	std::list<BufferEntry *> prefetch_queue;
+	//! The amount of blocks that are currently being loaded by the prefetch thread
+	index_t prefetch_loading;
+	//! Condition variable used to wake up the prefetch thread and to wait for it, protected by the lock
+	std::condition_variable prefetch_cv;
+	//! Set when the buffer manager is destroyed to stop the prefetch thread
+	bool prefetch_done;
+};
+
+} // namespace duckdb
@@ -10,12 +10,27 @@
 
 #include "storage/checkpoint_manager.hpp"
 #include "common/unordered_map.hpp"
+#include "storage/table/column_segment.hpp"
+#include "parallel/task_scheduler.hpp"
+#include "storage/index.hpp"
 
 namespace duckdb {
+class ART;
 
+//! The dictionary of the strings of a VARCHAR block. Every distinct string is assigned a dense code, the block stores
+//! the code of every row followed by the dictionary: [entry count][string offset of every code][string data]
 struct StringDictionary {
-	unordered_map<string, index_t> offsets;
+	//! The code of every string in the dictionary
+	unordered_map<string, index_t> codes;
+	//! The offset of every string (by code) in the string data
+	vector<index_t> offsets;
+	//! The size of the string data
 	index_t size = 0;
+
+	//! Returns the size of the dictionary when written to the block
+	index_t GetSize() {
+		return sizeof(uint32_t) + offsets.size() * sizeof(uint32_t) + size;
+	}
 };
 
 //! The table data writer is responsible for writing the data of a table to the block manager
@@ -31,15 +46,33 @@ public:
 public:
 	TableDataWriter(CheckpointManager &manager, TableCatalogEntry &table);
 
-	void WriteTableData(Transaction &transaction);
+	//! Prepare writing the data of the table. If the table has changed, a task that writes the data of a column is
+	//! added to the tasks for every column of the table. The tasks can be executed in parallel.
+	void WriteTableData(Transaction &transaction, vector<task_function_t> &tasks);
+	//! Scan the column and write its data to blocks
+	void WriteColumn(Transaction &transaction, index_t col);
+	//! Write the unique index with the given number to blocks
+	void WriteIndex(Transaction &transaction, index_t index_nr);
 
-	void WriteColumnData(DataChunk &chunk, index_t column_index);
+	void WriteColumnData(Vector &data, index_t column_index);
 	void WriteString(index_t index, const char *val);
-	void FlushBlock(index_t col);
+	//! Write the current block of the column to disk. If the block is the last block of the column and contains
+	//! little data, the data is packed into a block that is shared with other segments instead.
+	void FlushBlock(index_t col, bool last_block = false);
 
 	void WriteDataPointers();
+	//! Called after the checkpoint has been written: the table keeps the location of its data in the checkpoint, so
+	//! the next checkpoint can point to the same data if the table has not changed in the meantime
+	void FinalizeCheckpoint();
 
 private:
+	//! Writes the data pointers of a table that has not changed since the previous checkpoint, the data pointers
+	//! point to the existing blocks of the table
+	void WriteExistingTableData();
+	//! Write the rows [start, end) of the column as deleted rows
+	void WriteDeletedRows(index_t col, index_t start, index_t end);
+	//! Add the rows [start, end) to the deleted rows of the table
+	void AddDeletedRows(index_t start, index_t end);
 	//! Flush the block of the column if it cannot fit write_size more bytes
 	void FlushIfFull(index_t col, index_t write_size);
 	//! Writes the dictionary to the block buffer
@@ -54,8 +87,26 @@ private:
 	vector<index_t> row_numbers;
 	vector<index_t> indexes;
 	vector<StringDictionary> dictionaries;
+	//! The statistics of the data in the current block of each column
+	vector<unique_ptr<SegmentStatistics>> stats;
+	//! The compressors collecting the values of the current block of each fixed-size column (nullptr for VARCHAR)
+	vector<unique_ptr<SegmentCompressor>> compressors;
 
 	vector<vector<DataPointer>> data_pointers;
+	//! The blocks used by the data of the table
+	vector<block_id_t> data_blocks;
+	//! The blocks written by each column of the table
+	vector<vector<block_id_t>> column_blocks;
+	//! The indexes of the UNIQUE and PRIMARY KEY constraints of the table
+	vector<ART *> unique_indexes;
+	//! The location of each written unique index
+	vector<IndexPointer> index_pointers;
+	//! The amount of rows of the table, including deleted rows
+	index_t row_count;
+	//! The rows of the table that are not visible to the checkpoint, they are recorded by the task of the first column
+	vector<RowRange> deleted_rows;
+	//! The change count of the table when its data was written
+	index_t change_count;
 };
 
 } // namespace duckdb
@@ -12,6 +12,10 @@
 #include "common/types/chunk_collection.hpp"
 #include "storage/storage_manager.hpp"
 #include "storage/meta_block_writer.hpp"
+#include "storage/data_pointer.hpp"
+#include "common/unordered_map.hpp"
+
+#include <mutex>
 
 namespace duckdb {
 class ClientContext;
@@ -19,30 +23,32 @@ class MetaBlockReader;
 class SchemaCatalogEntry;
 class SequenceCatalogEntry;
 class TableCatalogEntry;
+class TableDataWriter;
+class Transaction;
 class ViewCatalogEntry;
 
-struct DataPointer {
-	double min;
-	double max;
-	uint64_t row_start;
-	uint64_t tuple_count;
-	block_id_t block_id;
-	uint32_t offset;
-};
-
 //! CheckpointManager is responsible for checkpointing the database
 class CheckpointManager {
 public:
+	//! Segments up to this size that do not fill a block by themselves are packed together into shared blocks
+	static constexpr index_t MAXIMUM_PACKED_SEGMENT_SIZE = BLOCK_SIZE / 2;
+
 	CheckpointManager(StorageManager &manager);
 
-	//! Checkpoint the current state of the WAL and flush it to the main storage. This should be called BEFORE any
-	//! connction is available because right now the checkpointing cannot be done online. (TODO)
+	//! Write a checkpoint of the current state of the database to the main storage. Tables that have not changed since
+	//! the previous checkpoint keep pointing to their existing blocks, all other tables are written to free blocks. The
+	//! checkpoint is written in a separate transaction, so it can be created while the database is in use.
 	void CreateCheckpoint();
 	//! Load from a stored checkpoint
 	void LoadFromStorage();
+	//! Copy the data of a small segment into the block that is shared by the small segments of all tables, and
+	//! returns the block id and offset the segment is stored at. Can be called from multiple threads.
+	void PackSegment(data_ptr_t data, index_t size, block_id_t &block_id, uint32_t &offset);
 
 	//! The block manager to write the checkpoint to
 	BlockManager &block_manager;
+	//! The buffer manager used to load the blocks of the checkpoint
+	BufferManager &buffer_manager;
 	//! The database this storagemanager belongs to
 	DuckDB &database;
 	//! The metadata writer is responsible for writing schema information
@@ -51,6 +57,21 @@ public:
 	unique_ptr<MetaBlockWriter> tabledata_writer;
 
 private:
+	//! Write the data of all tables in parallel, the data pointers are written afterwards together with the metadata
+	//! of the tables
+	void WriteTableData(Transaction &transaction, vector<SchemaCatalogEntry *> &schemas);
+	//! Write the shared block with the packed segments to disk
+	void FlushPartialBlock();
+
+	//! The writers that wrote the data of the tables
+	unordered_map<TableCatalogEntry *, unique_ptr<TableDataWriter>> table_writers;
+	//! Lock protecting the partial block
+	std::mutex partial_block_lock;
+	//! The block the small segments are currently packed into, or nullptr if there is none
+	unique_ptr<Block> partial_block;
+	//! The amount of bytes of the partial block that are in use
+	index_t partial_block_offset;
+
 	void WriteSchema(Transaction &transaction, SchemaCatalogEntry &schema);
 	void WriteTable(Transaction &transaction, TableCatalogEntry &table);
 	void WriteView(Transaction &transaction, ViewCatalogEntry &table);
@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// storage/data_pointer.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+#include "storage/storage_info.hpp"
+#include "storage/table/compression.hpp"
+
+namespace duckdb {
+
+struct DataPointer {
+	//! The minimum and maximum value of the block (only used for numeric types)
+	data_t min[8];
+	data_t max[8];
+	//! Whether or not the block contains NULL values
+	bool has_null;
+	uint64_t row_start;
+	uint64_t tuple_count;
+	block_id_t block_id;
+	uint32_t offset;
+	//! The compression used for the data of the block (only used for numeric types)
+	CompressionType compression;
+};
+
+//! A range of consecutive rows of a table
+struct RowRange {
+	row_t start;
+	index_t count;
+};
+
+//! The location of the data of a table in a checkpoint
+struct PersistentTableData {
+	//! The data pointers of the segments of every column
+	vector<vector<DataPointer>> data_pointers;
+	//! The blocks used by the data of the table, including the blocks of big strings
+	vector<block_id_t> data_blocks;
+	//! The amount of rows in the checkpoint. Rows keep their row id in the checkpoint, so this includes deleted rows.
+	index_t row_count = 0;
+	//! The rows that are deleted, their values are stored as NULL
+	vector<RowRange> deleted_rows;
+};
+
+} // namespace duckdb
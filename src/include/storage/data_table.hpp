@@ -10,10 +10,12 @@
 
 #include "common/enums/index_type.hpp"
 #include "common/types/data_chunk.hpp"
+#include "planner/table_filter.hpp"
 #include "storage/index.hpp"
 #include "storage/table/version_chunk.hpp"
 #include "storage/table_statistics.hpp"
 #include "storage/block.hpp"
+#include "storage/data_pointer.hpp"
 #include "storage/table/column_segment.hpp"
 #include "storage/table/persistent_segment.hpp"
 
@@ -42,6 +44,16 @@ struct TableScanState {
 	index_t last_chunk_count;
 };
 
+//! The ParallelTableScanState hands out morsels (version chunks) of a table to multiple scanning threads
+struct ParallelTableScanState {
+	//! Lock protecting the current chunk
+	std::mutex lock;
+	//! The next version chunk to hand out, or nullptr if the scan is exhausted
+	VersionChunk *current_chunk;
+	VersionChunk *last_chunk;
+	index_t last_chunk_count;
+};
+
 struct IndexTableScanState : public TableScanState {
 	index_t version_index;
 	index_t version_offset;
@@ -52,7 +64,8 @@ struct IndexTableScanState : public TableScanState {
 class DataTable {
 public:
 	DataTable(StorageManager &storage, string schema, string table, vector<TypeId> types,
-	          unique_ptr<vector<unique_ptr<PersistentSegment>>[]> data);
+	          unique_ptr<vector<unique_ptr<PersistentSegment>>[]> data,
+	          PersistentTableData persistent_data = PersistentTableData());
 
 	//! The amount of elements in the table. Note that this number signifies the amount of COMMITTED entries in the
 	//! table. It can be inaccurate inside of transactions. More work is needed to properly support that.
@@ -71,24 +84,51 @@ public:
 	StorageManager &storage;
 	//! Indexes
 	vector<unique_ptr<Index>> indexes;
+	//! The location of the data of the table in the last checkpoint that was written or loaded
+	PersistentTableData persistent_data;
+	//! The amount of changes to the table that were committed, plus the amount of appends that were rolled back (as
+	//! they leave deleted rows behind)
+	std::atomic<index_t> change_count;
+	//! The change count of the table when its persistent data was written or loaded
+	index_t persistent_change_count;
 
 public:
 	void InitializeScan(TableScanState &state);
 	//! Scans up to STANDARD_VECTOR_SIZE elements from the table starting
 	// from offset and store them in result. Offset is incremented with how many
-	// elements were returned.
+	// elements were returned. Only tuples that satisfy the table_filters are returned, version chunks for which the
+	// zone maps prove that no tuple can satisfy the table_filters are skipped entirely.
 	void Scan(Transaction &transaction, DataChunk &result, const vector<column_t> &column_ids,
-	          TableScanState &structure);
-	//! Fetch data from the specific row identifiers from the base table
+	          TableScanState &structure, const vector<TableFilter> &table_filters = vector<TableFilter>());
+	//! Initializes a scan of the table that is divided over multiple threads
+	void InitializeParallelScan(ParallelTableScanState &state);
+	//! Assigns the next morsel of a parallel scan to the (thread-local) scan state. Returns false if there are no
+	//! morsels left to scan.
+	bool NextParallelScan(ParallelTableScanState &state, TableScanState &scan_state);
+	//! Returns the amount of morsels a parallel scan of the table is divided into
+	index_t MorselCount();
+	//! Returns the amount of rows that have been appended to the table, including rows of uncommitted transactions.
+	//! Rows that are appended later receive row identifiers that are not smaller than this amount.
+	index_t AppendedRowCount();
+	//! Fetch data from the specific row identifiers from the base table. Consecutive row identifiers that belong to
+	//! the same storage chunk are fetched under a single lock of that chunk.
 	void Fetch(Transaction &transaction, DataChunk &result, vector<column_t> &column_ids, Vector &row_ids);
 	//! Append a DataChunk to the table. Throws an exception if the columns
 	// don't match the tables' columns.
 	void Append(TableCatalogEntry &table, ClientContext &context, DataChunk &chunk);
+	//! Append a DataChunk of rows whose constraints were already verified, only used to replay the WAL. If a
+	//! transaction is given the rows are only visible to the transaction until it commits, otherwise they are committed
+	//! right away: the rows are visible to all transactions, and cannot be rolled back.
+	void AppendVerified(DataChunk &chunk, Transaction *transaction);
 	//! Delete the entries with the specified row identifier from the table
 	void Delete(TableCatalogEntry &table, ClientContext &context, Vector &row_ids);
 	//! Update the entries with the specified row identifier from the table
 	void Update(TableCatalogEntry &table, ClientContext &context, Vector &row_ids, vector<column_t> &column_ids,
 	            DataChunk &data);
+	//! Update the entries with the specified row identifier from the table without verifying the constraints, only used
+	//! to replay the WAL
+	void UpdateVerified(TableCatalogEntry &table, ClientContext &context, Vector &row_ids,
+	                    vector<column_t> &column_ids, DataChunk &data);
 
 	void InitializeIndexScan(IndexTableScanState &state);
 	//! Scan used for creating an index, incrementally locks all storage chunks and scans ALL tuples in the table
@@ -109,24 +149,51 @@ public:
 	//! Add an index to the DataTable
 	void AddIndex(unique_ptr<Index> index, vector<unique_ptr<Expression>> &expressions);
 
+	//! Returns true if the table has changed since its persistent data was written or loaded, i.e. if rows have been
+	//! appended, deleted or updated by transactions that committed since then. Changes of transactions that have not
+	//! committed yet are not included: they are counted once the transaction commits.
+	bool HasChanges();
+
 private:
 	index_t InitializeTable(unique_ptr<vector<unique_ptr<PersistentSegment>>[]> data);
 	//! Append a storage chunk with the given start index to the data table. Returns a pointer to the newly created
 	//! storage chunk.
 	VersionChunk *AppendVersionChunk(index_t start);
+	//! Append the rows of the chunk to the table. If a transaction is given the rows are only visible to the
+	//! transaction until it commits, otherwise they are visible to all transactions right away. If verify_keys is false
+	//! the uniqueness of the index keys is not verified. If the rows are the new versions of rows that are moved by an
+	//! update, updated_columns holds the updated columns.
+	void AppendRows(DataChunk &chunk, Transaction *transaction, bool verify_keys,
+	                vector<column_t> *updated_columns = nullptr);
 	//! Append a subset of a vector to the specified column of the table
 	void AppendVector(index_t column, Vector &data, index_t offset, index_t count);
+	//! Checks the zone maps of the column segments covering the version chunk, returns false if no tuple in the chunk
+	//! can satisfy the table filters
+	bool CheckZonemap(VersionChunk *chunk, TableScanState &state, const vector<column_t> &column_ids,
+	                  const vector<TableFilter> &table_filters);
+	//! Start reading the persistent segments of the scanned columns ahead of the scan position in the background
+	void PrefetchColumns(TableScanState &state, const vector<column_t> &column_ids);
 
 	//! Verify constraints with a chunk from the Append containing all columns of the table
 	void VerifyAppendConstraints(TableCatalogEntry &table, DataChunk &chunk);
 	//! Verify constraints with a chunk from the Update containing only the specified column_ids
 	void VerifyUpdateConstraints(TableCatalogEntry &table, DataChunk &chunk, vector<column_t> &column_ids);
 
-	//! Append a DataChunk to the set of indexes
-	void AppendToIndexes(DataChunk &chunk, row_t row_start);
+	//! Update the entries with the specified row identifiers. The uniqueness of the index keys is only verified if
+	//! verify_keys is true.
+	void UpdateRows(TableCatalogEntry &table, ClientContext &context, Vector &row_ids, vector<column_t> &column_ids,
+	                DataChunk &updates, bool verify_keys);
+	//! Update the entries with the specified row identifiers, which all belong to the given chunk and are either all or
+	//! none stored in the last checkpoint
+	void UpdateChunk(TableCatalogEntry &table, ClientContext &context, VersionChunk &chunk, Vector &row_ids,
+	                 vector<column_t> &column_ids, DataChunk &updates, bool verify_keys);
+
+	//! Append a DataChunk to the set of indexes. The uniqueness of the keys is only verified if verify_keys is true.
+	//! If the rows are moved by an update, the indexes that are not affected by the updated columns keep their keys.
+	void AppendToIndexes(DataChunk &chunk, row_t row_start, bool verify_keys, vector<column_t> *updated_columns);
 	//! Issue the specified update to the set of indexes
 	void UpdateIndexes(TableCatalogEntry &table, vector<column_t> &column_ids, DataChunk &updates,
-	                   Vector &row_identifiers);
+	                   Vector &row_identifiers, bool verify_keys);
 
 private:
 	//! The stored data of the table
@@ -13,6 +13,7 @@
 #include "common/types/data_chunk.hpp"
 #include "parser/parsed_expression.hpp"
 #include "planner/expression.hpp"
+#include "storage/block.hpp"
 
 namespace duckdb {
 
@@ -20,6 +21,15 @@ class ClientContext;
 class DataTable;
 class Transaction;
 
+//! The location of an index that was written to storage by a checkpoint
+struct IndexPointer {
+	//! The block and offset the root node of the index is stored at (INVALID_BLOCK if the index is empty)
+	block_id_t block_id = INVALID_BLOCK;
+	uint32_t offset = 0;
+	//! The blocks used by the nodes of the index
+	vector<block_id_t> blocks;
+};
+
 struct IndexScanState {
 	vector<column_t> column_ids;
 
@@ -61,11 +71,19 @@ public:
 	                                                               vector<column_t> column_ids, Value low_value,
 	                                                               ExpressionType low_expression_type, Value high_value,
 	                                                               ExpressionType high_expression_type) = 0;
+	//! Initialize a scan on the index with the given column ids to fetch from the base table for the entries that are
+	//! equal to the given values, with a value for every expression of the index
+	virtual unique_ptr<IndexScanState> InitializeScanEqual(Transaction &transaction, vector<column_t> column_ids,
+	                                                       vector<Value> values) = 0;
 	//! Perform a lookup on the index
 	virtual void Scan(Transaction &transaction, IndexScanState *ss, DataChunk &result) = 0;
 
 	//! Called when data is appended to the index
 	virtual bool Append(DataChunk &entries, Vector &row_identifiers) = 0;
+	//! Called when data is appended to the index whose keys were already verified: rows that are moved to new row ids
+	//! by an update that does not change the keys, or rows that are replayed from the WAL. The uniqueness of the keys
+	//! is not checked, the entries of moved rows are deleted when the old rows are cleaned up.
+	virtual void AppendVerified(DataChunk &entries, Vector &row_identifiers) = 0;
 
 	//! Called when data inside the index is Deleted
 	virtual void Delete(DataChunk &entries, Vector &row_identifiers) = 0;
@@ -73,6 +91,12 @@ public:
 	//! Insert data into the index. Does not lock the index.
 	virtual bool Insert(DataChunk &input, Vector &row_identifiers) = 0;
 
+	//! Add entries of the existing table data to an index that is being created. The entries only have to be part of
+	//! the index after FinalizeBuild is called. Does not lock the index.
+	virtual void BuildAppend(DataChunk &input, Vector &row_identifiers) = 0;
+	//! Finish creating the index from the entries that were added with BuildAppend
+	virtual void FinalizeBuild() = 0;
+
 	//! Returns true if the index is affected by updates on the specified column ids, and false otherwise
 	bool IndexIsUpdated(vector<column_t> &column_ids);
 
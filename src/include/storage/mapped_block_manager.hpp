@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// storage/mapped_block_manager.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+#include "storage/block_manager.hpp"
+#include "storage/block.hpp"
+#include "common/file_system.hpp"
+
+#include <mutex>
+
+namespace duckdb {
+
+//! MappedBlockManager is a read-only BlockManager for a single database file that maps the file into memory. Loaded
+//! blocks point directly into the mapping instead of being copied into memory of their own, so processes that read the
+//! same database file share the pages of the file in the operating system's page cache.
+class MappedBlockManager : public BlockManager {
+	//! The location in the file where the block writing starts
+	static constexpr uint64_t BLOCK_START = HEADER_SIZE * 3;
+
+public:
+	MappedBlockManager(FileSystem &fs, string path);
+	~MappedBlockManager();
+
+	//! Blocks cannot be created in a read-only database, throws an exception
+	unique_ptr<Block> CreateBlock() override;
+	//! Blocks cannot be created in a read-only database, throws an exception
+	block_id_t GetFreeBlockId() override;
+	//! Blocks cannot be written in a read-only database, throws an exception
+	void MarkBlockAsUsed(block_id_t block_id) override;
+	//! Return the meta block id
+	block_id_t GetMetaBlock() override;
+	//! Read the content of the block from the file into the block
+	void Read(Block &block) override;
+	//! Returns a block that points into the mapped file. The checksum of the block is verified the first time it is
+	//! loaded.
+	unique_ptr<Block> LoadBlock(block_id_t block_id) override;
+	//! Blocks cannot be written in a read-only database, throws an exception
+	void Write(Block &block) override;
+	//! Blocks cannot be written in a read-only database, throws an exception
+	void WriteHeader(DatabaseHeader header) override;
+
+private:
+	//! Returns a pointer to the data of the block in the mapped file
+	data_ptr_t GetBlockData(block_id_t block_id);
+
+	//! The file system used to map the file
+	FileSystem &fs;
+	//! The path where the file is stored
+	string path;
+	//! The file handle
+	unique_ptr<FileHandle> handle;
+	//! The mapped database file
+	data_ptr_t data;
+	//! The size of the mapped database file
+	index_t file_size;
+	//! The current meta block id
+	block_id_t meta_block;
+	//! Lock protecting the set of verified blocks
+	std::mutex verify_lock;
+	//! Whether or not the checksum of a block has been verified already
+	vector<bool> verified_blocks;
+};
+} // namespace duckdb
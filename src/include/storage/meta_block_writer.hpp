@@ -24,6 +24,8 @@ public:
 	BlockManager &manager;
 	unique_ptr<Block> block;
 	index_t offset;
+	//! The ids of the blocks that have been written by the writer
+	vector<block_id_t> written_blocks;
 
 public:
 	void Flush();
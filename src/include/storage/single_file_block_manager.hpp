@@ -12,6 +12,9 @@
 #include "storage/block_manager.hpp"
 #include "storage/block.hpp"
 #include "common/file_system.hpp"
+#include "common/unordered_set.hpp"
+
+#include <mutex>
 
 namespace duckdb {
 class FileBuffer;
@@ -28,6 +31,8 @@ public:
 	unique_ptr<Block> CreateBlock() override;
 	//! Return the next free block id
 	block_id_t GetFreeBlockId() override;
+	//! Mark a block of the current checkpoint as being used by the next checkpoint
+	void MarkBlockAsUsed(block_id_t block_id) override;
 	//! Return the meta block id
 	block_id_t GetMetaBlock() override;
 	//! Read the content of the block from disk
@@ -49,10 +54,17 @@ private:
 	unique_ptr<FileHandle> handle;
 	//! The buffer used to read/write to the headers
 	FileBuffer header_buffer;
+	//! Lock protecting the free list and the set of blocks of the checkpoint, blocks are written by multiple threads
+	std::mutex block_lock;
 	//! The list of free blocks that can be written to currently
 	vector<block_id_t> free_list;
-	//! The list of blocks that are used by the current block manager
-	vector<block_id_t> used_blocks;
+	//! The set of blocks that are used by the current checkpoint
+	unordered_set<block_id_t> used_blocks;
+	//! The set of blocks that are used by the checkpoint that is currently being written
+	unordered_set<block_id_t> checkpoint_blocks;
+	//! The set of blocks that were used by the checkpoint the database was loaded from. The persistent segments in
+	//! memory can still read from these blocks, so they are never reused while the database is open.
+	unordered_set<block_id_t> loaded_blocks;
 	//! The current meta block id
 	block_id_t meta_block;
 	//! The current maximum block id, this id will be given away first after the free_list runs out
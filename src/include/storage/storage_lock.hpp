@@ -37,10 +37,22 @@ public:
 	unique_ptr<StorageLockKey> GetExclusiveLock();
 	//! Get a shared lock
 	unique_ptr<StorageLockKey> GetSharedLock();
+	//! Get an exclusive lock without waiting, returns nullptr if the lock is currently held by someone else
+	unique_ptr<StorageLockKey> TryGetExclusiveLock();
+
+	//! Start an optimistic read of the data protected by the lock, without obtaining the lock. Waits until no
+	//! exclusive lock is held, and returns the version that has to be passed to ValidateOptimisticRead.
+	index_t StartOptimisticRead();
+	//! Returns true if no exclusive lock was obtained since the optimistic read started, i.e. the data that was read
+	//! in the meantime is consistent. Otherwise the data has to be read again.
+	bool ValidateOptimisticRead(index_t version);
 
 private:
 	std::mutex exclusive_lock;
 	std::atomic<index_t> read_count;
+	//! Incremented both when an exclusive lock is obtained and when it is released, i.e. it is odd while an exclusive
+	//! lock is held
+	std::atomic<index_t> write_version;
 
 private:
 	//! Release an exclusive lock
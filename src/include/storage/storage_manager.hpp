@@ -14,6 +14,7 @@
 
 namespace duckdb {
 class BlockManager;
+class BufferManager;
 class Catalog;
 class DuckDB;
 class TransactionManager;
@@ -32,20 +33,25 @@ public:
 	WriteAheadLog *GetWriteAheadLog() {
 		return wal.initialized ? &wal : nullptr;
 	}
+	//! Checkpoint the database if the WAL has grown beyond the checkpoint_wal_size (or unconditionally if force is
+	//! set), and truncate the WAL afterwards. The checkpoint is created online: only transactions that made changes
+	//! have to wait for it to finish before they can commit.
+	void CreateCheckpoint(bool force = false);
 
 	DuckDB &GetDatabase() {
 		return database;
 	}
 	//! The BlockManager to read/store meta information and data in blocks
 	unique_ptr<BlockManager> block_manager;
+	//! The BufferManager that keeps the blocks of the database file in memory, only initialized for persistent
+	//! databases
+	unique_ptr<BufferManager> buffer_manager;
 	//! The database this storagemanager belongs to
 	DuckDB &database;
 
 private:
 	//! Load the database from a directory
 	void LoadDatabase();
-	//! Create a checkpoint of the database
-	void Checkpoint(string wal_path);
 
 	//! The path of the database
 	string path;
@@ -16,6 +16,7 @@ namespace duckdb {
 class BlockManager;
 class ColumnSegment;
 class Vector;
+struct TableFilter;
 
 enum class ColumnSegmentType : uint8_t { TRANSIENT, PERSISTENT };
 
@@ -30,12 +31,22 @@ struct ColumnPointer {
 struct SegmentStatistics {
 	SegmentStatistics(TypeId type, index_t type_size);
 
-	//! The minimum value of the segment
+	//! The type of the segment
+	TypeId type;
+	//! The minimum value of the segment (only maintained for numeric types)
 	unique_ptr<data_t[]> minimum;
-	//! The maximum value of the segment
+	//! The maximum value of the segment (only maintained for numeric types)
 	unique_ptr<data_t[]> maximum;
 	//! Whether or not the segment has NULL values
 	bool has_null;
+
+public:
+	//! Reset the statistics to the empty state
+	void Reset();
+	//! Update the statistics with the values of a vector
+	void Update(Vector &new_data);
+	//! Returns false if the statistics prove that no value in the segment can satisfy the filter, true otherwise
+	bool CheckZonemap(const TableFilter &filter);
 };
 
 class ColumnSegment : public SegmentBase {
@@ -58,6 +69,15 @@ public:
 	virtual void Scan(ColumnPointer &pointer, Vector &result, index_t count, sel_t *sel_vector, index_t sel_count) = 0;
 	//! Fetch an individual value and append it to a vector, row_id must be >= start
 	virtual void Fetch(Vector &result, index_t row_id) = 0;
+	//! Evaluates the table filter directly on the stored data for the sel_count entries of sel_vector (relative to the
+	//! pointer, which is not advanced). The selection vector is reduced to the entries that pass the filter. Returns
+	//! false if the segment cannot evaluate the filter, in which case the values have to be scanned and compared.
+	virtual bool Filter(ColumnPointer &pointer, const TableFilter &filter, sel_t sel_vector[], index_t &sel_count) {
+		return false;
+	}
+	//! Start loading the data of the segment in the background, if it is not in memory yet
+	virtual void Prefetch() {
+	}
 };
 
 } // namespace duckdb
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// storage/table/compression.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+#include "common/types/vector.hpp"
+#include "storage/storage_info.hpp"
+
+namespace duckdb {
+
+//! The compression used for the data of a persistent segment of a fixed-size column
+enum class CompressionType : uint8_t {
+	//! The values are stored as-is
+	UNCOMPRESSED = 0,
+	//! All values of the segment are identical, the value is stored once
+	CONSTANT = 1,
+	//! Run-length encoding: the value of every run is stored together with the (exclusive) end position of the run
+	RLE = 2,
+	//! Frame-of-reference + bit-packing: the values are stored as the bit-packed difference with the minimum value
+	BITPACKING = 3
+};
+
+//! The SegmentCompressor collects the values of a fixed-size column for a single persistent segment while a checkpoint
+//! is written. It keeps track of the size the collected values would have in every compression format, so the
+//! cheapest one can be chosen when the segment is written.
+class SegmentCompressor {
+public:
+	//! The maximum amount of uncompressed data that is collected for a single segment
+	static constexpr index_t MAXIMUM_UNCOMPRESSED_SIZE = 16 * BLOCK_SIZE;
+
+	SegmentCompressor(TypeId type);
+
+	//! The type of the column
+	TypeId type;
+	//! The size of the type
+	index_t type_size;
+	//! The amount of values collected
+	index_t count;
+
+public:
+	//! Add the values of the vector to the segment. Returns false (without adding any values) if the compressed segment
+	//! would become larger than max_size.
+	bool Append(Vector &data, index_t max_size);
+	//! Returns the compression with the smallest size for the values collected so far
+	CompressionType GetCompression();
+	//! Returns the size of the collected values in the given compression format
+	index_t GetCompressedSize(CompressionType compression);
+	//! Write the collected values to the target in the given compression format
+	void Compress(CompressionType compression, data_ptr_t target);
+	//! Reset the compressor for the next segment
+	void Reset();
+
+	//! Decompress count values of a segment starting at the given offset, and append them to the result vector. If a
+	//! selection vector is given, only the sel_count selected values (relative to the offset) are appended.
+	static void Decompress(CompressionType compression, data_ptr_t segment_data, index_t offset, index_t count,
+	                       sel_t *sel_vector, Vector &result, bool has_null);
+
+public:
+	//! The statistics of the collected values that determine the compressed sizes
+	struct CompressionState {
+		//! The amount of values
+		index_t count = 0;
+		//! The amount of runs of identical values
+		index_t run_count = 0;
+		//! The last value
+		data_t last_value[8];
+		//! Whether or not there are NULL values
+		bool has_null = false;
+		//! Whether or not there are non-NULL values
+		bool has_value = false;
+		//! The minimum and maximum non-NULL value (only for integral types)
+		int64_t min = 0;
+		int64_t max = 0;
+	};
+
+private:
+	//! The statistics of the values collected so far
+	CompressionState state;
+	//! The collected values in uncompressed form
+	unique_ptr<data_t[]> data;
+	//! The capacity of the data buffer in values
+	index_t capacity;
+
+	//! Returns the size of the data in the given compression format for the given statistics, or INVALID_INDEX if
+	//! the compression cannot be used
+	index_t GetCompressedSize(CompressionState &state, CompressionType compression);
+	//! Returns the compression with the smallest size for the given statistics, and its size
+	CompressionType GetCompression(CompressionState &state, index_t &size);
+	//! Returns the bit width and NULL code of the bit-packed values
+	void GetBitpackingWidth(CompressionState &state, index_t &width, uint64_t &null_code);
+};
+
+} // namespace duckdb
@@ -11,6 +11,8 @@
 #include "storage/table/column_segment.hpp"
 #include "storage/block.hpp"
 #include "storage/block_manager.hpp"
+#include "storage/buffer_manager.hpp"
+#include "storage/table/compression.hpp"
 
 #include "common/unordered_map.hpp"
 
@@ -18,39 +20,55 @@ namespace duckdb {
 
 class PersistentSegment : public ColumnSegment {
 public:
-	PersistentSegment(BlockManager &manager, block_id_t id, index_t offset, TypeId type, index_t start, index_t count);
+	//! The maximum amount of entries of a string dictionary that is decoded and kept in memory. Scans of segments with
+	//! a decoded dictionary share the decoded strings instead of copying every string, and filters on them are
+	//! evaluated once per dictionary entry.
+	static constexpr index_t MAXIMUM_DECODED_DICTIONARY_SIZE = STANDARD_VECTOR_SIZE;
 
-	//! The block manager
-	BlockManager &manager;
+	PersistentSegment(BufferManager &manager, block_id_t id, index_t offset, TypeId type, index_t start, index_t count,
+	                  CompressionType compression = CompressionType::UNCOMPRESSED);
+
+	//! The buffer manager used to pin the block of the segment
+	BufferManager &manager;
 	//! The block id that this segment relates to
 	block_id_t block_id;
 	//! The offset into the block
 	index_t offset;
-	//! The block that holds the data for this segment (if loaded)
-	unique_ptr<Block> block;
-	//! The lock to load the block into memory (if not loaded yet)
-	std::mutex load_lock;
+	//! The compression of the data of the segment (only used for fixed-size types)
+	CompressionType compression;
 
 public:
-	void LoadBlock();
-
 	void Scan(ColumnPointer &pointer, Vector &result, index_t count) override;
 	void Scan(ColumnPointer &pointer, Vector &result, index_t count, sel_t *sel_vector, index_t sel_count) override;
 	void Fetch(Vector &result, index_t row_id) override;
+	bool Filter(ColumnPointer &pointer, const TableFilter &filter, sel_t sel_vector[], index_t &sel_count) override;
+	void Prefetch() override;
 
 private:
-	//! Pointer to the dictionary, only used for string blocks
-	data_ptr_t dictionary;
-	//! Heap used for big strings
+	//! The lock used to read big strings and to decode the dictionary
+	std::mutex heap_lock;
+	//! Heap used for big strings and the decoded dictionary
 	StringHeap heap;
 	//! Big string map
 	unordered_map<block_id_t, const char *> big_strings;
+	//! Whether or not the dictionary of the (VARCHAR) segment has been loaded
+	bool dictionary_loaded = false;
+	//! The decoded strings of the dictionary by code, empty if the dictionary is too large to be decoded
+	vector<const char *> dictionary;
 
-	void AppendFromStorage(Vector &source, Vector &target, bool has_null);
+	//! Returns a pointer to the data of the segment inside the pinned block
+	data_ptr_t GetData(BufferHandle &handle);
+	//! Returns a pointer to the string dictionary of a VARCHAR segment inside the pinned block
+	data_ptr_t GetDictionary(BufferHandle &handle);
+	//! Decodes the dictionary if it is small enough. Returns true if the decoded dictionary is available.
+	bool LoadDictionary(BufferHandle &handle);
+	void AppendFromStorage(BufferHandle &handle, Vector &source, Vector &target, bool has_null);
 
-	template <bool HAS_NULL> void AppendStrings(Vector &source, Vector &target);
+	template <bool HAS_NULL> void AppendStrings(BufferHandle &handle, Vector &source, Vector &target);
 
 	const char *GetBigString(block_id_t block);
+	//! Reads a big string from disk, requires the heap lock to be held
+	const char *ReadBigString(block_id_t block);
 };
 
 } // namespace duckdb
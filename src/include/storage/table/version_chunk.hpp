@@ -14,6 +14,7 @@
 #include "storage/table/segment_tree.hpp"
 #include "storage/table/column_segment.hpp"
 #include "storage/table/version_chunk_info.hpp"
+#include "planner/table_filter.hpp"
 
 namespace duckdb {
 class ColumnDefinition;
@@ -30,17 +31,20 @@ class VersionChunk : public SegmentBase {
 
 public:
 	VersionChunk(VersionChunkType type, DataTable &table, index_t start);
+	~VersionChunk();
 
 	//! The type of version chunk
 	VersionChunkType type;
 	//! The table
 	DataTable &table;
-	//! The version chunk pointers for this version chunk
-	// FIXME: replace shared_ptr here with unique_ptr and deletion in transactionmanager
-	std::shared_ptr<VersionChunkInfo> version_data[STORAGE_CHUNK_VECTORS];
+	//! The version chunk pointers for this version chunk. They are owned by the version chunk, except when a scan
+	//! removes a version chunk pointer: its deletion is then deferred by the transaction manager until no scan can
+	//! be using it anymore.
+	std::atomic<VersionChunkInfo *> version_data[STORAGE_CHUNK_VECTORS];
 	//! Pointers to the column segments
 	unique_ptr<ColumnPointer[]> columns;
-	//! The lock for the storage
+	//! The lock for the storage. Modifications of the chunk hold it exclusively, scans read the chunk optimistically
+	//! without obtaining it.
 	StorageLock lock;
 	//! The string heap of the storage chunk
 	StringHeap string_heap;
@@ -59,10 +63,11 @@ public:
 	void PushTuple(Transaction &transaction, UndoFlags flag, index_t offset);
 	//! Retrieve the tuple data for a specific row identifier. Requires shared lock of the chunk to be held.
 	void RetrieveTupleData(Transaction &transaction, DataChunk &result, vector<column_t> &column_ids, index_t offset);
-	//! Scan a DataChunk from the version chunk. Returns true if the scanned version_index is the last segment of the
-	//! chunk.
+	//! Scan a DataChunk from the version chunk, only returning the tuples that satisfy the table filters. Returns true
+	//! if the scanned version_index is the last segment of the chunk. The chunk is not locked: if it is modified
+	//! while it is being scanned, the scan is repeated.
 	bool Scan(TableScanState &state, Transaction &transaction, DataChunk &result, const vector<column_t> &column_ids,
-	          index_t version_index);
+	          index_t version_index, const vector<TableFilter> &table_filters);
 
 	//! Scan used for creating an index, scans ALL tuples in the table (including all versions of a tuple). Returns true
 	//! if the chunk is exhausted
@@ -78,6 +83,12 @@ private:
 	void RetrieveTupleFromBaseTable(DataChunk &result, vector<column_t> &column_ids, row_t row_id);
 
 	VersionChunkInfo *GetOrCreateVersionInfo(index_t version_index);
+	//! Scans a vector of the chunk, see Scan. Sets clean to true if the version info of the vector can be removed.
+	bool ScanVector(TableScanState &state, Transaction &transaction, DataChunk &result,
+	                const vector<column_t> &column_ids, index_t version_index, const vector<TableFilter> &table_filters,
+	                bool &clean);
+	//! Removes the version info of a vector if it does not contain any deleted tuples or tuple versions anymore
+	void RemoveVersionInfo(index_t version_index);
 	//! Fetch "count" entries from the specified column pointer, and place them in the result vector. The column pointer
 	//! is advanced by "count" entries.
 	void RetrieveColumnData(ColumnPointer &pointer, Vector &result, index_t count);
@@ -86,6 +97,18 @@ private:
 	void RetrieveColumnData(ColumnPointer &pointer, Vector &result, index_t count, sel_t *sel_vector,
 	                        index_t sel_count);
 
+	//! Evaluates the table filters on the "count" entries in "sel_vector" of a "scan_count" size chunk, without
+	//! advancing the scan. The selection vector is reduced to the entries that pass all filters, and the amount of
+	//! remaining entries is returned.
+	index_t FilterColumnData(TableScanState &state, const vector<column_t> &column_ids,
+	                         const vector<TableFilter> &table_filters, index_t scan_count, sel_t sel_vector[],
+	                         index_t count);
+	//! Evaluates the table filters on a set of tuple versions, and only keeps the versions that pass all filters.
+	//! Returns the amount of remaining versions.
+	index_t FilterVersionedData(const vector<column_t> &column_ids, const vector<TableFilter> &table_filters,
+	                            data_ptr_t alternate_version_pointers[], index_t alternate_version_index[],
+	                            index_t alternate_version_count);
+
 	void FetchColumnData(TableScanState &state, DataChunk &result, const vector<column_t> &column_ids,
 	                     index_t offset_in_chunk, index_t count);
 	void FetchColumnData(TableScanState &state, DataChunk &result, const vector<column_t> &column_ids,
@@ -14,6 +14,8 @@
 #include "storage/table/segment_tree.hpp"
 #include "storage/table/column_segment.hpp"
 
+#include <atomic>
+
 namespace duckdb {
 
 class VersionChunk;
@@ -25,8 +27,9 @@ public:
 
 	//! Whether or not the tuples are deleted
 	bool deleted[STANDARD_VECTOR_SIZE] = {0};
-	//! The version pointers
-	VersionInfo *version_pointers[STANDARD_VECTOR_SIZE] = {nullptr};
+	//! The version pointers. Scans read them without locking the chunk, hence a version is only linked in after it has
+	//! been filled in.
+	std::atomic<VersionInfo *> version_pointers[STANDARD_VECTOR_SIZE];
 	//! The chunk this info belongs to
 	VersionChunk &chunk;
 	//! The start index
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// storage/temporary_file.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+#include "common/types/data_chunk.hpp"
+
+#include <mutex>
+
+namespace duckdb {
+class BufferedFileReader;
+class BufferedFileWriter;
+class FileSystem;
+
+//! The TemporaryDirectory is the directory in which operators can spill intermediate results to disk. The directory
+//! is only created when the first temporary file is created, and is removed again when the database is closed.
+class TemporaryDirectory {
+public:
+	TemporaryDirectory(FileSystem &fs, string path);
+	~TemporaryDirectory();
+
+	//! The file system used to write the temporary files
+	FileSystem &fs;
+	//! The path of the directory
+	string path;
+
+public:
+	//! Returns a new, unique path for a temporary file inside the directory, creating the directory if required
+	string CreateFilePath();
+
+private:
+	std::mutex lock;
+	//! Whether or not the directory was created by us
+	bool created_directory;
+	//! The index of the next temporary file
+	index_t file_index;
+};
+
+//! A TemporaryFile holds a sequence of DataChunks that are spilled to disk. Chunks are first appended to the file,
+//! after which the file can be read back sequentially. The file is removed when the TemporaryFile is destroyed.
+class TemporaryFile {
+public:
+	TemporaryFile(TemporaryDirectory &directory);
+	~TemporaryFile();
+
+	//! The amount of tuples written to the file
+	index_t count;
+
+public:
+	//! Append a chunk to the file. Cannot be called anymore after the file has been scanned.
+	void Append(DataChunk &chunk);
+	//! Read the next chunk from the file into the result chunk. Returns false if the file is exhausted.
+	bool Scan(DataChunk &result);
+	//! Restart scanning the file from the first chunk
+	void Rewind();
+
+private:
+	FileSystem &fs;
+	//! The path of the file
+	string path;
+	unique_ptr<BufferedFileWriter> writer;
+	unique_ptr<BufferedFileReader> reader;
+	//! The amount of chunks written to and read from the file
+	index_t chunks_written;
+	index_t chunks_read;
+};
+
+} // namespace duckdb
@@ -14,6 +14,10 @@
 #include "common/serializer/buffered_file_writer.hpp"
 #include "catalog/catalog_entry/sequence_catalog_entry.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 namespace duckdb {
 
 class BufferedSerializer;
@@ -43,6 +47,10 @@ public:
 
 	//! Initialize the WAL in the specified directory
 	void Initialize(string &path);
+	//! Returns the current size of the WAL in bytes
+	int64_t GetWALSize();
+	//! Truncate the WAL after its contents have been written to the database file by a checkpoint
+	void Truncate();
 
 	void WriteCreateTable(TableCatalogEntry *entry);
 	void WriteDropTable(TableCatalogEntry *entry);
@@ -66,11 +74,33 @@ public:
 
 	void WriteQuery(string &query);
 
+	//! Write the records of a committing transaction to the WAL file. The records are not durable until Sync is called.
 	void Flush();
+	//! Wait until everything that has been flushed to the WAL so far is synced to disk. The WAL is synced once for all
+	//! transactions that are waiting at the same time (group commit). Throws if the records could not be synced.
+	void Sync();
 
 private:
 	DuckDB &database;
 	unique_ptr<BufferedFileWriter> writer;
+	//! The path of the WAL file
+	string wal_path;
+
+	//! The lock used to coordinate the syncs of concurrently committing transactions
+	std::mutex sync_lock;
+	//! Signals the transactions waiting for the WAL to be synced
+	std::condition_variable sync_cv;
+	//! Whether or not a transaction is currently syncing the WAL
+	bool sync_in_progress;
+	//! Whether or not a sync of the WAL failed. Later syncs fail as well, as the file system might have dropped the
+	//! records that the failed sync should have made durable.
+	bool sync_failed;
+	//! The amount of transactions waiting for the WAL to be synced
+	index_t waiting_commits;
+	//! The size of the WAL file that has been written to
+	std::atomic<index_t> flushed_size;
+	//! The size of the WAL file that has been synced to disk
+	index_t synced_size;
 };
 
 } // namespace duckdb
@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// transaction/checkpoint_lock.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/common.hpp"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace duckdb {
+class CheckpointLock;
+
+enum class CheckpointLockType { SHARED = 0, EXCLUSIVE = 1 };
+
+class CheckpointLockKey {
+public:
+	CheckpointLockKey(CheckpointLock &lock, CheckpointLockType type);
+	~CheckpointLockKey();
+
+private:
+	CheckpointLock &lock;
+	CheckpointLockType type;
+};
+
+//! The CheckpointLock is a shared lock that is held exclusively while a checkpoint is written. Both a checkpoint and
+//! the commit of a transaction can take a long time (they write to disk), so waiting threads are blocked on a condition
+//! variable instead of spinning. A checkpoint that waits for the lock blocks new shared lock holders, so it cannot be
+//! starved by a stream of commits.
+class CheckpointLock {
+	friend class CheckpointLockKey;
+
+public:
+	CheckpointLock();
+
+	//! Get an exclusive lock, waits until all shared locks are released
+	unique_ptr<CheckpointLockKey> GetExclusiveLock();
+	//! Get a shared lock, waits while an exclusive lock is held or requested
+	unique_ptr<CheckpointLockKey> GetSharedLock();
+
+private:
+	std::mutex lock;
+	std::condition_variable cv;
+	//! Whether an exclusive lock is held or requested
+	bool exclusive;
+	//! The amount of shared locks that are held
+	index_t shared_count;
+
+private:
+	//! Release an exclusive lock
+	void ReleaseExclusiveLock();
+	//! Release a shared lock
+	void ReleaseSharedLock();
+};
+
+} // namespace duckdb
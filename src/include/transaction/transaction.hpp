@@ -32,7 +32,7 @@ class Transaction {
 public:
 	Transaction(transaction_t start_time, transaction_t transaction_id, timestamp_t start_timestamp)
 	    : start_time(start_time), transaction_id(transaction_id), commit_id(0), highest_active_query(0),
-	      active_query(MAXIMUM_QUERY_ID), start_timestamp(start_timestamp) {
+	      active_query(MAXIMUM_QUERY_ID), start_timestamp(start_timestamp), writes_rows(false) {
 	}
 
 	//! The start timestamp of this transaction
@@ -43,11 +43,14 @@ public:
 	transaction_t commit_id;
 	//! Highest active query when the transaction finished, used for cleaning up
 	transaction_t highest_active_query;
-	//! The current active query for the transaction. Set to MAXIMUM_QUERY_ID if
-	//! no query is active.
+	//! The current active query for the transaction. Version information that is removed while the query is active is
+	//! not freed until it finishes. A transaction starts out with a query number that it keeps until its first query
+	//! finishes, after that it is set to MAXIMUM_QUERY_ID if no query is active.
 	transaction_t active_query;
 	//! The timestamp when the transaction started
 	timestamp_t start_timestamp;
+	//! Whether or not the transaction appends or updates rows, see TransactionManager::RegisterRowWrites
+	bool writes_rows;
 	//! Map of all sequences that were used during the transaction and the value they had in this transaction
 	unordered_map<SequenceCatalogEntry *, SequenceValue> sequence_usage;
 
@@ -60,6 +63,10 @@ public:
 	//! Push a query into the undo buffer
 	void PushQuery(string query);
 
+	//! Returns true if the transaction made any changes that have to be written to the WAL when it commits
+	bool ChangesMade() {
+		return undo_buffer.ChangesMade() || sequence_usage.size() > 0;
+	}
 	//! Commit the current transaction with the given commit identifier
 	void Commit(WriteAheadLog *log, transaction_t commit_id);
 	//! Rollback
@@ -10,6 +10,8 @@
 
 #include "catalog/catalog_set.hpp"
 #include "common/common.hpp"
+#include "transaction/checkpoint_lock.hpp"
+#include "storage/table/version_chunk_info.hpp"
 
 #include <atomic>
 #include <memory>
@@ -28,6 +30,13 @@ struct StoredCatalogSet {
 	transaction_t highest_active_query;
 };
 
+struct StoredVersionChunkInfo {
+	//! Version info that was removed from its version chunk
+	unique_ptr<VersionChunkInfo> info;
+	//! The current query number when the version info was stored; used for cleaning up
+	transaction_t highest_active_query;
+};
+
 //! The Transaction Manager is responsible for creating and managing
 //! transactions
 class TransactionManager {
@@ -41,21 +50,47 @@ public:
 	void RollbackTransaction(Transaction *transaction);
 	//! Add the catalog set
 	void AddCatalogSet(ClientContext &context, unique_ptr<CatalogSet> catalog_set);
+	//! Add version info that was removed from a version chunk, it is deleted once no active query of a transaction can
+	//! be scanning it. Transactions that scan without running a query keep the query number they started with.
+	void AddVersionChunkInfo(unique_ptr<VersionChunkInfo> info);
+
+	//! Register that the transaction appends or updates rows of a table. Row ids are stable across checkpoints, but the
+	//! rows appended or updated in-place by a transaction that has not committed yet would get different row ids when
+	//! its changes are replayed from the WAL on top of a checkpoint. No checkpoint is written while such a transaction
+	//! is active.
+	void RegisterRowWrites(Transaction &transaction);
+	//! Returns true if any active transaction appends or updates rows
+	bool HasRowWrites();
 
 	transaction_t GetQueryNumber() {
 		return current_query_number++;
 	}
 
+	//! The lock that is held exclusively while a checkpoint is written. Transactions that made changes hold it shared
+	//! while they commit, so they wait for the checkpoint to finish. Other transactions are not affected by it.
+	CheckpointLock checkpoint_lock;
+
 private:
 	//! Remove the given transaction from the list of active transactions
 	void RemoveTransaction(Transaction *transaction);
+	//! Advance the start timestamp of new transactions past all commits that are durable
+	void PublishCommits();
 
 	//! The current query number
 	std::atomic<transaction_t> current_query_number;
-	//! The current start timestamp used by transactions
-	transaction_t current_start_timestamp;
+	//! The start timestamp of new transactions. It is only advanced after a commit has finished and its WAL records
+	//! were synced, so the commit id of a commit in progress is never smaller than the start timestamp of any
+	//! transaction, and transactions never see changes that can be lost in a crash.
+	std::atomic<transaction_t> current_start_timestamp;
+	//! The commit id of the next commit
+	transaction_t current_commit_id;
+	//! The commit ids of the commits whose WAL records have not been synced yet, in ascending order
+	vector<transaction_t> unsynced_commits;
+	//! Set when the WAL records of a commit could not be synced. Changes can then no longer be made durable, so no
+	//! transaction can be started and no changes can be committed anymore.
+	std::atomic<bool> invalidated;
 	//! The current transaction ID used by transactions
-	transaction_t current_transaction_id;
+	std::atomic<transaction_t> current_transaction_id;
 	//! Set of currently running transactions
 	vector<unique_ptr<Transaction>> active_transactions;
 	//! Set of recently committed transactions
@@ -64,8 +99,13 @@ private:
 	vector<unique_ptr<Transaction>> old_transactions;
 	//! Catalog sets
 	vector<StoredCatalogSet> old_catalog_sets;
-	//! The lock used for transaction operations
+	//! Version info awaiting GC
+	vector<StoredVersionChunkInfo> old_version_info;
+	//! The lock used for commits and rollbacks
 	std::mutex transaction_lock;
+	//! The lock used for the set of active transactions and the version info awaiting GC. It is only held briefly, so
+	//! starting a transaction does not wait for a commit in progress.
+	std::mutex active_lock;
 	//! The storage manager
 	StorageManager &storage;
 };
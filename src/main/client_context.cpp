@@ -213,6 +213,7 @@ static string CanExecuteStatementInReadOnlyMode(SQLStatement &stmt) {
 	case StatementType::DROP:
 	case StatementType::ALTER:
 	case StatementType::TRANSACTION:
+	case StatementType::CHECKPOINT:
 		return StringUtil::Format("Cannot execute statement of type \"%s\" in read-only mode!",
 		                          StatementTypeToString(stmt.type).c_str());
 	case StatementType::PREPARE: {
@@ -319,7 +320,11 @@ unique_ptr<QueryResult> ClientContext::ExecuteStatementsInternal(string query,
 		bool is_last_statement = i + 1 == statements.size();
 		// check if we are on AutoCommit. In this case we should start a transaction.
 		if (transaction.IsAutoCommit()) {
-			transaction.BeginTransaction();
+			try {
+				transaction.BeginTransaction();
+			} catch (std::exception &ex) {
+				return make_unique<MaterializedQueryResult>(ex.what());
+			}
 		}
 		ActiveTransaction().active_query = db.transaction_manager->GetQueryNumber();
 		if (statement->type == StatementType::SELECT && query_verification_enabled) {
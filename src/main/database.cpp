@@ -3,7 +3,9 @@
 #include "catalog/catalog.hpp"
 #include "common/file_system.hpp"
 #include "main/connection_manager.hpp"
+#include "parallel/task_scheduler.hpp"
 #include "storage/storage_manager.hpp"
+#include "storage/temporary_file.hpp"
 #include "transaction/transaction_manager.hpp"
 
 using namespace duckdb;
@@ -13,19 +15,22 @@ DBConfig::~DBConfig() {
 }
 
 DuckDB::DuckDB(const char *path, DBConfig *config) {
+	string database_path = path ? string(path) : string();
 	if (config) {
 		// user-supplied configuration
-		Configure(*config);
+		Configure(*config, database_path);
 	} else {
 		// default configuration
 		DBConfig config;
-		Configure(config);
+		Configure(config, database_path);
 	}
 
-	storage = make_unique<StorageManager>(*this, path ? string(path) : string(), access_mode == AccessMode::READ_ONLY);
+	storage = make_unique<StorageManager>(*this, database_path, access_mode == AccessMode::READ_ONLY);
 	catalog = make_unique<Catalog>(*storage);
 	transaction_manager = make_unique<TransactionManager>(*storage);
 	connection_manager = make_unique<ConnectionManager>();
+	scheduler = make_unique<TaskScheduler>();
+	scheduler->SetThreads(maximum_threads);
 	// initialize the database
 	storage->Initialize();
 }
@@ -36,7 +41,7 @@ DuckDB::DuckDB(const string &path, DBConfig *config) : DuckDB(path.c_str(), conf
 DuckDB::~DuckDB() {
 }
 
-void DuckDB::Configure(DBConfig &config) {
+void DuckDB::Configure(DBConfig &config, const string &path) {
 	if (config.access_mode != AccessMode::UNDEFINED) {
 		access_mode = config.access_mode;
 	} else {
@@ -47,7 +52,18 @@ void DuckDB::Configure(DBConfig &config) {
 	} else {
 		file_system = make_unique<FileSystem>();
 	}
-	checkpoint_only = config.checkpoint_only;
 	checkpoint_wal_size = config.checkpoint_wal_size;
+	commit_delay = config.commit_delay;
+	commit_batch_size = config.commit_batch_size;
 	use_direct_io = config.use_direct_io;
+	use_mmap = config.use_mmap;
+	maximum_threads = config.maximum_threads;
+	maximum_memory = config.maximum_memory;
+	prefetch_depth = config.prefetch_depth;
+	string temporary_path = config.temporary_directory;
+	if (temporary_path.empty()) {
+		bool in_memory = path.empty() || path == ":memory:";
+		temporary_path = in_memory ? ".tmp" : path + ".tmp";
+	}
+	temporary_directory = make_unique<TemporaryDirectory>(*file_system, temporary_path);
 }
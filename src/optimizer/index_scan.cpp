@@ -45,6 +45,27 @@ static void RewriteIndexExpression(Index &index, LogicalGet &get, Expression &ex
 	    expr, [&](Expression &child) { RewriteIndexExpression(index, get, child, rewrite_possible); });
 }
 
+//! Find a filter expression that compares the index expression for equality with a constant, and return the constant
+static bool FindEqualityComparison(LogicalFilter &filter, Expression &index_expression, Value &result) {
+	for (auto &expr : filter.expressions) {
+		// match on an equality comparison of the index expression with a constant
+		ComparisonExpressionMatcher matcher;
+		matcher.expr_type = make_unique<SpecificExpressionTypeMatcher>(ExpressionType::COMPARE_EQUAL);
+		matcher.matchers.push_back(make_unique<ExpressionEqualityMatcher>(&index_expression));
+		matcher.matchers.push_back(make_unique<ConstantExpressionMatcher>());
+		matcher.policy = SetMatcher::Policy::UNORDERED;
+
+		vector<Expression *> bindings;
+		if (matcher.Match(expr.get(), bindings)) {
+			// bindings[2] = the constant
+			assert(bindings[2]->type == ExpressionType::VALUE_CONSTANT);
+			result = ((BoundConstantExpression *)bindings[2])->value;
+			return true;
+		}
+	}
+	return false;
+}
+
 unique_ptr<LogicalOperator> IndexScan::TransformFilterToIndexScan(unique_ptr<LogicalOperator> op) {
 	assert(op->type == LogicalOperatorType::FILTER);
 	auto &filter = (LogicalFilter &)*op;
@@ -65,16 +86,41 @@ unique_ptr<LogicalOperator> IndexScan::TransformFilterToIndexScan(unique_ptr<Log
 	for (size_t j = 0; j < storage.indexes.size(); j++) {
 		auto &index = storage.indexes[j];
 
-		assert(index->unbound_expressions.size() == 1);
-		// first rewrite the index expression so the ColumnBindings align with the column bindings of the current table
-		auto index_expression = index->unbound_expressions[0]->Copy();
+		// first rewrite the index expressions so the ColumnBindings align with the column bindings of the current table
+		vector<unique_ptr<Expression>> index_expressions;
 		bool rewrite_possible = true;
-		RewriteIndexExpression(*index, *get, *index_expression, rewrite_possible);
+		for (auto &unbound_expression : index->unbound_expressions) {
+			auto index_expression = unbound_expression->Copy();
+			RewriteIndexExpression(*index, *get, *index_expression, rewrite_possible);
+			index_expressions.push_back(move(index_expression));
+		}
 		if (!rewrite_possible) {
 			// could not rewrite!
 			continue;
 		}
 
+		if (index_expressions.size() > 1) {
+			// an index on multiple expressions can only be used if every expression is compared for equality
+			vector<Value> equal_values;
+			for (auto &index_expression : index_expressions) {
+				Value equal_value;
+				if (!FindEqualityComparison(filter, *index_expression, equal_value)) {
+					break;
+				}
+				equal_values.push_back(equal_value);
+			}
+			if (equal_values.size() == index_expressions.size()) {
+				auto logical_index_scan = make_unique<LogicalIndexScan>(*get->table, *get->table->storage, *index,
+				                                                        get->column_ids, get->table_index);
+				logical_index_scan->equal_values = move(equal_values);
+				logical_index_scan->equal_index = true;
+				op->children[0] = move(logical_index_scan);
+				break;
+			}
+			continue;
+		}
+		auto &index_expression = index_expressions[0];
+
 		Value low_value, high_value, equal_value;
 		// try to find a matching index for any of the filter expressions
 		auto expr = filter.expressions[0].get();
@@ -130,7 +176,7 @@ unique_ptr<LogicalOperator> IndexScan::TransformFilterToIndexScan(unique_ptr<Log
 			auto logical_index_scan = make_unique<LogicalIndexScan>(*get->table, *get->table->storage, *index,
 			                                                        get->column_ids, get->table_index);
 			if (!equal_value.is_null) {
-				logical_index_scan->equal_value = equal_value;
+				logical_index_scan->equal_values.push_back(equal_value);
 				logical_index_scan->equal_index = true;
 			}
 			if (!low_value.is_null) {
@@ -0,0 +1,135 @@
+#include "parallel/pipeline_executor.hpp"
+
+#include "execution/operator/join/physical_hash_join.hpp"
+#include "execution/operator/scan/physical_table_scan.hpp"
+#include "main/client_context.hpp"
+#include "main/database.hpp"
+#include "parallel/task_scheduler.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+//! Returns the base table scan of a pipeline, or nullptr if the pipeline cannot be executed in parallel
+static PhysicalTableScan *GetPipelineSource(PhysicalOperator *op) {
+	while (true) {
+		switch (op->type) {
+		case PhysicalOperatorType::FILTER:
+		case PhysicalOperatorType::PROJECTION:
+			if (op->children.size() != 1) {
+				return nullptr;
+			}
+			op = op->children[0].get();
+			break;
+		case PhysicalOperatorType::HASH_JOIN:
+			// after the hash table is built, the probe side streams through the join
+			if (!((PhysicalHashJoin *)op)->ParallelProbe()) {
+				return nullptr;
+			}
+			op = op->children[0].get();
+			break;
+		case PhysicalOperatorType::SEQ_SCAN: {
+			auto scan = (PhysicalTableScan *)op;
+			return scan->column_ids.size() > 0 ? scan : nullptr;
+		}
+		default:
+			return nullptr;
+		}
+	}
+}
+
+//! Returns the state of the base table scan within the state tree of a pipeline
+static PhysicalTableScanOperatorState *GetPipelineSourceState(PhysicalOperatorState *state) {
+	while (state->child_state) {
+		state = state->child_state.get();
+	}
+	return (PhysicalTableScanOperatorState *)state;
+}
+
+index_t PipelineExecutor::ParallelThreadCount(ClientContext &context, PhysicalOperator &op) {
+	if (context.profiler.IsEnabled()) {
+		// the profiler cannot be used from multiple threads
+		return 1;
+	}
+	auto thread_count = context.db.scheduler->NumberOfThreads();
+	if (thread_count <= 1) {
+		return 1;
+	}
+	auto source = GetPipelineSource(&op);
+	if (!source) {
+		return 1;
+	}
+	return std::min(thread_count, source->table.MorselCount());
+}
+
+void PipelineExecutor::Execute(ClientContext &context, PhysicalOperator &op, PhysicalOperatorState *state,
+                               index_t thread_count, pipeline_sink_t sink) {
+	auto source = GetPipelineSource(&op);
+	assert(source);
+
+	// build the hash tables of the joins in the pipeline before the threads start probing them
+	bool parallel_probe = true;
+	auto current_state = state;
+	for (auto current = &op; current != source; current = current->children[0].get()) {
+		if (current->type == PhysicalOperatorType::HASH_JOIN) {
+			((PhysicalHashJoin *)current)->BuildHashTable(context, current_state);
+			if (((PhysicalHashJoinOperatorState *)current_state)->build->spilled) {
+				parallel_probe = false;
+			}
+		}
+		current_state = current_state->child_state.get();
+	}
+	if (!parallel_probe) {
+		// a join spilled its build side: its probe side is partitioned as a whole, so the pipeline runs in this thread
+		DataChunk chunk;
+		op.InitializeChunk(chunk);
+		while (true) {
+			op.GetChunk(context, chunk, state);
+			if (chunk.size() == 0) {
+				break;
+			}
+			sink(0, chunk);
+		}
+		return;
+	}
+
+	ParallelTableScanState parallel_state;
+	source->table.InitializeParallelScan(parallel_state);
+
+	// create the operator states up front, so the tasks do not touch the operator tree concurrently
+	vector<unique_ptr<PhysicalOperatorState>> states;
+	for (index_t i = 0; i < thread_count; i++) {
+		auto thread_state = op.GetOperatorState();
+		// the threads probe the hash tables that were built for the pipeline
+		auto current_state = state;
+		auto current_thread_state = thread_state.get();
+		for (auto current = &op; current != source; current = current->children[0].get()) {
+			if (current->type == PhysicalOperatorType::HASH_JOIN) {
+				((PhysicalHashJoinOperatorState *)current_thread_state)->build =
+				    ((PhysicalHashJoinOperatorState *)current_state)->build;
+			}
+			current_state = current_state->child_state.get();
+			current_thread_state = current_thread_state->child_state.get();
+		}
+		auto source_state = GetPipelineSourceState(thread_state.get());
+		source_state->parallel_state = &parallel_state;
+		source_state->scan_offset.chunk = nullptr;
+		states.push_back(move(thread_state));
+	}
+
+	vector<task_function_t> tasks;
+	for (index_t i = 0; i < thread_count; i++) {
+		auto state = states[i].get();
+		tasks.push_back([&context, &op, &sink, state, i]() {
+			DataChunk chunk;
+			op.InitializeChunk(chunk);
+			while (true) {
+				op.GetChunk(context, chunk, state);
+				if (chunk.size() == 0) {
+					break;
+				}
+				sink(i, chunk);
+			}
+		});
+	}
+	context.db.scheduler->ExecuteTasks(move(tasks));
+}
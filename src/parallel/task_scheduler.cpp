@@ -0,0 +1,113 @@
+#include "parallel/task_scheduler.hpp"
+
+#include "common/exception.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TaskGroup::TaskGroup(vector<task_function_t> tasks) : tasks(move(tasks)), next_task(0), finished_tasks(0) {
+}
+
+void TaskGroup::Work() {
+	while (true) {
+		index_t task_idx = next_task++;
+		if (task_idx >= tasks.size()) {
+			return;
+		}
+		exception_ptr task_error;
+		try {
+			tasks[task_idx]();
+		} catch (...) {
+			task_error = current_exception();
+		}
+		lock_guard<mutex> guard(lock);
+		if (task_error && !error) {
+			error = task_error;
+		}
+		finished_tasks++;
+		if (finished_tasks == tasks.size()) {
+			finished.notify_all();
+		}
+	}
+}
+
+TaskScheduler::TaskScheduler() : shutdown(false) {
+}
+
+TaskScheduler::~TaskScheduler() {
+	lock_guard<mutex> guard(thread_lock);
+	StopWorkers();
+}
+
+void TaskScheduler::SetThreads(index_t threads) {
+	if (threads == 0) {
+		throw Exception("Number of threads must be at least 1");
+	}
+	lock_guard<mutex> guard(thread_lock);
+	if (threads - 1 == workers.size()) {
+		return;
+	}
+	StopWorkers();
+	for (index_t i = 0; i + 1 < threads; i++) {
+		workers.push_back(thread(&TaskScheduler::WorkerThread, this));
+	}
+}
+
+index_t TaskScheduler::NumberOfThreads() {
+	lock_guard<mutex> guard(thread_lock);
+	return workers.size() + 1;
+}
+
+void TaskScheduler::StopWorkers() {
+	{
+		lock_guard<mutex> guard(queue_lock);
+		shutdown = true;
+	}
+	queue_signal.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	// any task groups left in the queue are finished by the threads that issued them
+	lock_guard<mutex> guard(queue_lock);
+	shutdown = false;
+}
+
+void TaskScheduler::ExecuteTasks(vector<task_function_t> tasks) {
+	if (tasks.size() == 0) {
+		return;
+	}
+	auto group = make_shared<TaskGroup>(move(tasks));
+	if (group->tasks.size() > 1) {
+		// let the worker threads help out with the tasks
+		lock_guard<mutex> guard(queue_lock);
+		for (index_t i = 1; i < group->tasks.size(); i++) {
+			queue.push(group);
+		}
+	}
+	queue_signal.notify_all();
+	// the calling thread participates in executing the tasks
+	group->Work();
+	// wait for the tasks that were picked up by the worker threads to finish
+	unique_lock<mutex> guard(group->lock);
+	group->finished.wait(guard, [&]() { return group->finished_tasks == group->tasks.size(); });
+	if (group->error) {
+		rethrow_exception(group->error);
+	}
+}
+
+void TaskScheduler::WorkerThread() {
+	while (true) {
+		shared_ptr<TaskGroup> group;
+		{
+			unique_lock<mutex> guard(queue_lock);
+			queue_signal.wait(guard, [&]() { return shutdown || !queue.empty(); });
+			if (shutdown) {
+				return;
+			}
+			group = move(queue.front());
+			queue.pop();
+		}
+		group->Work();
+	}
+}
@@ -1,8 +1,12 @@
 #include "parser/parser.hpp"
 
 #include "main/client_context.hpp"
+#include "main/database.hpp"
+#include "parallel/task_scheduler.hpp"
 #include "parser/transformer.hpp"
 #include "postgres_parser.hpp"
+#include "storage/buffer_manager.hpp"
+#include "storage/storage_manager.hpp"
 
 namespace postgres {
 #include "parser/parser.h"
@@ -45,6 +49,42 @@ void Parser::ParseQuery(string query) {
 
 enum class PragmaType : uint8_t { NOTHING, ASSIGNMENT, CALL };
 
+//! Parses a memory limit of the form [number][unit] (e.g. 1GB or 500 MB), or -1/none for no limit
+static index_t ParseMemoryLimit(string arg) {
+	if (arg == "-1" || arg == "none") {
+		return (index_t)-1;
+	}
+	// parse the number
+	index_t idx = 0;
+	while (idx < arg.size() && (isdigit(arg[idx]) || arg[idx] == '.')) {
+		idx++;
+	}
+	if (idx == 0) {
+		throw ParserException("Memory limit must have a number (e.g. PRAGMA memory_limit=1GB)");
+	}
+	auto limit = stod(arg.substr(0, idx));
+	// parse the unit
+	while (idx < arg.size() && isspace(arg[idx])) {
+		idx++;
+	}
+	string unit = arg.substr(idx);
+	double multiplier;
+	if (unit == "" || unit == "b" || unit == "byte" || unit == "bytes") {
+		multiplier = 1;
+	} else if (unit == "kb" || unit == "kilobyte" || unit == "kilobytes") {
+		multiplier = 1000LL;
+	} else if (unit == "mb" || unit == "megabyte" || unit == "megabytes") {
+		multiplier = 1000LL * 1000LL;
+	} else if (unit == "gb" || unit == "gigabyte" || unit == "gigabytes") {
+		multiplier = 1000LL * 1000LL * 1000LL;
+	} else if (unit == "tb" || unit == "terabyte" || unit == "terabytes") {
+		multiplier = 1000LL * 1000LL * 1000LL * 1000LL;
+	} else {
+		throw ParserException("Unknown unit for memory_limit: %s (expected: b, kb, mb, gb or tb)", unit.c_str());
+	}
+	return (index_t)(multiplier * limit);
+}
+
 bool Parser::ParsePragma(string &query) {
 	// check if there is a PRAGMA statement, this is done before calling the
 	// postgres parser
@@ -132,6 +172,32 @@ bool Parser::ParsePragma(string &query) {
 		}
 		string location = StringUtil::Replace(StringUtil::Lower(query.substr(pos + 1)), ";", "");
 		context.profiler.save_location = location;
+	} else if (keyword == "threads" || keyword == "worker_threads") {
+		// set the amount of threads used for query execution
+		if (type != PragmaType::ASSIGNMENT) {
+			throw ParserException("Threads must be an assignment");
+		}
+		string assignment = StringUtil::Replace(query.substr(pos + 1), ";", "");
+		StringUtil::Trim(assignment);
+		char *end;
+		auto threads = strtoll(assignment.c_str(), &end, 10);
+		if (assignment.empty() || *end != '\0' || threads < 1) {
+			throw ParserException("Invalid amount of threads %s, expected a positive integer", assignment.c_str());
+		}
+		context.db.scheduler->SetThreads((index_t)threads);
+	} else if (keyword == "memory_limit") {
+		// set the maximum amount of memory used for keeping blocks of the database file in memory
+		if (type != PragmaType::ASSIGNMENT) {
+			throw ParserException("Memory limit must be an assignment (e.g. PRAGMA memory_limit=1GB)");
+		}
+		string assignment = StringUtil::Replace(StringUtil::Lower(query.substr(pos + 1)), ";", "");
+		assignment = StringUtil::Replace(assignment, "'", "");
+		StringUtil::Trim(assignment);
+		auto limit = ParseMemoryLimit(assignment);
+		if (context.db.storage->buffer_manager) {
+			context.db.storage->buffer_manager->SetLimit(limit);
+		}
+		context.db.maximum_memory = limit;
 	} else {
 		throw ParserException("Unrecognized PRAGMA keyword: %s", keyword.c_str());
 	}
@@ -38,6 +38,8 @@ unique_ptr<BoundSQLStatement> Binder::Bind(SQLStatement &statement) {
 		return Bind((CreateViewStatement &)statement);
 	case StatementType::EXECUTE:
 		return Bind((ExecuteStatement &)statement);
+	case StatementType::CHECKPOINT:
+		return Bind((CheckpointStatement &)statement);
 	default:
 		assert(statement.type == StatementType::CREATE_INDEX);
 		return Bind((CreateIndexStatement &)statement);
@@ -0,0 +1,10 @@
+#include "parser/statement/checkpoint_statement.hpp"
+#include "planner/binder.hpp"
+#include "planner/statement/bound_checkpoint_statement.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+unique_ptr<BoundSQLStatement> Binder::Bind(CheckpointStatement &stmt) {
+	return make_unique<BoundCheckpointStatement>();
+}
@@ -0,0 +1,10 @@
+#include "planner/logical_plan_generator.hpp"
+#include "planner/operator/logical_checkpoint.hpp"
+#include "planner/statement/bound_checkpoint_statement.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+unique_ptr<LogicalOperator> LogicalPlanGenerator::CreatePlan(BoundCheckpointStatement &stmt) {
+	return make_unique<LogicalCheckpoint>();
+}
@@ -27,6 +27,8 @@ unique_ptr<LogicalOperator> LogicalPlanGenerator::CreatePlan(BoundSQLStatement &
 		return CreatePlan((BoundCreateTableStatement &)statement);
 	case StatementType::CREATE_INDEX:
 		return CreatePlan((BoundCreateIndexStatement &)statement);
+	case StatementType::CHECKPOINT:
+		return CreatePlan((BoundCheckpointStatement &)statement);
 	default:
 		assert(statement.type == StatementType::EXECUTE);
 		return CreatePlan((BoundExecuteStatement &)statement);
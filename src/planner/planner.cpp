@@ -50,6 +50,7 @@ void Planner::CreatePlan(unique_ptr<SQLStatement> statement) {
 	case StatementType::CREATE_INDEX:
 	case StatementType::CREATE_TABLE:
 	case StatementType::EXECUTE:
+	case StatementType::CHECKPOINT:
 		CreatePlan(*statement);
 		break;
 	case StatementType::CREATE_VIEW: {
@@ -5,3 +5,6 @@ using namespace std;
 
 Block::Block(block_id_t id) : FileBuffer(BLOCK_SIZE), id(id) {
 }
+
+Block::Block(block_id_t id, data_ptr_t data) : FileBuffer(data, BLOCK_SIZE), id(id) {
+}
@@ -0,0 +1,200 @@
+#include "storage/buffer_manager.hpp"
+
+#include "common/exception.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+namespace duckdb {
+
+struct BufferEntry {
+	BufferEntry(block_id_t id) : id(id), ref_count(0) {
+	}
+
+	//! The block id of the entry
+	block_id_t id;
+	//! The loaded block, or nullptr if it has not been loaded yet
+	unique_ptr<Block> block;
+	//! The amount of handles that currently pin this block
+	index_t ref_count;
+	//! The position of the entry in the LRU list (only valid if ref_count is 0)
+	list<BufferEntry *>::iterator lru_position;
+	//! Lock held while the block is being loaded from disk
+	mutex load_lock;
+};
+
+} // namespace duckdb
+
+BufferHandle::BufferHandle(BufferManager &manager, BufferEntry *entry, Block *block)
+    : manager(manager), block(block), entry(entry) {
+}
+
+BufferHandle::~BufferHandle() {
+	manager.Unpin(entry);
+}
+
+BufferManager::BufferManager(BlockManager &manager, index_t maximum_memory)
+    : manager(manager), current_memory(0), maximum_memory(maximum_memory), prefetch_loading(0), prefetch_done(false) {
+}
+
+BufferManager::~BufferManager() {
+	{
+		lock_guard<mutex> buffer_lock(lock);
+		prefetch_done = true;
+	}
+	prefetch_cv.notify_all();
+	if (prefetch_thread.joinable()) {
+		prefetch_thread.join();
+	}
+}
+
+unique_ptr<BufferHandle> BufferManager::Pin(block_id_t block_id) {
+	BufferEntry *entry;
+	{
+		lock_guard<mutex> buffer_lock(lock);
+		auto it = blocks.find(block_id);
+		if (it == blocks.end()) {
+			// the block is not loaded: reserve memory for it, evicting other blocks if required
+			if (!EvictBlocks(BLOCK_SIZE, maximum_memory)) {
+				throw OutOfMemoryException("Could not load block of %lld bytes: the memory limit of %lld bytes is "
+				                           "exceeded and all loaded blocks are pinned",
+				                           (long long)BLOCK_SIZE, (long long)maximum_memory);
+			}
+			current_memory += BLOCK_SIZE;
+			auto new_entry = make_unique<BufferEntry>(block_id);
+			entry = new_entry.get();
+			blocks[block_id] = move(new_entry);
+		} else {
+			entry = it->second.get();
+			if (entry->ref_count == 0) {
+				// the block was unpinned: it can no longer be evicted
+				lru.erase(entry->lru_position);
+			}
+		}
+		entry->ref_count++;
+	}
+	// load the block from disk if that has not happened yet
+	// this happens outside of the main lock so multiple blocks can be loaded concurrently
+	// if the block is being prefetched we wait for the prefetch thread to finish loading it
+	try {
+		LoadBlock(entry);
+	} catch (...) {
+		Unpin(entry);
+		throw;
+	}
+	return make_unique<BufferHandle>(*this, entry, entry->block.get());
+}
+
+void BufferManager::LoadBlock(BufferEntry *entry) {
+	lock_guard<mutex> load_lock(entry->load_lock);
+	if (!entry->block) {
+		entry->block = manager.LoadBlock(entry->id);
+	}
+}
+
+void BufferManager::Prefetch(block_id_t block_id) {
+	{
+		lock_guard<mutex> buffer_lock(lock);
+		if (prefetch_done || blocks.find(block_id) != blocks.end()) {
+			// the block is already loaded or being loaded
+			return;
+		}
+		// the blocks that are waiting to be prefetched cannot be evicted: limit them to half of the memory so pinning
+		// other blocks does not fail because of the prefetcher
+		if ((prefetch_queue.size() + 1) * BLOCK_SIZE * 2 > maximum_memory) {
+			return;
+		}
+		if (!EvictBlocks(BLOCK_SIZE, maximum_memory)) {
+			return;
+		}
+		current_memory += BLOCK_SIZE;
+		auto new_entry = make_unique<BufferEntry>(block_id);
+		// the prefetcher pins the block until it is loaded, so it cannot be evicted before it is used
+		new_entry->ref_count++;
+		prefetch_queue.push_back(new_entry.get());
+		blocks[block_id] = move(new_entry);
+		if (!prefetch_thread.joinable()) {
+			prefetch_thread = thread(&BufferManager::PrefetchBlocks, this);
+		}
+	}
+	prefetch_cv.notify_all();
+}
+
+void BufferManager::PrefetchBlocks() {
+	while (true) {
+		BufferEntry *entry;
+		{
+			unique_lock<mutex> buffer_lock(lock);
+			prefetch_cv.wait(buffer_lock, [&] { return prefetch_done || !prefetch_queue.empty(); });
+			if (prefetch_done) {
+				return;
+			}
+			entry = prefetch_queue.front();
+			prefetch_queue.pop_front();
+			prefetch_loading++;
+		}
+		try {
+			LoadBlock(entry);
+		} catch (...) {
+			// prefetching is only a hint: a failed read is retried (and reported) by the Pin of the block
+		}
+		{
+			lock_guard<mutex> buffer_lock(lock);
+			ReleaseEntry(entry);
+			prefetch_loading--;
+		}
+		prefetch_cv.notify_all();
+	}
+}
+
+void BufferManager::Unpin(BufferEntry *entry) {
+	lock_guard<mutex> buffer_lock(lock);
+	ReleaseEntry(entry);
+}
+
+void BufferManager::ReleaseEntry(BufferEntry *entry) {
+	assert(entry->ref_count > 0);
+	entry->ref_count--;
+	if (entry->ref_count > 0) {
+		return;
+	}
+	if (!entry->block) {
+		// loading the block failed: remove the entry again
+		current_memory -= BLOCK_SIZE;
+		blocks.erase(entry->id);
+		return;
+	}
+	// nobody is using the block anymore: it can be evicted if we need the memory
+	entry->lru_position = lru.insert(lru.end(), entry);
+}
+
+void BufferManager::SetLimit(index_t limit) {
+	unique_lock<mutex> buffer_lock(lock);
+	// cancel the pending prefetches and wait for the block that is being prefetched, so they do not keep memory
+	// pinned
+	while (!prefetch_queue.empty()) {
+		auto entry = prefetch_queue.front();
+		prefetch_queue.pop_front();
+		ReleaseEntry(entry);
+	}
+	prefetch_cv.wait(buffer_lock, [&] { return prefetch_loading == 0; });
+	if (!EvictBlocks(0, limit)) {
+		throw OutOfMemoryException("Failed to change memory limit to %lld: could not free up enough memory",
+		                           (long long)limit);
+	}
+	maximum_memory = limit;
+}
+
+bool BufferManager::EvictBlocks(index_t extra_memory, index_t memory_limit) {
+	while (current_memory + extra_memory > memory_limit) {
+		if (lru.empty()) {
+			return false;
+		}
+		// evict the least recently used block
+		auto entry = lru.front();
+		lru.pop_front();
+		current_memory -= BLOCK_SIZE;
+		blocks.erase(entry->id);
+	}
+	return true;
+}
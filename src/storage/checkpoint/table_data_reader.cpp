@@ -25,23 +25,58 @@ void TableDataReader::ReadTableData() {
 	assert(columns.size() > 0);
 
 	// load the data pointers for the table
+	auto &data_pointers = info.persistent_data.data_pointers;
+	data_pointers.resize(columns.size());
 	for (index_t col = 0; col < columns.size(); col++) {
 		auto &column = columns[col];
 		index_t data_pointer_count = reader.Read<index_t>();
 		for (index_t data_ptr = 0; data_ptr < data_pointer_count; data_ptr++) {
 			// read the data pointer
 			DataPointer data_pointer;
-			data_pointer.min = reader.Read<double>();
-			data_pointer.max = reader.Read<double>();
+			reader.ReadData(data_pointer.min, sizeof(data_pointer.min));
+			reader.ReadData(data_pointer.max, sizeof(data_pointer.max));
+			data_pointer.has_null = reader.Read<bool>();
 			data_pointer.row_start = reader.Read<index_t>();
 			data_pointer.tuple_count = reader.Read<index_t>();
 			data_pointer.block_id = reader.Read<block_id_t>();
 			data_pointer.offset = reader.Read<uint32_t>();
+			data_pointer.compression = (CompressionType)reader.Read<uint8_t>();
 			// create a persistent segment
-			auto segment = make_unique<PersistentSegment>(manager.block_manager, data_pointer.block_id,
-			                                              data_pointer.offset, GetInternalType(column.type),
-			                                              data_pointer.row_start, data_pointer.tuple_count);
+			auto segment = make_unique<PersistentSegment>(
+			    manager.buffer_manager, data_pointer.block_id, data_pointer.offset, GetInternalType(column.type),
+			    data_pointer.row_start, data_pointer.tuple_count, data_pointer.compression);
+			// initialize the statistics of the segment
+			memcpy(segment->stats.minimum.get(), data_pointer.min, segment->type_size);
+			memcpy(segment->stats.maximum.get(), data_pointer.max, segment->type_size);
+			segment->stats.has_null = data_pointer.has_null;
 			info.data[col].push_back(move(segment));
+			data_pointers[col].push_back(data_pointer);
 		}
 	}
+	// read the blocks used by the table
+	index_t block_count = reader.Read<index_t>();
+	for (index_t i = 0; i < block_count; i++) {
+		info.persistent_data.data_blocks.push_back(reader.Read<block_id_t>());
+	}
+	// read the location of the unique indexes of the table
+	index_t index_count = reader.Read<index_t>();
+	for (index_t i = 0; i < index_count; i++) {
+		IndexPointer pointer;
+		pointer.block_id = reader.Read<block_id_t>();
+		pointer.offset = reader.Read<uint32_t>();
+		index_t index_block_count = reader.Read<index_t>();
+		for (index_t k = 0; k < index_block_count; k++) {
+			pointer.blocks.push_back(reader.Read<block_id_t>());
+		}
+		info.indexes.push_back(move(pointer));
+	}
+	// finally read the amount of rows and the deleted rows
+	info.persistent_data.row_count = reader.Read<index_t>();
+	index_t range_count = reader.Read<index_t>();
+	for (index_t i = 0; i < range_count; i++) {
+		RowRange range;
+		range.start = reader.Read<row_t>();
+		range.count = reader.Read<index_t>();
+		info.persistent_data.deleted_rows.push_back(range);
+	}
 }
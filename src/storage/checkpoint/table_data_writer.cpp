@@ -5,6 +5,8 @@
 
 #include "catalog/catalog_entry/table_catalog_entry.hpp"
 #include "common/serializer/buffered_serializer.hpp"
+#include "common/unordered_set.hpp"
+#include "execution/index/art/art.hpp"
 
 using namespace duckdb;
 using namespace std;
@@ -17,85 +19,232 @@ TableDataWriter::TableDataWriter(CheckpointManager &manager, TableCatalogEntry &
     : manager(manager), table(table) {
 }
 
-void TableDataWriter::WriteTableData(Transaction &transaction) {
+void TableDataWriter::WriteTableData(Transaction &transaction, vector<task_function_t> &tasks) {
 	assert(blocks.size() == 0);
+	data_pointers.resize(table.columns.size());
+	// the indexes of the UNIQUE and PRIMARY KEY constraints are written together with the table
+	for (auto &index : table.storage->indexes) {
+		if (index->type == IndexType::ART && ((ART &)*index).is_unique) {
+			unique_indexes.push_back((ART *)index.get());
+		}
+	}
+	index_pointers.resize(unique_indexes.size());
+	// changes that are committed from now on are not part of this checkpoint
+	change_count = table.storage->change_count;
+	if (!table.storage->HasChanges()) {
+		// the table is unchanged: there is no need to write its data again
+		WriteExistingTableData();
+		// the same holds for indexes that are stored in the previous checkpoint
+		for (index_t i = 0; i < unique_indexes.size(); i++) {
+			auto &pointer = unique_indexes[i]->persistent_pointer;
+			if (pointer.block_id == INVALID_BLOCK) {
+				tasks.push_back([this, &transaction, i]() { WriteIndex(transaction, i); });
+				continue;
+			}
+			for (auto &block_id : pointer.blocks) {
+				manager.block_manager.MarkBlockAsUsed(block_id);
+			}
+			index_pointers[i] = pointer;
+		}
+		return;
+	}
+	// rows keep their row id in the checkpoint, so every row that was appended to the table is written. Rows that are
+	// not visible to the checkpoint are written as deleted rows.
+	TableScanState state;
+	table.storage->InitializeScan(state);
+	row_count = state.last_chunk->start + state.last_chunk_count;
+	// the columns are written independently of each other, so every column is written by a separate task
+	// the state of a column is only initialized by its task, so only the columns that are being written use memory
+	blocks.resize(table.columns.size());
+	offsets.resize(table.columns.size());
+	tuple_counts.resize(table.columns.size());
+	row_numbers.resize(table.columns.size());
+	dictionaries.resize(table.columns.size());
+	stats.resize(table.columns.size());
+	compressors.resize(table.columns.size());
+	column_blocks.resize(table.columns.size());
+	for (index_t i = 0; i < table.columns.size(); i++) {
+		tasks.push_back([this, &transaction, i]() { WriteColumn(transaction, i); });
+	}
+	for (index_t i = 0; i < unique_indexes.size(); i++) {
+		tasks.push_back([this, &transaction, i]() { WriteIndex(transaction, i); });
+	}
+}
 
-	// when writing table data we write columns to individual blocks
-	// we scan the underlying table structure and write to the blocks
-	// then flush the blocks to disk when they are full
+void TableDataWriter::WriteColumn(Transaction &transaction, index_t col) {
+	// create a block that serves as the buffer for the data of the column
+	blocks[col] = make_unique<Block>(INVALID_BLOCK);
+	offsets[col] = GetTypeHeaderSize(table.columns[col].type);
+	tuple_counts[col] = 0;
+	row_numbers[col] = 0;
+	auto internal_type = GetInternalType(table.columns[col].type);
+	stats[col] = make_unique<SegmentStatistics>(internal_type, GetTypeIdSize(internal_type));
+	if (TypeIsConstantSize(internal_type)) {
+		compressors[col] = make_unique<SegmentCompressor>(internal_type);
+	}
 
-	// initialize scan structures to prepare for the scan
+	// scan the column and write its data to the block, the block is flushed to disk when it is full
+	// the row ids are scanned as well: the rows that are not visible to the checkpoint are written as NULL values
 	TableScanState state;
 	table.storage->InitializeScan(state);
-	vector<column_t> column_ids;
-	for (auto &column : table.columns) {
-		column_ids.push_back(column.oid);
-	}
-	//! get all types of the table and initialize the chunk
-	auto types = table.GetTypes();
+	vector<column_t> column_ids = {table.columns[col].oid, COLUMN_IDENTIFIER_ROW_ID};
+	vector<TypeId> types = {internal_type, ROW_TYPE};
 	DataChunk chunk;
 	chunk.Initialize(types);
+	Vector values(internal_type, true, false);
+	auto type_size = GetTypeIdSize(internal_type);
+	index_t next_row = 0;
+	while (true) {
+		chunk.Reset();
+		table.storage->Scan(transaction, chunk, column_ids, state);
+		if (chunk.size() == 0) {
+			break;
+		}
+		chunk.Flatten();
+		auto row_ids = (row_t *)chunk.data[1].data;
+		index_t first_row = row_ids[0];
+		index_t last_row = row_ids[chunk.size() - 1];
+		assert(first_row >= next_row && last_row < row_count);
+		WriteDeletedRows(col, next_row, first_row);
+		if (last_row - first_row + 1 == chunk.size()) {
+			// the scanned rows are consecutive
+			WriteColumnData(chunk.data[0], col);
+		} else {
+			// the rows of a scanned chunk belong to the same vector of the table: place the values at the position of
+			// their row, the rows in between them are deleted
+			values.count = last_row - first_row + 1;
+			values.nullmask.set();
+			for (index_t i = 0; i < chunk.size(); i++) {
+				index_t position = row_ids[i] - first_row;
+				memcpy(values.data + position * type_size, chunk.data[0].data + i * type_size, type_size);
+				values.nullmask[position] = chunk.data[0].nullmask[i];
+				if (col == 0 && i > 0 && (index_t)row_ids[i] > (index_t)row_ids[i - 1] + 1) {
+					AddDeletedRows(row_ids[i - 1] + 1, row_ids[i]);
+				}
+			}
+			WriteColumnData(values, col);
+		}
+		next_row = last_row + 1;
+	}
+	WriteDeletedRows(col, next_row, row_count);
+	// finally we write the block that was not completely filled to disk, small blocks are packed together
+	FlushBlock(col, true);
+	// free up the memory of the column
+	blocks[col].reset();
+	compressors[col].reset();
+}
 
-	// the pointers to the written column data for this table
-	dictionaries.resize(table.columns.size());
-	data_pointers.resize(table.columns.size());
-	// we want to fetch all the column ids from the scan
-	// so make a list of all column ids of the table
-	for (index_t i = 0; i < table.columns.size(); i++) {
-		// for each column, create a block that serves as the buffer for that blocks data
-		blocks.push_back(make_unique<Block>(INVALID_BLOCK));
-		// initialize offsets, tuple counts and row number sizes
-		offsets.push_back(GetTypeHeaderSize(table.columns[i].type));
-		tuple_counts.push_back(0);
-		row_numbers.push_back(0);
+void TableDataWriter::WriteIndex(Transaction &transaction, index_t index_nr) {
+	auto &index = *unique_indexes[index_nr];
+	// the index of the table can contain entries that are not visible to the checkpoint, hence the written index is
+	// built from the rows that are written
+	vector<unique_ptr<Expression>> unbound_expressions;
+	vector<TypeId> types;
+	for (index_t i = 0; i < index.unbound_expressions.size(); i++) {
+		unbound_expressions.push_back(index.unbound_expressions[i]->Copy());
+		types.push_back(table.storage->types[index.column_ids[i]]);
 	}
+	ART written_index(*table.storage, index.column_ids, move(unbound_expressions), index.is_unique);
+
+	// the index expressions are references to the indexed columns, so the scanned columns are the keys of the index
+	// they are scanned together with the row ids, which the rows keep in the checkpoint
+	auto column_ids = index.column_ids;
+	column_ids.push_back(COLUMN_IDENTIFIER_ROW_ID);
+	types.push_back(ROW_TYPE);
+	TableScanState state;
+	table.storage->InitializeScan(state);
+	DataChunk chunk, keys;
+	chunk.Initialize(types);
+	types.pop_back();
+	keys.InitializeEmpty(types);
 	while (true) {
 		chunk.Reset();
-		// now scan the table to construct the blocks
 		table.storage->Scan(transaction, chunk, column_ids, state);
 		if (chunk.size() == 0) {
 			break;
 		}
-		// for each column, we append whatever we can fit into the block
-		for (index_t i = 0; i < table.columns.size(); i++) {
-			assert(chunk.data[i].type == GetInternalType(table.columns[i].type));
-			WriteColumnData(chunk, i);
+		chunk.Flatten();
+		for (index_t i = 0; i < keys.column_count; i++) {
+			keys.data[i].Reference(chunk.data[i]);
 		}
+		written_index.BuildAppend(keys, chunk.data[keys.column_count]);
 	}
-	// finally we write the blocks that were not completely filled to disk
-	// FIXME: pack together these unfilled blocks
-	for (index_t i = 0; i < table.columns.size(); i++) {
-		// we only write blocks that have data in them
-		if (offsets[i] > 0) {
-			FlushBlock(i);
-		}
+	written_index.FinalizeBuild();
+	index_pointers[index_nr] = written_index.WriteToStorage(manager.block_manager);
+}
+
+void TableDataWriter::WriteExistingTableData() {
+	auto &persistent_data = table.storage->persistent_data;
+	data_pointers = persistent_data.data_pointers;
+	row_count = persistent_data.row_count;
+	deleted_rows = persistent_data.deleted_rows;
+	// the blocks of the table are still used by the new checkpoint
+	data_blocks = persistent_data.data_blocks;
+	for (auto &block_id : data_blocks) {
+		manager.block_manager.MarkBlockAsUsed(block_id);
+	}
+}
+
+void TableDataWriter::FinalizeCheckpoint() {
+	auto &storage = *table.storage;
+	storage.persistent_data.data_pointers = move(data_pointers);
+	storage.persistent_data.data_blocks = move(data_blocks);
+	storage.persistent_data.row_count = row_count;
+	storage.persistent_data.deleted_rows = move(deleted_rows);
+	storage.persistent_change_count = change_count;
+	for (index_t i = 0; i < unique_indexes.size(); i++) {
+		unique_indexes[i]->persistent_pointer = move(index_pointers[i]);
+	}
+}
+
+void TableDataWriter::WriteDeletedRows(index_t col, index_t start, index_t end) {
+	if (start == end) {
+		return;
+	}
+	if (col == 0) {
+		AddDeletedRows(start, end);
+	}
+	Vector nulls(GetInternalType(table.columns[col].type), true, false);
+	nulls.nullmask.set();
+	for (index_t row = start; row < end; row += STANDARD_VECTOR_SIZE) {
+		nulls.count = std::min((index_t)STANDARD_VECTOR_SIZE, end - row);
+		WriteColumnData(nulls, col);
+	}
+}
+
+void TableDataWriter::AddDeletedRows(index_t start, index_t end) {
+	assert(start < end);
+	if (deleted_rows.size() > 0 && (index_t)(deleted_rows.back().start + deleted_rows.back().count) == start) {
+		// the rows directly follow the previous range of deleted rows
+		deleted_rows.back().count += end - start;
+		return;
 	}
-	// finally write the table storage information
-	WriteDataPointers();
+	deleted_rows.push_back(RowRange{(row_t)start, end - start});
 }
 
 //===--------------------------------------------------------------------===//
 // Write Column Data to Block
 //===--------------------------------------------------------------------===//
-void TableDataWriter::WriteColumnData(DataChunk &chunk, index_t column_index) {
-	TypeId type = chunk.data[column_index].type;
+void TableDataWriter::WriteColumnData(Vector &data, index_t column_index) {
+	TypeId type = data.type;
+	assert(type == GetInternalType(table.columns[column_index].type));
 	if (TypeIsConstantSize(type)) {
-		// constant size type: simple memcpy
-		// first check if we can fit the chunk into the block
-		index_t size = GetTypeIdSize(type) * chunk.size();
-		// check if we need to flush
+		// constant size type: the values are collected by the compressor and compressed when the block is flushed
 		// FIXME: append part of data that still fits into block if it does not fit entirely
-		FlushIfFull(column_index, size);
-		// data fits into block, write it and update the offset
-		auto ptr = blocks[column_index]->buffer + offsets[column_index];
-		VectorOperations::CopyToStorage(chunk.data[column_index], ptr);
-		offsets[column_index] += size;
-		tuple_counts[column_index] += chunk.size();
+		auto &compressor = *compressors[column_index];
+		if (!compressor.Append(data, blocks[column_index]->size)) {
+			// the compressed data does not fit into the block anymore: flush the block and start a new one
+			FlushBlock(column_index);
+			// an empty compressor always accepts the values
+			compressor.Append(data, blocks[column_index]->size);
+		}
+		stats[column_index]->Update(data);
+		tuple_counts[column_index] += data.count;
 	} else {
 		assert(type == TypeId::VARCHAR);
 		// we inline strings into the block
-		VectorOperations::ExecType<const char *>(chunk.data[column_index], [&](const char *val, size_t i, size_t k) {
-			if (chunk.data[column_index].nullmask[i]) {
+		VectorOperations::ExecType<const char *>(data, [&](const char *val, size_t i, size_t k) {
+			if (data.nullmask[i]) {
 				// NULL value
 				val = NullValue<const char *>();
 			}
@@ -104,34 +253,57 @@ void TableDataWriter::WriteColumnData(DataChunk &chunk, index_t column_index) {
 	}
 }
 
-void TableDataWriter::FlushBlock(index_t col) {
+void TableDataWriter::FlushBlock(index_t col, bool last_block) {
 	if (tuple_counts[col] == 0) {
 		return;
 	}
-	assert(offsets[col] + dictionaries[col].size < blocks[col]->size);
-	// get a block id
-	blocks[col]->id = manager.block_manager.GetFreeBlockId();
+	assert(table.columns[col].type.id != SQLTypeId::VARCHAR ||
+	       offsets[col] + dictionaries[col].GetSize() < blocks[col]->size);
+	// construct the data pointer
+	DataPointer data_pointer;
+	data_pointer.compression = CompressionType::UNCOMPRESSED;
+	index_t segment_size;
 	if (table.columns[col].type.id == SQLTypeId::VARCHAR) {
 		// for varchar columns, write the dictionary to the buffer
+		segment_size = offsets[col] + dictionaries[col].GetSize();
 		FlushDictionary(col);
+	} else {
+		// for fixed-size columns, write the collected values in the smallest compression format
+		auto &compressor = *compressors[col];
+		assert(compressor.count == tuple_counts[col]);
+		data_pointer.compression = compressor.GetCompression();
+		segment_size = compressor.GetCompressedSize(data_pointer.compression);
+		assert(segment_size <= blocks[col]->size);
+		compressor.Compress(data_pointer.compression, blocks[col]->buffer);
+		compressor.Reset();
 	}
-	// construct the data pointer, FIXME: add statistics as well
-	DataPointer data_pointer;
-	data_pointer.block_id = blocks[col]->id;
-	data_pointer.offset = 0;
+	memcpy(data_pointer.min, stats[col]->minimum.get(), GetTypeIdSize(stats[col]->type));
+	memcpy(data_pointer.max, stats[col]->maximum.get(), GetTypeIdSize(stats[col]->type));
+	data_pointer.has_null = stats[col]->has_null;
 	data_pointer.row_start = row_numbers[col];
 	data_pointer.tuple_count = tuple_counts[col];
+	if (last_block && segment_size <= CheckpointManager::MAXIMUM_PACKED_SEGMENT_SIZE) {
+		// the segment does not fill its block: pack it together with other small segments
+		manager.PackSegment(blocks[col]->buffer, segment_size, data_pointer.block_id, data_pointer.offset);
+		column_blocks[col].push_back(data_pointer.block_id);
+	} else {
+		// write the segment to a block of its own
+		blocks[col]->id = manager.block_manager.GetFreeBlockId();
+		data_pointer.block_id = blocks[col]->id;
+		data_pointer.offset = 0;
+		column_blocks[col].push_back(data_pointer.block_id);
+		manager.block_manager.Write(*blocks[col]);
+	}
 	data_pointers[col].push_back(data_pointer);
-	// write the block
-	manager.block_manager.Write(*blocks[col]);
 
 	offsets[col] = GetTypeHeaderSize(table.columns[col].type);
 	row_numbers[col] += tuple_counts[col];
 	tuple_counts[col] = 0;
+	stats[col]->Reset();
 }
 
 void TableDataWriter::FlushIfFull(index_t col, index_t write_size) {
-	if (offsets[col] + dictionaries[col].size + write_size >= blocks[col]->size) {
+	if (offsets[col] + dictionaries[col].GetSize() + write_size >= blocks[col]->size) {
 		// data does not fit into block, flush block to disk
 		FlushBlock(col);
 	}
@@ -139,16 +311,26 @@ void TableDataWriter::FlushIfFull(index_t col, index_t write_size) {
 
 void TableDataWriter::FlushDictionary(index_t col) {
 	assert(table.columns[col].type.id == SQLTypeId::VARCHAR);
-	assert(dictionaries[col].size > 0);
-	// write the dictionary size offset to the start of the block
+	auto &dictionary = dictionaries[col];
+	assert(dictionary.offsets.size() > 0);
+	// write the dictionary offset to the start of the block
 	*((int32_t *)blocks[col]->buffer) = offsets[col];
+	// write the amount of entries and the offsets of the strings
+	auto dictionary_ptr = blocks[col]->buffer + offsets[col];
+	*((uint32_t *)dictionary_ptr) = dictionary.offsets.size();
+	auto string_offsets = (uint32_t *)(dictionary_ptr + sizeof(uint32_t));
+	for (index_t code = 0; code < dictionary.offsets.size(); code++) {
+		string_offsets[code] = dictionary.offsets[code];
+	}
 	// now write the strings to the block
-	for (auto &entry : dictionaries[col].offsets) {
-		memcpy(blocks[col]->buffer + offsets[col] + entry.second, entry.first.c_str(), entry.first.size() + 1);
+	auto string_data = (data_ptr_t)(string_offsets + dictionary.offsets.size());
+	for (auto &entry : dictionary.codes) {
+		memcpy(string_data + dictionary.offsets[entry.second], entry.first.c_str(), entry.first.size() + 1);
 	}
 	// reset the dictionary
-	dictionaries[col].offsets.clear();
-	dictionaries[col].size = 0;
+	dictionary.codes.clear();
+	dictionary.offsets.clear();
+	dictionary.size = 0;
 }
 
 static index_t GetTypeHeaderSize(SQLType type) {
@@ -180,27 +362,33 @@ void TableDataWriter::WriteString(index_t col, const char *val) {
 		string marker = BigStringMarker(writer.block->id);
 		// write the string to the overflow blocks
 		writer.WriteString(str_value);
+		writer.Flush();
+		column_blocks[col].insert(column_blocks[col].end(), writer.written_blocks.begin(), writer.written_blocks.end());
 		// now write the marker in the dictionary
 		str_value = marker;
 	}
 	// add the string to the dictionary
-	auto entry = dictionaries[col].offsets.find(str_value);
-	int32_t offset;
-	if (entry == dictionaries[col].offsets.end()) {
+	auto &dictionary = dictionaries[col];
+	auto entry = dictionary.codes.find(str_value);
+	int32_t code;
+	if (entry == dictionary.codes.end()) {
 		// not in the dictionary yet, add it to the dictionary
-		// first check if we have room for the string in our dictionary
-		FlushIfFull(col, sizeof(int32_t) + str_value.size() + 1);
+		// first check if we have room for the code, the string offset and the string in our dictionary
+		FlushIfFull(col, sizeof(int32_t) + sizeof(uint32_t) + str_value.size() + 1);
 		// now add the string to the dictionary
-		offset = dictionaries[col].size;
-		dictionaries[col].offsets[str_value] = offset;
-		dictionaries[col].size += str_value.size() + 1;
+		code = dictionary.offsets.size();
+		dictionary.codes[str_value] = code;
+		dictionary.offsets.push_back(dictionary.size);
+		dictionary.size += str_value.size() + 1;
 	} else {
-		// in the dictionary, only need to write the offset
-		// check if we have room to write the offset
-		offset = entry->second;
+		// in the dictionary, only need to write the code
+		code = entry->second;
 	}
-	// now write the offset of this string into the buffer
-	*((int32_t *)(blocks[col]->buffer + offsets[col])) = offset;
+	if (IsNullValue<const char *>(val)) {
+		stats[col]->has_null = true;
+	}
+	// now write the code of this string into the buffer
+	*((int32_t *)(blocks[col]->buffer + offsets[col])) = code;
 	offsets[col] += sizeof(int32_t);
 	tuple_counts[col]++;
 }
@@ -213,12 +401,46 @@ void TableDataWriter::WriteDataPointers() {
 		// then write the data pointers themselves
 		for (index_t k = 0; k < data_pointer_list.size(); k++) {
 			auto &data_pointer = data_pointer_list[k];
-			manager.tabledata_writer->Write<double>(data_pointer.min);
-			manager.tabledata_writer->Write<double>(data_pointer.max);
+			manager.tabledata_writer->WriteData(data_pointer.min, sizeof(data_pointer.min));
+			manager.tabledata_writer->WriteData(data_pointer.max, sizeof(data_pointer.max));
+			manager.tabledata_writer->Write<bool>(data_pointer.has_null);
 			manager.tabledata_writer->Write<index_t>(data_pointer.row_start);
 			manager.tabledata_writer->Write<index_t>(data_pointer.tuple_count);
 			manager.tabledata_writer->Write<block_id_t>(data_pointer.block_id);
 			manager.tabledata_writer->Write<uint32_t>(data_pointer.offset);
+			manager.tabledata_writer->Write<uint8_t>((uint8_t)data_pointer.compression);
+		}
+	}
+	// finally write the blocks used by the table, so they can be kept by later checkpoints if the table is unchanged
+	// a block with packed segments can be shared by multiple columns, but is only written once
+	unordered_set<block_id_t> written_blocks;
+	for (auto &blocks_of_column : column_blocks) {
+		for (auto &block_id : blocks_of_column) {
+			if (written_blocks.find(block_id) == written_blocks.end()) {
+				written_blocks.insert(block_id);
+				data_blocks.push_back(block_id);
+			}
 		}
 	}
+	manager.tabledata_writer->Write<index_t>(data_blocks.size());
+	for (auto &block_id : data_blocks) {
+		manager.tabledata_writer->Write<block_id_t>(block_id);
+	}
+	// then write the location of the unique indexes and the blocks used by them
+	manager.tabledata_writer->Write<index_t>(index_pointers.size());
+	for (auto &pointer : index_pointers) {
+		manager.tabledata_writer->Write<block_id_t>(pointer.block_id);
+		manager.tabledata_writer->Write<uint32_t>(pointer.offset);
+		manager.tabledata_writer->Write<index_t>(pointer.blocks.size());
+		for (auto &block_id : pointer.blocks) {
+			manager.tabledata_writer->Write<block_id_t>(block_id);
+		}
+	}
+	// finally write the amount of rows and the deleted rows
+	manager.tabledata_writer->Write<index_t>(row_count);
+	manager.tabledata_writer->Write<index_t>(deleted_rows.size());
+	for (auto &range : deleted_rows) {
+		manager.tabledata_writer->Write<row_t>(range.start);
+		manager.tabledata_writer->Write<index_t>(range.count);
+	}
 }
@@ -22,6 +22,7 @@
 #include "main/client_context.hpp"
 #include "main/database.hpp"
 
+#include "parallel/task_scheduler.hpp"
 #include "transaction/transaction_manager.hpp"
 
 #include "storage/checkpoint/table_data_writer.hpp"
@@ -33,13 +34,16 @@ using namespace std;
 // constexpr uint64_t CheckpointManager::DATA_BLOCK_HEADER_SIZE;
 
 CheckpointManager::CheckpointManager(StorageManager &manager)
-    : block_manager(*manager.block_manager), database(manager.database) {
+    : block_manager(*manager.block_manager), buffer_manager(*manager.buffer_manager), database(manager.database),
+      partial_block_offset(0) {
 }
 
 void CheckpointManager::CreateCheckpoint() {
 	// assert that the checkpoint manager hasn't been used before
 	assert(!metadata_writer);
 
+	// the checkpoint keeps the query number its transaction started with, so the version information it scans is not
+	// freed by concurrent transactions while it is being written
 	auto transaction = database.transaction_manager->StartTransaction();
 
 	//! Set up the writers for the checkpoints
@@ -53,13 +57,15 @@ void CheckpointManager::CreateCheckpoint() {
 	// we scan the schemas
 	database.catalog->schemas.Scan(*transaction,
 	                               [&](CatalogEntry *entry) { schemas.push_back((SchemaCatalogEntry *)entry); });
-	// write the actual data into the database
+	// first write the data of the tables, then write the metadata of the catalog
+	WriteTableData(*transaction, schemas);
 	// write the amount of schemas
 	metadata_writer->Write<uint32_t>(schemas.size());
 	for (auto &schema : schemas) {
 		WriteSchema(*transaction, *schema);
 	}
-	// flush the meta data to disk
+	// flush the last block of packed segments and the meta data to disk
+	FlushPartialBlock();
 	metadata_writer->Flush();
 	tabledata_writer->Flush();
 
@@ -67,6 +73,60 @@ void CheckpointManager::CreateCheckpoint() {
 	DatabaseHeader header;
 	header.meta_block = meta_block;
 	block_manager.WriteHeader(header);
+	// the tables now point to their data in the new checkpoint
+	for (auto &entry : table_writers) {
+		entry.second->FinalizeCheckpoint();
+	}
+
+	// the checkpoint only read from the database
+	database.transaction_manager->RollbackTransaction(transaction);
+}
+
+void CheckpointManager::WriteTableData(Transaction &transaction, vector<SchemaCatalogEntry *> &schemas) {
+	// the data of every column of every changed table is written by a separate task
+	vector<task_function_t> tasks;
+	for (auto &schema : schemas) {
+		schema->tables.Scan(transaction, [&](CatalogEntry *entry) {
+			if (entry->type != CatalogType::TABLE) {
+				return;
+			}
+			auto table = (TableCatalogEntry *)entry;
+			auto writer = make_unique<TableDataWriter>(*this, *table);
+			writer->WriteTableData(transaction, tasks);
+			table_writers[table] = move(writer);
+		});
+	}
+	database.scheduler->ExecuteTasks(move(tasks));
+}
+
+void CheckpointManager::PackSegment(data_ptr_t data, index_t size, block_id_t &block_id, uint32_t &offset) {
+	assert(size <= MAXIMUM_PACKED_SEGMENT_SIZE);
+	lock_guard<mutex> partial_lock(partial_block_lock);
+	// segments start at an 8-byte aligned offset
+	index_t segment_offset = (partial_block_offset + 7) & ~(index_t)7;
+	if (partial_block && segment_offset + size > partial_block->size) {
+		// the segment does not fit into the current block anymore: write it and start a new block
+		FlushPartialBlock();
+		segment_offset = 0;
+	}
+	if (!partial_block) {
+		partial_block = make_unique<Block>(block_manager.GetFreeBlockId());
+		partial_block->Clear();
+		segment_offset = 0;
+	}
+	memcpy(partial_block->buffer + segment_offset, data, size);
+	partial_block_offset = segment_offset + size;
+	block_id = partial_block->id;
+	offset = segment_offset;
+}
+
+void CheckpointManager::FlushPartialBlock() {
+	if (!partial_block) {
+		return;
+	}
+	block_manager.Write(*partial_block);
+	partial_block.reset();
+	partial_block_offset = 0;
 }
 
 void CheckpointManager::LoadFromStorage() {
@@ -187,9 +247,10 @@ void CheckpointManager::WriteTable(Transaction &transaction, TableCatalogEntry &
 	metadata_writer->Write<block_id_t>(tabledata_writer->block->id);
 	//! and the offset to where the info starts
 	metadata_writer->Write<uint64_t>(tabledata_writer->offset);
-	// now we need to write the table data
-	TableDataWriter writer(*this, table);
-	writer.WriteTableData(transaction);
+	// now we write the pointers to the table data, which was written before
+	auto entry = table_writers.find(&table);
+	assert(entry != table_writers.end());
+	entry->second->WriteDataPointers();
 }
 
 void CheckpointManager::ReadTable(ClientContext &context, MetaBlockReader &reader) {
@@ -10,6 +10,7 @@
 #include "planner/constraints/list.hpp"
 #include "transaction/transaction.hpp"
 #include "transaction/transaction_manager.hpp"
+#include "storage/storage_manager.hpp"
 #include "storage/table/transient_segment.hpp"
 
 #include "transaction/version_info.hpp"
@@ -18,20 +19,31 @@ using namespace duckdb;
 using namespace std;
 
 DataTable::DataTable(StorageManager &storage, string schema, string table, vector<TypeId> types_,
-                     unique_ptr<vector<unique_ptr<PersistentSegment>>[]> data)
-    : cardinality(0), schema(schema), table(table), types(types_), storage(storage) {
+                     unique_ptr<vector<unique_ptr<PersistentSegment>>[]> data, PersistentTableData persistent_data_)
+    : cardinality(0), schema(schema), table(table), types(types_), storage(storage),
+      persistent_data(move(persistent_data_)), change_count(0), persistent_change_count(0) {
 	index_t accumulative_size = 0;
 	for (index_t i = 0; i < types.size(); i++) {
 		accumulative_tuple_size.push_back(accumulative_size);
 		accumulative_size += GetTypeIdSize(types[i]);
 	}
 	tuple_size = accumulative_size;
+	// a table that was not loaded from storage has no segments in the last checkpoint
+	persistent_data.data_pointers.resize(types.size());
 
 	// set up the segment trees for the column segments
 	columns = unique_ptr<SegmentTree[]>(new SegmentTree[types.size()]);
 
 	// initialize the table with the existing data from disk
 	index_t current_row = InitializeTable(move(data));
+	assert(current_row == persistent_data.row_count);
+	// rows keep their row id in the checkpoint: the rows that were deleted are stored as well
+	for (auto &range : persistent_data.deleted_rows) {
+		for (index_t row = range.start; row < range.start + range.count; row++) {
+			auto chunk = GetChunk(row);
+			chunk->SetDeleted(row - chunk->start);
+		}
+	}
 
 	// now initialize the transient segments and the transient version chunk
 	for (index_t i = 0; i < types.size(); i++) {
@@ -167,8 +179,10 @@ static void VerifyCheckConstraint(TableCatalogEntry &table, Expression &expr, Da
 }
 
 static void VerifyUniqueConstraint(TableCatalogEntry &table, unordered_set<index_t> &keys, DataChunk &chunk) {
-	// not implemented for multiple keys
-	assert(keys.size() == 1);
+	if (keys.size() > 1) {
+		// duplicate combinations of multiple columns within the chunk are detected when they are added to the index
+		return;
+	}
 	// check if the columns are unique
 	for (auto &key : keys) {
 		if (!VectorOperations::Unique(chunk.data[key])) {
@@ -203,7 +217,8 @@ void DataTable::VerifyAppendConstraints(TableCatalogEntry &table, DataChunk &chu
 	}
 }
 
-void DataTable::AppendToIndexes(DataChunk &chunk, row_t row_start) {
+void DataTable::AppendToIndexes(DataChunk &chunk, row_t row_start, bool verify_keys,
+                                vector<column_t> *updated_columns) {
 	if (indexes.size() == 0) {
 		return;
 	}
@@ -216,6 +231,11 @@ void DataTable::AppendToIndexes(DataChunk &chunk, row_t row_start) {
 	index_t failed_index = INVALID_INDEX;
 	// now append the entries to the indices
 	for (index_t i = 0; i < indexes.size(); i++) {
+		if (!verify_keys || (updated_columns && !indexes[i]->IndexIsUpdated(*updated_columns))) {
+			// the keys were already verified, or the keys of the moved rows are unchanged
+			indexes[i]->AppendVerified(chunk, row_identifiers);
+			continue;
+		}
 		if (!indexes[i]->Append(chunk, row_identifiers)) {
 			failed_index = i;
 			break;
@@ -244,6 +264,23 @@ void DataTable::Append(TableCatalogEntry &table, ClientContext &context, DataChu
 	// verify any constraints on the new chunk
 	VerifyAppendConstraints(table, chunk);
 
+	auto &transaction = context.ActiveTransaction();
+	context.db.transaction_manager->RegisterRowWrites(transaction);
+	AppendRows(chunk, &transaction, true);
+}
+
+void DataTable::AppendVerified(DataChunk &chunk, Transaction *transaction) {
+	if (chunk.size() == 0) {
+		return;
+	}
+	if (chunk.column_count != types.size()) {
+		throw CatalogException("Mismatch in column count for append");
+	}
+	AppendRows(chunk, transaction, false);
+}
+
+void DataTable::AppendRows(DataChunk &chunk, Transaction *transaction, bool verify_keys,
+                           vector<column_t> *updated_columns) {
 	StringHeap heap;
 	chunk.MoveStringsToHeap(heap);
 
@@ -259,16 +296,17 @@ void DataTable::Append(TableCatalogEntry &table, ClientContext &context, DataChu
 		row_start = last_chunk->start + last_chunk->count;
 
 		// Append the entries to the indexes, we do this first because this might fail in case of unique index conflicts
-		AppendToIndexes(chunk, row_start);
+		AppendToIndexes(chunk, row_start, verify_keys, updated_columns);
 
-		Transaction &transaction = context.ActiveTransaction();
 		index_t remainder = chunk.size();
 		index_t offset = 0;
 		while (remainder > 0) {
 			index_t to_copy = min(STORAGE_CHUNK_SIZE - last_chunk->count, remainder);
 			if (to_copy > 0) {
-				// push deleted entries into the undo buffer
-				last_chunk->PushDeletedEntries(transaction, to_copy);
+				if (transaction) {
+					// push deleted entries into the undo buffer, so the rows are only visible to the transaction
+					last_chunk->PushDeletedEntries(*transaction, to_copy);
+				}
 				// now insert the elements into the column segments
 				for (index_t i = 0; i < chunk.column_count; i++) {
 					AppendVector(i, chunk.data[i], offset, to_copy);
@@ -286,6 +324,10 @@ void DataTable::Append(TableCatalogEntry &table, ClientContext &context, DataChu
 		// after an append move the strings to the chunk
 		last_chunk->string_heap.MergeHeap(heap);
 	}
+	if (!transaction) {
+		// the rows are committed right away
+		change_count++;
+	}
 }
 
 //===--------------------------------------------------------------------===//
@@ -300,19 +342,19 @@ void DataTable::Delete(TableCatalogEntry &table, ClientContext &context, Vector
 	Transaction &transaction = context.ActiveTransaction();
 
 	auto ids = (row_t *)row_identifiers.data;
-	auto sel_vector = row_identifiers.sel_vector;
-	auto first_id = sel_vector ? ids[sel_vector[0]] : ids[0];
-	// first find the chunk the row ids belong to
-	auto chunk = GetChunk(first_id);
-
-	// get an exclusive lock on the chunk
-	auto lock = chunk->lock.GetExclusiveLock();
+	VersionChunk *chunk = nullptr;
+	unique_ptr<StorageLockKey> lock;
 	// no constraints are violated
 	// now delete the entries
 	VectorOperations::Exec(row_identifiers, [&](index_t i, index_t k) {
+		if (!chunk || (index_t)ids[i] < chunk->start || (index_t)ids[i] >= chunk->start + chunk->count) {
+			// the row ids of a scan belong to a single chunk, but row ids obtained from an index can belong to any
+			// chunk: find the chunk of the row id and get an exclusive lock on it
+			lock.reset();
+			chunk = GetChunk(ids[i]);
+			lock = chunk->lock.GetExclusiveLock();
+		}
 		auto id = ids[i] - chunk->start;
-		// assert that all ids in the vector belong to the same storage
-		// chunk
 		assert(id < chunk->count);
 		// check for conflicts
 		auto version = chunk->GetVersionInfo(id);
@@ -407,7 +449,7 @@ void DataTable::VerifyUpdateConstraints(TableCatalogEntry &table, DataChunk &chu
 }
 
 void DataTable::UpdateIndexes(TableCatalogEntry &table, vector<column_t> &column_ids, DataChunk &updates,
-                              Vector &row_identifiers) {
+                              Vector &row_identifiers, bool verify_keys) {
 	if (indexes.size() == 0) {
 		return;
 	}
@@ -423,7 +465,9 @@ void DataTable::UpdateIndexes(TableCatalogEntry &table, vector<column_t> &column
 			continue;
 		}
 		// if it is, we append the data to the index
-		if (!indexes[i]->Append(mock_chunk, row_identifiers)) {
+		if (!verify_keys) {
+			indexes[i]->AppendVerified(mock_chunk, row_identifiers);
+		} else if (!indexes[i]->Append(mock_chunk, row_identifiers)) {
 			failed_index = i;
 			break;
 		}
@@ -450,18 +494,90 @@ void DataTable::Update(TableCatalogEntry &table, ClientContext &context, Vector
 
 	// first verify that no constraints are violated
 	VerifyUpdateConstraints(table, updates, column_ids);
+	context.db.transaction_manager->RegisterRowWrites(context.ActiveTransaction());
+	UpdateRows(table, context, row_identifiers, column_ids, updates, true);
+}
 
-	// now perform the actual update
-	Transaction &transaction = context.ActiveTransaction();
+void DataTable::UpdateVerified(TableCatalogEntry &table, ClientContext &context, Vector &row_identifiers,
+                               vector<column_t> &column_ids, DataChunk &updates) {
+	assert(row_identifiers.type == ROW_TYPE);
+	if (row_identifiers.count == 0) {
+		return;
+	}
+	UpdateRows(table, context, row_identifiers, column_ids, updates, false);
+}
+
+void DataTable::UpdateRows(TableCatalogEntry &table, ClientContext &context, Vector &row_identifiers,
+                           vector<column_t> &column_ids, DataChunk &updates, bool verify_keys) {
+	// find the chunk the row ids belong to
+	auto ids = (row_t *)row_identifiers.data;
+	row_t min_id = numeric_limits<row_t>::max(), max_id = 0;
+	VectorOperations::Exec(row_identifiers, [&](index_t i, index_t k) {
+		min_id = std::min(min_id, ids[i]);
+		max_id = std::max(max_id, ids[i]);
+	});
+	// the rows that are stored in the last checkpoint are updated differently from the other rows (see UpdateChunk)
+	index_t persistent_rows = persistent_data.row_count;
+	auto chunk = GetChunk(min_id);
+	if ((index_t)max_id < chunk->start + chunk->count &&
+	    ((index_t)min_id < persistent_rows) == ((index_t)max_id < persistent_rows)) {
+		// all row ids belong to the same chunk
+		UpdateChunk(table, context, *chunk, row_identifiers, column_ids, updates, verify_keys);
+		return;
+	}
+	// the row ids of a scan belong to a single chunk, but row ids obtained from an index can belong to any chunk:
+	// order the rows by row id and update the rows of every chunk separately
+	updates.Flatten();
+	row_identifiers.Flatten();
+	index_t count = row_identifiers.count;
+	sel_t order[STANDARD_VECTOR_SIZE];
+	for (index_t i = 0; i < count; i++) {
+		order[i] = i;
+	}
+	sort(order, order + count, [&](sel_t left, sel_t right) { return ids[left] < ids[right]; });
+	auto update_types = updates.GetTypes();
+	index_t start = 0;
+	while (start < count) {
+		chunk = GetChunk(ids[order[start]]);
+		index_t end_row = chunk->start + chunk->count;
+		if ((index_t)ids[order[start]] < persistent_rows) {
+			end_row = std::min(end_row, persistent_rows);
+		}
+		index_t end = start + 1;
+		while (end < count && (index_t)ids[order[end]] < end_row) {
+			end++;
+		}
+		// select the rows of the chunk from the row ids and the updates
+		Vector chunk_ids;
+		chunk_ids.Reference(row_identifiers);
+		chunk_ids.sel_vector = order + start;
+		chunk_ids.count = end - start;
+		chunk_ids.Flatten();
+		DataChunk chunk_updates;
+		chunk_updates.InitializeEmpty(update_types);
+		for (index_t col_idx = 0; col_idx < updates.column_count; col_idx++) {
+			chunk_updates.data[col_idx].Reference(updates.data[col_idx]);
+			chunk_updates.data[col_idx].sel_vector = order + start;
+			chunk_updates.data[col_idx].count = end - start;
+		}
+		chunk_updates.sel_vector = order + start;
+		chunk_updates.Flatten();
+		UpdateChunk(table, context, *chunk, chunk_ids, column_ids, chunk_updates, verify_keys);
+		start = end;
+	}
+}
 
+void DataTable::UpdateChunk(TableCatalogEntry &table, ClientContext &context, VersionChunk &chunk_ref,
+                            Vector &row_identifiers, vector<column_t> &column_ids, DataChunk &updates,
+                            bool verify_keys) {
+	auto chunk = &chunk_ref;
+	Transaction &transaction = context.ActiveTransaction();
 	auto ids = (row_t *)row_identifiers.data;
-	auto sel_vector = row_identifiers.sel_vector;
-	auto first_id = sel_vector ? ids[sel_vector[0]] : ids[0];
-	// first find the chunk the row ids belong to
-	auto chunk = GetChunk(first_id);
+	auto first_id = row_identifiers.sel_vector ? ids[row_identifiers.sel_vector[0]] : ids[0];
 
-	if (chunk->type == VersionChunkType::PERSISTENT) {
-		// persistent chunk, we can't do an in-place update here
+	if ((index_t)first_id < persistent_data.row_count) {
+		// the rows are stored in the last checkpoint. When the WAL is replayed the rows are part of a persistent chunk,
+		// which cannot be updated in-place. The rows are updated in the same way here, so they get the same row ids.
 		// first fetch the existing columns for any non-updated columns
 		updates.Flatten();
 		row_identifiers.Flatten();
@@ -502,7 +618,7 @@ void DataTable::Update(TableCatalogEntry &table, ClientContext &context, Vector
 		}
 
 		// append the new set of rows
-		Append(table, context, append_chunk);
+		AppendRows(append_chunk, &transaction, verify_keys, &column_ids);
 
 		// finally delete the current set of rows
 		Delete(table, context, row_identifiers);
@@ -533,7 +649,7 @@ void DataTable::Update(TableCatalogEntry &table, ClientContext &context, Vector
 	});
 
 	// now we update any indexes, we do this before inserting anything into the undo buffer
-	UpdateIndexes(table, column_ids, updates, row_identifiers);
+	UpdateIndexes(table, column_ids, updates, row_identifiers, verify_keys);
 
 	// now we know there are no conflicts, move the tuples into the undo buffer and mark the chunk as dirty
 	VectorOperations::Exec(row_identifiers, [&](index_t i, index_t k) {
@@ -569,13 +685,33 @@ void DataTable::InitializeScan(TableScanState &state) {
 }
 
 void DataTable::Scan(Transaction &transaction, DataChunk &result, const vector<column_t> &column_ids,
-                     TableScanState &state) {
+                     TableScanState &state, const vector<TableFilter> &table_filters) {
 	// scan the base table
 	while (state.chunk) {
 		auto current_chunk = state.chunk;
 
+		// when starting a (non-final) chunk, check if the zone maps allow us to skip it entirely
+		// the final chunk of the table can still be appended to, so we always scan it
+		if (state.offset == 0 && table_filters.size() > 0 && current_chunk->next &&
+		    !CheckZonemap(current_chunk, state, column_ids, table_filters)) {
+			if (current_chunk == state.last_chunk) {
+				state.chunk = nullptr;
+				break;
+			}
+			auto next_chunk = (VersionChunk *)current_chunk->next.get();
+			for (index_t i = 0; i < types.size(); i++) {
+				state.columns[i] = next_chunk->columns[i];
+			}
+			state.chunk = next_chunk;
+			continue;
+		}
+
+		if (state.offset == 0) {
+			PrefetchColumns(state, column_ids);
+		}
 		// scan the current chunk
-		bool is_last_segment = current_chunk->Scan(state, transaction, result, column_ids, state.offset);
+		bool is_last_segment =
+		    current_chunk->Scan(state, transaction, result, column_ids, state.offset, table_filters);
 
 		if (is_last_segment) {
 			// last segment of this chunk: move to next segment
@@ -596,15 +732,114 @@ void DataTable::Scan(Transaction &transaction, DataChunk &result, const vector<c
 	}
 }
 
+void DataTable::PrefetchColumns(TableScanState &state, const vector<column_t> &column_ids) {
+	index_t prefetch_depth = storage.GetDatabase().prefetch_depth;
+	if (prefetch_depth == 0) {
+		return;
+	}
+	// the segments are prefetched every time the scan starts a new chunk: segments that are already loaded (or being
+	// loaded) are skipped by the buffer manager, so this only issues reads for the segments the scan has not reached
+	for (auto column_id : column_ids) {
+		if (column_id == COLUMN_IDENTIFIER_ROW_ID) {
+			continue;
+		}
+		auto segment = state.columns[column_id].segment;
+		for (index_t i = 0; segment && i < prefetch_depth; i++) {
+			segment->Prefetch();
+			segment = (ColumnSegment *)segment->next.get();
+		}
+	}
+}
+
+bool DataTable::CheckZonemap(VersionChunk *chunk, TableScanState &state, const vector<column_t> &column_ids,
+                             const vector<TableFilter> &table_filters) {
+	index_t chunk_end = chunk->start + chunk->count;
+	for (auto &filter : table_filters) {
+		auto column_id = column_ids[filter.column_index];
+		if (column_id == COLUMN_IDENTIFIER_ROW_ID) {
+			continue;
+		}
+		// check the segments that overlap with this chunk
+		bool may_match = false;
+		auto segment = state.columns[column_id].segment;
+		while (segment && segment->start < chunk_end) {
+			if (segment->stats.CheckZonemap(filter)) {
+				may_match = true;
+				break;
+			}
+			segment = (ColumnSegment *)segment->next.get();
+		}
+		if (!may_match) {
+			// no segment can contain a matching tuple: the chunk can be skipped
+			return false;
+		}
+	}
+	return true;
+}
+
+void DataTable::InitializeParallelScan(ParallelTableScanState &state) {
+	state.current_chunk = (VersionChunk *)storage_tree.GetRootSegment();
+	state.last_chunk = (VersionChunk *)storage_tree.GetLastSegment();
+	state.last_chunk_count = state.last_chunk->count;
+}
+
+bool DataTable::NextParallelScan(ParallelTableScanState &state, TableScanState &scan_state) {
+	VersionChunk *chunk;
+	index_t chunk_count;
+	{
+		lock_guard<mutex> parallel_lock(state.lock);
+		chunk = state.current_chunk;
+		if (!chunk) {
+			return false;
+		}
+		if (chunk == state.last_chunk) {
+			chunk_count = state.last_chunk_count;
+			state.current_chunk = nullptr;
+		} else {
+			chunk_count = chunk->count;
+			state.current_chunk = (VersionChunk *)chunk->next.get();
+		}
+	}
+	// the morsel is a single version chunk: start scanning the columns at the start of the chunk
+	scan_state.chunk = chunk;
+	scan_state.last_chunk = chunk;
+	scan_state.last_chunk_count = chunk_count;
+	if (!scan_state.columns) {
+		scan_state.columns = unique_ptr<ColumnPointer[]>(new ColumnPointer[types.size()]);
+	}
+	for (index_t i = 0; i < types.size(); i++) {
+		scan_state.columns[i] = chunk->columns[i];
+	}
+	scan_state.offset = 0;
+	scan_state.version_chain = nullptr;
+	return true;
+}
+
+index_t DataTable::MorselCount() {
+	lock_guard<mutex> tree_lock(storage_tree.node_lock);
+	return storage_tree.nodes.size();
+}
+
+index_t DataTable::AppendedRowCount() {
+	auto last_chunk = (VersionChunk *)storage_tree.GetLastSegment();
+	return last_chunk->start + last_chunk->count;
+}
+
 void DataTable::Fetch(Transaction &transaction, DataChunk &result, vector<column_t> &column_ids,
                       Vector &row_identifiers) {
 	assert(row_identifiers.type == ROW_TYPE);
 	auto row_ids = (row_t *)row_identifiers.data;
 
+	VersionChunk *chunk = nullptr;
+	unique_ptr<StorageLockKey> lock;
 	VectorOperations::Exec(row_identifiers, [&](index_t i, index_t k) {
 		auto row_id = row_ids[i];
-		auto chunk = GetChunk(row_id);
-		auto lock = chunk->lock.GetSharedLock();
+		if (!chunk || (index_t)row_id < chunk->start || (index_t)row_id >= chunk->start + chunk->count) {
+			// the row is not part of the chunk of the previous row: look up and lock its chunk
+			lock.reset();
+			chunk = GetChunk(row_id);
+			lock = chunk->lock.GetSharedLock();
+		}
 
 		assert((index_t)row_id >= chunk->start && (index_t)row_id < chunk->start + chunk->count);
 		auto index = row_id - chunk->start;
@@ -693,7 +928,7 @@ void DataTable::AddIndex(unique_ptr<Index> index, vector<unique_ptr<Expression>>
 	intermediate_types.push_back(ROW_TYPE);
 	intermediate.Initialize(intermediate_types);
 
-	// now start incrementally building the index
+	// now scan the table to build the index
 	while (true) {
 		intermediate.Reset();
 		// scan a new chunk from the table to index
@@ -706,8 +941,14 @@ void DataTable::AddIndex(unique_ptr<Index> index, vector<unique_ptr<Expression>>
 		// resolve the expressions for this chunk
 		ExpressionExecutor executor(intermediate);
 		executor.Execute(expressions, result);
-		// insert into the index
-		index->Insert(result, intermediate.data[intermediate.column_count - 1]);
+		// collect the entries for the index
+		index->BuildAppend(result, intermediate.data[intermediate.column_count - 1]);
 	}
+	// construct the index from all entries at once
+	index->FinalizeBuild();
 	indexes.push_back(move(index));
 }
+
+bool DataTable::HasChanges() {
+	return change_count != persistent_change_count;
+}
@@ -0,0 +1,92 @@
+#include "storage/mapped_block_manager.hpp"
+#include "common/exception.hpp"
+#include "common/file_buffer.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+MappedBlockManager::MappedBlockManager(FileSystem &fs, string path)
+    : fs(fs), path(path), data(nullptr), file_size(0), meta_block(INVALID_BLOCK) {
+	handle = fs.OpenFile(path, FileFlags::READ, FileLockType::READ_LOCK);
+	auto size = fs.GetFileSize(*handle);
+	if (size < (int64_t)BLOCK_START) {
+		throw IOException("Cannot open database file \"%s\": the file is too small to be a database file",
+		                  path.c_str());
+	}
+	file_size = size;
+	data = fs.MapFile(*handle, file_size);
+
+	// check the version number in the main header
+	FileBuffer main_header(data, HEADER_SIZE);
+	main_header.VerifyChecksum();
+	auto version_number = ((MainHeader *)main_header.buffer)->version_number;
+	if (version_number != VERSION_NUMBER) {
+		throw IOException("Trying to read a database file with version number %lld, but we can only read version %lld",
+		                  version_number, VERSION_NUMBER);
+	}
+	// use the database header with the highest iteration count
+	FileBuffer h1_buffer(data + HEADER_SIZE, HEADER_SIZE), h2_buffer(data + HEADER_SIZE * 2, HEADER_SIZE);
+	h1_buffer.VerifyChecksum();
+	h2_buffer.VerifyChecksum();
+	auto h1 = (DatabaseHeader *)h1_buffer.buffer;
+	auto h2 = (DatabaseHeader *)h2_buffer.buffer;
+	meta_block = h1->iteration > h2->iteration ? h1->meta_block : h2->meta_block;
+	verified_blocks.resize((file_size - BLOCK_START) / BLOCK_SIZE, false);
+}
+
+MappedBlockManager::~MappedBlockManager() {
+	if (data) {
+		fs.UnmapFile(data, file_size);
+	}
+}
+
+unique_ptr<Block> MappedBlockManager::CreateBlock() {
+	throw Exception("Cannot create a block in a read-only database");
+}
+
+block_id_t MappedBlockManager::GetFreeBlockId() {
+	throw Exception("Cannot create a block in a read-only database");
+}
+
+void MappedBlockManager::MarkBlockAsUsed(block_id_t block_id) {
+	throw Exception("Cannot write blocks in a read-only database");
+}
+
+block_id_t MappedBlockManager::GetMetaBlock() {
+	return meta_block;
+}
+
+data_ptr_t MappedBlockManager::GetBlockData(block_id_t block_id) {
+	if (block_id < 0 || (index_t)block_id >= verified_blocks.size()) {
+		throw IOException("Corrupt database file: block %lld is outside of the file", (long long)block_id);
+	}
+	return data + BLOCK_START + block_id * BLOCK_SIZE;
+}
+
+void MappedBlockManager::Read(Block &block) {
+	GetBlockData(block.id);
+	block.Read(*handle, BLOCK_START + block.id * BLOCK_SIZE);
+}
+
+unique_ptr<Block> MappedBlockManager::LoadBlock(block_id_t block_id) {
+	auto block = make_unique<Block>(block_id, GetBlockData(block_id));
+	{
+		lock_guard<mutex> lock(verify_lock);
+		if (verified_blocks[block_id]) {
+			return block;
+		}
+	}
+	// first time the block is touched: verify the checksum, which faults the pages of the block in from disk
+	block->VerifyChecksum();
+	lock_guard<mutex> lock(verify_lock);
+	verified_blocks[block_id] = true;
+	return block;
+}
+
+void MappedBlockManager::Write(Block &block) {
+	throw Exception("Cannot write blocks in a read-only database");
+}
+
+void MappedBlockManager::WriteHeader(DatabaseHeader header) {
+	throw Exception("Cannot write blocks in a read-only database");
+}
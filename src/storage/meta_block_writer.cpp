@@ -15,6 +15,7 @@ MetaBlockWriter::~MetaBlockWriter() {
 void MetaBlockWriter::Flush() {
 	if (offset > sizeof(block_id_t)) {
 		manager.Write(*block);
+		written_blocks.push_back(block->id);
 		offset = sizeof(block_id_t);
 	}
 }
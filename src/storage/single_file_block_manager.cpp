@@ -55,6 +55,8 @@ SingleFileBlockManager::SingleFileBlockManager(FileSystem &fs, string path, bool
 		handle->Sync();
 		// we start with h2 as active_header, this way our initial write will be in h1
 		active_header = 1;
+		meta_block = INVALID_BLOCK;
+		iteration_count = 1;
 		max_block = 0;
 	} else {
 		MainHeader header;
@@ -98,18 +100,36 @@ void SingleFileBlockManager::Initialize(DatabaseHeader &header) {
 	meta_block = header.meta_block;
 	iteration_count = header.iteration;
 	max_block = header.block_count;
+	// the free list contains all blocks that are not used by the checkpoint
+	unordered_set<block_id_t> free_blocks(free_list.begin(), free_list.end());
+	for (block_id_t block_id = 0; block_id < max_block; block_id++) {
+		if (free_blocks.find(block_id) == free_blocks.end()) {
+			used_blocks.insert(block_id);
+		}
+	}
+	loaded_blocks = used_blocks;
 }
 
 block_id_t SingleFileBlockManager::GetFreeBlockId() {
+	lock_guard<mutex> lock(block_lock);
+	block_id_t block;
 	if (free_list.size() > 0) {
 		// free list is non empty
 		// take an entry from the free list
-		block_id_t block = free_list.back();
+		block = free_list.back();
 		// erase the entry from the free list again
 		free_list.pop_back();
-		return block;
+	} else {
+		block = max_block++;
 	}
-	return max_block++;
+	checkpoint_blocks.insert(block);
+	return block;
+}
+
+void SingleFileBlockManager::MarkBlockAsUsed(block_id_t block_id) {
+	lock_guard<mutex> lock(block_lock);
+	assert(used_blocks.find(block_id) != used_blocks.end());
+	checkpoint_blocks.insert(block_id);
 }
 
 block_id_t SingleFileBlockManager::GetMetaBlock() {
@@ -122,7 +142,6 @@ unique_ptr<Block> SingleFileBlockManager::CreateBlock() {
 
 void SingleFileBlockManager::Read(Block &block) {
 	assert(block.id >= 0);
-	used_blocks.push_back(block.id);
 	block.Read(*handle, BLOCK_START + block.id * BLOCK_SIZE);
 }
 
@@ -132,22 +151,44 @@ void SingleFileBlockManager::Write(Block &block) {
 }
 
 void SingleFileBlockManager::WriteHeader(DatabaseHeader header) {
-	if (!use_direct_io) {
-		// if we are not using Direct IO we need to fsync BEFORE we write the header to ensure that all the previous
-		// blocks are written as well
-		handle->Sync();
-	}
 	// set the iteration count
 	header.iteration = ++iteration_count;
-	header.block_count = max_block;
-	// now handle the free list
-	if (used_blocks.size() > 0) {
+	// now handle the free list: every block that is not used by the new checkpoint is free
+	vector<block_id_t> free_blocks;
+	for (block_id_t block_id = 0; block_id < max_block; block_id++) {
+		if (checkpoint_blocks.find(block_id) == checkpoint_blocks.end()) {
+			free_blocks.push_back(block_id);
+		}
+	}
+	// the free list itself is written to free blocks that can be overwritten, or to new blocks at the end of the file if
+	// there are not enough of them. Blocks that are read by this database or that belong to the checkpoint the header
+	// on disk points to cannot be overwritten: the header on disk still refers to them until the new header is written.
+	// The blocks the list is written to are taken out of the free list first, so the list does not contain its own
+	// blocks.
+	free_list.clear();
+	index_t list_entries = free_blocks.size();
+	// every block of the list starts with the block checksum and the id of the next block of the list
+	index_t block_capacity = BLOCK_SIZE - sizeof(uint64_t) - sizeof(block_id_t);
+	for (index_t i = free_blocks.size(); i > 0; i--) {
+		index_t required_blocks = (sizeof(uint64_t) + list_entries * sizeof(block_id_t) + block_capacity - 1) /
+		                          block_capacity;
+		if (free_list.size() >= required_blocks) {
+			break;
+		}
+		auto block_id = free_blocks[i - 1];
+		if (loaded_blocks.find(block_id) == loaded_blocks.end() && used_blocks.find(block_id) == used_blocks.end()) {
+			free_list.push_back(block_id);
+			free_blocks.erase(free_blocks.begin() + (i - 1));
+			list_entries--;
+		}
+	}
+	if (free_blocks.size() > 0 || free_list.size() > 0) {
 		// there are blocks in the free list
 		// write them to the file
 		MetaBlockWriter writer(*this);
 		header.free_list = writer.block->id;
-		writer.Write<uint64_t>(used_blocks.size());
-		for (auto &block_id : used_blocks) {
+		writer.Write<uint64_t>(free_blocks.size());
+		for (auto &block_id : free_blocks) {
 			writer.Write<block_id_t>(block_id);
 		}
 		writer.Flush();
@@ -155,6 +196,12 @@ void SingleFileBlockManager::WriteHeader(DatabaseHeader header) {
 		// no blocks in the free list
 		header.free_list = INVALID_BLOCK;
 	}
+	if (!use_direct_io) {
+		// if we are not using Direct IO we need to fsync BEFORE we write the header to ensure that all the previous
+		// blocks, including the blocks of the free list, are written as well
+		handle->Sync();
+	}
+	header.block_count = max_block;
 	// set the header inside the buffer
 	header_buffer.Clear();
 	*((DatabaseHeader *)header_buffer.buffer) = header;
@@ -166,6 +213,14 @@ void SingleFileBlockManager::WriteHeader(DatabaseHeader header) {
 	//! Ensure the header write ends up on disk
 	handle->Sync();
 
-	// the free list is now equal to the blocks that were used by the previous iteration
-	free_list = used_blocks;
+	// the new checkpoint is now the current checkpoint
+	meta_block = header.meta_block;
+	used_blocks = move(checkpoint_blocks);
+	checkpoint_blocks.clear();
+	// the free blocks can be written to by the next checkpoint, unless they can still be read by the database
+	for (auto &block_id : free_blocks) {
+		if (loaded_blocks.find(block_id) == loaded_blocks.end()) {
+			free_list.push_back(block_id);
+		}
+	}
 }
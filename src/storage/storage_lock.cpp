@@ -1,5 +1,7 @@
 #include "storage/storage_lock.hpp"
 
+#include <thread>
+
 using namespace duckdb;
 using namespace std;
 
@@ -15,16 +17,31 @@ StorageLockKey::~StorageLockKey() {
 	}
 }
 
-StorageLock::StorageLock() : read_count(0) {
+StorageLock::StorageLock() : read_count(0), write_version(0) {
 }
 
 unique_ptr<StorageLockKey> StorageLock::GetExclusiveLock() {
 	exclusive_lock.lock();
+	// invalidate any optimistic reads before the data is modified
+	write_version++;
 	while (read_count != 0) {
 	}
 	return make_unique<StorageLockKey>(*this, StorageLockType::EXCLUSIVE);
 }
 
+unique_ptr<StorageLockKey> StorageLock::TryGetExclusiveLock() {
+	if (!exclusive_lock.try_lock()) {
+		return nullptr;
+	}
+	if (read_count != 0) {
+		// there are readers holding a shared lock
+		exclusive_lock.unlock();
+		return nullptr;
+	}
+	write_version++;
+	return make_unique<StorageLockKey>(*this, StorageLockType::EXCLUSIVE);
+}
+
 unique_ptr<StorageLockKey> StorageLock::GetSharedLock() {
 	exclusive_lock.lock();
 	read_count++;
@@ -32,7 +49,24 @@ unique_ptr<StorageLockKey> StorageLock::GetSharedLock() {
 	return make_unique<StorageLockKey>(*this, StorageLockType::SHARED);
 }
 
+index_t StorageLock::StartOptimisticRead() {
+	index_t version = write_version;
+	while (version % 2 == 1) {
+		// an exclusive lock is held: wait for the writer to finish
+		std::this_thread::yield();
+		version = write_version;
+	}
+	return version;
+}
+
+bool StorageLock::ValidateOptimisticRead(index_t version) {
+	// make sure the reads of the protected data happen before the version is checked again
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return write_version.load(std::memory_order_relaxed) == version;
+}
+
 void StorageLock::ReleaseExclusiveLock() {
+	write_version++;
 	exclusive_lock.unlock();
 }
 
@@ -1,6 +1,8 @@
 #include "storage/storage_manager.hpp"
 #include "storage/checkpoint_manager.hpp"
 #include "storage/single_file_block_manager.hpp"
+#include "storage/mapped_block_manager.hpp"
+#include "storage/buffer_manager.hpp"
 
 #include "catalog/catalog.hpp"
 #include "common/file_system.hpp"
@@ -10,7 +12,6 @@
 #include "parser/parsed_data/create_schema_info.hpp"
 #include "transaction/transaction_manager.hpp"
 #include "planner/binder.hpp"
-#include "common/serializer/buffered_file_reader.hpp"
 
 using namespace duckdb;
 using namespace std;
@@ -51,31 +52,33 @@ void StorageManager::Initialize() {
 	}
 }
 
-void StorageManager::Checkpoint(string wal_path) {
-	if (!database.file_system->FileExists(wal_path)) {
-		// no WAL to checkpoint
+void StorageManager::CreateCheckpoint(bool force) {
+	if (!wal.initialized) {
+		// in-memory or read-only database: nothing to checkpoint
 		return;
 	}
-	if (read_only) {
-		// cannot checkpoint in read-only system
+	if (!force && wal.GetWALSize() <= (int64_t)database.checkpoint_wal_size) {
+		// WAL is too small
 		return;
 	}
-	// check the size of the WAL
-	{
-		BufferedFileReader reader(*database.file_system, wal_path.c_str());
-		if (reader.FileSize() <= database.checkpoint_wal_size) {
-			// WAL is too small
+	// block transactions that made changes from committing while the checkpoint is written
+	auto checkpoint_guard = database.transaction_manager->checkpoint_lock.GetExclusiveLock();
+	if (!force && wal.GetWALSize() <= (int64_t)database.checkpoint_wal_size) {
+		// another transaction created a checkpoint in the meantime
+		return;
+	}
+	if (database.transaction_manager->HasRowWrites()) {
+		if (!force) {
+			// the checkpoint is created by a later commit instead
 			return;
 		}
+		throw TransactionException("Cannot CHECKPOINT: there are active transactions that appended or updated rows");
 	}
-
-	// checkpoint the database
-	// FIXME: we do this now by creating a new database and forcing a checkpoint in that database
-	// then reloading the file again
-	// this should be fixed and turned into an incremental checkpoint
-	DBConfig config;
-	config.checkpoint_only = true;
-	DuckDB db(path, &config);
+	// write the changed tables to the database file
+	CheckpointManager checkpointer(*this);
+	checkpointer.CreateCheckpoint();
+	// all changes in the WAL are now part of the checkpoint
+	wal.Truncate();
 }
 
 void StorageManager::LoadDatabase() {
@@ -95,13 +98,17 @@ void StorageManager::LoadDatabase() {
 		// initialize the block manager while creating a new db file
 		block_manager =
 		    make_unique<SingleFileBlockManager>(*database.file_system, path, read_only, true, database.use_direct_io);
+		buffer_manager = make_unique<BufferManager>(*block_manager, database.maximum_memory);
 	} else {
-		if (!database.checkpoint_only) {
-			Checkpoint(wal_path);
-		}
 		// initialize the block manager while loading the current db file
-		block_manager =
-		    make_unique<SingleFileBlockManager>(*database.file_system, path, read_only, false, database.use_direct_io);
+		// read-only databases are mapped into memory, unless they are explicitly read with direct IO
+		if (read_only && database.use_mmap && !database.use_direct_io) {
+			block_manager = make_unique<MappedBlockManager>(*database.file_system, path);
+		} else {
+			block_manager = make_unique<SingleFileBlockManager>(*database.file_system, path, read_only, false,
+			                                                    database.use_direct_io);
+		}
+		buffer_manager = make_unique<BufferManager>(*block_manager, database.maximum_memory);
 		//! Load from storage
 		CheckpointManager checkpointer(*this);
 		checkpointer.LoadFromStorage();
@@ -109,17 +116,12 @@ void StorageManager::LoadDatabase() {
 		if (database.file_system->FileExists(wal_path)) {
 			// replay the WAL
 			WriteAheadLog::Replay(database, wal_path);
-			if (database.checkpoint_only) {
-				assert(!read_only);
-				// checkpoint the database
-				checkpointer.CreateCheckpoint();
-				// remove the WAL
-				database.file_system->RemoveFile(wal_path);
-			}
 		}
 	}
 	// initialize the WAL file
-	if (!database.checkpoint_only && !read_only) {
+	if (!read_only) {
 		wal.Initialize(wal_path);
+		// checkpoint the replayed WAL if it is too large
+		CreateCheckpoint();
 	}
 }
@@ -1,5 +1,11 @@
 #include "storage/table/column_segment.hpp"
 
+#include "common/vector_operations/vector_operations.hpp"
+#include "planner/table_filter.hpp"
+
+#include <cstring>
+#include <limits>
+
 using namespace duckdb;
 using namespace std;
 
@@ -8,8 +14,133 @@ ColumnSegment::ColumnSegment(TypeId type, ColumnSegmentType segment_type, index_
       stats(type, type_size) {
 }
 
-SegmentStatistics::SegmentStatistics(TypeId type, index_t type_size) {
+SegmentStatistics::SegmentStatistics(TypeId type, index_t type_size) : type(type) {
 	minimum = unique_ptr<data_t[]>(new data_t[type_size]);
 	maximum = unique_ptr<data_t[]>(new data_t[type_size]);
+	Reset();
+}
+
+template <class T> static void initialize_min_max(data_ptr_t min, data_ptr_t max) {
+	*((T *)min) = std::numeric_limits<T>::max();
+	*((T *)max) = std::numeric_limits<T>::lowest();
+}
+
+void SegmentStatistics::Reset() {
 	has_null = false;
+	switch (type) {
+	case TypeId::BOOLEAN:
+	case TypeId::TINYINT:
+		initialize_min_max<int8_t>(minimum.get(), maximum.get());
+		break;
+	case TypeId::SMALLINT:
+		initialize_min_max<int16_t>(minimum.get(), maximum.get());
+		break;
+	case TypeId::INTEGER:
+		initialize_min_max<int32_t>(minimum.get(), maximum.get());
+		break;
+	case TypeId::BIGINT:
+		initialize_min_max<int64_t>(minimum.get(), maximum.get());
+		break;
+	case TypeId::FLOAT:
+		initialize_min_max<float>(minimum.get(), maximum.get());
+		break;
+	case TypeId::DOUBLE:
+		initialize_min_max<double>(minimum.get(), maximum.get());
+		break;
+	default:
+		// no min/max statistics for this type
+		memset(minimum.get(), 0, GetTypeIdSize(type));
+		memset(maximum.get(), 0, GetTypeIdSize(type));
+		break;
+	}
+}
+
+template <class T> static void update_min_max(Vector &new_data, data_ptr_t min_ptr, data_ptr_t max_ptr) {
+	auto min = (T *)min_ptr;
+	auto max = (T *)max_ptr;
+	VectorOperations::ExecType<T>(new_data, [&](T value, index_t i, index_t k) {
+		if (new_data.nullmask[i]) {
+			return;
+		}
+		if (value < *min) {
+			*min = value;
+		}
+		if (value > *max) {
+			*max = value;
+		}
+	});
+}
+
+void SegmentStatistics::Update(Vector &new_data) {
+	assert(new_data.type == type);
+	if (new_data.nullmask.any()) {
+		has_null = true;
+	}
+	switch (type) {
+	case TypeId::BOOLEAN:
+	case TypeId::TINYINT:
+		update_min_max<int8_t>(new_data, minimum.get(), maximum.get());
+		break;
+	case TypeId::SMALLINT:
+		update_min_max<int16_t>(new_data, minimum.get(), maximum.get());
+		break;
+	case TypeId::INTEGER:
+		update_min_max<int32_t>(new_data, minimum.get(), maximum.get());
+		break;
+	case TypeId::BIGINT:
+		update_min_max<int64_t>(new_data, minimum.get(), maximum.get());
+		break;
+	case TypeId::FLOAT:
+		update_min_max<float>(new_data, minimum.get(), maximum.get());
+		break;
+	case TypeId::DOUBLE:
+		update_min_max<double>(new_data, minimum.get(), maximum.get());
+		break;
+	default:
+		break;
+	}
+}
+
+template <class T> static bool check_zonemap(data_ptr_t min_ptr, data_ptr_t max_ptr, ExpressionType type, T constant) {
+	T min = *((T *)min_ptr);
+	T max = *((T *)max_ptr);
+	switch (type) {
+	case ExpressionType::COMPARE_EQUAL:
+		return constant >= min && constant <= max;
+	case ExpressionType::COMPARE_GREATERTHAN:
+		return max > constant;
+	case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+		return max >= constant;
+	case ExpressionType::COMPARE_LESSTHAN:
+		return min < constant;
+	case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		return min <= constant;
+	default:
+		return true;
+	}
+}
+
+bool SegmentStatistics::CheckZonemap(const TableFilter &filter) {
+	if (filter.constant.type != type || filter.constant.is_null) {
+		return true;
+	}
+	auto &constant = filter.constant.value_;
+	switch (type) {
+	case TypeId::BOOLEAN:
+	case TypeId::TINYINT:
+		return check_zonemap<int8_t>(minimum.get(), maximum.get(), filter.comparison_type, constant.tinyint);
+	case TypeId::SMALLINT:
+		return check_zonemap<int16_t>(minimum.get(), maximum.get(), filter.comparison_type, constant.smallint);
+	case TypeId::INTEGER:
+		return check_zonemap<int32_t>(minimum.get(), maximum.get(), filter.comparison_type, constant.integer);
+	case TypeId::BIGINT:
+		return check_zonemap<int64_t>(minimum.get(), maximum.get(), filter.comparison_type, constant.bigint);
+	case TypeId::FLOAT:
+		return check_zonemap<float>(minimum.get(), maximum.get(), filter.comparison_type, constant.float_);
+	case TypeId::DOUBLE:
+		return check_zonemap<double>(minimum.get(), maximum.get(), filter.comparison_type, constant.double_);
+	default:
+		// no statistics available for this type
+		return true;
+	}
 }
@@ -0,0 +1,396 @@
+#include "storage/table/compression.hpp"
+
+#include "common/exception.hpp"
+#include "common/types/null_value.hpp"
+#include "common/vector_operations/vector_operations.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace duckdb;
+using namespace std;
+
+constexpr index_t SegmentCompressor::MAXIMUM_UNCOMPRESSED_SIZE;
+
+//! RLE segments start with the amount of runs, followed by the run ends and the run values
+static constexpr index_t RLE_HEADER_SIZE = sizeof(uint64_t);
+//! Bit-packed segments start with the frame of reference, the bit width and the code used for NULL values
+static constexpr index_t BITPACKING_HEADER_SIZE = sizeof(int64_t) + sizeof(uint64_t) + sizeof(uint64_t);
+
+static index_t RLEValueOffset(index_t run_count) {
+	// the values are aligned to 8 bytes
+	index_t offset = RLE_HEADER_SIZE + run_count * sizeof(uint32_t);
+	return (offset + 7) & ~((index_t)7);
+}
+
+SegmentCompressor::SegmentCompressor(TypeId type) : type(type), type_size(GetTypeIdSize(type)), count(0), capacity(0) {
+	assert(TypeIsConstantSize(type));
+}
+
+template <class T>
+static void update_compression_state(SegmentCompressor::CompressionState &state, T *values, index_t count,
+                                     bool integral) {
+	for (index_t i = 0; i < count; i++) {
+		T value = values[i];
+		if (state.count == 0 || memcmp(&value, state.last_value, sizeof(T)) != 0) {
+			// start of a new run
+			state.run_count++;
+			memcpy(state.last_value, &value, sizeof(T));
+		}
+		state.count++;
+		if (IsNullValue<T>(value)) {
+			state.has_null = true;
+			continue;
+		}
+		if (!integral) {
+			continue;
+		}
+		auto integral_value = (int64_t)value;
+		if (!state.has_value) {
+			state.min = state.max = integral_value;
+			state.has_value = true;
+		} else {
+			state.min = std::min(state.min, integral_value);
+			state.max = std::max(state.max, integral_value);
+		}
+	}
+}
+
+static void UpdateCompressionState(SegmentCompressor::CompressionState &state, TypeId type, data_ptr_t values,
+                                   index_t count) {
+	switch (type) {
+	case TypeId::BOOLEAN:
+	case TypeId::TINYINT:
+		update_compression_state<int8_t>(state, (int8_t *)values, count, true);
+		break;
+	case TypeId::SMALLINT:
+		update_compression_state<int16_t>(state, (int16_t *)values, count, true);
+		break;
+	case TypeId::INTEGER:
+		update_compression_state<int32_t>(state, (int32_t *)values, count, true);
+		break;
+	case TypeId::BIGINT:
+		update_compression_state<int64_t>(state, (int64_t *)values, count, true);
+		break;
+	case TypeId::FLOAT:
+		update_compression_state<float>(state, (float *)values, count, false);
+		break;
+	case TypeId::DOUBLE:
+		update_compression_state<double>(state, (double *)values, count, false);
+		break;
+	default:
+		throw NotImplementedException("Unimplemented type for segment compression");
+	}
+}
+
+bool SegmentCompressor::Append(Vector &new_data, index_t max_size) {
+	auto new_count = new_data.count;
+	if ((count + new_count) * type_size > MAXIMUM_UNCOMPRESSED_SIZE && count > 0) {
+		return false;
+	}
+	if (count + new_count > capacity) {
+		// grow the buffer of uncompressed values
+		auto new_capacity = std::max(capacity * 2, (index_t)STANDARD_VECTOR_SIZE);
+		while (new_capacity < count + new_count) {
+			new_capacity *= 2;
+		}
+		auto new_buffer = unique_ptr<data_t[]>(new data_t[new_capacity * type_size]);
+		if (count > 0) {
+			memcpy(new_buffer.get(), data.get(), count * type_size);
+		}
+		data = move(new_buffer);
+		capacity = new_capacity;
+	}
+	// copy the values (with NULL values stored as the NULL value of the type) to the buffer
+	auto target = data.get() + count * type_size;
+	VectorOperations::CopyToStorage(new_data, target);
+
+	// check if the segment still fits after adding the values
+	auto new_state = state;
+	UpdateCompressionState(new_state, type, target, new_count);
+	index_t compressed_size;
+	GetCompression(new_state, compressed_size);
+	if (count > 0 && compressed_size > max_size) {
+		return false;
+	}
+	state = new_state;
+	count += new_count;
+	return true;
+}
+
+void SegmentCompressor::GetBitpackingWidth(CompressionState &state, index_t &width, uint64_t &null_code) {
+	// the values are stored as their difference with the minimum, the code after the largest difference is NULL
+	uint64_t max_code = state.has_value ? (uint64_t)state.max - (uint64_t)state.min : 0;
+	null_code = max_code + 1;
+	if (state.has_null) {
+		max_code = null_code;
+	}
+	width = 0;
+	while (width < 64 && (max_code >> width) != 0) {
+		width++;
+	}
+}
+
+index_t SegmentCompressor::GetCompressedSize(CompressionState &state, CompressionType compression) {
+	switch (compression) {
+	case CompressionType::UNCOMPRESSED:
+		return state.count * type_size;
+	case CompressionType::CONSTANT:
+		return state.run_count == 1 ? type_size : INVALID_INDEX;
+	case CompressionType::RLE:
+		return RLEValueOffset(state.run_count) + state.run_count * type_size;
+	case CompressionType::BITPACKING: {
+		if (type == TypeId::FLOAT || type == TypeId::DOUBLE) {
+			return INVALID_INDEX;
+		}
+		index_t width;
+		uint64_t null_code;
+		GetBitpackingWidth(state, width, null_code);
+		if (width >= type_size * 8) {
+			return INVALID_INDEX;
+		}
+		return BITPACKING_HEADER_SIZE + (state.count * width + 63) / 64 * sizeof(uint64_t);
+	}
+	default:
+		throw NotImplementedException("Unimplemented compression type");
+	}
+}
+
+index_t SegmentCompressor::GetCompressedSize(CompressionType compression) {
+	return GetCompressedSize(state, compression);
+}
+
+CompressionType SegmentCompressor::GetCompression(CompressionState &state, index_t &size) {
+	// only use a compression if it is strictly smaller than the uncompressed data
+	auto result = CompressionType::UNCOMPRESSED;
+	size = GetCompressedSize(state, result);
+	for (auto compression : {CompressionType::CONSTANT, CompressionType::RLE, CompressionType::BITPACKING}) {
+		auto compressed_size = GetCompressedSize(state, compression);
+		if (compressed_size < size) {
+			result = compression;
+			size = compressed_size;
+		}
+	}
+	return result;
+}
+
+CompressionType SegmentCompressor::GetCompression() {
+	index_t size;
+	return GetCompression(state, size);
+}
+
+template <class T> static void compress_rle(T *values, index_t count, data_ptr_t target, index_t run_count) {
+	*((uint64_t *)target) = run_count;
+	auto run_ends = (uint32_t *)(target + RLE_HEADER_SIZE);
+	auto run_values = (T *)(target + RLEValueOffset(run_count));
+	index_t run_idx = 0;
+	for (index_t i = 0; i < count; i++) {
+		if (i > 0 && memcmp(&values[i], &values[i - 1], sizeof(T)) == 0) {
+			// continue the current run
+			run_ends[run_idx - 1] = i + 1;
+			continue;
+		}
+		run_values[run_idx] = values[i];
+		run_ends[run_idx] = i + 1;
+		run_idx++;
+	}
+	assert(run_idx == run_count);
+}
+
+template <class T>
+static void compress_bitpacking(T *values, index_t count, data_ptr_t target, int64_t frame, index_t width,
+                                uint64_t null_code) {
+	*((int64_t *)target) = frame;
+	*((uint64_t *)(target + sizeof(int64_t))) = width;
+	*((uint64_t *)(target + sizeof(int64_t) + sizeof(uint64_t))) = null_code;
+	auto words = (uint64_t *)(target + BITPACKING_HEADER_SIZE);
+	memset(words, 0, (count * width + 63) / 64 * sizeof(uint64_t));
+	if (width == 0) {
+		return;
+	}
+	for (index_t i = 0; i < count; i++) {
+		uint64_t code = IsNullValue<T>(values[i]) ? null_code : (uint64_t)(int64_t)values[i] - (uint64_t)frame;
+		index_t bit = i * width;
+		index_t word = bit / 64, shift = bit % 64;
+		words[word] |= code << shift;
+		if (shift + width > 64) {
+			// the code is split over two words
+			words[word + 1] |= code >> (64 - shift);
+		}
+	}
+}
+
+template <class T>
+static void compress_values(CompressionType compression, T *values, index_t count, data_ptr_t target,
+                            index_t run_count, int64_t frame, index_t width, uint64_t null_code) {
+	switch (compression) {
+	case CompressionType::RLE:
+		compress_rle<T>(values, count, target, run_count);
+		break;
+	case CompressionType::BITPACKING:
+		compress_bitpacking<T>(values, count, target, frame, width, null_code);
+		break;
+	default:
+		throw NotImplementedException("Unimplemented compression type");
+	}
+}
+
+void SegmentCompressor::Compress(CompressionType compression, data_ptr_t target) {
+	assert(count > 0);
+	assert(GetCompressedSize(compression) != INVALID_INDEX);
+	switch (compression) {
+	case CompressionType::UNCOMPRESSED:
+		memcpy(target, data.get(), count * type_size);
+		return;
+	case CompressionType::CONSTANT:
+		memcpy(target, data.get(), type_size);
+		return;
+	default:
+		break;
+	}
+	index_t width = 0;
+	uint64_t null_code = 0;
+	if (compression == CompressionType::BITPACKING) {
+		GetBitpackingWidth(state, width, null_code);
+	}
+	auto values = data.get();
+	switch (type) {
+	case TypeId::BOOLEAN:
+	case TypeId::TINYINT:
+		compress_values<int8_t>(compression, (int8_t *)values, count, target, state.run_count, state.min, width,
+		                        null_code);
+		break;
+	case TypeId::SMALLINT:
+		compress_values<int16_t>(compression, (int16_t *)values, count, target, state.run_count, state.min, width,
+		                         null_code);
+		break;
+	case TypeId::INTEGER:
+		compress_values<int32_t>(compression, (int32_t *)values, count, target, state.run_count, state.min, width,
+		                         null_code);
+		break;
+	case TypeId::BIGINT:
+		compress_values<int64_t>(compression, (int64_t *)values, count, target, state.run_count, state.min, width,
+		                         null_code);
+		break;
+	case TypeId::FLOAT:
+		compress_values<float>(compression, (float *)values, count, target, state.run_count, state.min, width,
+		                       null_code);
+		break;
+	case TypeId::DOUBLE:
+		compress_values<double>(compression, (double *)values, count, target, state.run_count, state.min, width,
+		                        null_code);
+		break;
+	default:
+		throw NotImplementedException("Unimplemented type for segment compression");
+	}
+}
+
+void SegmentCompressor::Reset() {
+	state = CompressionState();
+	count = 0;
+}
+
+//===--------------------------------------------------------------------===//
+// Decompression
+//===--------------------------------------------------------------------===//
+//! Writes the values at the positions [offset + sel_vector[i]] (or [offset + i] without selection vector) to the end
+//! of the result vector. GET returns the value at a position; the positions are passed in increasing order.
+template <class T, class GET>
+static void decompress_loop(index_t offset, index_t count, sel_t *sel_vector, Vector &result, bool has_null,
+                            GET get) {
+	auto target = ((T *)result.data) + result.count;
+	for (index_t i = 0; i < count; i++) {
+		auto value = get(offset + (sel_vector ? sel_vector[i] : i));
+		target[i] = value;
+		if (has_null && IsNullValue<T>(value)) {
+			result.nullmask[result.count + i] = true;
+		}
+	}
+	result.count += count;
+}
+
+template <class T>
+static void decompress_values(CompressionType compression, data_ptr_t segment_data, index_t offset, index_t count,
+                              sel_t *sel_vector, Vector &result, bool has_null) {
+	switch (compression) {
+	case CompressionType::UNCOMPRESSED: {
+		auto values = (T *)segment_data;
+		decompress_loop<T>(offset, count, sel_vector, result, has_null, [&](index_t position) { return values[position]; });
+		break;
+	}
+	case CompressionType::CONSTANT: {
+		auto value = *((T *)segment_data);
+		decompress_loop<T>(offset, count, sel_vector, result, has_null, [&](index_t position) { return value; });
+		break;
+	}
+	case CompressionType::RLE: {
+		auto run_count = *((uint64_t *)segment_data);
+		auto run_ends = (uint32_t *)(segment_data + RLE_HEADER_SIZE);
+		auto run_values = (T *)(segment_data + RLEValueOffset(run_count));
+		// find the run of the first position, the other runs are found by moving forward
+		index_t run_idx = upper_bound(run_ends, run_ends + run_count, (uint32_t)offset) - run_ends;
+		decompress_loop<T>(offset, count, sel_vector, result, has_null, [&](index_t position) {
+			while (position >= run_ends[run_idx]) {
+				run_idx++;
+			}
+			assert(run_idx < run_count);
+			return run_values[run_idx];
+		});
+		break;
+	}
+	case CompressionType::BITPACKING: {
+		auto frame = *((int64_t *)segment_data);
+		auto width = *((uint64_t *)(segment_data + sizeof(int64_t)));
+		auto null_code = *((uint64_t *)(segment_data + sizeof(int64_t) + sizeof(uint64_t)));
+		auto words = (uint64_t *)(segment_data + BITPACKING_HEADER_SIZE);
+		uint64_t mask = width == 64 ? ~(uint64_t)0 : (((uint64_t)1 << width) - 1);
+		decompress_loop<T>(offset, count, sel_vector, result, has_null, [&](index_t position) {
+			uint64_t code = 0;
+			if (width > 0) {
+				index_t bit = position * width;
+				index_t word = bit / 64, shift = bit % 64;
+				code = words[word] >> shift;
+				if (shift + width > 64) {
+					code |= words[word + 1] << (64 - shift);
+				}
+				code &= mask;
+			}
+			if (code == null_code) {
+				return NullValue<T>();
+			}
+			return (T)(int64_t)((uint64_t)frame + code);
+		});
+		break;
+	}
+	default:
+		throw NotImplementedException("Unimplemented compression type");
+	}
+}
+
+void SegmentCompressor::Decompress(CompressionType compression, data_ptr_t segment_data, index_t offset,
+                                   index_t count, sel_t *sel_vector, Vector &result, bool has_null) {
+	assert(result.count + count <= STANDARD_VECTOR_SIZE);
+	switch (result.type) {
+	case TypeId::BOOLEAN:
+	case TypeId::TINYINT:
+		decompress_values<int8_t>(compression, segment_data, offset, count, sel_vector, result, has_null);
+		break;
+	case TypeId::SMALLINT:
+		decompress_values<int16_t>(compression, segment_data, offset, count, sel_vector, result, has_null);
+		break;
+	case TypeId::INTEGER:
+		decompress_values<int32_t>(compression, segment_data, offset, count, sel_vector, result, has_null);
+		break;
+	case TypeId::BIGINT:
+		decompress_values<int64_t>(compression, segment_data, offset, count, sel_vector, result, has_null);
+		break;
+	case TypeId::FLOAT:
+		decompress_values<float>(compression, segment_data, offset, count, sel_vector, result, has_null);
+		break;
+	case TypeId::DOUBLE:
+		decompress_values<double>(compression, segment_data, offset, count, sel_vector, result, has_null);
+		break;
+	default:
+		throw NotImplementedException("Unimplemented type for segment decompression");
+	}
+}
@@ -5,63 +5,63 @@
 #include "common/types/null_value.hpp"
 #include "storage/checkpoint/table_data_writer.hpp"
 #include "storage/meta_block_reader.hpp"
+#include "planner/table_filter.hpp"
 
 using namespace duckdb;
 using namespace std;
 
-PersistentSegment::PersistentSegment(BlockManager &manager, block_id_t id, index_t offset, TypeId type, index_t start,
-                                     index_t count)
-    : ColumnSegment(type, ColumnSegmentType::PERSISTENT, start, count), manager(manager), block_id(id), offset(offset) {
-	// FIXME
+PersistentSegment::PersistentSegment(BufferManager &manager, block_id_t id, index_t offset, TypeId type, index_t start,
+                                     index_t count, CompressionType compression)
+    : ColumnSegment(type, ColumnSegmentType::PERSISTENT, start, count), manager(manager), block_id(id), offset(offset),
+      compression(compression) {
+	// the statistics are filled in by the TableDataReader, until then we have to assume the segment has NULL values
 	stats.has_null = true;
-}
-
-void PersistentSegment::LoadBlock() {
-	if (block) {
-		// already loaded
-		return;
-	}
-	// load the block
-	lock_guard<mutex> lock(load_lock);
-	if (block) {
-		// loaded in the meantime
-		return;
-	}
-	block = make_unique<Block>(block_id);
-	manager.Read(*block);
 	if (type == TypeId::VARCHAR) {
-		int32_t dictionary_offset = *((int32_t *)(block->buffer + offset));
-		dictionary = block->buffer + offset + dictionary_offset;
-		offset += sizeof(int32_t);
+		// string segments start with the offset of the dictionary, followed by the dictionary codes of the strings
+		this->offset += sizeof(int32_t);
 		type_size = sizeof(int32_t);
 	}
 }
 
+data_ptr_t PersistentSegment::GetData(BufferHandle &handle) {
+	return handle.block->buffer + offset;
+}
+
 void PersistentSegment::Scan(ColumnPointer &pointer, Vector &result, index_t count) {
-	LoadBlock();
+	auto handle = manager.Pin(block_id);
+	if (type != TypeId::VARCHAR) {
+		SegmentCompressor::Decompress(compression, GetData(*handle), pointer.offset, count, nullptr, result,
+		                              stats.has_null);
+		pointer.offset += count;
+		return;
+	}
 
-	data_ptr_t dataptr = block->buffer + offset + pointer.offset * type_size;
+	data_ptr_t dataptr = GetData(*handle) + pointer.offset * type_size;
 	Vector source(type, dataptr);
 	source.count = count;
-	AppendFromStorage(source, result, stats.has_null);
+	AppendFromStorage(*handle, source, result, stats.has_null);
 	pointer.offset += count;
 }
 
 void PersistentSegment::Scan(ColumnPointer &pointer, Vector &result, index_t count, sel_t *sel_vector,
                              index_t sel_count) {
-	LoadBlock();
+	auto handle = manager.Pin(block_id);
+	if (type != TypeId::VARCHAR) {
+		SegmentCompressor::Decompress(compression, GetData(*handle), pointer.offset, sel_count, sel_vector, result,
+		                              stats.has_null);
+		pointer.offset += count;
+		return;
+	}
 
-	data_ptr_t dataptr = block->buffer + offset + pointer.offset * type_size;
+	data_ptr_t dataptr = GetData(*handle) + pointer.offset * type_size;
 	Vector source(type, dataptr);
 	source.count = sel_count;
 	source.sel_vector = sel_vector;
-	AppendFromStorage(source, result, stats.has_null);
+	AppendFromStorage(*handle, source, result, stats.has_null);
 	pointer.offset += count;
 }
 
 void PersistentSegment::Fetch(Vector &result, index_t row_id) {
-	LoadBlock();
-
 	assert(row_id >= start);
 	if (row_id >= start + count) {
 		assert(next);
@@ -69,10 +69,17 @@ void PersistentSegment::Fetch(Vector &result, index_t row_id) {
 		next_segment.Fetch(result, row_id);
 		return;
 	}
-	data_ptr_t dataptr = block->buffer + (row_id - start) * type_size;
+	auto handle = manager.Pin(block_id);
+	if (type != TypeId::VARCHAR) {
+		SegmentCompressor::Decompress(compression, GetData(*handle), row_id - start, 1, nullptr, result,
+		                              stats.has_null);
+		return;
+	}
+
+	data_ptr_t dataptr = GetData(*handle) + (row_id - start) * type_size;
 	Vector source(type, dataptr);
 	source.count = 1;
-	AppendFromStorage(source, result, stats.has_null);
+	AppendFromStorage(*handle, source, result, stats.has_null);
 }
 
 template <class T, bool HAS_NULL>
@@ -87,47 +94,162 @@ static void append_function(T *__restrict source, T *__restrict target, index_t
 	});
 }
 
-template <bool HAS_NULL> void PersistentSegment::AppendStrings(Vector &source, Vector &target) {
-	auto offsets = (int32_t *)source.data;
+//! Returns the string with the given code from the dictionary
+static const char *GetDictionaryString(data_ptr_t dictionary, int32_t code) {
+	auto entry_count = *((uint32_t *)dictionary);
+	auto string_offsets = (uint32_t *)(dictionary + sizeof(uint32_t));
+	auto string_data = (const char *)(string_offsets + entry_count);
+	assert((uint32_t)code < entry_count);
+	return string_data + string_offsets[code];
+}
+
+//! Returns the big string block id if the string is a big string marker, or INVALID_BLOCK otherwise
+static block_id_t GetBigStringBlock(const char *str_val) {
+	if (*str_val != TableDataWriter::BIG_STRING_MARKER[0]) {
+		return INVALID_BLOCK;
+	}
+	return *((block_id_t *)(str_val + 2 * sizeof(char)));
+}
+
+data_ptr_t PersistentSegment::GetDictionary(BufferHandle &handle) {
+	assert(type == TypeId::VARCHAR);
+	auto base_ptr = handle.block->buffer + offset - sizeof(int32_t);
+	return base_ptr + *((int32_t *)base_ptr);
+}
+
+bool PersistentSegment::LoadDictionary(BufferHandle &handle) {
+	lock_guard<mutex> lock(heap_lock);
+	if (!dictionary_loaded) {
+		dictionary_loaded = true;
+		auto dictionary_ptr = GetDictionary(handle);
+		index_t entry_count = *((uint32_t *)dictionary_ptr);
+		if (entry_count <= MAXIMUM_DECODED_DICTIONARY_SIZE) {
+			// small dictionary: decode all the strings into the heap of the segment
+			for (index_t code = 0; code < entry_count; code++) {
+				auto str_val = GetDictionaryString(dictionary_ptr, code);
+				auto big_string_block = GetBigStringBlock(str_val);
+				if (big_string_block != INVALID_BLOCK) {
+					dictionary.push_back(ReadBigString(big_string_block));
+				} else if (IsNullValue<const char *>(str_val)) {
+					dictionary.push_back(NullValue<const char *>());
+				} else {
+					dictionary.push_back(heap.AddString(str_val));
+				}
+			}
+		}
+	}
+	// the dictionary is never modified after it is loaded, so it can be read without holding the lock
+	return dictionary.size() > 0;
+}
+
+template <bool HAS_NULL>
+void PersistentSegment::AppendStrings(BufferHandle &handle, Vector &source, Vector &target) {
+	auto codes = (int32_t *)source.data;
 	auto target_strings = (const char **)target.data;
-	VectorOperations::Exec(source, [&](index_t i, index_t k) {
-		const char *str_val = (const char *)(dictionary + offsets[i]);
-		if (*str_val == TableDataWriter::BIG_STRING_MARKER[0]) {
-			// big string, load from block if not loaded yet
-			auto block_id = *((block_id_t *)(str_val + 2 * sizeof(char)));
-			target_strings[target.count + k] = GetBigString(block_id);
-		} else if (HAS_NULL && IsNullValue<const char *>(str_val)) {
-			target.nullmask[target.count + k] = true;
-		} else {
+	if (LoadDictionary(handle)) {
+		// decoded dictionary: the strings are shared with the segment
+		VectorOperations::Exec(source, [&](index_t i, index_t k) {
+			auto str_val = dictionary[codes[i]];
 			target_strings[target.count + k] = str_val;
-		}
-	});
+			if (HAS_NULL && IsNullValue<const char *>(str_val)) {
+				target.nullmask[target.count + k] = true;
+			}
+		});
+	} else {
+		auto dictionary_ptr = GetDictionary(handle);
+		VectorOperations::Exec(source, [&](index_t i, index_t k) {
+			auto str_val = GetDictionaryString(dictionary_ptr, codes[i]);
+			auto big_string_block = GetBigStringBlock(str_val);
+			if (big_string_block != INVALID_BLOCK) {
+				// big string, load from block if not loaded yet
+				target_strings[target.count + k] = GetBigString(big_string_block);
+			} else if (HAS_NULL && IsNullValue<const char *>(str_val)) {
+				target.nullmask[target.count + k] = true;
+			} else {
+				// the block can be evicted after the scan: copy the string into the heap of the target vector
+				target_strings[target.count + k] = target.string_heap.AddString(str_val);
+			}
+		});
+	}
 	target.count += source.count;
 }
 
-void PersistentSegment::AppendFromStorage(Vector &source, Vector &target, bool has_null) {
-	if (source.type == TypeId::VARCHAR) {
-		// varchar vector: load data from dictionary
-		if (has_null) {
-			AppendStrings<true>(source, target);
-		} else {
-			AppendStrings<false>(source, target);
-		}
+void PersistentSegment::AppendFromStorage(BufferHandle &handle, Vector &source, Vector &target, bool has_null) {
+	// varchar vector: load data from dictionary
+	assert(source.type == TypeId::VARCHAR);
+	if (has_null) {
+		AppendStrings<true>(handle, source, target);
 	} else {
-		VectorOperations::AppendFromStorage(source, target, has_null);
+		AppendStrings<false>(handle, source, target);
 	}
 }
 
+//! Evaluates the comparison of the table filter on a string
+static bool CompareString(const char *str_val, const TableFilter &filter) {
+	if (IsNullValue<const char *>(str_val)) {
+		return false;
+	}
+	auto cmp = strcmp(str_val, filter.constant.str_value.c_str());
+	switch (filter.comparison_type) {
+	case ExpressionType::COMPARE_EQUAL:
+		return cmp == 0;
+	case ExpressionType::COMPARE_GREATERTHAN:
+		return cmp > 0;
+	case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+		return cmp >= 0;
+	case ExpressionType::COMPARE_LESSTHAN:
+		return cmp < 0;
+	case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		return cmp <= 0;
+	default:
+		throw NotImplementedException("Unsupported comparison type for table filter");
+	}
+}
+
+void PersistentSegment::Prefetch() {
+	manager.Prefetch(block_id);
+}
+
+bool PersistentSegment::Filter(ColumnPointer &pointer, const TableFilter &filter, sel_t sel_vector[],
+                               index_t &sel_count) {
+	if (type != TypeId::VARCHAR || filter.constant.type != TypeId::VARCHAR) {
+		return false;
+	}
+	auto handle = manager.Pin(block_id);
+	if (!LoadDictionary(*handle)) {
+		return false;
+	}
+	// evaluate the filter on the codes: the comparison is only performed once for every distinct code
+	auto codes = (int32_t *)GetData(*handle) + pointer.offset;
+	int8_t matches[MAXIMUM_DECODED_DICTIONARY_SIZE];
+	memset(matches, -1, dictionary.size());
+	index_t result_count = 0;
+	for (index_t i = 0; i < sel_count; i++) {
+		auto code = codes[sel_vector[i]];
+		if (matches[code] < 0) {
+			matches[code] = CompareString(dictionary[code], filter);
+		}
+		if (matches[code]) {
+			sel_vector[result_count++] = sel_vector[i];
+		}
+	}
+	sel_count = result_count;
+	return true;
+}
+
 const char *PersistentSegment::GetBigString(block_id_t block_id) {
-	lock_guard<mutex> lock(load_lock);
+	lock_guard<mutex> lock(heap_lock);
+	return ReadBigString(block_id);
+}
 
+const char *PersistentSegment::ReadBigString(block_id_t block_id) {
 	// check if the big string was already read from disk
 	auto entry = big_strings.find(block_id);
 	if (entry != big_strings.end()) {
 		return entry->second;
 	}
 	// the big string was not read yet: read it from disk
-	MetaBlockReader reader(manager, block_id);
+	MetaBlockReader reader(manager.GetBlockManager(), block_id);
 	auto read_string = reader.Read<string>();
 	// add it to the string heap
 	auto big_string = heap.AddString(read_string);
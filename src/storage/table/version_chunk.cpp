@@ -2,16 +2,30 @@
 #include "common/exception.hpp"
 #include "common/helper.hpp"
 #include "common/vector_operations/vector_operations.hpp"
+#include "main/database.hpp"
 #include "storage/data_table.hpp"
+#include "storage/storage_manager.hpp"
 #include "transaction/transaction.hpp"
+#include "transaction/transaction_manager.hpp"
 #include "transaction/version_info.hpp"
 #include "storage/table/transient_segment.hpp"
 
+#include <algorithm>
+
 using namespace duckdb;
 using namespace std;
 
 VersionChunk::VersionChunk(VersionChunkType type, DataTable &base_table, index_t start)
     : SegmentBase(start, 0), type(type), table(base_table) {
+	for (index_t i = 0; i < STORAGE_CHUNK_VECTORS; i++) {
+		version_data[i] = nullptr;
+	}
+}
+
+VersionChunk::~VersionChunk() {
+	for (index_t i = 0; i < STORAGE_CHUNK_VECTORS; i++) {
+		delete version_data[i].load();
+	}
 }
 
 index_t VersionChunk::GetVersionIndex(index_t index) {
@@ -21,7 +35,7 @@ index_t VersionChunk::GetVersionIndex(index_t index) {
 
 VersionInfo *VersionChunk::GetVersionInfo(index_t index) {
 	index_t version_index = GetVersionIndex(index);
-	auto version = version_data[version_index];
+	VersionChunkInfo *version = version_data[version_index];
 	if (!version) {
 		return nullptr;
 	}
@@ -38,10 +52,12 @@ void VersionChunk::SetDeleted(index_t index) {
 
 VersionChunkInfo *VersionChunk::GetOrCreateVersionInfo(index_t version_index) {
 	assert(version_index < STORAGE_CHUNK_VECTORS);
-	if (!version_data[version_index]) {
-		version_data[version_index] = make_shared<VersionChunkInfo>(*this, version_index * STANDARD_VECTOR_SIZE);
+	VersionChunkInfo *version = version_data[version_index];
+	if (!version) {
+		version = new VersionChunkInfo(*this, version_index * STANDARD_VECTOR_SIZE);
+		version_data[version_index] = version;
 	}
-	return version_data[version_index].get();
+	return version;
 }
 
 void VersionChunk::PushDeletedEntries(Transaction &transaction, index_t amount) {
@@ -91,14 +107,7 @@ void VersionChunk::PushTuple(Transaction &transaction, UndoFlags flag, index_t o
 	meta->entry = offset_in_version;
 	meta->vinfo = version;
 
-	meta->prev = nullptr;
-	meta->next = version->version_pointers[offset_in_version];
-	version->version_pointers[offset_in_version] = meta;
-
-	if (meta->next) {
-		meta->next->prev = meta;
-	}
-
+	// copy the current tuple data into the version
 	DataChunk chunk;
 	chunk.Initialize(table.types);
 
@@ -114,6 +123,14 @@ void VersionChunk::PushTuple(Transaction &transaction, UndoFlags flag, index_t o
 		VectorOperations::Scatter::SetAll(chunk.data[i], target);
 		target_locations[0] += columns[i].segment->type_size;
 	}
+
+	// now link the version into the version chain of the tuple, concurrent scans can see it from here on
+	meta->prev = nullptr;
+	meta->next = version->version_pointers[offset_in_version];
+	if (meta->next) {
+		meta->next->prev = meta;
+	}
+	version->version_pointers[offset_in_version] = meta;
 }
 
 void VersionChunk::RetrieveTupleFromBaseTable(DataChunk &result, vector<column_t> &column_ids, row_t row_id) {
@@ -183,14 +200,14 @@ void VersionChunk::RetrieveTupleData(Transaction &transaction, DataChunk &result
                                      index_t offset) {
 	// check if this tuple is versioned
 	index_t version_index = GetVersionIndex(offset);
-	auto version = version_data[version_index];
+	VersionChunkInfo *version = version_data[version_index];
 	if (!version) {
 		// not versioned, retrieve base data
 		RetrieveTupleFromBaseTable(result, column_ids, start + offset);
 		return;
 	}
 	index_t index_in_version = offset % STANDARD_VECTOR_SIZE;
-	auto root_info = version->version_pointers[index_in_version];
+	VersionInfo *root_info = version->version_pointers[index_in_version];
 	auto version_info = VersionInfo::GetVersionForTransaction(transaction, root_info);
 	if (version_info) {
 		if (version_info->tuple_data) {
@@ -230,13 +247,23 @@ void VersionChunk::RetrieveColumnData(ColumnPointer &pointer, Vector &result, in
 
 void VersionChunk::RetrieveColumnData(ColumnPointer &pointer, Vector &result, index_t count, sel_t *sel_vector,
                                       index_t sel_count) {
+	// the entries of the (sorted) selection vector are relative to the start of the scan
+	// if the scan spans multiple column segments, we have to split up the selection vector over the segments
+	index_t segment_start = 0, sel_idx = 0;
+	sel_t segment_sel[STANDARD_VECTOR_SIZE];
 	// copy data from the column storage
 	while (count > 0) {
 		// check how much we can copy from this column segment
 		index_t to_copy = std::min(count, pointer.segment->count - pointer.offset);
 		if (to_copy > 0) {
-			// we can copy everything from this column segment, copy with the sel vector
-			pointer.segment->Scan(pointer, result, to_copy, sel_vector, sel_count);
+			// figure out which entries of the selection vector belong to this column segment
+			index_t segment_count = 0;
+			while (sel_idx < sel_count && sel_vector[sel_idx] < segment_start + to_copy) {
+				segment_sel[segment_count++] = sel_vector[sel_idx++] - segment_start;
+			}
+			// copy the selected entries from the column segment
+			pointer.segment->Scan(pointer, result, to_copy, segment_sel, segment_count);
+			segment_start += to_copy;
 			count -= to_copy;
 		}
 		if (count > 0) {
@@ -248,10 +275,146 @@ void VersionChunk::RetrieveColumnData(ColumnPointer &pointer, Vector &result, in
 	}
 }
 
+//! Compares the vector with the constant of the table filter, and writes the entries that pass the filter to
+//! result_sel. Returns the amount of entries that passed the filter.
+static index_t ApplyTableFilter(Vector &input, const TableFilter &filter, sel_t result_sel[]) {
+	Vector constant(filter.constant);
+	Vector result(TypeId::BOOLEAN, true, false);
+	switch (filter.comparison_type) {
+	case ExpressionType::COMPARE_EQUAL:
+		VectorOperations::Equals(input, constant, result);
+		break;
+	case ExpressionType::COMPARE_GREATERTHAN:
+		VectorOperations::GreaterThan(input, constant, result);
+		break;
+	case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+		VectorOperations::GreaterThanEquals(input, constant, result);
+		break;
+	case ExpressionType::COMPARE_LESSTHAN:
+		VectorOperations::LessThan(input, constant, result);
+		break;
+	case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		VectorOperations::LessThanEquals(input, constant, result);
+		break;
+	default:
+		throw NotImplementedException("Unsupported comparison type for table filter");
+	}
+	auto result_data = (bool *)result.data;
+	index_t result_count = 0;
+	VectorOperations::Exec(result, [&](index_t i, index_t k) {
+		if (result_data[i] && !result.nullmask[i]) {
+			result_sel[result_count++] = i;
+		}
+	});
+	return result_count;
+}
+
+index_t VersionChunk::FilterColumnData(TableScanState &state, const vector<column_t> &column_ids,
+                                       const vector<TableFilter> &table_filters, index_t scan_count,
+                                       sel_t sel_vector[], index_t count) {
+	for (auto &filter : table_filters) {
+		if (count == 0) {
+			break;
+		}
+		auto column_id = column_ids[filter.column_index];
+		assert(column_id != COLUMN_IDENTIFIER_ROW_ID);
+		// fetch the filter column without advancing the scan, the remaining tuples are fetched afterwards
+		ColumnPointer pointer = state.columns[column_id];
+		if (pointer.segment->count - pointer.offset >= scan_count &&
+		    pointer.segment->Filter(pointer, filter, sel_vector, count)) {
+			// the segment evaluated the filter on its stored data (e.g. on the codes of a string dictionary)
+			continue;
+		}
+		Vector filter_data(table.types[column_id], true, false);
+		RetrieveColumnData(pointer, filter_data, scan_count);
+		// evaluate the filter only on the tuples that passed the previous filters
+		filter_data.sel_vector = sel_vector;
+		filter_data.count = count;
+		count = ApplyTableFilter(filter_data, filter, sel_vector);
+	}
+	return count;
+}
+
+index_t VersionChunk::FilterVersionedData(const vector<column_t> &column_ids, const vector<TableFilter> &table_filters,
+                                          data_ptr_t alternate_version_pointers[], index_t alternate_version_index[],
+                                          index_t alternate_version_count) {
+	for (auto &filter : table_filters) {
+		if (alternate_version_count == 0) {
+			break;
+		}
+		auto column_id = column_ids[filter.column_index];
+		// gather the filter column from the tuple versions
+		Vector version_pointers(TypeId::POINTER, (data_ptr_t)alternate_version_pointers);
+		version_pointers.count = alternate_version_count;
+		Vector filter_data(table.types[column_id], true, false);
+		VectorOperations::Gather::Append(version_pointers, filter_data, table.accumulative_tuple_size[column_id]);
+		// evaluate the filter and only keep the versions that pass it
+		sel_t filter_sel[STANDARD_VECTOR_SIZE];
+		alternate_version_count = ApplyTableFilter(filter_data, filter, filter_sel);
+		for (index_t i = 0; i < alternate_version_count; i++) {
+			alternate_version_pointers[i] = alternate_version_pointers[filter_sel[i]];
+			alternate_version_index[i] = alternate_version_index[filter_sel[i]];
+		}
+	}
+	return alternate_version_count;
+}
+
 bool VersionChunk::Scan(TableScanState &state, Transaction &transaction, DataChunk &result,
-                        const vector<column_t> &column_ids, index_t version_index) {
-	// obtain a shared lock on this chunk
-	auto shared_lock = lock.GetSharedLock();
+                        const vector<column_t> &column_ids, index_t version_index,
+                        const vector<TableFilter> &table_filters) {
+	// the version info is read without locking the chunk: it is only kept alive for transactions with an active query
+	assert(transaction.active_query != MAXIMUM_QUERY_ID);
+	// remember the position of the scan, so the vector can be scanned again if the chunk is modified concurrently
+	index_t column_count = table.types.size();
+	vector<ColumnPointer> scan_columns(state.columns.get(), state.columns.get() + column_count);
+	index_t result_count = result.size();
+	while (true) {
+		// scan the vector without locking the chunk
+		index_t version = lock.StartOptimisticRead();
+		bool clean = false;
+		bool finished = ScanVector(state, transaction, result, column_ids, version_index, table_filters, clean);
+		if (lock.ValidateOptimisticRead(version)) {
+			if (clean) {
+				// the scan was clean: remove the version info
+				RemoveVersionInfo(version_index);
+			}
+			return finished;
+		}
+		// the chunk was modified while we were scanning it: discard the result and scan the vector again
+		for (index_t i = 0; i < column_count; i++) {
+			state.columns[i] = scan_columns[i];
+		}
+		for (index_t i = 0; i < result.column_count; i++) {
+			result.data[i].count = result_count;
+		}
+	}
+}
+
+void VersionChunk::RemoveVersionInfo(index_t version_index) {
+	// don't wait for concurrent writers: the version info is removed by a later scan instead
+	auto write_lock = lock.TryGetExclusiveLock();
+	if (!write_lock) {
+		return;
+	}
+	// check that the vector is still clean now that we hold the lock
+	VersionChunkInfo *version = version_data[version_index];
+	if (!version) {
+		return;
+	}
+	index_t vector_count = std::min((index_t)STANDARD_VECTOR_SIZE, this->count - version->start);
+	for (index_t i = 0; i < vector_count; i++) {
+		if (version->deleted[i] || version->version_pointers[i]) {
+			return;
+		}
+	}
+	version_data[version_index] = nullptr;
+	// concurrent scans can still be reading the version info: the transaction manager deletes it once they are done
+	table.storage.GetDatabase().transaction_manager->AddVersionChunkInfo(unique_ptr<VersionChunkInfo>(version));
+}
+
+bool VersionChunk::ScanVector(TableScanState &state, Transaction &transaction, DataChunk &result,
+                              const vector<column_t> &column_ids, index_t version_index,
+                              const vector<TableFilter> &table_filters, bool &clean) {
 	// now figure out how many tuples to scan in this chunk
 	index_t scan_start = version_index * STANDARD_VECTOR_SIZE;
 	index_t end = this == state.last_chunk ? state.last_chunk_count : this->count;
@@ -264,7 +427,7 @@ bool VersionChunk::Scan(TableScanState &state, Transaction &transaction, DataChu
 	index_t regular_count = 0, version_count = 0;
 
 	// if the segment is dirty we need to scan the version pointers and deleted flags
-	auto vdata = version_data[version_index];
+	VersionChunkInfo *vdata = version_data[version_index];
 	if (vdata) {
 		// start scanning the chunk to check for deleted and version pointers
 		for (index_t i = 0; i < scan_count; i++) {
@@ -274,23 +437,23 @@ bool VersionChunk::Scan(TableScanState &state, Transaction &transaction, DataChu
 			version_count += has_version;
 			regular_count += !(is_deleted || has_version);
 		}
-		if (regular_count == scan_count && (scan_count == STANDARD_VECTOR_SIZE || end == this->count)) {
-			// the scan was clean: delete the version_data
-			version_data[version_index] = nullptr;
-		}
+		// the version info can be removed if the scan was clean
+		clean = regular_count == scan_count && (scan_count == STANDARD_VECTOR_SIZE || end == this->count);
 	} else {
 		// no deleted entries or version information: just scan everything
 		regular_count = scan_count;
 	}
 
-	if (regular_count < scan_count) {
+	bool has_selection = regular_count < scan_count;
+	if (has_selection) {
 		// there are versions! chase the version pointers
 		data_ptr_t alternate_version_pointers[STANDARD_VECTOR_SIZE];
 		index_t alternate_version_index[STANDARD_VECTOR_SIZE];
 		index_t alternate_version_count = 0;
 
+		index_t base_count = regular_count;
 		for (index_t i = 0; i < version_count; i++) {
-			auto root_info = vdata->version_pointers[version_entries[i]];
+			VersionInfo *root_info = vdata->version_pointers[version_entries[i]];
 			// follow the version chain for this version
 			auto version_info = VersionInfo::GetVersionForTransaction(transaction, root_info);
 			if (!version_info) {
@@ -308,15 +471,36 @@ bool VersionChunk::Scan(TableScanState &state, Transaction &transaction, DataChu
 				}
 			}
 		}
+		if (regular_count > base_count) {
+			// base table entries were added for versioned tuples: keep the selection vector sorted
+			sort(regular_entries, regular_entries + regular_count);
+		}
+		if (alternate_version_count > 0 && table_filters.size() > 0) {
+			alternate_version_count = FilterVersionedData(column_ids, table_filters, alternate_version_pointers,
+			                                              alternate_version_index, alternate_version_count);
+		}
 		if (alternate_version_count > 0) {
 			// retrieve alternate versions, if any
 			table.RetrieveVersionedData(result, column_ids, alternate_version_pointers, alternate_version_index,
 			                            alternate_version_count);
 		}
+	}
+	if (table_filters.size() > 0) {
+		// evaluate the table filters on the filter columns first, so only the qualifying tuples are fetched
+		if (!has_selection) {
+			for (index_t i = 0; i < scan_count; i++) {
+				regular_entries[i] = i;
+			}
+		}
+		regular_count =
+		    FilterColumnData(state, column_ids, table_filters, scan_count, regular_entries, regular_count);
+		has_selection = regular_count < scan_count;
+	}
+	if (has_selection) {
 		// retrieve entries from the base table with the selection vector
 		FetchColumnData(state, result, column_ids, scan_start, scan_count, regular_entries, regular_count);
 	} else {
-		// no versions or deleted tuples, simply scan the column segments
+		// no versions, deleted or filtered tuples, simply scan the column segments
 		FetchColumnData(state, result, column_ids, scan_start, regular_count);
 	}
 	return scan_start + scan_count == end;
@@ -365,7 +549,7 @@ bool VersionChunk::CreateIndexScan(IndexTableScanState &state, vector<column_t>
 		index_t regular_count = 0;
 		index_t scan_count = min((index_t)STANDARD_VECTOR_SIZE, this->count - state.offset);
 		index_t version_index = GetVersionIndex(state.offset);
-		auto version = version_data[version_index];
+		VersionChunkInfo *version = version_data[version_index];
 		if (version) {
 			// this chunk is versioned, scan to see which tuples are deleted
 			for (index_t i = 0; i < scan_count; i++) {
@@ -395,7 +579,7 @@ bool VersionChunk::CreateIndexScan(IndexTableScanState &state, vector<column_t>
 	index_t result_count = 0;
 	// the base table was exhausted, now scan any remaining version chunks
 	while (state.version_index < max_version_index && result_count < STANDARD_VECTOR_SIZE) {
-		auto version = version_data[state.version_index];
+		VersionChunkInfo *version = version_data[state.version_index];
 		if (!version) {
 			state.version_index++;
 			continue;
@@ -4,6 +4,9 @@ using namespace duckdb;
 using namespace std;
 
 VersionChunkInfo::VersionChunkInfo(VersionChunk &chunk, index_t start) : chunk(chunk), start(start) {
+	for (index_t i = 0; i < STANDARD_VECTOR_SIZE; i++) {
+		version_pointers[i] = nullptr;
+	}
 }
 
 void VersionChunkInfo::Cleanup(VersionInfo *info) {
@@ -19,6 +22,9 @@ void VersionChunkInfo::Undo(VersionInfo *info) {
 	assert(version_pointers[entry] == info);
 	if (!info->tuple_data) {
 		deleted[entry] = true;
+	} else if (chunk.type == VersionChunkType::PERSISTENT) {
+		// persistent chunks are never updated in-place, the base table still holds the original data
+		deleted[entry] = false;
 	} else {
 		// move data back to the original chunk
 		deleted[entry] = false;
@@ -0,0 +1,80 @@
+#include "storage/temporary_file.hpp"
+
+#include "common/file_system.hpp"
+#include "common/serializer/buffered_file_reader.hpp"
+#include "common/serializer/buffered_file_writer.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TemporaryDirectory::TemporaryDirectory(FileSystem &fs, string path)
+    : fs(fs), path(path), created_directory(false), file_index(0) {
+}
+
+TemporaryDirectory::~TemporaryDirectory() {
+	// only remove the directory if we created it ourselves
+	if (created_directory) {
+		try {
+			fs.RemoveDirectory(path);
+		} catch (...) {
+		}
+	}
+}
+
+string TemporaryDirectory::CreateFilePath() {
+	lock_guard<mutex> directory_lock(lock);
+	if (!fs.DirectoryExists(path)) {
+		fs.CreateDirectory(path);
+		created_directory = true;
+	}
+	// make the file name unique between multiple database instances using the same directory
+	auto file_name = "duckdb_temp_" + to_string((uint64_t)this) + "_" + to_string(file_index++);
+	return fs.JoinPath(path, file_name);
+}
+
+TemporaryFile::TemporaryFile(TemporaryDirectory &directory)
+    : count(0), fs(directory.fs), path(directory.CreateFilePath()), chunks_written(0), chunks_read(0) {
+	writer = make_unique<BufferedFileWriter>(fs, path.c_str());
+}
+
+TemporaryFile::~TemporaryFile() {
+	writer.reset();
+	reader.reset();
+	try {
+		fs.RemoveFile(path);
+	} catch (...) {
+	}
+}
+
+void TemporaryFile::Append(DataChunk &chunk) {
+	assert(writer);
+	if (chunk.size() == 0) {
+		return;
+	}
+	chunk.Serialize(*writer);
+	count += chunk.size();
+	chunks_written++;
+}
+
+bool TemporaryFile::Scan(DataChunk &result) {
+	if (writer) {
+		// first scan: finish writing the file
+		writer->Flush();
+		writer.reset();
+	}
+	if (!reader) {
+		reader = make_unique<BufferedFileReader>(fs, path.c_str());
+	}
+	if (chunks_read >= chunks_written) {
+		// exhausted the file
+		return false;
+	}
+	result.Deserialize(*reader);
+	chunks_read++;
+	return true;
+}
+
+void TemporaryFile::Rewind() {
+	reader.reset();
+	chunks_read = 0;
+}
@@ -1,138 +1,358 @@
 #include "storage/write_ahead_log.hpp"
 #include "common/serializer/buffered_file_reader.hpp"
 
+#include "parser/parsed_data/create_sequence_info.hpp"
+#include "parser/parsed_data/create_table_info.hpp"
+#include "parser/parsed_data/create_view_info.hpp"
 #include "parser/parsed_data/drop_info.hpp"
 
+#include <list>
+#include <thread>
+
 using namespace duckdb;
 using namespace std;
 
+//! The maximum amount of entries in a batch of decoded WAL entries. Transactions that are larger than this are handed
+//! to the replay in multiple (incomplete) batches.
+#define MAXIMUM_REPLAY_BATCH_SIZE 1024
+//! The maximum amount of decoded batches that are queued up for the replay
+#define MAXIMUM_QUEUED_REPLAY_BATCHES 4
+
+//! A decoded entry of the WAL
+struct WALEntry {
+	WALEntry(WALType type) : type(type), usage_count(0), counter(0) {
+	}
+
+	WALType type;
+	//! The schema and name of the catalog entry the entry refers to
+	string schema;
+	string name;
+	//! The info of CREATE TABLE/VIEW/SEQUENCE entries
+	unique_ptr<CreateTableInfo> table_info;
+	unique_ptr<CreateViewInfo> view_info;
+	unique_ptr<CreateSequenceInfo> sequence_info;
+	//! The value of SEQUENCE_VALUE entries
+	uint64_t usage_count;
+	int64_t counter;
+	//! The data of INSERT/DELETE/UPDATE entries
+	unique_ptr<DataChunk> chunk;
+	//! The query of QUERY entries
+	string query;
+};
+
+//! A batch of decoded WAL entries that belong to the same transaction
+struct ReplayBatch {
+	vector<unique_ptr<WALEntry>> entries;
+	//! Whether or not the transaction commits after the entries of this batch have been replayed
+	bool commit = false;
+	//! Whether or not the batch contains the entire transaction. The transaction is then known to be committed in the
+	//! WAL, which allows its inserts to be appended to the tables as committed rows directly.
+	bool complete = false;
+};
+
+//! The ReplayDecoder reads and decodes the entries of the WAL in a background thread, while the previously decoded
+//! entries are replayed
+class ReplayDecoder {
+public:
+	ReplayDecoder(FileSystem &fs, string &path);
+	~ReplayDecoder();
+
+	//! Whether or not the WAL is empty
+	bool IsEmpty() {
+		return empty;
+	}
+	//! Start decoding the WAL in the background thread
+	void Start();
+	//! Returns the next decoded batch, or nullptr if there are no batches left. If the end of the WAL could not be
+	//! decoded, the error is stored in the decoder.
+	unique_ptr<ReplayBatch> NextBatch();
+
+	//! The error that occurred while decoding the WAL, if any
+	string error;
+
+private:
+	void DecodeEntries();
+	unique_ptr<WALEntry> DecodeEntry(WALType type);
+	//! Queue a batch for the replay, returns false if the decoder was cancelled
+	bool PushBatch(unique_ptr<ReplayBatch> batch);
+
+	BufferedFileReader reader;
+	bool empty;
+
+	std::thread decode_thread;
+	std::mutex lock;
+	std::condition_variable cv;
+	//! The decoded batches that have not been replayed yet
+	list<unique_ptr<ReplayBatch>> batches;
+	//! Whether or not the decoder has finished reading the WAL
+	bool finished;
+	//! Whether or not the replay stopped early, in which case the decoder stops reading the WAL
+	bool cancelled;
+};
+
 class ReplayState {
 public:
-	ReplayState(DuckDB &db, ClientContext &context, Deserializer &source)
-	    : db(db), context(context), source(source), current_table(nullptr) {
+	ReplayState(DuckDB &db, ClientContext &context) : db(db), context(context), current_table(nullptr) {
 	}
 
 	DuckDB &db;
 	ClientContext &context;
-	Deserializer &source;
 	TableCatalogEntry *current_table;
 
 public:
-	void ReplayEntry(WALType entry_type);
+	//! Replay an entry. If committed is true, the transaction of the entry is known to commit.
+	void ReplayEntry(WALEntry &entry, bool committed);
 
 private:
-	void ReplayCreateTable();
-	void ReplayDropTable();
+	void ReplayCreateTable(WALEntry &entry);
+	void ReplayDropTable(WALEntry &entry);
 
-	void ReplayCreateView();
-	void ReplayDropView();
+	void ReplayCreateView(WALEntry &entry);
+	void ReplayDropView(WALEntry &entry);
 
-	void ReplayCreateSchema();
-	void ReplayDropSchema();
+	void ReplayCreateSchema(WALEntry &entry);
+	void ReplayDropSchema(WALEntry &entry);
 
-	void ReplayCreateSequence();
-	void ReplayDropSequence();
-	void ReplaySequenceValue();
+	void ReplayCreateSequence(WALEntry &entry);
+	void ReplayDropSequence(WALEntry &entry);
+	void ReplaySequenceValue(WALEntry &entry);
 
-	void ReplayUseTable();
-	void ReplayInsert();
-	void ReplayDelete();
-	void ReplayUpdate();
+	void ReplayUseTable(WALEntry &entry);
+	void ReplayInsert(WALEntry &entry, bool committed);
+	void ReplayDelete(WALEntry &entry);
+	void ReplayUpdate(WALEntry &entry);
 
-	void ReplayQuery();
+	void ReplayQuery(WALEntry &entry);
 };
 
 void WriteAheadLog::Replay(DuckDB &database, string &path) {
-	BufferedFileReader reader(*database.file_system, path.c_str());
-
-	if (reader.Finished()) {
+	ReplayDecoder decoder(*database.file_system, path);
+	if (decoder.IsEmpty()) {
 		// WAL is empty
 		return;
 	}
+	// start decoding the WAL in the background
+	decoder.Start();
 
 	ClientContext context(database);
 	context.transaction.SetAutoCommit(false);
 	context.transaction.BeginTransaction();
 
-	ReplayState state(database, context, reader);
+	ReplayState state(database, context);
 
 	// replay the WAL
 	// note that everything is wrapped inside a try/catch block here
 	// there can be errors in WAL replay because of a corrupt WAL file
 	// in this case we should throw a warning but startup anyway
+	try {
+		while (true) {
+			auto batch = decoder.NextBatch();
+			if (!batch) {
+				break;
+			}
+			// replay the entries of the batch
+			for (auto &entry : batch->entries) {
+				state.ReplayEntry(*entry, batch->complete);
+			}
+			if (batch->commit) {
+				// flush: commit the current transaction
+				context.transaction.Commit();
+				context.transaction.BeginTransaction();
+			}
+		}
+		if (!decoder.error.empty()) {
+			throw Exception(decoder.error);
+		}
+	} catch (std::exception &ex) {
+		// FIXME: this report a proper warning in the connection
+		fprintf(stderr, "Exception in WAL playback: %s\n", ex.what());
+	}
+	// rollback the last transaction: it is either empty or was not committed in the WAL
+	context.transaction.Rollback();
+}
+
+//===--------------------------------------------------------------------===//
+// Decode Entries
+//===--------------------------------------------------------------------===//
+ReplayDecoder::ReplayDecoder(FileSystem &fs, string &path)
+    : reader(fs, path.c_str()), finished(false), cancelled(false) {
+	empty = reader.Finished();
+}
+
+ReplayDecoder::~ReplayDecoder() {
+	if (decode_thread.joinable()) {
+		{
+			lock_guard<mutex> guard(lock);
+			cancelled = true;
+		}
+		cv.notify_all();
+		decode_thread.join();
+	}
+}
+
+void ReplayDecoder::Start() {
+	decode_thread = std::thread(&ReplayDecoder::DecodeEntries, this);
+}
+
+unique_ptr<ReplayBatch> ReplayDecoder::NextBatch() {
+	unique_lock<mutex> guard(lock);
+	cv.wait(guard, [&] { return batches.size() > 0 || finished; });
+	if (batches.size() == 0) {
+		return nullptr;
+	}
+	auto batch = move(batches.front());
+	batches.pop_front();
+	// wake up the decoder in case it is waiting for space in the queue
+	cv.notify_all();
+	return batch;
+}
+
+bool ReplayDecoder::PushBatch(unique_ptr<ReplayBatch> batch) {
+	unique_lock<mutex> guard(lock);
+	cv.wait(guard, [&] { return batches.size() < MAXIMUM_QUEUED_REPLAY_BATCHES || cancelled; });
+	if (cancelled) {
+		return false;
+	}
+	batches.push_back(move(batch));
+	cv.notify_all();
+	return true;
+}
+
+void ReplayDecoder::DecodeEntries() {
+	auto batch = make_unique<ReplayBatch>();
+	// whether or not the entries of the current transaction have all been added to the current batch
+	bool complete = true;
 	try {
 		while (true) {
 			// read the current entry
 			WALType entry_type = reader.Read<WALType>();
 			if (entry_type == WALType::WAL_FLUSH) {
-				// flush: commit the current transaction
-				context.transaction.Commit();
+				// flush: the transaction is committed
+				batch->commit = true;
+				batch->complete = complete;
+				if (!PushBatch(move(batch))) {
+					return;
+				}
 				// check if the file is exhausted
 				if (reader.Finished()) {
-					// we finished reading the file: break
+					// we finished reading the file
 					break;
 				}
 				// otherwise we keep on reading
-				context.transaction.BeginTransaction();
+				batch = make_unique<ReplayBatch>();
+				complete = true;
 			} else {
-				// replay the entry
-				state.ReplayEntry(entry_type);
+				batch->entries.push_back(DecodeEntry(entry_type));
+				if (batch->entries.size() >= MAXIMUM_REPLAY_BATCH_SIZE) {
+					// the transaction is too large to buffer entirely: hand out the entries decoded so far
+					if (!PushBatch(move(batch))) {
+						return;
+					}
+					batch = make_unique<ReplayBatch>();
+					complete = false;
+				}
 			}
 		}
 	} catch (std::exception &ex) {
-		// FIXME: this report a proper warning in the connection
-		fprintf(stderr, "Exception in WAL playback: %s\n", ex.what());
-		// exception thrown in WAL replay: rollback
-		context.transaction.Rollback();
+		// the entries of the last transaction could not be decoded: the transaction is not replayed
+		lock_guard<mutex> guard(lock);
+		error = ex.what();
+	}
+	lock_guard<mutex> guard(lock);
+	finished = true;
+	cv.notify_all();
+}
+
+unique_ptr<WALEntry> ReplayDecoder::DecodeEntry(WALType type) {
+	auto entry = make_unique<WALEntry>(type);
+	switch (type) {
+	case WALType::CREATE_TABLE:
+		entry->table_info = TableCatalogEntry::Deserialize(reader);
+		break;
+	case WALType::CREATE_VIEW:
+		entry->view_info = ViewCatalogEntry::Deserialize(reader);
+		break;
+	case WALType::CREATE_SEQUENCE:
+		entry->sequence_info = SequenceCatalogEntry::Deserialize(reader);
+		break;
+	case WALType::CREATE_SCHEMA:
+	case WALType::DROP_SCHEMA:
+		entry->name = reader.Read<string>();
+		break;
+	case WALType::DROP_TABLE:
+	case WALType::DROP_VIEW:
+	case WALType::DROP_SEQUENCE:
+	case WALType::USE_TABLE:
+		entry->schema = reader.Read<string>();
+		entry->name = reader.Read<string>();
+		break;
+	case WALType::SEQUENCE_VALUE:
+		entry->schema = reader.Read<string>();
+		entry->name = reader.Read<string>();
+		entry->usage_count = reader.Read<uint64_t>();
+		entry->counter = reader.Read<int64_t>();
+		break;
+	case WALType::INSERT_TUPLE:
+	case WALType::DELETE_TUPLE:
+	case WALType::UPDATE_TUPLE:
+		entry->chunk = make_unique<DataChunk>();
+		entry->chunk->Deserialize(reader);
+		break;
+	case WALType::QUERY:
+		entry->query = reader.Read<string>();
+		break;
+	default:
+		throw Exception("Invalid WAL entry type!");
 	}
+	return entry;
 }
 
 //===--------------------------------------------------------------------===//
 // Replay Entries
 //===--------------------------------------------------------------------===//
-void ReplayState::ReplayEntry(WALType entry_type) {
-	switch (entry_type) {
+void ReplayState::ReplayEntry(WALEntry &entry, bool committed) {
+	switch (entry.type) {
 	case WALType::CREATE_TABLE:
-		ReplayCreateTable();
+		ReplayCreateTable(entry);
 		break;
 	case WALType::DROP_TABLE:
-		ReplayDropTable();
+		ReplayDropTable(entry);
 		break;
 	case WALType::CREATE_VIEW:
-		ReplayCreateView();
+		ReplayCreateView(entry);
 		break;
 	case WALType::DROP_VIEW:
-		ReplayDropView();
+		ReplayDropView(entry);
 		break;
 	case WALType::CREATE_SCHEMA:
-		ReplayCreateSchema();
+		ReplayCreateSchema(entry);
 		break;
 	case WALType::DROP_SCHEMA:
-		ReplayDropSchema();
+		ReplayDropSchema(entry);
 		break;
 	case WALType::CREATE_SEQUENCE:
-		ReplayCreateSequence();
+		ReplayCreateSequence(entry);
 		break;
 	case WALType::DROP_SEQUENCE:
-		ReplayDropSequence();
+		ReplayDropSequence(entry);
 		break;
 	case WALType::SEQUENCE_VALUE:
-		ReplaySequenceValue();
+		ReplaySequenceValue(entry);
 		break;
 	case WALType::USE_TABLE:
-		ReplayUseTable();
+		ReplayUseTable(entry);
 		break;
 	case WALType::INSERT_TUPLE:
-		ReplayInsert();
+		ReplayInsert(entry, committed);
 		break;
 	case WALType::DELETE_TUPLE:
-		ReplayDelete();
+		ReplayDelete(entry);
 		break;
 	case WALType::UPDATE_TUPLE:
-		ReplayUpdate();
+		ReplayUpdate(entry);
 		break;
 	case WALType::QUERY:
-		ReplayQuery();
+		ReplayQuery(entry);
 		break;
 	default:
 		throw Exception("Invalid WAL entry type!");
@@ -142,22 +362,20 @@ void ReplayState::ReplayEntry(WALType entry_type) {
 //===--------------------------------------------------------------------===//
 // Replay Table
 //===--------------------------------------------------------------------===//
-void ReplayState::ReplayCreateTable() {
-	auto info = TableCatalogEntry::Deserialize(source);
-
+void ReplayState::ReplayCreateTable(WALEntry &entry) {
 	// bind the constraints to the table again
 	Binder binder(context);
-	auto bound_info = binder.BindCreateTableInfo(move(info));
+	auto bound_info = binder.BindCreateTableInfo(move(entry.table_info));
 
 	db.catalog->CreateTable(context.ActiveTransaction(), bound_info.get());
 }
 
-void ReplayState::ReplayDropTable() {
+void ReplayState::ReplayDropTable(WALEntry &entry) {
 	DropInfo info;
 
 	info.type = CatalogType::TABLE;
-	info.schema = source.Read<string>();
-	info.name = source.Read<string>();
+	info.schema = entry.schema;
+	info.name = entry.name;
 
 	db.catalog->DropTable(context.ActiveTransaction(), &info);
 }
@@ -165,35 +383,33 @@ void ReplayState::ReplayDropTable() {
 //===--------------------------------------------------------------------===//
 // Replay View
 //===--------------------------------------------------------------------===//
-void ReplayState::ReplayCreateView() {
-	auto entry = ViewCatalogEntry::Deserialize(source);
-
-	db.catalog->CreateView(context.ActiveTransaction(), entry.get());
+void ReplayState::ReplayCreateView(WALEntry &entry) {
+	db.catalog->CreateView(context.ActiveTransaction(), entry.view_info.get());
 }
 
-void ReplayState::ReplayDropView() {
+void ReplayState::ReplayDropView(WALEntry &entry) {
 	DropInfo info;
 	info.type = CatalogType::VIEW;
-	info.schema = source.Read<string>();
-	info.name = source.Read<string>();
+	info.schema = entry.schema;
+	info.name = entry.name;
 	db.catalog->DropView(context.ActiveTransaction(), &info);
 }
 
 //===--------------------------------------------------------------------===//
 // Replay Schema
 //===--------------------------------------------------------------------===//
-void ReplayState::ReplayCreateSchema() {
+void ReplayState::ReplayCreateSchema(WALEntry &entry) {
 	CreateSchemaInfo info;
-	info.schema = source.Read<string>();
+	info.schema = entry.name;
 
 	db.catalog->CreateSchema(context.ActiveTransaction(), &info);
 }
 
-void ReplayState::ReplayDropSchema() {
+void ReplayState::ReplayDropSchema(WALEntry &entry) {
 	DropInfo info;
 
 	info.type = CatalogType::SCHEMA;
-	info.name = source.Read<string>();
+	info.name = entry.name;
 
 	db.catalog->DropSchema(context.ActiveTransaction(), &info);
 }
@@ -201,61 +417,50 @@ void ReplayState::ReplayDropSchema() {
 //===--------------------------------------------------------------------===//
 // Replay Sequence
 //===--------------------------------------------------------------------===//
-void ReplayState::ReplayCreateSequence() {
-	auto entry = SequenceCatalogEntry::Deserialize(source);
-
-	db.catalog->CreateSequence(context.ActiveTransaction(), entry.get());
+void ReplayState::ReplayCreateSequence(WALEntry &entry) {
+	db.catalog->CreateSequence(context.ActiveTransaction(), entry.sequence_info.get());
 }
 
-void ReplayState::ReplayDropSequence() {
+void ReplayState::ReplayDropSequence(WALEntry &entry) {
 	DropInfo info;
 	info.type = CatalogType::SEQUENCE;
-	info.schema = source.Read<string>();
-	info.name = source.Read<string>();
+	info.schema = entry.schema;
+	info.name = entry.name;
 
 	db.catalog->DropSequence(context.ActiveTransaction(), &info);
 }
 
-void ReplayState::ReplaySequenceValue() {
-	auto schema = source.Read<string>();
-	auto name = source.Read<string>();
-	auto usage_count = source.Read<uint64_t>();
-	auto counter = source.Read<int64_t>();
-
+void ReplayState::ReplaySequenceValue(WALEntry &entry) {
 	// fetch the sequence from the catalog
-	auto seq = db.catalog->GetSequence(context.ActiveTransaction(), schema, name);
-	if (usage_count > seq->usage_count) {
-		seq->usage_count = usage_count;
-		seq->counter = counter;
+	auto seq = db.catalog->GetSequence(context.ActiveTransaction(), entry.schema, entry.name);
+	if (entry.usage_count > seq->usage_count) {
+		seq->usage_count = entry.usage_count;
+		seq->counter = entry.counter;
 	}
 }
 
 //===--------------------------------------------------------------------===//
 // Replay Data
 //===--------------------------------------------------------------------===//
-void ReplayState::ReplayUseTable() {
-	auto schema_name = source.Read<string>();
-	auto table_name = source.Read<string>();
-	current_table = db.catalog->GetTable(context.ActiveTransaction(), schema_name, table_name);
+void ReplayState::ReplayUseTable(WALEntry &entry) {
+	current_table = db.catalog->GetTable(context.ActiveTransaction(), entry.schema, entry.name);
 }
 
-void ReplayState::ReplayInsert() {
+void ReplayState::ReplayInsert(WALEntry &entry, bool committed) {
 	if (!current_table) {
 		throw Exception("Corrupt WAL: insert without table");
 	}
-	DataChunk chunk;
-	chunk.Deserialize(source);
-
-	// append to the current table
-	current_table->storage->Append(*current_table, context, chunk);
+	auto &chunk = *entry.chunk;
+	// the constraints were already verified when the rows were inserted originally. If the transaction is known to
+	// commit the rows are appended directly as committed rows.
+	current_table->storage->AppendVerified(chunk, committed ? nullptr : &context.ActiveTransaction());
 }
 
-void ReplayState::ReplayDelete() {
+void ReplayState::ReplayDelete(WALEntry &entry) {
 	if (!current_table) {
 		throw Exception("Corrupt WAL: delete without table");
 	}
-	DataChunk chunk;
-	chunk.Deserialize(source);
+	auto &chunk = *entry.chunk;
 
 	assert(chunk.column_count == 1 && chunk.data[0].type == ROW_TYPE);
 	row_t row_ids[1];
@@ -270,12 +475,11 @@ void ReplayState::ReplayDelete() {
 	}
 }
 
-void ReplayState::ReplayUpdate() {
+void ReplayState::ReplayUpdate(WALEntry &entry) {
 	if (!current_table) {
 		throw Exception("Corrupt WAL: update without table");
 	}
-	DataChunk chunk;
-	chunk.Deserialize(source);
+	auto &chunk = *entry.chunk;
 
 	vector<column_t> column_ids;
 	for (index_t i = 0; i < chunk.column_count - 1; i++) {
@@ -294,16 +498,13 @@ void ReplayState::ReplayUpdate() {
 
 	for (index_t i = 0; i < update_count; i++) {
 		chunk.owned_sel_vector[0] = i;
-		current_table->storage->Update(*current_table, context, row_ids, column_ids, chunk);
+		current_table->storage->UpdateVerified(*current_table, context, row_ids, column_ids, chunk);
 	}
 }
 
 //===--------------------------------------------------------------------===//
 // Query
 //===--------------------------------------------------------------------===//
-void ReplayState::ReplayQuery() {
-	// read the query
-	auto query = source.Read<string>();
-
-	context.Query(query, false);
+void ReplayState::ReplayQuery(WALEntry &entry) {
+	context.Query(entry.query, false);
 }
@@ -5,14 +5,31 @@
 using namespace duckdb;
 using namespace std;
 
-WriteAheadLog::WriteAheadLog(DuckDB &database) : initialized(false), database(database) {
+WriteAheadLog::WriteAheadLog(DuckDB &database)
+    : initialized(false), database(database), sync_in_progress(false), sync_failed(false), waiting_commits(0),
+      flushed_size(0), synced_size(0) {
 }
 
 void WriteAheadLog::Initialize(string &path) {
+	wal_path = path;
 	writer = make_unique<BufferedFileWriter>(*database.file_system, path.c_str(), true);
+	flushed_size = synced_size = writer->GetFileSize();
 	initialized = true;
 }
 
+int64_t WriteAheadLog::GetWALSize() {
+	return flushed_size;
+}
+
+void WriteAheadLog::Truncate() {
+	assert(writer);
+	// close the current WAL, remove it and start over with an empty file
+	writer.reset();
+	database.file_system->RemoveFile(wal_path);
+	writer = make_unique<BufferedFileWriter>(*database.file_system, wal_path.c_str(), true);
+	flushed_size = synced_size = 0;
+}
+
 //===--------------------------------------------------------------------===//
 // Write Entries
 //===--------------------------------------------------------------------===//
@@ -136,6 +153,51 @@ void WriteAheadLog::WriteQuery(string &query) {
 void WriteAheadLog::Flush() {
 	// write an empty entry
 	writer->Write<WALType>(WALType::WAL_FLUSH);
-	// flushes all changes made to the WAL to disk
-	writer->Sync();
+	// write all changes made to the WAL to the file
+	writer->Flush();
+	flushed_size = writer->GetFileSize();
+}
+
+void WriteAheadLog::Sync() {
+	unique_lock<mutex> guard(sync_lock);
+	index_t target_size = flushed_size;
+	waiting_commits++;
+	sync_cv.notify_all();
+	while (synced_size < target_size) {
+		if (sync_failed) {
+			// the records written since the last successful sync might have been lost
+			waiting_commits--;
+			throw IOException("Could not sync the WAL: a previous sync of the WAL failed");
+		}
+		if (sync_in_progress) {
+			// another transaction is syncing the WAL, which might include our records: wait for it to finish
+			sync_cv.wait(guard);
+			continue;
+		}
+		sync_in_progress = true;
+		if (database.commit_delay > 0) {
+			// give concurrently committing transactions the chance to write their records, so they are synced together
+			sync_cv.wait_for(guard, chrono::microseconds(database.commit_delay),
+			                 [&]() { return waiting_commits >= database.commit_batch_size; });
+		}
+		// sync everything that has been written so far, without holding the lock so other transactions can continue
+		// writing their records and start waiting for the next sync
+		index_t sync_size = flushed_size;
+		guard.unlock();
+		try {
+			writer->handle->Sync();
+		} catch (...) {
+			guard.lock();
+			sync_in_progress = false;
+			sync_failed = true;
+			waiting_commits--;
+			sync_cv.notify_all();
+			throw;
+		}
+		guard.lock();
+		synced_size = std::max(synced_size, sync_size);
+		sync_in_progress = false;
+		sync_cv.notify_all();
+	}
+	waiting_commits--;
 }
@@ -0,0 +1,51 @@
+#include "transaction/checkpoint_lock.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+CheckpointLockKey::CheckpointLockKey(CheckpointLock &lock, CheckpointLockType type) : lock(lock), type(type) {
+}
+
+CheckpointLockKey::~CheckpointLockKey() {
+	if (type == CheckpointLockType::EXCLUSIVE) {
+		lock.ReleaseExclusiveLock();
+	} else {
+		assert(type == CheckpointLockType::SHARED);
+		lock.ReleaseSharedLock();
+	}
+}
+
+CheckpointLock::CheckpointLock() : exclusive(false), shared_count(0) {
+}
+
+unique_ptr<CheckpointLockKey> CheckpointLock::GetExclusiveLock() {
+	unique_lock<mutex> guard(lock);
+	// only one exclusive lock can be held or requested at a time
+	cv.wait(guard, [&]() { return !exclusive; });
+	// request the lock: new shared locks are not handed out anymore, wait for the current ones to be released
+	exclusive = true;
+	cv.wait(guard, [&]() { return shared_count == 0; });
+	return make_unique<CheckpointLockKey>(*this, CheckpointLockType::EXCLUSIVE);
+}
+
+unique_ptr<CheckpointLockKey> CheckpointLock::GetSharedLock() {
+	unique_lock<mutex> guard(lock);
+	cv.wait(guard, [&]() { return !exclusive; });
+	shared_count++;
+	return make_unique<CheckpointLockKey>(*this, CheckpointLockType::SHARED);
+}
+
+void CheckpointLock::ReleaseExclusiveLock() {
+	lock_guard<mutex> guard(lock);
+	exclusive = false;
+	cv.notify_all();
+}
+
+void CheckpointLock::ReleaseSharedLock() {
+	lock_guard<mutex> guard(lock);
+	assert(shared_count > 0);
+	shared_count--;
+	if (shared_count == 0) {
+		cv.notify_all();
+	}
+}
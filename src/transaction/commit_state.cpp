@@ -230,6 +230,8 @@ template <bool HAS_LOG> void CommitState<HAS_LOG>::CommitEntry(UndoFlags type, d
 			}
 			break;
 		}
+		// the table has to be written by the next checkpoint
+		info->GetTable().change_count++;
 		// set the commit timestamp of the entry
 		info->version_number = commit_id;
 		break;
@@ -30,6 +30,11 @@ void RollbackState::RollbackEntry(UndoFlags type, data_ptr_t data) {
 		// parent needs to refer to a storage chunk because of our transactional model
 		// the current entry is still dirty, hence no other transaction can have modified it
 		info->vinfo->Undo(info);
+		if (type == UndoFlags::INSERT_TUPLE) {
+			// the rolled back rows stay in the table as deleted rows, so the table has to be written by the next
+			// checkpoint
+			info->GetTable().change_count++;
+		}
 		break;
 	}
 	case UndoFlags::QUERY:
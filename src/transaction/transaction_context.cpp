@@ -30,8 +30,10 @@ void TransactionContext::Commit() {
 	if (!current_transaction) {
 		throw TransactionException("No transaction is currently active - cannot commit!");
 	}
-	transaction_manager.CommitTransaction(current_transaction);
+	// the transaction is finished even if the commit fails
+	auto transaction = current_transaction;
 	current_transaction = nullptr;
+	transaction_manager.CommitTransaction(transaction);
 }
 
 void TransactionContext::Rollback() {
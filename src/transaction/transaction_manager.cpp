@@ -18,8 +18,10 @@ transaction_t MAXIMUM_QUERY_ID = std::numeric_limits<transaction_t>::max(); // 2
 } // namespace duckdb
 
 TransactionManager::TransactionManager(StorageManager &storage) : storage(storage) {
-	// start timestamp starts at zero
-	current_start_timestamp = 0;
+	// start timestamp starts at one, a commit id of zero indicates an uncommitted transaction
+	current_start_timestamp = 1;
+	current_commit_id = 1;
+	invalidated = false;
 	// transaction ID starts very high:
 	// it should be much higher than the current start timestamp
 	// if transaction_id < start_timestamp for any set of active transactions
@@ -30,22 +32,31 @@ TransactionManager::TransactionManager(StorageManager &storage) : storage(storag
 }
 
 Transaction *TransactionManager::StartTransaction() {
-	// obtain the transaction lock during this function
-	lock_guard<mutex> lock(transaction_lock);
+	// starting a transaction does not wait for commits in progress: their commit id is not smaller than the start time
+	// of the transaction, so it does not see any of their changes
+	// the start time is obtained while holding the lock on the set of active transactions, so the garbage collection
+	// always sees the start time of all running transactions
+	lock_guard<mutex> lock(active_lock);
+	if (invalidated) {
+		throw TransactionException("Cannot start a transaction: a previous commit could not be synced to the WAL, "
+		                           "the database has to be restarted");
+	}
 
-	if (current_start_timestamp >= TRANSACTION_ID_START) {
+	// obtain the start time and transaction ID of this transaction
+	transaction_t start_time = current_start_timestamp;
+	if (start_time >= TRANSACTION_ID_START) {
 		throw Exception("Cannot start more transactions, ran out of "
 		                "transaction identifiers!");
 	}
-
-	// obtain the start time and transaction ID of this transaction
-	transaction_t start_time = current_start_timestamp++;
 	transaction_t transaction_id = current_transaction_id++;
 	timestamp_t start_timestamp = Timestamp::GetCurrentTimestamp();
 
 	// create the actual transaction
 	auto transaction = make_unique<Transaction>(start_time, transaction_id, start_timestamp);
 	auto transaction_ptr = transaction.get();
+	// the transaction starts out with a query number, so transactions that scan tables without running a query are
+	// protected from having the version information they scan freed as well
+	transaction->active_query = GetQueryNumber();
 
 	// store it in the set of active transactions
 	active_transactions.push_back(move(transaction));
@@ -53,18 +64,92 @@ Transaction *TransactionManager::StartTransaction() {
 }
 
 void TransactionManager::CommitTransaction(Transaction *transaction) {
-	// obtain the transaction lock during this function
-	lock_guard<mutex> lock(transaction_lock);
+	// a transaction that made changes cannot commit while a checkpoint is being written: its changes would neither be
+	// part of the checkpoint nor of the truncated WAL
+	bool changes_made = transaction->ChangesMade();
+	if (changes_made && invalidated) {
+		// the changes can no longer be made durable
+		RollbackTransaction(transaction);
+		throw TransactionException("Failed to commit: a previous commit could not be synced to the WAL, the database "
+		                           "has to be restarted");
+	}
+	unique_ptr<CheckpointLockKey> checkpoint_guard;
+	if (changes_made) {
+		checkpoint_guard = checkpoint_lock.GetSharedLock();
+	}
+	auto log = storage.GetWriteAheadLog();
+	bool requires_sync = changes_made && log;
+	transaction_t commit_id;
+	{
+		// obtain the transaction lock during the commit
+		lock_guard<mutex> lock(transaction_lock);
 
-	// obtain a commit id for the transaction
-	transaction_t commit_id = current_start_timestamp++;
+		// obtain a commit id for the transaction
+		commit_id = current_commit_id++;
 
-	// commit the UndoBuffer of the transaction
-	transaction->Commit(storage.GetWriteAheadLog(), commit_id);
+		// commit the UndoBuffer of the transaction
+		transaction->Commit(log, commit_id);
+		if (!requires_sync) {
+			// there is nothing to sync: the commit is finished
+			PublishCommits();
+			// remove the transaction id from the list of active transactions
+			// potentially resulting in garbage collection
+			RemoveTransaction(transaction);
+			return;
+		}
+		// the changes only become visible to other transactions once they are durable
+		unsynced_commits.push_back(commit_id);
+	}
+	// the WAL is synced outside of the transaction lock: the records of all transactions that commit concurrently
+	// are synced together
+	try {
+		log->Sync();
+	} catch (...) {
+		// the commit is not durable, but it cannot be undone either: its records were already written to the WAL and
+		// later commits might follow them. Invalidate the database so no transaction ever sees the commit, and remove
+		// it from the pending commits so the concurrent commits that were synced are still finished.
+		lock_guard<mutex> lock(transaction_lock);
+		invalidated = true;
+		auto entry = find(unsynced_commits.begin(), unsynced_commits.end(), commit_id);
+		if (entry != unsynced_commits.end()) {
+			unsynced_commits.erase(entry);
+		}
+		RemoveTransaction(transaction);
+		throw;
+	}
+	{
+		lock_guard<mutex> lock(transaction_lock);
+		// the records of a commit are written to the WAL before those of any later commit, so syncing them made the
+		// commits with a lower commit id durable as well
+		unsynced_commits.erase(unsynced_commits.begin(),
+		                       upper_bound(unsynced_commits.begin(), unsynced_commits.end(), commit_id));
+		PublishCommits();
+		RemoveTransaction(transaction);
+	}
+	checkpoint_guard.reset();
+	// checkpoint the database if the WAL has grown too large
+	storage.CreateCheckpoint();
+}
 
-	// remove the transaction id from the list of active transactions
-	// potentially resulting in garbage collection
-	RemoveTransaction(transaction);
+void TransactionManager::RegisterRowWrites(Transaction &transaction) {
+	if (transaction.writes_rows) {
+		return;
+	}
+	// a checkpoint checks the registered transactions while it holds the checkpoint lock exclusively: by registering
+	// while holding it shared, the transaction either waits for the checkpoint to finish or prevents it
+	auto checkpoint_guard = checkpoint_lock.GetSharedLock();
+	lock_guard<mutex> lock(active_lock);
+	transaction.writes_rows = true;
+}
+
+bool TransactionManager::HasRowWrites() {
+	lock_guard<mutex> lock(active_lock);
+	for (auto &transaction : active_transactions) {
+		if (transaction->writes_rows) {
+			return true;
+		}
+	}
+	return false;
 }
 
 void TransactionManager::RollbackTransaction(Transaction *transaction) {
@@ -79,23 +164,33 @@ void TransactionManager::RollbackTransaction(Transaction *transaction) {
 	RemoveTransaction(transaction);
 }
 
+void TransactionManager::PublishCommits() {
+	// transactions that start from now on see the changes of all commits that are durable, the commit ids of the
+	// commits that are not durable yet are never smaller than their start time
+	current_start_timestamp = unsynced_commits.empty() ? current_commit_id : unsynced_commits.front();
+}
+
 void TransactionManager::RemoveTransaction(Transaction *transaction) {
-	// remove the transaction from the list of active transactions
-	index_t t_index = active_transactions.size();
+	unique_ptr<Transaction> current_transaction;
 	// check for the lowest and highest start time in the list of transactions
 	transaction_t lowest_start_time = TRANSACTION_ID_START;
-	transaction_t lowest_active_query = MAXIMUM_QUERY_ID;
-	for (index_t i = 0; i < active_transactions.size(); i++) {
-		if (active_transactions[i].get() == transaction) {
-			t_index = i;
-		} else {
-			lowest_start_time = std::min(lowest_start_time, active_transactions[i]->start_time);
-			lowest_active_query = std::min(lowest_active_query, active_transactions[i]->active_query);
+	{
+		lock_guard<mutex> lock(active_lock);
+		// remove the transaction from the list of active transactions
+		index_t t_index = active_transactions.size();
+		for (index_t i = 0; i < active_transactions.size(); i++) {
+			if (active_transactions[i].get() == transaction) {
+				t_index = i;
+			} else {
+				lowest_start_time = std::min(lowest_start_time, active_transactions[i]->start_time);
+			}
 		}
+		assert(t_index != active_transactions.size());
+		current_transaction = move(active_transactions[t_index]);
+		// remove the transaction from the set of currently active transactions
+		active_transactions.erase(active_transactions.begin() + t_index);
 	}
 	transaction_t lowest_stored_query = lowest_start_time;
-	assert(t_index != active_transactions.size());
-	auto current_transaction = move(active_transactions[t_index]);
 	if (transaction->commit_id != 0) {
 		// the transaction was committed, add it to the list of recently
 		// committed transactions
@@ -106,8 +201,6 @@ void TransactionManager::RemoveTransaction(Transaction *transaction) {
 		current_transaction->highest_active_query = current_query_number;
 		old_transactions.push_back(move(current_transaction));
 	}
-	// remove the transaction from the set of currently active transactions
-	active_transactions.erase(active_transactions.begin() + t_index);
 	// traverse the recently_committed transactions to see if we can remove any
 	index_t i = 0;
 	for (; i < recently_committed_transactions.size(); i++) {
@@ -143,20 +236,40 @@ void TransactionManager::RemoveTransaction(Transaction *transaction) {
 		recently_committed_transactions.erase(recently_committed_transactions.begin(),
 		                                      recently_committed_transactions.begin() + i);
 	}
-	// check if we can free the memory of any old transactions
-	i = active_transactions.size() == 0 ? old_transactions.size() : 0;
-	for (; i < old_transactions.size(); i++) {
-		assert(old_transactions[i]);
-		assert(old_transactions[i]->highest_active_query > 0);
-		if (old_transactions[i]->highest_active_query >= lowest_active_query) {
-			// there is still a query running that could be using
-			// this transactions' data
-			break;
+	{
+		// check the queries that are running now: transactions that start after this point cannot reach any of the
+		// version information that was cleaned up above anymore
+		lock_guard<mutex> lock(active_lock);
+		transaction_t lowest_active_query = MAXIMUM_QUERY_ID;
+		for (auto &active : active_transactions) {
+			lowest_active_query = std::min(lowest_active_query, active->active_query);
+		}
+		// check if we can free the memory of any old transactions
+		i = active_transactions.size() == 0 ? old_transactions.size() : 0;
+		for (; i < old_transactions.size(); i++) {
+			assert(old_transactions[i]);
+			assert(old_transactions[i]->highest_active_query > 0);
+			if (old_transactions[i]->highest_active_query >= lowest_active_query) {
+				// there is still a query running that could be using
+				// this transactions' data
+				break;
+			}
+		}
+		if (i > 0) {
+			// we garbage collected transactions: remove them from the list
+			old_transactions.erase(old_transactions.begin(), old_transactions.begin() + i);
+		}
+		// check if we can free the memory of any old version info
+		i = active_transactions.size() == 0 ? old_version_info.size() : 0;
+		for (; i < old_version_info.size(); i++) {
+			if (old_version_info[i].highest_active_query >= lowest_active_query) {
+				// there is still a query running that could be scanning this version info
+				break;
+			}
+		}
+		if (i > 0) {
+			old_version_info.erase(old_version_info.begin(), old_version_info.begin() + i);
 		}
-	}
-	if (i > 0) {
-		// we garbage collected transactions: remove them from the list
-		old_transactions.erase(old_transactions.begin(), old_transactions.begin() + i);
 	}
 	// check if we can free the memory of any old catalog sets
 	for (i = 0; i < old_catalog_sets.size(); i++) {
@@ -185,3 +298,13 @@ void TransactionManager::AddCatalogSet(ClientContext &context, unique_ptr<Catalo
 
 	old_catalog_sets.push_back(move(set));
 }
+
+void TransactionManager::AddVersionChunkInfo(unique_ptr<VersionChunkInfo> info) {
+	lock_guard<mutex> lock(active_lock);
+
+	StoredVersionChunkInfo stored;
+	stored.info = move(info);
+	stored.highest_active_query = current_query_number;
+
+	old_version_info.push_back(move(stored));
+}
@@ -254,3 +254,27 @@ TEST_CASE("Test GROUP BY with many groups", "[aggregate]") {
 	REQUIRE(CHECK_COLUMN(result, 0, {49995000}));
 	REQUIRE(CHECK_COLUMN(result, 1, {30000}));
 }
+
+TEST_CASE("Test aggregates over chunks of different sizes", "[aggregate]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER);"));
+	string values;
+	for (index_t i = 0; i < 1000; i++) {
+		values += (i == 0 ? "(" : ", (") + to_string(i) + ")";
+	}
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES " + values));
+	// the aggregate first receives a chunk with a single row, followed by a larger chunk: the constant group and the
+	// constant aggregate input have to be expanded to the size of the larger chunk
+	result = con.Query("SELECT COUNT(*), SUM(i), SUM(2) FROM (SELECT 1000 AS i UNION ALL SELECT i FROM integers) tbl");
+	REQUIRE(CHECK_COLUMN(result, 0, {1001}));
+	REQUIRE(CHECK_COLUMN(result, 1, {500500}));
+	REQUIRE(CHECK_COLUMN(result, 2, {2002}));
+	result = con.Query("SELECT g, COUNT(*), SUM(2) FROM (SELECT 1000 UNION ALL SELECT i FROM integers) tbl(i), "
+	                   "(SELECT 1) tbl2(g) GROUP BY g");
+	REQUIRE(CHECK_COLUMN(result, 0, {1}));
+	REQUIRE(CHECK_COLUMN(result, 1, {1001}));
+	REQUIRE(CHECK_COLUMN(result, 2, {2002}));
+}
@@ -0,0 +1,128 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+
+#include <atomic>
+#include <thread>
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test GROUP BY with more groups than fit in the memory limit", "[aggregations]") {
+	unique_ptr<QueryResult> result;
+	auto config = GetTestConfig();
+	auto temp_directory = TestCreatePath("external_aggregate_tmp");
+	TestDeleteDirectory(temp_directory);
+	config->temporary_directory = temp_directory;
+
+	index_t tuple_count = 100000;
+	{
+		DuckDB db(nullptr, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE test(g INTEGER, i INTEGER, s VARCHAR)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "test");
+		for (index_t k = 0; k < tuple_count; k++) {
+			// 25000 groups (and a NULL group), every group appears four times
+			appender->BeginRow();
+			if (k % 1000 == 0) {
+				appender->AppendValue(Value());
+			} else {
+				appender->AppendInteger((int32_t)((k * 7919) % 25000));
+			}
+			appender->AppendInteger((int32_t)k);
+			auto str = "string " + to_string(k);
+			appender->AppendString(str.c_str());
+			appender->EndRow();
+		}
+		con.CloseAppender();
+
+		vector<string> queries = {
+		    "SELECT COUNT(*), SUM(c), SUM(s), MIN(mi), MAX(ma), SUM(a) FROM (SELECT g, COUNT(*) AS c, SUM(i) AS s, "
+		    "MIN(i) AS mi, MAX(i) AS ma, AVG(i) AS a FROM test GROUP BY g) t",
+		    // string groups and string aggregate states
+		    "SELECT COUNT(*), MIN(mi), MAX(ma), SUM(c) FROM (SELECT s, MIN(s) AS mi, MAX(s) AS ma, COUNT(g) AS c FROM "
+		    "test GROUP BY s) t",
+		    "SELECT COUNT(*), MIN(mi), MAX(ma), MIN(mi2), MAX(ma2) FROM (SELECT g, MIN(s) AS mi, MAX(s) AS ma, MIN(i) "
+		    "AS mi2, MAX(i) AS ma2 FROM test GROUP BY g) t",
+		    // multiple groups and aggregates with larger states
+		    "SELECT COUNT(*), SUM(c), SUM(v) FROM (SELECT g, i % 2 AS m, COUNT(*) AS c, ROUND(STDDEV_SAMP(i), 3) AS v "
+		    "FROM test GROUP BY g, m) t",
+		    // aggregates that cannot be combined are not spilled
+		    "SELECT COUNT(*), SUM(c) FROM (SELECT g, COUNT(DISTINCT i % 3) AS c FROM test GROUP BY g) t",
+		    // the groups themselves
+		    "SELECT g, COUNT(*), SUM(i), MIN(s) FROM test GROUP BY g ORDER BY g LIMIT 5",
+		    "SELECT g, COUNT(*), SUM(i), MAX(s) FROM test GROUP BY g ORDER BY g DESC LIMIT 5",
+		};
+
+		// compute the expected results without a memory limit
+		vector<vector<vector<Value>>> expected_results;
+		for (auto &query : queries) {
+			auto expected = con.Query(query);
+			REQUIRE(expected->success);
+			vector<vector<Value>> columns(expected->types.size());
+			for (index_t col = 0; col < columns.size(); col++) {
+				for (index_t row = 0; row < expected->collection.count; row++) {
+					columns[col].push_back(expected->GetValue(col, row));
+				}
+			}
+			expected_results.push_back(move(columns));
+		}
+
+		// the memory limit is much smaller than the HT: the partial aggregates are spilled to disk
+		REQUIRE_NO_FAIL(con.Query("PRAGMA memory_limit=200KB"));
+		for (index_t threads = 1; threads <= 4; threads += 3) {
+			REQUIRE_NO_FAIL(con.Query("PRAGMA threads=" + to_string(threads)));
+			for (index_t q = 0; q < queries.size(); q++) {
+				result = con.Query(queries[q]);
+				for (index_t col = 0; col < expected_results[q].size(); col++) {
+					REQUIRE(CHECK_COLUMN(result, col, expected_results[q][col]));
+				}
+			}
+		}
+		// the partitions were written to the temporary directory
+		REQUIRE(db.file_system->DirectoryExists(temp_directory));
+	}
+	FileSystem fs;
+	REQUIRE(!fs.DirectoryExists(temp_directory));
+}
+
+TEST_CASE("Test changing the memory limit while aggregates are running", "[aggregations]") {
+	unique_ptr<QueryResult> result;
+	auto config = GetTestConfig();
+	auto temp_directory = TestCreatePath("external_aggregate_tmp");
+	TestDeleteDirectory(temp_directory);
+	config->temporary_directory = temp_directory;
+
+	{
+		DuckDB db(nullptr, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE test(g INTEGER, i INTEGER)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "test");
+		for (index_t k = 0; k < 20000; k++) {
+			appender->BeginRow();
+			appender->AppendInteger((int32_t)(k % 5000));
+			appender->AppendInteger((int32_t)k);
+			appender->EndRow();
+		}
+		con.CloseAppender();
+
+		// another connection switches between spilling and not spilling while the aggregates run
+		atomic<bool> finished(false);
+		thread pragma_thread([&]() {
+			Connection pragma_con(db);
+			for (index_t k = 0; !finished; k++) {
+				pragma_con.Query(k % 2 == 0 ? "PRAGMA memory_limit=100KB" : "PRAGMA memory_limit=none");
+			}
+		});
+		bool correct = true;
+		for (index_t k = 0; k < 20 && correct; k++) {
+			result = con.Query("SELECT COUNT(*), SUM(c), SUM(s) FROM (SELECT g, COUNT(*) AS c, SUM(i) AS s FROM test "
+			                   "GROUP BY g) t");
+			correct = CHECK_COLUMN(result, 0, {5000}) && CHECK_COLUMN(result, 1, {20000}) &&
+			          CHECK_COLUMN(result, 2, {199990000});
+		}
+		finished = true;
+		pragma_thread.join();
+		REQUIRE(correct);
+	}
+	TestDeleteDirectory(temp_directory);
+}
@@ -59,27 +59,24 @@ TEST_CASE("Multiple PRIMARY KEY constraint", "[constraints]") {
 	DuckDB db(nullptr);
 	Connection con(db);
 
-	// FIXME: not supported by ART yet
-	REQUIRE_FAIL(con.Query("CREATE TABLE integers(i INTEGER, j VARCHAR, PRIMARY KEY(i, j))"));
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER, j VARCHAR, PRIMARY KEY(i, j))"));
 
-	// REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER, j VARCHAR, PRIMARY KEY(i, j))"));
-
-	// // insert unique values
-	// REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (3, 'hello'), (3, 'world')"));
+	// insert unique values
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (3, 'hello'), (3, 'world')"));
 
-	// result = con.Query("SELECT * FROM integers");
-	// REQUIRE(CHECK_COLUMN(result, 0, {3, 3}));
-	// REQUIRE(CHECK_COLUMN(result, 1, {"hello", "world"}));
+	result = con.Query("SELECT * FROM integers");
+	REQUIRE(CHECK_COLUMN(result, 0, {3, 3}));
+	REQUIRE(CHECK_COLUMN(result, 1, {"hello", "world"}));
 
-	// // insert a duplicate value as part of a chain of values
-	// REQUIRE_FAIL(con.Query("INSERT INTO integers VALUES (6, 'bla'), (3, 'hello');"));
+	// insert a duplicate value as part of a chain of values
+	REQUIRE_FAIL(con.Query("INSERT INTO integers VALUES (6, 'bla'), (3, 'hello');"));
 
-	// // now insert just the first value
-	// REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (6, 'bla');"));
+	// now insert just the first value
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (6, 'bla');"));
 
-	// result = con.Query("SELECT * FROM integers");
-	// REQUIRE(CHECK_COLUMN(result, 0, {3, 3, 6}));
-	// REQUIRE(CHECK_COLUMN(result, 1, {"hello", "world", "bla"}));
+	result = con.Query("SELECT * FROM integers");
+	REQUIRE(CHECK_COLUMN(result, 0, {3, 3, 6}));
+	REQUIRE(CHECK_COLUMN(result, 1, {"hello", "world", "bla"}));
 }
 
 TEST_CASE("PRIMARY KEY and transactions", "[constraints]") {
@@ -143,43 +140,47 @@ TEST_CASE("PRIMARY KEY and update/delete on multiple columns", "[constraints]")
 	DuckDB db(nullptr);
 	Connection con(db);
 
-	// FIXME: not supported by ART yet
-	REQUIRE_FAIL(con.Query("CREATE TABLE test (a INTEGER, b VARCHAR, PRIMARY KEY(a, b));"));
-
-	// // create a table
-	// REQUIRE_NO_FAIL(con.Query("CREATE TABLE test (a INTEGER, b VARCHAR, PRIMARY KEY(a, b));"));
-	// REQUIRE_NO_FAIL(con.Query("INSERT INTO test VALUES (11, 'hello'), (12, "
-	//                           "'world'), (13, 'blablabla')"));
-	// // update one of the columns, should work as it does not introduce duplicates
-	// REQUIRE_NO_FAIL(con.Query("UPDATE test SET b='hello';"));
-	// //! Set every key one higher, should also work without conflicts
-	// REQUIRE_NO_FAIL(con.Query("UPDATE test SET a=a+1;"));
-	// //! Set only the first key higher, should not work as this introduces a
-	// //! duplicate key!
-	// REQUIRE_FAIL(con.Query("UPDATE test SET a=a+1 WHERE a<=12;"));
-	// //! Set all keys to 4, results in a conflict!
-	// REQUIRE_FAIL(con.Query("UPDATE test SET a=4;"));
-
-	// result = con.Query("SELECT * FROM test;");
-	// REQUIRE(CHECK_COLUMN(result, 0, {12, 13, 14}));
-	// REQUIRE(CHECK_COLUMN(result, 1, {Value("hello"), Value("hello"), Value("hello")}));
-
-	// // delete and insert the same value should just work
-	// REQUIRE_NO_FAIL(con.Query("DELETE FROM test WHERE a=12"));
-	// REQUIRE_NO_FAIL(con.Query("INSERT INTO test VALUES (12, 'hello');"));
-
-	// // insert a duplicate should fail
-	// REQUIRE_FAIL(con.Query("INSERT INTO test VALUES (12, 'hello');"));
-
-	// // update one key
-	// REQUIRE_NO_FAIL(con.Query("UPDATE test SET a=4 WHERE a=12;"));
-
-	// result = con.Query("SELECT * FROM test ORDER BY a;");
-	// REQUIRE(CHECK_COLUMN(result, 0, {4, 13, 14}));
-	// REQUIRE(CHECK_COLUMN(result, 1, {Value("hello"), Value("hello"), Value("hello")}));
-
-	// // set a column to NULL should fail
-	// REQUIRE_FAIL(con.Query("UPDATE test SET b=NULL WHERE a=13;"));
+	// create a table
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE test (a INTEGER, b VARCHAR, PRIMARY KEY(a, b));"));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO test VALUES (11, 'hello'), (12, "
+	                          "'world'), (13, 'blablabla')"));
+	// update one of the columns, should work as it does not introduce duplicates
+	REQUIRE_NO_FAIL(con.Query("UPDATE test SET b='hello' WHERE a=12;"));
+	//! Set only the first key higher, should not work as this introduces a duplicate key!
+	REQUIRE_FAIL(con.Query("UPDATE test SET a=a+1 WHERE a=11;"));
+	//! Set all keys to 4, results in a conflict!
+	REQUIRE_FAIL(con.Query("UPDATE test SET a=4;"));
+
+	result = con.Query("SELECT * FROM test ORDER BY a;");
+	REQUIRE(CHECK_COLUMN(result, 0, {11, 12, 13}));
+	REQUIRE(CHECK_COLUMN(result, 1, {Value("hello"), Value("hello"), Value("blablabla")}));
+
+	// delete and insert the same value should just work
+	REQUIRE_NO_FAIL(con.Query("DELETE FROM test WHERE a=11"));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO test VALUES (11, 'hello');"));
+
+	// insert a duplicate should fail
+	REQUIRE_FAIL(con.Query("INSERT INTO test VALUES (11, 'hello');"));
+	// a value that is only equal in one of the columns is not a duplicate
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO test VALUES (11, 'world');"));
+
+	// update one key
+	REQUIRE_NO_FAIL(con.Query("UPDATE test SET a=4 WHERE a=13;"));
+
+	result = con.Query("SELECT * FROM test ORDER BY a, b;");
+	REQUIRE(CHECK_COLUMN(result, 0, {4, 11, 11, 12}));
+	REQUIRE(CHECK_COLUMN(result, 1, {Value("blablabla"), Value("hello"), Value("world"), Value("hello")}));
+
+	// point lookups on both columns of the key
+	result = con.Query("SELECT a FROM test WHERE a=11 AND b='world';");
+	REQUIRE(CHECK_COLUMN(result, 0, {11}));
+	result = con.Query("SELECT a FROM test WHERE b='hello' AND a=12;");
+	REQUIRE(CHECK_COLUMN(result, 0, {12}));
+	result = con.Query("SELECT a FROM test WHERE a=12 AND b='world';");
+	REQUIRE(CHECK_COLUMN(result, 0, {}));
+
+	// set a column to NULL should fail
+	REQUIRE_FAIL(con.Query("UPDATE test SET b=NULL WHERE a=12;"));
 }
 
 TEST_CASE("PRIMARY KEY and update/delete in the same transaction", "[constraints]") {
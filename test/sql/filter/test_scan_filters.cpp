@@ -0,0 +1,90 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test filters evaluated inside the table scan", "[filter]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db), con2(db);
+	con.EnableQueryVerification();
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER, j INTEGER, s VARCHAR)"));
+	REQUIRE_NO_FAIL(
+	    con.Query("INSERT INTO integers VALUES (1, 10, 'a'), (2, NULL, 'b'), (3, 30, NULL), (NULL, 40, 'd'), (5, 50, 'e')"));
+
+	// single filter, filter with the constant on the left side
+	result = con.Query("SELECT i, j, s FROM integers WHERE i>2 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {3, 5}));
+	REQUIRE(CHECK_COLUMN(result, 1, {30, 50}));
+	REQUIRE(CHECK_COLUMN(result, 2, {Value(), "e"}));
+	result = con.Query("SELECT i FROM integers WHERE 2>=i ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {1, 2}));
+	// filters on multiple columns, including NULL values
+	result = con.Query("SELECT i, j FROM integers WHERE i>=2 AND j<=40 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {3}));
+	REQUIRE(CHECK_COLUMN(result, 1, {30}));
+	// filter on a column that is not projected
+	result = con.Query("SELECT s FROM integers WHERE j=40");
+	REQUIRE(CHECK_COLUMN(result, 0, {"d"}));
+	// string filters
+	result = con.Query("SELECT i FROM integers WHERE s>'b' ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {Value(), 5}));
+	// filters that are pushed into the scan combined with filters that are not
+	result = con.Query("SELECT i FROM integers WHERE i<5 AND i+j>20 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {3}));
+	// filters together with the row ids of DELETE and UPDATE
+	REQUIRE_NO_FAIL(con.Query("UPDATE integers SET j=j+1 WHERE i>=3"));
+	result = con.Query("SELECT j FROM integers ORDER BY j");
+	REQUIRE(CHECK_COLUMN(result, 0, {Value(), 10, 31, 40, 51}));
+
+	// transaction-local and uncommitted versions have to be filtered as well
+	REQUIRE_NO_FAIL(con2.Query("BEGIN TRANSACTION"));
+	REQUIRE_NO_FAIL(con2.Query("UPDATE integers SET i=100 WHERE i=1"));
+	REQUIRE_NO_FAIL(con2.Query("DELETE FROM integers WHERE i=5"));
+	result = con2.Query("SELECT i FROM integers WHERE i>=3 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {3, 100}));
+	result = con.Query("SELECT i FROM integers WHERE i>=3 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {3, 5}));
+	result = con.Query("SELECT i FROM integers WHERE i<3 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {1, 2}));
+	REQUIRE_NO_FAIL(con2.Query("ROLLBACK"));
+}
+
+TEST_CASE("Test scan filters over multiple column segments", "[filter]") {
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("scan_filter_test");
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE strings(i INTEGER, s VARCHAR)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "strings");
+		for (index_t i = 0; i < 50000; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendString(("this is a longer string " + to_string(i)).c_str());
+			appender->EndRow();
+		}
+		con.CloseAppender();
+	}
+	// reload the database: the string column is now stored in multiple blocks that do not align with the vectors
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		if (i == 0) {
+			REQUIRE_NO_FAIL(con.Query("DELETE FROM strings WHERE i%7=0"));
+		}
+		result = con.Query("SELECT COUNT(*), SUM(i) FROM strings WHERE i>=1000");
+		REQUIRE(CHECK_COLUMN(result, 0, {42000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {1070993000}));
+		result = con.Query("SELECT COUNT(*) FROM strings WHERE i%2=0 AND s<'this is a longer string 2'");
+		REQUIRE(CHECK_COLUMN(result, 0, {4762}));
+		result = con.Query("SELECT s FROM strings WHERE i=49999");
+		REQUIRE(CHECK_COLUMN(result, 0, {"this is a longer string 49999"}));
+	}
+	DeleteDatabase(storage_database);
+}
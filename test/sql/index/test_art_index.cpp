@@ -975,6 +975,87 @@ TEST_CASE("Test updates resulting from big index scans", "[art][.]") {
 	REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(0)}));
 }
 
+TEST_CASE("Test range scans that start in between the keys of the index", "[art]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i integer)"));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (256), (512), (1000)"));
+	REQUIRE_NO_FAIL(con.Query("CREATE INDEX i_index ON integers(i)"));
+
+	// the lower bound is bigger than the keys of the first child of the root
+	result = con.Query("SELECT i FROM integers WHERE i >= 300 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {512, 1000}));
+	result = con.Query("SELECT i FROM integers WHERE i > 300 AND i < 2000 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {512, 1000}));
+	// the lower bound is bigger than all keys
+	result = con.Query("SELECT i FROM integers WHERE i > 1000");
+	REQUIRE(CHECK_COLUMN(result, 0, {}));
+	// the lower bound is smaller than all keys
+	result = con.Query("SELECT i FROM integers WHERE i > 1 AND i <= 512 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {256, 512}));
+	result = con.Query("SELECT i FROM integers WHERE i > 256 AND i < 1000");
+	REQUIRE(CHECK_COLUMN(result, 0, {512}));
+}
+
+TEST_CASE("Test updating the key of the rows found by a streaming index scan", "[art]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i integer, j integer)"));
+	REQUIRE_NO_FAIL(con.Query("CREATE INDEX i_index ON integers(i)"));
+	REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+	for (index_t i = 0; i < 5000; i++) {
+		// every key is stored twice, and the keys are not inserted in order
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES ($1, 0)", (int32_t)((i * 7) % 2500)));
+	}
+	REQUIRE_NO_FAIL(con.Query("COMMIT"));
+
+	// the scan returns more than one batch of row ids
+	result = con.Query("SELECT COUNT(*), SUM(i) FROM integers WHERE i >= 100 AND i < 2400");
+	REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(4600)}));
+	REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(5747700)}));
+
+	// the updated rows are moved to keys the scan has not reached yet, they are only updated once
+	REQUIRE_NO_FAIL(con.Query("UPDATE integers SET i=i+10, j=j+1 WHERE i >= 100"));
+	result = con.Query("SELECT COUNT(*), MIN(j), MAX(j) FROM integers WHERE i >= 110");
+	REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(4800)}));
+	REQUIRE(CHECK_COLUMN(result, 1, {1}));
+	REQUIRE(CHECK_COLUMN(result, 2, {1}));
+	result = con.Query("SELECT COUNT(*), SUM(j) FROM integers");
+	REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(5000)}));
+	REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(4800)}));
+}
+
+TEST_CASE("Test index scans over rows that are not visible to the transaction", "[art]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db), con2(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i integer)"));
+	REQUIRE_NO_FAIL(con.Query("CREATE INDEX i_index ON integers(i)"));
+	// the rows of the uncommitted transaction have the smallest keys and row ids, so the first batches of the scan
+	// do not contain any row that is visible to the other connection
+	REQUIRE_NO_FAIL(con2.Query("BEGIN TRANSACTION"));
+	string values;
+	for (int32_t i = 0; i < 3000; i++) {
+		values += (i == 0 ? "(" : ", (") + to_string(i) + ")";
+	}
+	REQUIRE_NO_FAIL(con2.Query("INSERT INTO integers VALUES " + values));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (5000)"));
+
+	result = con.Query("SELECT i FROM integers WHERE i >= 0");
+	REQUIRE(CHECK_COLUMN(result, 0, {5000}));
+	// the row of the other connection was committed after the transaction started
+	result = con2.Query("SELECT COUNT(*) FROM integers WHERE i >= 0");
+	REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(3000)}));
+	REQUIRE_NO_FAIL(con2.Query("ROLLBACK"));
+	result = con.Query("SELECT i FROM integers WHERE i >= 0");
+	REQUIRE(CHECK_COLUMN(result, 0, {5000}));
+}
+
 TEST_CASE("ART Node 4", "[art]") {
 	unique_ptr<QueryResult> result;
 	DuckDB db(nullptr);
@@ -1092,6 +1173,187 @@ TEST_CASE("ART Node 48", "[art]") {
 	REQUIRE_NO_FAIL(con.Query("DROP TABLE integers"));
 }
 
+TEST_CASE("Test creating an ART index on a big table", "[art]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER, j INTEGER)"));
+	REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+	for (int i = 0; i < 1000; i++) {
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (" + to_string(i) + ", " + to_string(i % 7) + ")"));
+	}
+	// double the table until it contains the values [0, 256000)
+	for (int count = 1000; count < 256000; count *= 2) {
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers SELECT i + " + to_string(count) + ", j FROM integers"));
+	}
+	// the multiples of 10 occur twice, and there is a NULL value
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers SELECT i, j FROM integers WHERE i % 10 = 0"));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (NULL, 0)"));
+	REQUIRE_NO_FAIL(con.Query("COMMIT"));
+
+	// the index is built from the sorted entries, in parallel if there are multiple threads
+	for (index_t threads = 1; threads <= 4; threads += 3) {
+		REQUIRE_NO_FAIL(con.Query("PRAGMA threads=" + to_string(threads)));
+		REQUIRE_NO_FAIL(con.Query("CREATE INDEX i_index_" + to_string(threads) + " ON integers using art(i)"));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i = 12340");
+		REQUIRE(CHECK_COLUMN(result, 0, {2}));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i = 12341");
+		REQUIRE(CHECK_COLUMN(result, 0, {1}));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i = 256000");
+		REQUIRE(CHECK_COLUMN(result, 0, {0}));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i >= 1000 AND i < 2000");
+		REQUIRE(CHECK_COLUMN(result, 0, {1100}));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i < 100");
+		REQUIRE(CHECK_COLUMN(result, 0, {110}));
+		result = con.Query("SELECT COUNT(*), SUM(j) FROM integers WHERE i > 255900");
+		REQUIRE(CHECK_COLUMN(result, 0, {108}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(323)}));
+		// the index can be changed after it has been built
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i = 12341"));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i = 12341");
+		REQUIRE(CHECK_COLUMN(result, 0, {0}));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (12341, 0)"));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i = 12341");
+		REQUIRE(CHECK_COLUMN(result, 0, {1}));
+	}
+}
+
+TEST_CASE("ART VARCHAR keys", "[art]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	// strings that are prefixes of each other, and long strings with a long common prefix
+	string long_prefix(100, 'x');
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE strings(i INTEGER, s VARCHAR)"));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO strings VALUES (0, ''), (1, 'a'), (2, 'ab'), (3, 'abc'), (4, 'abd'), (5, "
+	                          "'b'), (6, '" +
+	                          long_prefix + "a'), (7, '" + long_prefix + "b'), (8, NULL)"));
+	REQUIRE_NO_FAIL(con.Query("CREATE INDEX i_index ON strings(s)"));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO strings VALUES (9, 'abcd'), (10, '" + long_prefix + "'), (11, 'ab')"));
+
+	result = con.Query("SELECT i FROM strings WHERE s = 'ab' ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {2, 11}));
+	result = con.Query("SELECT i FROM strings WHERE s = ''");
+	REQUIRE(CHECK_COLUMN(result, 0, {0}));
+	result = con.Query("SELECT i FROM strings WHERE s = '" + long_prefix + "'");
+	REQUIRE(CHECK_COLUMN(result, 0, {10}));
+	result = con.Query("SELECT i FROM strings WHERE s = '" + long_prefix + "b'");
+	REQUIRE(CHECK_COLUMN(result, 0, {7}));
+	result = con.Query("SELECT i FROM strings WHERE s = 'abcde'");
+	REQUIRE(CHECK_COLUMN(result, 0, {}));
+	result = con.Query("SELECT COUNT(*) FROM strings WHERE s >= 'ab' AND s < 'b'");
+	REQUIRE(CHECK_COLUMN(result, 0, {5}));
+	result = con.Query("SELECT COUNT(*) FROM strings WHERE s > '" + long_prefix + "'");
+	REQUIRE(CHECK_COLUMN(result, 0, {2}));
+	result = con.Query("SELECT i FROM strings WHERE s < 'a'");
+	REQUIRE(CHECK_COLUMN(result, 0, {0}));
+
+	REQUIRE_NO_FAIL(con.Query("DELETE FROM strings WHERE i = 3"));
+	result = con.Query("SELECT i FROM strings WHERE s = 'abc'");
+	REQUIRE(CHECK_COLUMN(result, 0, {}));
+	result = con.Query("SELECT i FROM strings WHERE s = 'abcd'");
+	REQUIRE(CHECK_COLUMN(result, 0, {9}));
+}
+
+TEST_CASE("ART FLOAT and DOUBLE keys", "[art]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE numbers(i INTEGER, f FLOAT, d DOUBLE)"));
+	REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+	for (int i = -50; i <= 50; i++) {
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO numbers VALUES (" + to_string(i) + ", " + to_string(i * 0.25) + ", " +
+		                          to_string(i) + "e10)"));
+	}
+	REQUIRE_NO_FAIL(con.Query("COMMIT"));
+	REQUIRE_NO_FAIL(con.Query("CREATE INDEX f_index ON numbers(f)"));
+	REQUIRE_NO_FAIL(con.Query("CREATE INDEX d_index ON numbers(d)"));
+
+	// negative numbers are ordered before positive numbers, and by decreasing magnitude
+	result = con.Query("SELECT COUNT(*) FROM numbers WHERE f > -1.0");
+	REQUIRE(CHECK_COLUMN(result, 0, {54}));
+	result = con.Query("SELECT COUNT(*) FROM numbers WHERE f <= -10");
+	REQUIRE(CHECK_COLUMN(result, 0, {11}));
+	result = con.Query("SELECT i FROM numbers WHERE f = 2.5");
+	REQUIRE(CHECK_COLUMN(result, 0, {10}));
+	result = con.Query("SELECT COUNT(*) FROM numbers WHERE d >= -1e11 AND d < 5e10");
+	REQUIRE(CHECK_COLUMN(result, 0, {15}));
+	result = con.Query("SELECT i FROM numbers WHERE d < -4.5e11 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {-50, -49, -48, -47, -46}));
+	result = con.Query("SELECT i FROM numbers WHERE d = 0");
+	REQUIRE(CHECK_COLUMN(result, 0, {0}));
+	result = con.Query("SELECT i FROM numbers WHERE d = -1e10");
+	REQUIRE(CHECK_COLUMN(result, 0, {-1}));
+}
+
+TEST_CASE("ART keys on multiple columns", "[art]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE users(tenant_id INTEGER, user_name VARCHAR, age INTEGER)"));
+	for (int tenant = 0; tenant < 10; tenant++) {
+		string values;
+		for (int user = 0; user < 200; user++) {
+			values += (user == 0 ? "(" : ", (") + to_string(tenant) + ", 'user" + to_string(user) + "', " +
+			          to_string(tenant * 1000 + user) + ")";
+		}
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO users VALUES " + values));
+	}
+	REQUIRE_NO_FAIL(con.Query("CREATE INDEX users_index ON users(tenant_id, user_name)"));
+	// rows with a NULL in any of the columns are not part of the index
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO users VALUES (3, 'user5', 1), (NULL, 'user5', 2), (3, NULL, 3)"));
+
+	result = con.Query("SELECT age FROM users WHERE tenant_id = 3 AND user_name = 'user17'");
+	REQUIRE(CHECK_COLUMN(result, 0, {3017}));
+	result = con.Query("SELECT age FROM users WHERE user_name = 'user5' AND tenant_id = 3 ORDER BY age");
+	REQUIRE(CHECK_COLUMN(result, 0, {1, 3005}));
+	result = con.Query("SELECT age FROM users WHERE tenant_id = 3 AND user_name = 'user200'");
+	REQUIRE(CHECK_COLUMN(result, 0, {}));
+	result = con.Query("SELECT age FROM users WHERE tenant_id = 10 AND user_name = 'user1'");
+	REQUIRE(CHECK_COLUMN(result, 0, {}));
+	result = con.Query("SELECT COUNT(*) FROM users WHERE tenant_id = 3");
+	REQUIRE(CHECK_COLUMN(result, 0, {202}));
+
+	REQUIRE_NO_FAIL(con.Query("DELETE FROM users WHERE age = 3017"));
+	result = con.Query("SELECT age FROM users WHERE tenant_id = 3 AND user_name = 'user17'");
+	REQUIRE(CHECK_COLUMN(result, 0, {}));
+	result = con.Query("SELECT age FROM users WHERE tenant_id = 3 AND user_name = 'user18'");
+	REQUIRE(CHECK_COLUMN(result, 0, {3018}));
+}
+
+TEST_CASE("Test deleting keys until the nodes of the ART shrink", "[art]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER PRIMARY KEY)"));
+	// the keys only differ in their last byte, so they are all children of the same node
+	string values, deleted_values;
+	for (int32_t i = 0; i < 100; i++) {
+		values += (i == 0 ? "(" : ", (") + to_string(i) + ")";
+		if (i >= 2) {
+			deleted_values += (i == 2 ? "(" : ", (") + to_string(i) + ")";
+		}
+	}
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES " + values));
+	// every key is deleted on its own, so the node shrinks from a Node256 to a Node48, a Node16 and a Node4
+	for (int32_t i = 99; i >= 2; i--) {
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i = " + to_string(i)));
+	}
+	result = con.Query("SELECT i FROM integers ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {0, 1}));
+	// the deleted keys were removed from the index when the nodes shrunk, so they can be inserted again
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES " + deleted_values));
+	result = con.Query("SELECT COUNT(*), SUM(i) FROM integers WHERE i >= 0");
+	REQUIRE(CHECK_COLUMN(result, 0, {100}));
+	REQUIRE(CHECK_COLUMN(result, 1, {4950}));
+	REQUIRE_FAIL(con.Query("INSERT INTO integers VALUES (50)"));
+}
+
 TEST_CASE("Index Exceptions", "[art]") {
 	unique_ptr<QueryResult> result;
 	DuckDB db(nullptr);
@@ -1106,9 +1368,48 @@ TEST_CASE("Index Exceptions", "[art]") {
 
 	REQUIRE_FAIL(con.Query("CREATE INDEX i_index ON integers using blabla(i)"));
 
-	REQUIRE_FAIL(con.Query("CREATE INDEX i_index ON integers(i,j)"));
+	REQUIRE_FAIL(con.Query("CREATE INDEX i_index ON integers(i,k)"));
 
 	REQUIRE_FAIL(con.Query("CREATE INDEX i_index ON integers(k)"));
 
 	REQUIRE_FAIL(con.Query("CREATE INDEX i_index ON integers(f)"));
 }
+
+TEST_CASE("Delete and update rows of index scans that span storage chunks", "[art]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE big(i INTEGER PRIMARY KEY, j INTEGER, s VARCHAR)"));
+	// consecutive keys are spread over all storage chunks of the table
+	auto appender = con.OpenAppender(DEFAULT_SCHEMA, "big");
+	for (int32_t i = 0; i < 250000; i++) {
+		int32_t key = (int32_t)(((int64_t)i * 7919) % 250000);
+		appender->BeginRow();
+		appender->AppendInteger(key);
+		appender->AppendInteger(key);
+		appender->AppendString("string");
+		appender->EndRow();
+	}
+	con.CloseAppender();
+
+	// the rows are verified with full scans of the table
+	REQUIRE_NO_FAIL(con.Query("UPDATE big SET j = j + 1 WHERE i >= 100000 AND i < 150000"));
+	REQUIRE_NO_FAIL(con.Query("UPDATE big SET s = 'updated' WHERE i >= 150000 AND i < 155000"));
+	result = con.Query("SELECT COUNT(*), SUM(j) FROM big");
+	REQUIRE(CHECK_COLUMN(result, 0, {250000}));
+	REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(31249925000)}));
+	result = con.Query("SELECT COUNT(*), MIN(j), MAX(j) FROM big WHERE s = 'updated'");
+	REQUIRE(CHECK_COLUMN(result, 0, {5000}));
+	REQUIRE(CHECK_COLUMN(result, 1, {150000}));
+	REQUIRE(CHECK_COLUMN(result, 2, {154999}));
+
+	REQUIRE_NO_FAIL(con.Query("DELETE FROM big WHERE i >= 200000"));
+	result = con.Query("SELECT COUNT(*), SUM(j), MAX(j) FROM big");
+	REQUIRE(CHECK_COLUMN(result, 0, {200000}));
+	REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(19999950000)}));
+	REQUIRE(CHECK_COLUMN(result, 2, {199999}));
+	// the deleted keys can be inserted again
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO big VALUES (200000, 0, 'string')"));
+	REQUIRE_FAIL(con.Query("INSERT INTO big VALUES (199999, 0, 'string')"));
+}
@@ -297,3 +297,63 @@ TEST_CASE("Parallel appends to table with index with transactions", "[index][.]"
 	REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(THREAD_COUNT * 500)}));
 	REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(THREAD_COUNT * 500)}));
 }
+
+static void scan_unchanged_keys(DuckDB *db, bool *correct, index_t threadnr) {
+	Connection con(*db);
+	correct[threadnr] = true;
+	while (!is_finished) {
+		// the rows with keys below 1000 are never changed by the writer
+		auto result = con.Query("SELECT COUNT(*), SUM(i) FROM integers WHERE i >= 0 AND i < 1000");
+		if (!CHECK_COLUMN(result, 0, {1000}) || !CHECK_COLUMN(result, 1, {499500})) {
+			correct[threadnr] = false;
+		}
+		result = con.Query("SELECT j FROM integers WHERE i = " + to_string(threadnr * 100 + 7));
+		if (!CHECK_COLUMN(result, 0, {Value::INTEGER(threadnr * 100 + 7)})) {
+			correct[threadnr] = false;
+		}
+	}
+}
+
+TEST_CASE("Concurrent index scans while the index is modified", "[index]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER PRIMARY KEY, j INTEGER)"));
+	auto appender = con.OpenAppender(DEFAULT_SCHEMA, "integers");
+	for (int32_t i = 0; i < 2000; i++) {
+		appender->BeginRow();
+		appender->AppendInteger(i);
+		appender->AppendInteger(i);
+		appender->EndRow();
+	}
+	con.CloseAppender();
+
+	is_finished = false;
+	// launch the readers, they scan the index while its nodes are split, grown, shrunk and replaced
+	bool correct[4];
+	thread threads[4];
+	for (index_t i = 0; i < 4; i++) {
+		threads[i] = thread(scan_unchanged_keys, &db, correct, i);
+	}
+	// the readers keep the old keys of updated and deleted rows from being cleaned up, so every round uses new keys
+	for (int32_t round = 0; round < 10; round++) {
+		string values;
+		for (int32_t i = 0; i < 200; i++) {
+			values += (i == 0 ? "(" : ", (") + to_string(5000 + round * 2000 + i * 7) + ", 0)";
+		}
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES " + values));
+		REQUIRE_NO_FAIL(con.Query("UPDATE integers SET i = i + 100000 WHERE i >= 1000 AND j > 0"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i >= 5000 AND i < 100000"));
+	}
+	is_finished = true;
+
+	for (index_t i = 0; i < 4; i++) {
+		threads[i].join();
+		REQUIRE(correct[i]);
+	}
+	result = con.Query("SELECT COUNT(*), SUM(i), SUM(j) FROM integers WHERE i >= 0");
+	REQUIRE(CHECK_COLUMN(result, 0, {2000}));
+	REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(1001999000)}));
+	REQUIRE(CHECK_COLUMN(result, 2, {1999000}));
+}
@@ -0,0 +1,98 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test hash joins with a build side larger than the memory limit", "[join]") {
+	unique_ptr<QueryResult> result;
+	auto config = GetTestConfig();
+	auto temp_directory = TestCreatePath("grace_hash_join_tmp");
+	TestDeleteDirectory(temp_directory);
+	config->temporary_directory = temp_directory;
+
+	index_t left_count = 20000, right_count = 50000;
+	{
+		DuckDB db(nullptr, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE l(i INTEGER, s VARCHAR)"));
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE r(i INTEGER, j INTEGER, s VARCHAR)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "l");
+		for (index_t k = 0; k < left_count; k++) {
+			// every hundredth key is NULL, the keys [0, 40000) with a step of two match half of the keys of r
+			appender->BeginRow();
+			if (k % 100 == 0) {
+				appender->AppendValue(Value());
+				appender->AppendValue(Value());
+			} else {
+				auto str = "string " + to_string(k * 2);
+				appender->AppendInteger((int32_t)(k * 2));
+				appender->AppendString(str.c_str());
+			}
+			appender->EndRow();
+		}
+		con.CloseAppender();
+		appender = con.OpenAppender(DEFAULT_SCHEMA, "r");
+		for (index_t k = 0; k < right_count; k++) {
+			appender->BeginRow();
+			if (k % 1000 == 0) {
+				appender->AppendValue(Value());
+			} else {
+				appender->AppendInteger((int32_t)k);
+			}
+			appender->AppendInteger((int32_t)(k % 7));
+			auto str = "string " + to_string(k);
+			appender->AppendString(str.c_str());
+			appender->EndRow();
+		}
+		con.CloseAppender();
+
+		vector<string> queries = {
+		    // inner joins, with and without payload on the build side
+		    "SELECT COUNT(*), SUM(l.i), SUM(r.j) FROM l JOIN r ON l.i=r.i",
+		    "SELECT COUNT(*), SUM(l.i) FROM l JOIN r ON l.i=r.i",
+		    "SELECT COUNT(*), MIN(r.s), MAX(l.s) FROM l JOIN r ON l.s=r.s",
+		    // multiple join conditions
+		    "SELECT COUNT(*), SUM(r.j) FROM l JOIN r ON l.i=r.i AND l.s=r.s",
+		    // left outer join
+		    "SELECT COUNT(*), COUNT(r.i), SUM(r.j) FROM l LEFT JOIN r ON l.i=r.i",
+		    // semi, anti and mark joins
+		    "SELECT COUNT(*), SUM(i) FROM l WHERE i IN (SELECT i FROM r)",
+		    "SELECT COUNT(*), SUM(i) FROM l WHERE i NOT IN (SELECT i FROM r)",
+		    "SELECT COUNT(*), SUM(i) FROM l WHERE i NOT IN (SELECT i FROM r WHERE i IS NOT NULL)",
+		    "SELECT COUNT(*) FROM l WHERE EXISTS (SELECT i FROM r WHERE r.i=l.i)",
+		    "SELECT COUNT(*) FROM l WHERE NOT EXISTS (SELECT i FROM r WHERE r.i=l.i)",
+		    "SELECT SUM(CASE WHEN i IN (SELECT i FROM r WHERE i IS NOT NULL) THEN 1 ELSE 0 END) FROM l",
+		};
+
+		// compute the expected results without a memory limit
+		vector<vector<vector<Value>>> expected_results;
+		for (auto &query : queries) {
+			auto expected = con.Query(query);
+			REQUIRE(expected->success);
+			vector<vector<Value>> columns(expected->types.size());
+			for (index_t col = 0; col < columns.size(); col++) {
+				for (index_t row = 0; row < expected->collection.count; row++) {
+					columns[col].push_back(expected->GetValue(col, row));
+				}
+			}
+			expected_results.push_back(move(columns));
+		}
+
+		// the memory limit is much smaller than the build side: the join partitions both sides to disk
+		REQUIRE_NO_FAIL(con.Query("PRAGMA memory_limit=100KB"));
+		for (index_t threads = 1; threads <= 4; threads += 3) {
+			REQUIRE_NO_FAIL(con.Query("PRAGMA threads=" + to_string(threads)));
+			for (index_t q = 0; q < queries.size(); q++) {
+				result = con.Query(queries[q]);
+				for (index_t col = 0; col < expected_results[q].size(); col++) {
+					REQUIRE(CHECK_COLUMN(result, col, expected_results[q][col]));
+				}
+			}
+		}
+		// the partitions were written to the temporary directory
+		REQUIRE(db.file_system->DirectoryExists(temp_directory));
+	}
+	FileSystem fs;
+	REQUIRE(!fs.DirectoryExists(temp_directory));
+}
@@ -0,0 +1,148 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+static void CreateParallelTestData(Connection &con) {
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER, g INTEGER)"));
+	// insert enough rows to span multiple morsels
+	auto appender = con.OpenAppender(DEFAULT_SCHEMA, "integers");
+	for (index_t i = 0; i < 100000; i++) {
+		appender->BeginRow();
+		appender->AppendInteger(i);
+		appender->AppendInteger(i % 10);
+		appender->EndRow();
+	}
+	con.CloseAppender();
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE strings AS SELECT i, CAST(g AS VARCHAR) AS s FROM integers"));
+}
+
+TEST_CASE("Test parallel aggregation", "[parallel]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+	CreateParallelTestData(con);
+
+	for (index_t threads = 1; threads <= 4; threads *= 2) {
+		REQUIRE_NO_FAIL(con.Query("PRAGMA threads=" + to_string(threads)));
+
+		result = con.Query("SELECT COUNT(*), SUM(i), MIN(i), MAX(i) FROM integers");
+		REQUIRE(CHECK_COLUMN(result, 0, {100000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(4999950000)}));
+		REQUIRE(CHECK_COLUMN(result, 2, {0}));
+		REQUIRE(CHECK_COLUMN(result, 3, {99999}));
+
+		// filter and projection in the pipeline
+		result = con.Query("SELECT COUNT(*), SUM(i + 1) FROM integers WHERE i % 2 = 0");
+		REQUIRE(CHECK_COLUMN(result, 0, {50000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(2500000000)}));
+
+		// grouped aggregates
+		result = con.Query("SELECT g, COUNT(*), SUM(i) FROM integers GROUP BY g ORDER BY g");
+		REQUIRE(CHECK_COLUMN(result, 0, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+		REQUIRE(CHECK_COLUMN(result, 1, {10000, 10000, 10000, 10000, 10000, 10000, 10000, 10000, 10000, 10000}));
+		REQUIRE(CHECK_COLUMN(result, 2,
+		                     {499950000, 499960000, 499970000, 499980000, 499990000, 500000000, 500010000, 500020000,
+		                      500030000, 500040000}));
+
+		// distinct aggregates and string groups
+		result = con.Query("SELECT s, COUNT(DISTINCT i % 100) FROM strings GROUP BY s ORDER BY s");
+		REQUIRE(CHECK_COLUMN(result, 0, {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9"}));
+		REQUIRE(CHECK_COLUMN(result, 1, {10, 10, 10, 10, 10, 10, 10, 10, 10, 10}));
+	}
+}
+
+TEST_CASE("Test partitioned parallel aggregation", "[parallel]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+	CreateParallelTestData(con);
+
+	for (index_t threads = 1; threads <= 4; threads *= 2) {
+		REQUIRE_NO_FAIL(con.Query("PRAGMA threads=" + to_string(threads)));
+
+		// many groups spread over all partitions
+		result = con.Query("SELECT COUNT(*), SUM(c), SUM(s), MIN(c), MAX(c) FROM (SELECT i % 50000 AS k, COUNT(*) AS c, "
+		                   "SUM(i) AS s FROM integers GROUP BY k) t");
+		REQUIRE(CHECK_COLUMN(result, 0, {50000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {100000}));
+		REQUIRE(CHECK_COLUMN(result, 2, {Value::BIGINT(4999950000)}));
+		REQUIRE(CHECK_COLUMN(result, 3, {2}));
+		REQUIRE(CHECK_COLUMN(result, 4, {2}));
+
+		// combining algebraic aggregates
+		result = con.Query("SELECT g, AVG(i), MIN(i), MAX(i), STDDEV_POP(g) FROM integers GROUP BY g ORDER BY g");
+		REQUIRE(CHECK_COLUMN(result, 0, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+		REQUIRE(CHECK_COLUMN(result, 1,
+		                     {49995.0, 49996.0, 49997.0, 49998.0, 49999.0, 50000.0, 50001.0, 50002.0, 50003.0, 50004.0}));
+		REQUIRE(CHECK_COLUMN(result, 2, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+		REQUIRE(CHECK_COLUMN(result, 3, {99990, 99991, 99992, 99993, 99994, 99995, 99996, 99997, 99998, 99999}));
+		REQUIRE(CHECK_COLUMN(result, 4, {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}));
+
+		// string groups and string aggregate states
+		result = con.Query("SELECT s, MIN(CAST(i AS VARCHAR)), MAX(CAST(i AS VARCHAR)) FROM strings WHERE i % 10 < 3 "
+		                   "GROUP BY s ORDER BY s");
+		REQUIRE(CHECK_COLUMN(result, 0, {"0", "1", "2"}));
+		REQUIRE(CHECK_COLUMN(result, 1, {"0", "1", "10002"}));
+		REQUIRE(CHECK_COLUMN(result, 2, {"99990", "99991", "99992"}));
+	}
+}
+
+TEST_CASE("Test parallel hash join build and order", "[parallel]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+	CreateParallelTestData(con);
+
+	for (index_t threads = 1; threads <= 4; threads *= 2) {
+		REQUIRE_NO_FAIL(con.Query("PRAGMA threads=" + to_string(threads)));
+
+		result = con.Query("SELECT COUNT(*), SUM(i2.i) FROM integers i1, integers i2 WHERE i1.i=i2.i AND i1.i < 1000");
+		REQUIRE(CHECK_COLUMN(result, 0, {1000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {499500}));
+
+		result = con.Query("SELECT COUNT(*) FROM strings s1, integers i1 WHERE s1.i=i1.i AND s1.s='3'");
+		REQUIRE(CHECK_COLUMN(result, 0, {10000}));
+
+		result = con.Query("SELECT i FROM integers WHERE i % 1000 = 0 ORDER BY i DESC LIMIT 3");
+		REQUIRE(CHECK_COLUMN(result, 0, {99000, 98000, 97000}));
+
+		result = con.Query("SELECT s, i FROM strings WHERE i % 10000 = 3 ORDER BY i");
+		REQUIRE(CHECK_COLUMN(result, 0, {"3", "3", "3", "3", "3", "3", "3", "3", "3", "3"}));
+		REQUIRE(CHECK_COLUMN(result, 1, {3, 10003, 20003, 30003, 40003, 50003, 60003, 70003, 80003, 90003}));
+	}
+}
+
+TEST_CASE("Test parallel hash join build and probe", "[parallel]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+	CreateParallelTestData(con);
+
+	for (index_t threads = 1; threads <= 4; threads *= 2) {
+		REQUIRE_NO_FAIL(con.Query("PRAGMA threads=" + to_string(threads)));
+
+		// large build side with many duplicate keys
+		result = con.Query("SELECT COUNT(*), SUM(i1.i) FROM integers i1, integers i2 WHERE i1.i=i2.g");
+		REQUIRE(CHECK_COLUMN(result, 0, {100000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {450000}));
+
+		// the probe side is scanned by multiple threads, the string payload comes from the build side
+		result = con.Query("SELECT COUNT(*), MIN(s1.s), MAX(s1.s) FROM integers i1, strings s1 WHERE i1.i=s1.i AND "
+		                   "i1.i % 2 = 1");
+		REQUIRE(CHECK_COLUMN(result, 0, {50000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {"1"}));
+		REQUIRE(CHECK_COLUMN(result, 2, {"9"}));
+
+		// semi, anti, mark and left joins
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i IN (SELECT i * 2 FROM integers)");
+		REQUIRE(CHECK_COLUMN(result, 0, {50000}));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i NOT IN (SELECT i * 2 FROM integers)");
+		REQUIRE(CHECK_COLUMN(result, 0, {50000}));
+		result = con.Query("SELECT COUNT(*), COUNT(i2.i) FROM integers i1 LEFT JOIN (SELECT i FROM integers WHERE i "
+		                   "< 10) i2 ON i1.i=i2.i");
+		REQUIRE(CHECK_COLUMN(result, 0, {100000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {10}));
+	}
+}
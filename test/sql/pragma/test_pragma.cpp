@@ -46,3 +46,18 @@ TEST_CASE("Test PRAGMA enable_profiling parsing", "[pragma]") {
 	// but we can clear it again
 	REQUIRE_NO_FAIL(con.Query("PRAGMA profiling_output="));
 }
+
+TEST_CASE("Test PRAGMA threads parsing", "[pragma]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("PRAGMA threads=4"));
+	REQUIRE_NO_FAIL(con.Query("PRAGMA threads = 2;"));
+	REQUIRE_NO_FAIL(con.Query("PRAGMA threads=1"));
+	// threads must be assigned a positive integer
+	REQUIRE_FAIL(con.Query("PRAGMA threads"));
+	REQUIRE_FAIL(con.Query("PRAGMA threads=0"));
+	REQUIRE_FAIL(con.Query("PRAGMA threads=-1"));
+	REQUIRE_FAIL(con.Query("PRAGMA threads=abc"));
+}
@@ -366,3 +366,40 @@ TEST_CASE("PREPARE with NULL", "[prepared]") {
 	result = con.Query("SELECT i FROM b");
 	REQUIRE(CHECK_COLUMN(result, 0, {Value()}));
 }
+
+TEST_CASE("PREPARE for hash joins", "[prepared]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE l (i INTEGER)"));
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE r (i INTEGER, j INTEGER)"));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO l VALUES (1), (2), (3)"));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO r VALUES (1, 10), (2, 20)"));
+
+	// every execution builds the hash table from the current contents of the build side
+	REQUIRE_NO_FAIL(con.Query("PREPARE s1 AS SELECT l.i, r.j FROM l, r WHERE l.i=r.i ORDER BY 1"));
+	result = con.Query("EXECUTE s1");
+	REQUIRE(CHECK_COLUMN(result, 0, {1, 2}));
+	REQUIRE(CHECK_COLUMN(result, 1, {10, 20}));
+	result = con.Query("EXECUTE s1");
+	REQUIRE(CHECK_COLUMN(result, 0, {1, 2}));
+	REQUIRE(CHECK_COLUMN(result, 1, {10, 20}));
+
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO r VALUES (3, 30)"));
+	REQUIRE_NO_FAIL(con.Query("DELETE FROM r WHERE i=1"));
+	result = con.Query("EXECUTE s1");
+	REQUIRE(CHECK_COLUMN(result, 0, {2, 3}));
+	REQUIRE(CHECK_COLUMN(result, 1, {20, 30}));
+
+	// correlated MARK join, the duplicate eliminated side is materialized again for every execution
+	REQUIRE_NO_FAIL(
+	    con.Query("PREPARE s2 AS SELECT i, i IN (SELECT r.i FROM r WHERE r.j > l.i * 10) FROM l ORDER BY 1"));
+	result = con.Query("EXECUTE s2");
+	REQUIRE(CHECK_COLUMN(result, 0, {1, 2, 3}));
+	REQUIRE(CHECK_COLUMN(result, 1, {false, false, false}));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO r VALUES (1, 11)"));
+	result = con.Query("EXECUTE s2");
+	REQUIRE(CHECK_COLUMN(result, 0, {1, 2, 3}));
+	REQUIRE(CHECK_COLUMN(result, 1, {true, false, false}));
+}
@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+
+#include <algorithm>
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test ORDER BY on data larger than the memory limit", "[order]") {
+	unique_ptr<QueryResult> result;
+	auto config = GetTestConfig();
+	auto temp_directory = TestCreatePath("external_sort_tmp");
+	TestDeleteDirectory(temp_directory);
+	config->temporary_directory = temp_directory;
+
+	index_t tuple_count = 50000;
+	vector<int> integers;
+	vector<string> strings;
+	{
+		DuckDB db(nullptr, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE test(i INTEGER, s VARCHAR)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "test");
+		for (index_t k = 0; k < tuple_count; k++) {
+			// every tenth value is NULL, the others are a permutation of [0, tuple_count)
+			int value = (int)((k * 7919) % tuple_count);
+			appender->BeginRow();
+			if (k % 10 == 0) {
+				appender->AppendValue(Value());
+				appender->AppendValue(Value());
+			} else {
+				auto str = "string " + to_string(value);
+				appender->AppendInteger(value);
+				appender->AppendString(str.c_str());
+				integers.push_back(value);
+				strings.push_back(str);
+			}
+			appender->EndRow();
+		}
+		con.CloseAppender();
+		index_t null_count = tuple_count - integers.size();
+
+		sort(integers.begin(), integers.end());
+		sort(strings.begin(), strings.end());
+		vector<Value> expected_asc, expected_desc, expected_strings;
+		for (index_t k = 0; k < null_count; k++) {
+			expected_asc.push_back(Value());
+			expected_strings.push_back(Value());
+		}
+		for (index_t k = 0; k < integers.size(); k++) {
+			expected_asc.push_back(Value::INTEGER(integers[k]));
+			expected_desc.push_back(Value::INTEGER(integers[integers.size() - k - 1]));
+			expected_strings.push_back(Value(strings[k]));
+		}
+		for (index_t k = 0; k < null_count; k++) {
+			expected_desc.push_back(Value());
+		}
+
+		// the memory limit is much smaller than the table: the sort has to spill sorted runs to disk
+		REQUIRE_NO_FAIL(con.Query("PRAGMA memory_limit=100KB"));
+		for (index_t threads = 1; threads <= 4; threads += 3) {
+			REQUIRE_NO_FAIL(con.Query("PRAGMA threads=" + to_string(threads)));
+
+			result = con.Query("SELECT i FROM test ORDER BY i");
+			REQUIRE(CHECK_COLUMN(result, 0, expected_asc));
+			result = con.Query("SELECT i, s FROM test ORDER BY i DESC");
+			REQUIRE(CHECK_COLUMN(result, 0, expected_desc));
+			result = con.Query("SELECT s, i FROM test ORDER BY s");
+			REQUIRE(CHECK_COLUMN(result, 0, expected_strings));
+			// multiple sort keys and expressions as sort keys
+			result = con.Query("SELECT i % 2 AS m, i FROM test WHERE i IS NOT NULL ORDER BY m DESC, i LIMIT 3");
+			REQUIRE(CHECK_COLUMN(result, 0, {1, 1, 1}));
+			REQUIRE(CHECK_COLUMN(result, 1, {1, 3, 5}));
+			result = con.Query("SELECT COUNT(*) FROM (SELECT i FROM test ORDER BY s DESC) t");
+			REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(tuple_count)}));
+		}
+		// the temporary files were written to the temporary directory
+		REQUIRE(db.file_system->DirectoryExists(temp_directory));
+
+		// without a memory limit the sort happens in memory
+		REQUIRE_NO_FAIL(con.Query("PRAGMA memory_limit=-1"));
+		result = con.Query("SELECT i FROM test ORDER BY i");
+		REQUIRE(CHECK_COLUMN(result, 0, expected_asc));
+	}
+	// the temporary directory is removed when the database is closed
+	FileSystem fs;
+	REQUIRE(!fs.DirectoryExists(temp_directory));
+}
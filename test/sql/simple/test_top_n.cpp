@@ -0,0 +1,92 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test ORDER BY with LIMIT (Top-N)", "[order]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+	con.EnableQueryVerification();
+
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE test (a INTEGER, b INTEGER, s VARCHAR);"));
+	REQUIRE_NO_FAIL(con.Query(
+	    "INSERT INTO test VALUES (11, 22, 'a'), (12, 21, 'b'), (13, 22, 'c'), (NULL, 23, NULL), (10, NULL, 'e')"));
+
+	// ORDER BY + LIMIT is planned as a Top-N operator
+	result = con.Query("EXPLAIN SELECT a FROM test ORDER BY a LIMIT 2");
+	REQUIRE(result->success);
+	auto plan = ((MaterializedQueryResult &)*result).collection.GetValue(1, 2).str_value;
+	REQUIRE(plan.find("TOP_N") != string::npos);
+
+	result = con.Query("SELECT a FROM test ORDER BY a LIMIT 2");
+	REQUIRE(CHECK_COLUMN(result, 0, {Value(), 10}));
+	result = con.Query("SELECT a, s FROM test ORDER BY a DESC LIMIT 3");
+	REQUIRE(CHECK_COLUMN(result, 0, {13, 12, 11}));
+	REQUIRE(CHECK_COLUMN(result, 1, {"c", "b", "a"}));
+	result = con.Query("SELECT b, a FROM test ORDER BY b DESC, a LIMIT 3");
+	REQUIRE(CHECK_COLUMN(result, 0, {23, 22, 22}));
+	REQUIRE(CHECK_COLUMN(result, 1, {Value(), 11, 13}));
+	// offset
+	result = con.Query("SELECT a FROM test ORDER BY a LIMIT 2 OFFSET 2");
+	REQUIRE(CHECK_COLUMN(result, 0, {11, 12}));
+	result = con.Query("SELECT a FROM test ORDER BY a LIMIT 10 OFFSET 3");
+	REQUIRE(CHECK_COLUMN(result, 0, {12, 13}));
+	result = con.Query("SELECT a FROM test ORDER BY a LIMIT 10 OFFSET 10");
+	REQUIRE(CHECK_COLUMN(result, 0, {}));
+	result = con.Query("SELECT a FROM test ORDER BY a OFFSET 4");
+	REQUIRE(CHECK_COLUMN(result, 0, {13}));
+	// limit larger than the input and limit zero
+	result = con.Query("SELECT s FROM test ORDER BY s DESC LIMIT 100");
+	REQUIRE(CHECK_COLUMN(result, 0, {"e", "c", "b", "a", Value()}));
+	result = con.Query("SELECT s FROM test ORDER BY s LIMIT 0");
+	REQUIRE(CHECK_COLUMN(result, 0, {}));
+	// order by an expression that is not projected
+	result = con.Query("SELECT s FROM test ORDER BY b * -1 LIMIT 2");
+	REQUIRE(CHECK_COLUMN(result, 0, {"e", Value()}));
+}
+
+TEST_CASE("Test Top-N with large table", "[order]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	index_t count = 100000;
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE test (i INTEGER, s VARCHAR);"));
+	auto appender = con.OpenAppender(DEFAULT_SCHEMA, "test");
+	for (index_t k = 0; k < count; k++) {
+		// a permutation of [0, count)
+		int value = (int)((k * 7919) % count);
+		appender->BeginRow();
+		appender->AppendInteger(value);
+		appender->AppendString(("s" + to_string(value)).c_str());
+		appender->EndRow();
+	}
+	con.CloseAppender();
+
+	for (index_t threads = 1; threads <= 4; threads += 3) {
+		REQUIRE_NO_FAIL(con.Query("PRAGMA threads=" + to_string(threads)));
+		result = con.Query("SELECT i, s FROM test ORDER BY i LIMIT 3");
+		REQUIRE(CHECK_COLUMN(result, 0, {0, 1, 2}));
+		REQUIRE(CHECK_COLUMN(result, 1, {"s0", "s1", "s2"}));
+		result = con.Query("SELECT i FROM test ORDER BY i DESC LIMIT 3 OFFSET 5000");
+		REQUIRE(CHECK_COLUMN(result, 0, {94999, 94998, 94997}));
+		result = con.Query("SELECT s FROM test ORDER BY s LIMIT 3");
+		REQUIRE(CHECK_COLUMN(result, 0, {"s0", "s1", "s10"}));
+		// a limit larger than a vector
+		result = con.Query("SELECT SUM(i), COUNT(*), MIN(i), MAX(i) FROM (SELECT i FROM test ORDER BY i LIMIT 5000 "
+		                   "OFFSET 1000) t");
+		REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(17497500)}));
+		REQUIRE(CHECK_COLUMN(result, 1, {5000}));
+		REQUIRE(CHECK_COLUMN(result, 2, {1000}));
+		REQUIRE(CHECK_COLUMN(result, 3, {5999}));
+		// limit + offset is larger than the maximum signed integer: the heap is never compacted
+		result = con.Query("SELECT SUM(i), COUNT(*), MIN(i), MAX(i) FROM (SELECT i FROM test ORDER BY i LIMIT "
+		                   "9223372036854775806 OFFSET 10) t");
+		REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(4999949955)}));
+		REQUIRE(CHECK_COLUMN(result, 1, {99990}));
+		REQUIRE(CHECK_COLUMN(result, 2, {10}));
+		REQUIRE(CHECK_COLUMN(result, 3, {99999}));
+	}
+}
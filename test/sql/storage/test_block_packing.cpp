@@ -0,0 +1,71 @@
+#include "catch.hpp"
+#include "common/file_system.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+#define TABLE_COUNT 100
+
+static void CheckSmallTables(Connection &con, index_t updated_table) {
+	for (index_t t = 0; t < TABLE_COUNT; t++) {
+		auto result = con.Query("SELECT SUM(i), MIN(s), MAX(s), SUM(d) FROM t" + to_string(t));
+		int64_t offset = t == updated_table ? 10 : 0;
+		REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(t * 10 + 45 + offset * 10)}));
+		REQUIRE(CHECK_COLUMN(result, 1, {"table " + to_string(t) + " row 0"}));
+		REQUIRE(CHECK_COLUMN(result, 2, {"table " + to_string(t) + " row 9"}));
+		REQUIRE(CHECK_COLUMN(result, 3, {4.5}));
+	}
+}
+
+TEST_CASE("Test packing small segments of many tables into shared blocks", "[storage]") {
+	FileSystem fs;
+	auto config = GetTestConfig();
+	auto storage_database = TestCreatePath("block_packing_test");
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+		for (index_t t = 0; t < TABLE_COUNT; t++) {
+			auto table_name = "t" + to_string(t);
+			REQUIRE_NO_FAIL(con.Query("CREATE TABLE " + table_name + "(i BIGINT, s VARCHAR, d DOUBLE)"));
+			for (index_t i = 0; i < 10; i++) {
+				REQUIRE_NO_FAIL(con.Query("INSERT INTO " + table_name + " VALUES (" + to_string(t + i) + ", 'table " +
+				                          to_string(t) + " row " + to_string(i) + "', " + to_string(i * 0.1) + ")"));
+			}
+		}
+		REQUIRE_NO_FAIL(con.Query("COMMIT"));
+		CheckSmallTables(con, TABLE_COUNT);
+	}
+	// the 300 segments of the tables take up a few shared blocks instead of a block each
+	{
+		auto handle = fs.OpenFile(storage_database, FileFlags::READ);
+		REQUIRE(fs.GetFileSize(*handle) < (int64_t)(8 * BLOCK_SIZE));
+	}
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		CheckSmallTables(con, TABLE_COUNT);
+	}
+	{
+		// rewrite a single table: the other tables keep using the shared blocks
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("UPDATE t42 SET i=i+10"));
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		CheckSmallTables(con, 42);
+	}
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		CheckSmallTables(con, 42);
+	}
+	{
+		// the blocks of the earlier checkpoint remain in the file as free blocks
+		auto handle = fs.OpenFile(storage_database, FileFlags::READ);
+		REQUIRE(fs.GetFileSize(*handle) < (int64_t)(16 * BLOCK_SIZE));
+	}
+	DeleteDatabase(storage_database);
+}
@@ -0,0 +1,108 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+#include "storage/buffer_manager.hpp"
+#include "storage/storage_manager.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test scanning a table larger than the memory limit", "[storage]") {
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("buffer_manager_test");
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER, s VARCHAR)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "integers");
+		for (index_t i = 0; i < 500000; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendString(("string " + to_string(i)).c_str());
+			appender->EndRow();
+		}
+		con.CloseAppender();
+	}
+	// reload the database with a memory limit of four blocks: the table does not fit in memory
+	index_t memory_limit = 4 * BLOCK_SIZE;
+	config->maximum_memory = memory_limit;
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		for (index_t k = 0; k < 2; k++) {
+			result = con.Query("SELECT COUNT(*), SUM(i), MIN(s), MAX(s) FROM integers");
+			REQUIRE(CHECK_COLUMN(result, 0, {500000}));
+			REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(124999750000)}));
+			REQUIRE(CHECK_COLUMN(result, 2, {"string 0"}));
+			REQUIRE(CHECK_COLUMN(result, 3, {"string 99999"}));
+			REQUIRE(db.storage->buffer_manager->GetUsedMemory() <= memory_limit);
+		}
+		// the strings have to remain valid after the blocks they were read from are evicted
+		result = con.Query("SELECT i, s FROM integers WHERE i%100000=0 ORDER BY s");
+		REQUIRE(CHECK_COLUMN(result, 0, {0, 100000, 200000, 300000, 400000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {"string 0", "string 100000", "string 200000", "string 300000",
+		                                 "string 400000"}));
+		// the memory limit can be changed at runtime
+		REQUIRE_NO_FAIL(con.Query("PRAGMA memory_limit=2MB"));
+		REQUIRE(db.storage->buffer_manager->GetMaxMemory() == 2000000);
+		REQUIRE(db.storage->buffer_manager->GetUsedMemory() <= 2000000);
+		REQUIRE_NO_FAIL(con.Query("PRAGMA memory_limit='0.5 GB'"));
+		REQUIRE(db.storage->buffer_manager->GetMaxMemory() == 500000000);
+		REQUIRE_FAIL(con.Query("PRAGMA memory_limit=2XB"));
+		REQUIRE_FAIL(con.Query("PRAGMA memory_limit"));
+		// with a memory limit below a single block nothing can be loaded anymore
+		REQUIRE_NO_FAIL(con.Query("PRAGMA memory_limit=1000"));
+		REQUIRE_FAIL(con.Query("SELECT SUM(i) FROM integers"));
+		REQUIRE_NO_FAIL(con.Query("PRAGMA memory_limit=-1"));
+		result = con.Query("SELECT SUM(i) FROM integers");
+		REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(124999750000)}));
+	}
+	DeleteDatabase(storage_database);
+}
+
+TEST_CASE("Test read-ahead of table scans", "[storage]") {
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("prefetch_test");
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER, j BIGINT, s VARCHAR)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "integers");
+		for (index_t i = 0; i < 300000; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendBigInt(i * 7919 % 1000003);
+			appender->AppendString(("string " + to_string(i)).c_str());
+			appender->EndRow();
+		}
+		con.CloseAppender();
+	}
+	// scan the table without read-ahead, with read-ahead and with read-ahead beyond the memory limit
+	for (index_t prefetch_depth : {0, 4, 64}) {
+		for (index_t memory_limit : {(index_t)-1, (index_t)(8 * BLOCK_SIZE)}) {
+			config->prefetch_depth = prefetch_depth;
+			config->maximum_memory = memory_limit;
+			config->maximum_threads = 4;
+			DuckDB db(storage_database, config.get());
+			Connection con(db);
+			for (index_t k = 0; k < 2; k++) {
+				result = con.Query("SELECT COUNT(*), SUM(i), SUM(j), MIN(s), MAX(s) FROM integers");
+				REQUIRE(CHECK_COLUMN(result, 0, {300000}));
+				REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(44999850000)}));
+				REQUIRE(CHECK_COLUMN(result, 2, {Value::BIGINT(149986541729)}));
+				REQUIRE(CHECK_COLUMN(result, 3, {"string 0"}));
+				REQUIRE(CHECK_COLUMN(result, 4, {"string 99999"}));
+				REQUIRE(db.storage->buffer_manager->GetUsedMemory() <= memory_limit);
+			}
+			// a scan of a single column with a filter
+			result = con.Query("SELECT COUNT(*) FROM integers WHERE i>=100000 AND i<200000");
+			REQUIRE(CHECK_COLUMN(result, 0, {100000}));
+		}
+	}
+	DeleteDatabase(storage_database);
+}
@@ -0,0 +1,371 @@
+#include "catch.hpp"
+#include "common/file_system.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+static int64_t GetFileSize(string path) {
+	FileSystem fs;
+	auto handle = fs.OpenFile(path, FileFlags::READ);
+	return fs.GetFileSize(*handle);
+}
+
+TEST_CASE("Test online incremental checkpoints", "[storage]") {
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("checkpoint_test");
+	auto wal_path = storage_database + ".wal";
+	// never checkpoint automatically
+	DBConfig config;
+	config.checkpoint_wal_size = (index_t)1 << 40;
+
+	DeleteDatabase(storage_database);
+	int64_t initial_size;
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db), con2(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE big(i INTEGER, s VARCHAR)"));
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE small(i INTEGER)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "big");
+		for (index_t i = 0; i < 300000; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendString(("string" + to_string(i)).c_str());
+			appender->EndRow();
+		}
+		con.CloseAppender();
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO small VALUES (1), (2), (3)"));
+		REQUIRE(GetFileSize(wal_path) > 0);
+
+		// a checkpoint does not stop readers: a transaction that started before the checkpoint keeps its snapshot
+		REQUIRE_NO_FAIL(con2.Query("BEGIN TRANSACTION"));
+		result = con2.Query("SELECT SUM(i) FROM small");
+		REQUIRE(CHECK_COLUMN(result, 0, {6}));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO small VALUES (4)"));
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		result = con2.Query("SELECT SUM(i) FROM small");
+		REQUIRE(CHECK_COLUMN(result, 0, {6}));
+		REQUIRE_NO_FAIL(con2.Query("COMMIT"));
+		result = con2.Query("SELECT SUM(i) FROM small");
+		REQUIRE(CHECK_COLUMN(result, 0, {10}));
+
+		// the WAL is truncated by the checkpoint
+		REQUIRE(GetFileSize(wal_path) == 0);
+		initial_size = GetFileSize(storage_database);
+		// the big table takes up more than ten blocks
+		REQUIRE(initial_size > (int64_t)(10 * BLOCK_SIZE));
+	}
+	for (index_t i = 0; i < 3; i++) {
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*), SUM(i), MIN(s), MAX(s) FROM big");
+		REQUIRE(CHECK_COLUMN(result, 0, {300000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(44999850000)}));
+		REQUIRE(CHECK_COLUMN(result, 2, {"string0"}));
+		REQUIRE(CHECK_COLUMN(result, 3, {"string99999"}));
+		result = con.Query("SELECT SUM(i) FROM small");
+		REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(10 + i * 5)}));
+
+		// only the changed table is written by the checkpoint, the unchanged table keeps its blocks
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO small VALUES (5)"));
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		REQUIRE(GetFileSize(wal_path) == 0);
+		REQUIRE(GetFileSize(storage_database) < initial_size + (int64_t)(8 * BLOCK_SIZE));
+	}
+	{
+		// changes after the checkpoint are replayed from the WAL
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM big WHERE i >= 100000"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE small SET i=i+1"));
+		REQUIRE(GetFileSize(wal_path) > 0);
+	}
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*), SUM(i) FROM big");
+		REQUIRE(CHECK_COLUMN(result, 0, {100000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(4999950000)}));
+		result = con.Query("SELECT SUM(i), COUNT(*) FROM small");
+		REQUIRE(CHECK_COLUMN(result, 0, {32}));
+		REQUIRE(CHECK_COLUMN(result, 1, {7}));
+		// the rewritten table can be checkpointed and reloaded as well
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+	}
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*), SUM(i) FROM big");
+		REQUIRE(CHECK_COLUMN(result, 0, {100000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(4999950000)}));
+		result = con.Query("SELECT SUM(i), COUNT(*) FROM small");
+		REQUIRE(CHECK_COLUMN(result, 0, {32}));
+		REQUIRE(CHECK_COLUMN(result, 1, {7}));
+	}
+	{
+		// checkpoints cannot be created in read-only mode
+		DBConfig readonly_config;
+		readonly_config.access_mode = AccessMode::READ_ONLY;
+		DuckDB db(storage_database, &readonly_config);
+		Connection con(db);
+		REQUIRE_FAIL(con.Query("CHECKPOINT"));
+	}
+	DeleteDatabase(storage_database);
+}
+
+TEST_CASE("Test that checkpoints only write the tables changed since the previous checkpoint", "[storage]") {
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("checkpoint_test");
+	// never checkpoint automatically
+	DBConfig config;
+	config.checkpoint_wal_size = (index_t)1 << 40;
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE big(i INTEGER, s VARCHAR)"));
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE small(i INTEGER PRIMARY KEY)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "big");
+		for (index_t i = 0; i < 300000; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendString(("string" + to_string(i)).c_str());
+			appender->EndRow();
+		}
+		con.CloseAppender();
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		auto initial_size = GetFileSize(storage_database);
+		REQUIRE(initial_size > (int64_t)(10 * BLOCK_SIZE));
+		// the big table was written by the first checkpoint, the later checkpoints keep its blocks
+		for (index_t i = 0; i < 3; i++) {
+			REQUIRE_NO_FAIL(con.Query("INSERT INTO small VALUES (" + to_string(i) + ")"));
+			REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+			// writing the big table again would require a second copy of its blocks
+			REQUIRE(GetFileSize(storage_database) < initial_size + initial_size / 2);
+		}
+	}
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*), SUM(i), MAX(s) FROM big");
+		REQUIRE(CHECK_COLUMN(result, 0, {300000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(44999850000)}));
+		REQUIRE(CHECK_COLUMN(result, 2, {"string99999"}));
+		result = con.Query("SELECT SUM(i) FROM small");
+		REQUIRE(CHECK_COLUMN(result, 0, {3}));
+		// rewrite the small table and its primary key, then checkpoint again while only the big table changes
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO small VALUES (3)"));
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM big WHERE i >= 200000"));
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+	}
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*), SUM(i), MAX(s) FROM big");
+		REQUIRE(CHECK_COLUMN(result, 0, {200000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(19999900000)}));
+		REQUIRE(CHECK_COLUMN(result, 2, {"string99999"}));
+		result = con.Query("SELECT SUM(i) FROM small");
+		REQUIRE(CHECK_COLUMN(result, 0, {6}));
+		// the primary key index of the small table is kept as well
+		REQUIRE_FAIL(con.Query("INSERT INTO small VALUES (3)"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO small VALUES (4)"));
+	}
+	DeleteDatabase(storage_database);
+}
+
+TEST_CASE("Test checkpoint of an in-memory database", "[storage]") {
+	DuckDB db(nullptr);
+	Connection con(db);
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER)"));
+	REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (1), (2), (3)"));
+	REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+	auto result = con.Query("SELECT SUM(i) FROM integers");
+	REQUIRE(CHECK_COLUMN(result, 0, {6}));
+}
+
+TEST_CASE("Test prepared checkpoints", "[storage]") {
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("checkpoint_test");
+	auto wal_path = storage_database + ".wal";
+	// never checkpoint automatically
+	DBConfig config;
+	config.checkpoint_wal_size = (index_t)1 << 40;
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER)"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (1), (2), (3)"));
+		REQUIRE(GetFileSize(wal_path) > 0);
+		// preparing a checkpoint does not create it: it is created every time the prepared statement is executed
+		auto prepared = con.Prepare("CHECKPOINT");
+		REQUIRE(prepared->success);
+		REQUIRE(GetFileSize(wal_path) > 0);
+		result = prepared->Execute();
+		REQUIRE(CHECK_COLUMN(result, 0, {true}));
+		REQUIRE(GetFileSize(wal_path) == 0);
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (4)"));
+		REQUIRE(GetFileSize(wal_path) > 0);
+		result = prepared->Execute();
+		REQUIRE(CHECK_COLUMN(result, 0, {true}));
+		REQUIRE(GetFileSize(wal_path) == 0);
+	}
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		result = con.Query("SELECT SUM(i) FROM integers");
+		REQUIRE(CHECK_COLUMN(result, 0, {10}));
+	}
+	DeleteDatabase(storage_database);
+}
+
+static void CheckParallelCheckpointTables(Connection &con, string &big_string) {
+	for (index_t t = 0; t < 4; t++) {
+		auto table_name = "t" + to_string(t);
+		auto result = con.Query("SELECT COUNT(*), SUM(i), SUM(j), MIN(s), MAX(s), SUM(d) FROM " + table_name);
+		REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(100001 + t)}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(5000050000 + 100000 * t + t * (t + 1) / 2)}));
+		REQUIRE(CHECK_COLUMN(result, 2, {Value::BIGINT(100000 * t)}));
+		REQUIRE(CHECK_COLUMN(result, 3, {"s0"}));
+		REQUIRE(CHECK_COLUMN(result, 4, {big_string}));
+		REQUIRE(CHECK_COLUMN(result, 5, {Value::DOUBLE(50000.0)}));
+	}
+}
+
+TEST_CASE("Test writing a checkpoint with multiple threads", "[storage]") {
+	auto storage_database = TestCreatePath("parallel_checkpoint_test");
+	string big_string = "zz" + string(BLOCK_SIZE, 'z');
+	DBConfig config;
+	config.maximum_threads = 4;
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		for (index_t t = 0; t < 4; t++) {
+			auto table_name = "t" + to_string(t);
+			REQUIRE_NO_FAIL(con.Query("CREATE TABLE " + table_name + "(i INTEGER, j BIGINT, s VARCHAR, d DOUBLE)"));
+			auto appender = con.OpenAppender(DEFAULT_SCHEMA, table_name);
+			for (index_t i = 0; i < 100000; i++) {
+				appender->BeginRow();
+				appender->AppendInteger(i);
+				appender->AppendBigInt(t);
+				appender->AppendString(("s" + to_string(i)).c_str());
+				appender->AppendDouble(i % 2 == 0 ? 0.0 : 1.0);
+				appender->EndRow();
+			}
+			// every table ends with a different amount of rows, the last of which have a big string
+			for (index_t i = 0; i <= t; i++) {
+				appender->BeginRow();
+				appender->AppendInteger(100000 + i);
+				appender->AppendBigInt(0);
+				appender->AppendString(big_string.c_str());
+				appender->AppendDouble(0.0);
+				appender->EndRow();
+			}
+			con.CloseAppender();
+		}
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		CheckParallelCheckpointTables(con, big_string);
+	}
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		CheckParallelCheckpointTables(con, big_string);
+		// rewrite one of the tables while the others keep their blocks
+		REQUIRE_NO_FAIL(con.Query("UPDATE t1 SET j=j"));
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+	}
+	DeleteDatabase(storage_database);
+}
+using namespace std;
+
+TEST_CASE("Test that rows keep their row ids across checkpoints", "[storage]") {
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("checkpoint_test");
+	// never checkpoint automatically
+	DBConfig config;
+	config.checkpoint_wal_size = (index_t)1 << 40;
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER)"));
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE keys(i INTEGER PRIMARY KEY, j INTEGER)"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (0), (1), (2), (3), (4), (5), (6), (7), (8), (9)"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO keys SELECT i, i FROM integers"));
+		// the rows of an aborted insert are deleted rows as well
+		REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (50), (51)"));
+		REQUIRE_NO_FAIL(con.Query("ROLLBACK"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (10), (11), (12), (13)"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i=0"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM keys WHERE i=0"));
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		// the WAL records of the changes after the checkpoint refer to the rows by their row id
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i=5"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE integers SET i=i+100 WHERE i=7 OR i=11"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (14), (15), (16)"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i=15"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE integers SET i=i+100 WHERE i=16"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM keys WHERE i=5"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE keys SET j=j+100 WHERE i=6"));
+	}
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		result = con.Query("SELECT i FROM integers ORDER BY i");
+		REQUIRE(CHECK_COLUMN(result, 0, {1, 2, 3, 4, 6, 8, 9, 10, 12, 13, 14, 107, 111, 116}));
+		result = con.Query("SELECT i, j FROM keys ORDER BY i");
+		REQUIRE(CHECK_COLUMN(result, 0, {1, 2, 3, 4, 6, 7, 8, 9}));
+		REQUIRE(CHECK_COLUMN(result, 1, {1, 2, 3, 4, 106, 7, 8, 9}));
+		// the second time, the changes are made after a checkpoint of a table that was loaded from storage
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i=1"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE integers SET i=i+1 WHERE i=2"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (1)"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i=3"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (2), (3)"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM keys WHERE i=1"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE keys SET j=j-100 WHERE i=6"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO keys VALUES (0, 0), (1, 1), (5, 5)"));
+		REQUIRE_FAIL(con.Query("INSERT INTO keys VALUES (6, 6)"));
+		result = con.Query("SELECT i FROM integers ORDER BY i");
+		REQUIRE(CHECK_COLUMN(result, 0, {1, 2, 3, 4, 6, 8, 9, 10, 12, 13, 14, 107, 111, 116}));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i<4 AND NOT i=3"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i=3"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (1), (2), (3)"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM keys WHERE i=0 OR i=5"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE keys SET j=j+100 WHERE i=6"));
+	}
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db), con2(db);
+		result = con.Query("SELECT i FROM integers ORDER BY i");
+		REQUIRE(CHECK_COLUMN(result, 0, {1, 2, 3, 4, 6, 8, 9, 10, 12, 13, 14, 107, 111, 116}));
+		result = con.Query("SELECT i, j FROM keys ORDER BY i");
+		REQUIRE(CHECK_COLUMN(result, 0, {1, 2, 3, 4, 6, 7, 8, 9}));
+		REQUIRE(CHECK_COLUMN(result, 1, {1, 2, 3, 4, 106, 7, 8, 9}));
+
+		// no checkpoint can be written while a transaction that appended rows is active
+		REQUIRE_NO_FAIL(con2.Query("BEGIN TRANSACTION"));
+		REQUIRE_NO_FAIL(con2.Query("INSERT INTO integers VALUES (200)"));
+		REQUIRE_FAIL(con.Query("CHECKPOINT"));
+		REQUIRE_NO_FAIL(con2.Query("COMMIT"));
+		REQUIRE_NO_FAIL(con.Query("CHECKPOINT"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i=200"));
+	}
+	{
+		DuckDB db(storage_database, &config);
+		Connection con(db);
+		result = con.Query("SELECT i FROM integers ORDER BY i");
+		REQUIRE(CHECK_COLUMN(result, 0, {1, 2, 3, 4, 6, 8, 9, 10, 12, 13, 14, 107, 111, 116}));
+	}
+	DeleteDatabase(storage_database);
+}
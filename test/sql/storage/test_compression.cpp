@@ -0,0 +1,115 @@
+#include "catch.hpp"
+#include "common/file_system.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+static void CheckCompressedQueries(Connection &con) {
+	unique_ptr<QueryResult> result;
+	// constant column
+	result = con.Query("SELECT COUNT(*), MIN(c), MAX(c) FROM compressed");
+	REQUIRE(CHECK_COLUMN(result, 0, {200000}));
+	REQUIRE(CHECK_COLUMN(result, 1, {42}));
+	REQUIRE(CHECK_COLUMN(result, 2, {42}));
+	// run-length encoded columns
+	result = con.Query("SELECT SUM(r), SUM(d) FROM compressed");
+	REQUIRE(CHECK_COLUMN(result, 0, {19900000}));
+	REQUIRE(CHECK_COLUMN(result, 1, {19900000.0}));
+	result = con.Query("SELECT COUNT(*) FROM compressed WHERE r=150");
+	REQUIRE(CHECK_COLUMN(result, 0, {1000}));
+	// bit-packed columns with NULL values
+	result = con.Query("SELECT COUNT(b), MIN(b), MAX(b), SUM(b) FROM compressed");
+	REQUIRE(CHECK_COLUMN(result, 0, {171428}));
+	REQUIRE(CHECK_COLUMN(result, 1, {1000000}));
+	REQUIRE(CHECK_COLUMN(result, 2, {1000099}));
+	result = con.Query("SELECT COUNT(*) FROM compressed WHERE b IS NULL");
+	REQUIRE(CHECK_COLUMN(result, 0, {28572}));
+	result = con.Query("SELECT COUNT(*) FROM compressed WHERE b=1000050");
+	REQUIRE(CHECK_COLUMN(result, 0, {1714}));
+	result = con.Query("SELECT COUNT(t), SUM(t), COUNT(*) - COUNT(t) FROM compressed");
+	REQUIRE(CHECK_COLUMN(result, 0, {190000}));
+	REQUIRE(CHECK_COLUMN(result, 1, {90000}));
+	REQUIRE(CHECK_COLUMN(result, 2, {10000}));
+	result = con.Query("SELECT COUNT(*) FROM compressed WHERE l");
+	REQUIRE(CHECK_COLUMN(result, 0, {100000}));
+	// fetch individual rows
+	result = con.Query("SELECT i, c, r, b, t, l, d FROM compressed WHERE i=123456 OR i=7 ORDER BY i");
+	REQUIRE(CHECK_COLUMN(result, 0, {7, 123456}));
+	REQUIRE(CHECK_COLUMN(result, 1, {42, 42}));
+	REQUIRE(CHECK_COLUMN(result, 2, {0, 123}));
+	REQUIRE(CHECK_COLUMN(result, 3, {Value(), 1000056}));
+	REQUIRE(CHECK_COLUMN(result, 4, {Value(), 0}));
+	REQUIRE(CHECK_COLUMN(result, 5, {false, true}));
+	REQUIRE(CHECK_COLUMN(result, 6, {0.0, 123.0}));
+}
+
+TEST_CASE("Test compression of persistent segments", "[storage]") {
+	FileSystem fs;
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("compression_test");
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE compressed(i INTEGER, c INTEGER, r SMALLINT, b BIGINT, t TINYINT, l "
+		                          "BOOLEAN, d DOUBLE)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "compressed");
+		for (index_t i = 0; i < 200000; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendInteger(42);
+			appender->AppendSmallInt(i / 1000);
+			if (i % 7 == 0) {
+				appender->AppendValue(Value());
+			} else {
+				appender->AppendBigInt(1000000 + i % 100);
+			}
+			if (i % 20 == 7) {
+				appender->AppendValue(Value());
+			} else {
+				appender->AppendTinyInt(i % 2);
+			}
+			appender->AppendBoolean(i % 2 == 0);
+			appender->AppendDouble(i / 1000);
+			appender->EndRow();
+		}
+		con.CloseAppender();
+		CheckCompressedQueries(con);
+	}
+	// reload the database twice so the data is read from (and written back to) the compressed segments
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		CheckCompressedQueries(con);
+	}
+	{
+		// the compressed columns take up a single block each, uncompressed they would take up around 22 blocks (the file
+		// also contains the meta blocks and the free blocks of the earlier checkpoints)
+		auto handle = fs.OpenFile(storage_database, FileFlags::READ);
+		REQUIRE(fs.GetFileSize(*handle) < (int64_t)(16 * BLOCK_SIZE));
+	}
+	{
+		// updates of persistent rows fetch the compressed values
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("UPDATE compressed SET c=43 WHERE i=7"));
+		result = con.Query("SELECT i, c, r, b, t, l, d FROM compressed WHERE i=7");
+		REQUIRE(CHECK_COLUMN(result, 0, {7}));
+		REQUIRE(CHECK_COLUMN(result, 1, {43}));
+		REQUIRE(CHECK_COLUMN(result, 2, {0}));
+		REQUIRE(CHECK_COLUMN(result, 3, {Value()}));
+		REQUIRE(CHECK_COLUMN(result, 4, {Value()}));
+		REQUIRE(CHECK_COLUMN(result, 5, {false}));
+		REQUIRE(CHECK_COLUMN(result, 6, {0.0}));
+	}
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		result = con.Query("SELECT SUM(c) FROM compressed");
+		REQUIRE(CHECK_COLUMN(result, 0, {200000 * 42 + 1}));
+	}
+	DeleteDatabase(storage_database);
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+#include "common/file_system.hpp"
+#include "test_helpers.hpp"
+
+#include <thread>
+
+using namespace duckdb;
+using namespace std;
+
+#define THREAD_COUNT 8
+#define INSERT_COUNT 50
+
+static void insert_rows(DuckDB *db, bool *correct, int threadnr) {
+	correct[threadnr] = true;
+	Connection con(*db);
+	for (int i = 0; i < INSERT_COUNT; i++) {
+		// every insert commits (and waits for the WAL to be synced) by itself
+		auto value = to_string(threadnr * INSERT_COUNT + i);
+		auto result = con.Query("INSERT INTO integers VALUES (" + value + ")");
+		if (!result->success) {
+			correct[threadnr] = false;
+		}
+		// the commit is visible once it has finished, even if the WAL was synced by another transaction
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i=" + value);
+		if (!CHECK_COLUMN(result, 0, {1})) {
+			correct[threadnr] = false;
+		}
+	}
+}
+
+static void CheckIntegers(Connection &con) {
+	auto total = THREAD_COUNT * INSERT_COUNT;
+	auto result = con.Query("SELECT COUNT(*), COUNT(DISTINCT i), SUM(i) FROM integers");
+	REQUIRE(CHECK_COLUMN(result, 0, {total}));
+	REQUIRE(CHECK_COLUMN(result, 1, {total}));
+	REQUIRE(CHECK_COLUMN(result, 2, {Value::BIGINT((int64_t)total * (total - 1) / 2)}));
+}
+
+TEST_CASE("Test group commit of concurrent transactions", "[storage]") {
+	auto storage_database = TestCreatePath("group_commit_test");
+	for (index_t commit_delay : {0, 1000}) {
+		DBConfig config;
+		config.commit_delay = commit_delay;
+		config.commit_batch_size = THREAD_COUNT / 2;
+
+		DeleteDatabase(storage_database);
+		{
+			DuckDB db(storage_database, &config);
+			Connection con(db);
+			REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER)"));
+
+			bool correct[THREAD_COUNT];
+			thread threads[THREAD_COUNT];
+			for (int i = 0; i < THREAD_COUNT; i++) {
+				threads[i] = thread(insert_rows, &db, correct, i);
+			}
+			for (int i = 0; i < THREAD_COUNT; i++) {
+				threads[i].join();
+				REQUIRE(correct[i]);
+			}
+			CheckIntegers(con);
+		}
+		{
+			// all the commits were synced to the WAL
+			DuckDB db(storage_database, &config);
+			Connection con(db);
+			CheckIntegers(con);
+		}
+	}
+	DeleteDatabase(storage_database);
+}
+
+namespace duckdb {
+//! A file system that fails to sync the WAL on request
+class FailingSyncFileSystem : public FileSystem {
+public:
+	bool fail_sync = false;
+
+	void FileSync(FileHandle &handle) override {
+		if (fail_sync && StringUtil::EndsWith(handle.path, ".wal")) {
+			throw IOException("Could not sync \"%s\"", handle.path.c_str());
+		}
+		FileSystem::FileSync(handle);
+	}
+};
+} // namespace duckdb
+
+TEST_CASE("Test a commit whose WAL records cannot be synced", "[storage]") {
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("failed_sync_test");
+	DeleteDatabase(storage_database);
+	{
+		DBConfig config;
+		auto file_system = make_unique<FailingSyncFileSystem>();
+		auto file_system_ptr = file_system.get();
+		config.file_system = move(file_system);
+		DuckDB db(storage_database, &config);
+		Connection con(db), con2(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER)"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (1)"));
+		REQUIRE_NO_FAIL(con2.Query("BEGIN TRANSACTION"));
+		REQUIRE_NO_FAIL(con2.Query("INSERT INTO integers VALUES (2)"));
+
+		file_system_ptr->fail_sync = true;
+		REQUIRE_FAIL(con.Query("INSERT INTO integers VALUES (3)"));
+		file_system_ptr->fail_sync = false;
+		// the database can no longer make changes durable: running transactions cannot commit their changes and no
+		// transactions can be started anymore
+		REQUIRE_FAIL(con2.Query("COMMIT"));
+		REQUIRE_FAIL(con.Query("SELECT * FROM integers"));
+		REQUIRE_FAIL(con.Query("INSERT INTO integers VALUES (4)"));
+	}
+	{
+		// the database can be used again after a restart
+		DuckDB db(storage_database);
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i=1 OR i=2 OR i=4");
+		REQUIRE(CHECK_COLUMN(result, 0, {1}));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (5)"));
+	}
+	DeleteDatabase(storage_database);
+}
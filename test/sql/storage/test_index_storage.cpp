@@ -0,0 +1,110 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test storing the indexes of PRIMARY KEY and UNIQUE constraints", "[storage]") {
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("index_storage_test");
+
+	// make sure the database does not exist
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers (i BIGINT PRIMARY KEY, j INTEGER UNIQUE, k INTEGER);"));
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE unchanged (i SMALLINT PRIMARY KEY);"));
+		REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+		for (int64_t i = 0; i < 3000; i++) {
+			// spread the keys out, so the trees have nodes of every size
+			auto key = to_string((i - 1500) * 1000003);
+			REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (" + key + ", " + to_string(i) + ", " +
+			                          to_string(i * 2) + ")"));
+			if (i < 500) {
+				REQUIRE_NO_FAIL(con.Query("INSERT INTO unchanged VALUES (" + to_string(i - 250) + ")"));
+			}
+		}
+		REQUIRE_NO_FAIL(con.Query("COMMIT"));
+		// deleted rows are not written, so the rows of the table are renumbered by the checkpoint
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE j % 3 = 0"));
+	}
+	int64_t sums[] = {3000000, 3010000, 3030000};
+	for (index_t i = 0; i < 3; i++) {
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*), SUM(j) FROM integers");
+		REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(2000 + i)}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(sums[i])}));
+		// point and range lookups in the stored indexes find the right rows
+		result = con.Query("SELECT j, k FROM integers WHERE i = " + to_string(-1499 * (int64_t)1000003));
+		REQUIRE(CHECK_COLUMN(result, 0, {1}));
+		REQUIRE(CHECK_COLUMN(result, 1, {2}));
+		result = con.Query("SELECT k FROM integers WHERE j = 1499");
+		REQUIRE(CHECK_COLUMN(result, 0, {2998}));
+		result = con.Query("SELECT k FROM integers WHERE j = 1500");
+		REQUIRE(CHECK_COLUMN(result, 0, {}));
+		result = con.Query("SELECT COUNT(*), SUM(k) FROM integers WHERE j >= 1000 AND j < 1100");
+		REQUIRE(CHECK_COLUMN(result, 0, {67}));
+		REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(140600)}));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i < 0");
+		REQUIRE(CHECK_COLUMN(result, 0, {1000}));
+		result = con.Query("SELECT COUNT(*), MIN(i), MAX(i) FROM unchanged WHERE i >= 0");
+		REQUIRE(CHECK_COLUMN(result, 0, {250}));
+		REQUIRE(CHECK_COLUMN(result, 1, {0}));
+		REQUIRE(CHECK_COLUMN(result, 2, {249}));
+		// the constraints are enforced by the stored indexes
+		REQUIRE_FAIL(con.Query("INSERT INTO integers VALUES (" + to_string(-1499 * (int64_t)1000003) + ", -1, 0)"));
+		REQUIRE_FAIL(con.Query("INSERT INTO integers VALUES (-1, 1, 0)"));
+		REQUIRE_FAIL(con.Query("INSERT INTO unchanged VALUES (100)"));
+		// change the table, so the next checkpoint writes a new index
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (" + to_string(1000000000000 + i) + ", " +
+		                          to_string(10000 * (i + 1)) + ", 0)"));
+	}
+}
+
+TEST_CASE("Test storing indexes on multiple columns and on VARCHAR and DOUBLE keys", "[storage]") {
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("index_key_storage_test");
+	// the user names share a prefix that is longer than eight bytes
+	string name_prefix = "a_rather_long_user_name_";
+
+	// make sure the database does not exist
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE users (tenant_id INTEGER, user_name VARCHAR, score DOUBLE UNIQUE, "
+		                          "PRIMARY KEY(tenant_id, user_name));"));
+		string values;
+		for (int i = 0; i < 1000; i++) {
+			values += (i == 0 ? "(" : ", (") + to_string(i % 10) + ", '" + name_prefix + to_string(i) + "', " +
+			          to_string(i * 0.5 - 100) + ")";
+		}
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO users VALUES " + values));
+	}
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*) FROM users");
+		REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(1000 + i)}));
+		// lookups in the stored indexes find the right rows
+		result = con.Query("SELECT score FROM users WHERE tenant_id = 7 AND user_name = '" + name_prefix + "17'");
+		REQUIRE(CHECK_COLUMN(result, 0, {Value::DOUBLE(-91.5)}));
+		result = con.Query("SELECT score FROM users WHERE tenant_id = 8 AND user_name = '" + name_prefix + "17'");
+		REQUIRE(CHECK_COLUMN(result, 0, {}));
+		result = con.Query("SELECT tenant_id FROM users WHERE score = -91.5");
+		REQUIRE(CHECK_COLUMN(result, 0, {7}));
+		result = con.Query("SELECT COUNT(*) FROM users WHERE score < 0");
+		REQUIRE(CHECK_COLUMN(result, 0, {200}));
+		// the constraints are enforced by the stored indexes
+		REQUIRE_FAIL(con.Query("INSERT INTO users VALUES (7, '" + name_prefix + "17', 12345)"));
+		REQUIRE_FAIL(con.Query("INSERT INTO users VALUES (8, 'new_user', -91.5)"));
+		// change the table, so the next checkpoint writes new indexes
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO users VALUES (7, 'new_user_" + to_string(i) + "', " +
+		                          to_string(10000 + i) + ")"));
+	}
+	DeleteDatabase(storage_database);
+}
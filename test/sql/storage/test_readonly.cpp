@@ -53,3 +53,75 @@ TEST_CASE("Test read only storage", "[storage]") {
 	}
 	DeleteDatabase(storage_database);
 }
+
+static void CheckReadOnlyQueries(Connection &con, string &big_string) {
+	auto result = con.Query("SELECT COUNT(*), SUM(i), MIN(s), MAX(s) FROM test");
+	REQUIRE(CHECK_COLUMN(result, 0, {100001}));
+	REQUIRE(CHECK_COLUMN(result, 1, {Value::BIGINT(5000050000)}));
+	REQUIRE(CHECK_COLUMN(result, 2, {"string 0"}));
+	REQUIRE(CHECK_COLUMN(result, 3, {big_string}));
+	result = con.Query("SELECT i, s FROM test WHERE i=77777");
+	REQUIRE(CHECK_COLUMN(result, 0, {77777}));
+	REQUIRE(CHECK_COLUMN(result, 1, {"string 77777"}));
+}
+
+TEST_CASE("Test memory-mapped read only storage", "[storage]") {
+	auto storage_database = TestCreatePath("mmap_test");
+	string big_string = "zz" + string(BLOCK_SIZE, 'z');
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database);
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE test (i INTEGER, s VARCHAR)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "test");
+		for (index_t i = 0; i < 100000; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendString(("string " + to_string(i)).c_str());
+			appender->EndRow();
+		}
+		appender->BeginRow();
+		appender->AppendInteger(100000);
+		appender->AppendString(big_string.c_str());
+		appender->EndRow();
+		con.CloseAppender();
+	}
+	for (bool use_mmap : {true, false}) {
+		DBConfig config;
+		config.access_mode = AccessMode::READ_ONLY;
+		config.use_mmap = use_mmap;
+		config.maximum_memory = 4 * BLOCK_SIZE;
+		// multiple databases can read the same file at the same time
+		DuckDB db(storage_database, &config), db2(storage_database, &config);
+		Connection con(db), con2(db2);
+		for (index_t i = 0; i < 2; i++) {
+			CheckReadOnlyQueries(con, big_string);
+			CheckReadOnlyQueries(con2, big_string);
+		}
+	}
+	{
+		// corrupt a byte in the first block of the file: the checksum of the block does not match anymore
+		FileSystem fs;
+		auto handle = fs.OpenFile(storage_database, FileFlags::WRITE);
+		index_t location = HEADER_SIZE * 3 + 1000;
+		uint8_t byte;
+		handle->Read(&byte, 1, location);
+		byte++;
+		handle->Write(&byte, 1, location);
+	}
+	for (bool use_mmap : {true, false}) {
+		DBConfig config;
+		config.access_mode = AccessMode::READ_ONLY;
+		config.use_mmap = use_mmap;
+		bool failed = false;
+		try {
+			DuckDB db(storage_database, &config);
+			Connection con(db);
+			failed = !con.Query("SELECT SUM(i), MAX(s) FROM test")->success;
+		} catch (...) {
+			failed = true;
+		}
+		REQUIRE(failed);
+	}
+	DeleteDatabase(storage_database);
+}
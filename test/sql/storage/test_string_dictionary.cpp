@@ -0,0 +1,86 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+static void CheckDictionaryQueries(Connection &con, string big_string) {
+	unique_ptr<QueryResult> result;
+	// low cardinality column: filters are evaluated on the dictionary codes
+	result = con.Query("SELECT COUNT(*) FROM strings WHERE country='NL'");
+	REQUIRE(CHECK_COLUMN(result, 0, {25000}));
+	result = con.Query("SELECT COUNT(*) FROM strings WHERE country='XX'");
+	REQUIRE(CHECK_COLUMN(result, 0, {0}));
+	result = con.Query("SELECT COUNT(*) FROM strings WHERE country>='DE' AND country<'US'");
+	REQUIRE(CHECK_COLUMN(result, 0, {50000}));
+	result = con.Query("SELECT COUNT(*) FROM strings WHERE 'FR'>country");
+	REQUIRE(CHECK_COLUMN(result, 0, {25000}));
+	result = con.Query("SELECT COUNT(*), COUNT(country) FROM strings WHERE country IS NULL");
+	REQUIRE(CHECK_COLUMN(result, 0, {25000}));
+	REQUIRE(CHECK_COLUMN(result, 1, {0}));
+	result = con.Query("SELECT country, COUNT(*), MIN(i), MAX(i) FROM strings WHERE country IS NOT NULL GROUP BY "
+	                   "country ORDER BY country");
+	REQUIRE(CHECK_COLUMN(result, 0, {"DE", "NL", "US", big_string}));
+	REQUIRE(CHECK_COLUMN(result, 1, {25000, 25000, 25000, 2}));
+	REQUIRE(CHECK_COLUMN(result, 2, {0, 1, 2, 100000}));
+	REQUIRE(CHECK_COLUMN(result, 3, {99996, 99997, 99998, 100001}));
+	// combined with filters on the high cardinality column, which is too large to be decoded
+	result = con.Query("SELECT name, country FROM strings WHERE name='name99997' AND country='NL'");
+	REQUIRE(CHECK_COLUMN(result, 0, {"name99997"}));
+	REQUIRE(CHECK_COLUMN(result, 1, {"NL"}));
+	result = con.Query("SELECT COUNT(*) FROM strings WHERE name>='name9' AND country='US'");
+	REQUIRE(CHECK_COLUMN(result, 0, {2778}));
+}
+
+TEST_CASE("Test dictionary encoded string segments", "[storage]") {
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("string_dictionary_test");
+	// a string that does not fit into a block is stored as a big string in the dictionary
+	string big_string = "ZZ" + string(BLOCK_SIZE, 'z');
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE strings(i INTEGER, country VARCHAR, name VARCHAR)"));
+		vector<Value> countries = {Value("DE"), Value("NL"), Value("US"), Value()};
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "strings");
+		for (index_t i = 0; i < 100000; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendValue(countries[i % countries.size()]);
+			appender->AppendString(("name" + to_string(i)).c_str());
+			appender->EndRow();
+		}
+		for (index_t i = 100000; i < 100002; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendString(big_string.c_str());
+			appender->AppendString(("name" + to_string(i)).c_str());
+			appender->EndRow();
+		}
+		con.CloseAppender();
+		CheckDictionaryQueries(con, big_string);
+	}
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		CheckDictionaryQueries(con, big_string);
+	}
+	{
+		// filters on updated and deleted rows of the persistent segments use the versioned data
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE strings SET country='NL' WHERE i<5"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM strings WHERE i>=99990"));
+		result = con.Query("SELECT COUNT(*) FROM strings WHERE country='NL'");
+		REQUIRE(CHECK_COLUMN(result, 0, {25002}));
+		result = con.Query("SELECT COUNT(*) FROM strings WHERE country='DE'");
+		REQUIRE(CHECK_COLUMN(result, 0, {24996}));
+		REQUIRE_NO_FAIL(con.Query("ROLLBACK"));
+		CheckDictionaryQueries(con, big_string);
+	}
+	DeleteDatabase(storage_database);
+}
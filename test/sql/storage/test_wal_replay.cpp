@@ -0,0 +1,120 @@
+#include "catch.hpp"
+#include "common/file_system.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test replaying large transactions from the WAL", "[storage]") {
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("wal_replay_test");
+
+	// make sure the database does not exist
+	DeleteDatabase(storage_database);
+	{
+		// do not checkpoint, so the changes are replayed from the WAL when the database is reloaded
+		auto wal_config = GetTestConfig();
+		wal_config->checkpoint_wal_size = 1 << 30;
+		DuckDB db(storage_database, wal_config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers (i INTEGER PRIMARY KEY, j VARCHAR);"));
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE other (i INTEGER);"));
+		// a transaction that is larger than a single batch of decoded WAL entries
+		REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+		for (index_t i = 0; i < 1500; i++) {
+			REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (" + to_string(i) + ", 'hello')"));
+			REQUIRE_NO_FAIL(con.Query("INSERT INTO other VALUES (" + to_string(i) + ")"));
+		}
+		REQUIRE_NO_FAIL(con.Query("COMMIT"));
+		// many small transactions, interleaved with deletes and updates
+		for (index_t i = 1500; i < 2000; i++) {
+			REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (" + to_string(i) + ", 'world')"));
+		}
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i % 2 = 0"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE other SET i=i+1 WHERE i < 100"));
+		// a transaction that inserts, deletes and updates its own rows
+		REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO other SELECT i FROM integers"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM other WHERE i >= 1500"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE other SET i=0 WHERE i < 10"));
+		REQUIRE_NO_FAIL(con.Query("COMMIT"));
+	}
+	for (index_t i = 0; i < 2; i++) {
+		// reload the database: the first reload replays the WAL, the second loads the checkpoint
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*), SUM(i), COUNT(j), MIN(j), MAX(j) FROM integers");
+		REQUIRE(CHECK_COLUMN(result, 0, {1000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {1000000}));
+		REQUIRE(CHECK_COLUMN(result, 2, {1000}));
+		REQUIRE(CHECK_COLUMN(result, 3, {"hello"}));
+		REQUIRE(CHECK_COLUMN(result, 4, {"world"}));
+		result = con.Query("SELECT COUNT(*), SUM(i) FROM other");
+		REQUIRE(CHECK_COLUMN(result, 0, {2250}));
+		REQUIRE(CHECK_COLUMN(result, 1, {1686780}));
+		// the primary key still holds after the replay
+		REQUIRE_FAIL(con.Query("INSERT INTO integers VALUES (1, 'duplicate')"));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (0, 'new')"));
+		REQUIRE_NO_FAIL(con.Query("DELETE FROM integers WHERE i=0"));
+	}
+	DeleteDatabase(storage_database);
+}
+
+TEST_CASE("Test replaying a WAL with a truncated transaction", "[storage]") {
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("wal_replay_test");
+	auto wal_path = storage_database + ".wal";
+
+	// make sure the database does not exist
+	DeleteDatabase(storage_database);
+	{
+		// do not checkpoint, so the changes are replayed from the WAL when the database is reloaded
+		auto wal_config = GetTestConfig();
+		wal_config->checkpoint_wal_size = 1 << 30;
+		DuckDB db(storage_database, wal_config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers (i INTEGER);"));
+		REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+		for (index_t i = 0; i < 1000; i++) {
+			REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (" + to_string(i) + ")"));
+		}
+		REQUIRE_NO_FAIL(con.Query("COMMIT"));
+		REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+		for (index_t i = 0; i < 1500; i++) {
+			REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (" + to_string(i) + ")"));
+		}
+		REQUIRE_NO_FAIL(con.Query("COMMIT"));
+	}
+	// cut off the end of the WAL, so the last transaction cannot be replayed
+	{
+		FileSystem fs;
+		auto handle = fs.OpenFile(wal_path.c_str(), FileFlags::READ);
+		auto wal_size = fs.GetFileSize(*handle);
+		REQUIRE(wal_size > 100);
+		auto buffer = unique_ptr<char[]>(new char[wal_size]);
+		fs.Read(*handle, buffer.get(), wal_size, 0);
+		handle.reset();
+		fs.RemoveFile(wal_path);
+		handle = fs.OpenFile(wal_path.c_str(), FileFlags::WRITE | FileFlags::CREATE);
+		fs.Write(*handle, buffer.get(), wal_size - 100, 0);
+		fs.FileSync(*handle);
+	}
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*), SUM(i) FROM integers");
+		REQUIRE(CHECK_COLUMN(result, 0, {1000}));
+		REQUIRE(CHECK_COLUMN(result, 1, {499500}));
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO integers VALUES (1000)"));
+	}
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		result = con.Query("SELECT COUNT(*), SUM(i) FROM integers");
+		REQUIRE(CHECK_COLUMN(result, 0, {1001}));
+		REQUIRE(CHECK_COLUMN(result, 1, {500500}));
+	}
+	DeleteDatabase(storage_database);
+}
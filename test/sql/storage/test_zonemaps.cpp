@@ -0,0 +1,86 @@
+#include "catch.hpp"
+#include "test_helpers.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+static void CheckZonemapQueries(Connection &con) {
+	unique_ptr<QueryResult> result;
+	result = con.Query("SELECT COUNT(*), MIN(i), MAX(i) FROM integers WHERE i=5000");
+	REQUIRE(CHECK_COLUMN(result, 0, {1}));
+	REQUIRE(CHECK_COLUMN(result, 1, {5000}));
+	REQUIRE(CHECK_COLUMN(result, 2, {5000}));
+	result = con.Query("SELECT COUNT(*) FROM integers WHERE i=-1");
+	REQUIRE(CHECK_COLUMN(result, 0, {0}));
+	result = con.Query("SELECT COUNT(*), SUM(i) FROM integers WHERE i<100");
+	REQUIRE(CHECK_COLUMN(result, 0, {100}));
+	REQUIRE(CHECK_COLUMN(result, 1, {4950}));
+	result = con.Query("SELECT COUNT(*) FROM integers WHERE i<=100");
+	REQUIRE(CHECK_COLUMN(result, 0, {101}));
+	result = con.Query("SELECT COUNT(*) FROM integers WHERE i>=99990");
+	REQUIRE(CHECK_COLUMN(result, 0, {10}));
+	result = con.Query("SELECT COUNT(*) FROM integers WHERE i>99990");
+	REQUIRE(CHECK_COLUMN(result, 0, {9}));
+	// constant on the left side
+	result = con.Query("SELECT COUNT(*) FROM integers WHERE 20000>i");
+	REQUIRE(CHECK_COLUMN(result, 0, {20000}));
+	// range filter
+	result = con.Query("SELECT COUNT(*) FROM integers WHERE i>=30000 AND i<30500");
+	REQUIRE(CHECK_COLUMN(result, 0, {500}));
+	// filters on doubles and on the (NULL containing) column
+	result = con.Query("SELECT COUNT(*) FROM integers WHERE d>99989.5");
+	REQUIRE(CHECK_COLUMN(result, 0, {10}));
+	result = con.Query("SELECT COUNT(*) FROM integers WHERE j=8");
+	REQUIRE(CHECK_COLUMN(result, 0, {1}));
+	result = con.Query("SELECT COUNT(*) FROM integers WHERE j IS NULL");
+	REQUIRE(CHECK_COLUMN(result, 0, {50000}));
+}
+
+TEST_CASE("Test zone map segment skipping", "[storage]") {
+	auto config = GetTestConfig();
+	unique_ptr<QueryResult> result;
+	auto storage_database = TestCreatePath("zonemap_test");
+
+	DeleteDatabase(storage_database);
+	{
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		REQUIRE_NO_FAIL(con.Query("CREATE TABLE integers(i INTEGER, d DOUBLE, j INTEGER)"));
+		auto appender = con.OpenAppender(DEFAULT_SCHEMA, "integers");
+		for (index_t i = 0; i < 100000; i++) {
+			appender->BeginRow();
+			appender->AppendInteger(i);
+			appender->AppendDouble(i);
+			if (i % 2 == 0) {
+				appender->AppendInteger(i);
+			} else {
+				appender->AppendValue(Value());
+			}
+			appender->EndRow();
+		}
+		con.CloseAppender();
+		CheckZonemapQueries(con);
+		// updates outside of the range of a chunk have to be visible to the scan
+		REQUIRE_NO_FAIL(con.Query("UPDATE integers SET i=1000000 WHERE i=50"));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i=1000000");
+		REQUIRE(CHECK_COLUMN(result, 0, {1}));
+		REQUIRE_NO_FAIL(con.Query("UPDATE integers SET i=50 WHERE i=1000000"));
+		// parallel scans use the zone maps as well
+		REQUIRE_NO_FAIL(con.Query("PRAGMA threads=4"));
+		CheckZonemapQueries(con);
+	}
+	// reload the database: the zone maps are now loaded from the persistent segments
+	for (index_t i = 0; i < 2; i++) {
+		DuckDB db(storage_database, config.get());
+		Connection con(db);
+		CheckZonemapQueries(con);
+		REQUIRE_NO_FAIL(con.Query("PRAGMA threads=4"));
+		CheckZonemapQueries(con);
+		// updates of persistent chunks are appended to the end of the table
+		REQUIRE_NO_FAIL(con.Query("UPDATE integers SET i=1000000 WHERE i=50"));
+		result = con.Query("SELECT COUNT(*) FROM integers WHERE i=1000000");
+		REQUIRE(CHECK_COLUMN(result, 0, {1}));
+		REQUIRE_NO_FAIL(con.Query("UPDATE integers SET i=50 WHERE i=1000000"));
+	}
+	DeleteDatabase(storage_database);
+}
@@ -187,3 +187,59 @@ TEST_CASE("Multiple concurrent updaters", "[updates][.]") {
 		REQUIRE(correct[i]);
 	}
 }
+
+static void scan_table_sums(DuckDB *db, bool *read_correct, int64_t expected_sum) {
+	*read_correct = true;
+	Connection con(*db);
+	while (!finished_updating) {
+		// updates move money between rows, the sum and count seen by a scan never change
+		auto result = con.Query("SELECT SUM(money), COUNT(*) FROM accounts WHERE money >= 0");
+		if (!CHECK_COLUMN(result, 0, {Value::BIGINT(expected_sum)}) || !CHECK_COLUMN(result, 1, {10000})) {
+			*read_correct = false;
+		}
+	}
+}
+
+TEST_CASE("Concurrent scans of a table that is being updated", "[transactions]") {
+	unique_ptr<QueryResult> result;
+	DuckDB db(nullptr);
+	Connection con(db);
+
+	finished_updating = false;
+	// a table that spans several vectors
+	REQUIRE_NO_FAIL(con.Query("CREATE TABLE accounts(id INTEGER, money INTEGER)"));
+	REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+	for (index_t i = 0; i < 10000; i++) {
+		REQUIRE_NO_FAIL(con.Query("INSERT INTO accounts VALUES (" + to_string(i) + ", 100)"));
+	}
+	REQUIRE_NO_FAIL(con.Query("COMMIT"));
+
+	bool read_correct[4];
+	vector<thread> read_threads;
+	for (index_t i = 0; i < 4; i++) {
+		read_threads.push_back(thread(scan_table_sums, &db, &read_correct[i], 1000000));
+	}
+	for (index_t i = 0; i < 200; i++) {
+		auto from = to_string((i * 37) % 10000);
+		auto to = to_string((i * 53 + 11) % 10000);
+		REQUIRE_NO_FAIL(con.Query("BEGIN TRANSACTION"));
+		REQUIRE_NO_FAIL(con.Query("UPDATE accounts SET money = money - 1 WHERE id = " + from));
+		REQUIRE_NO_FAIL(con.Query("UPDATE accounts SET money = money + 1 WHERE id = " + to));
+		// update rows in all vectors of the table, the intermediate state is never seen by the scans
+		auto condition = " WHERE id % 1000 = " + to_string(i % 1000);
+		REQUIRE_NO_FAIL(con.Query("UPDATE accounts SET money = money + 1000" + condition));
+		REQUIRE_NO_FAIL(con.Query("UPDATE accounts SET money = money - 1000" + condition));
+		// both committed and rolled back transactions keep the sum intact
+		REQUIRE_NO_FAIL(con.Query(i % 3 == 0 ? "ROLLBACK" : "COMMIT"));
+	}
+	finished_updating = true;
+	for (auto &thread : read_threads) {
+		thread.join();
+	}
+	for (index_t i = 0; i < 4; i++) {
+		REQUIRE(read_correct[i]);
+	}
+	result = con.Query("SELECT SUM(money), COUNT(*) FROM accounts");
+	REQUIRE(CHECK_COLUMN(result, 0, {Value::BIGINT(1000000)}));
+	REQUIRE(CHECK_COLUMN(result, 1, {10000}));
+}